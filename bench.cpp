@@ -0,0 +1,407 @@
+
+#include "memory.h"
+#include "rv32i.h"
+#include "timing.h"
+#include <sys/resource.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+static constexpr uint32_t bench_mem_size = 0x10000; // every kernel keeps its data below 0xc000
+
+// Guest kernels, RV32I only. Each one repeats its work a0 times and ends with ebreak. The
+// assembly of every word is beside it, numeric labels are local to a kernel (1b = back, 1f = ahead).
+// loop: a dependent chain of ALU instructions
+// memcpy: copies 4 KiB word by word, unrolled four times
+// sort: fills 256 words with xorshift numbers and insertion-sorts them
+// crc: bitwise CRC-32 of a 1 KiB buffer
+// chase: follows a linked list with a 2 KiB stride through 16 KiB
+// branchy: data-dependent branches on xorshift numbers
+static const uint32_t kernel_loop[] = {
+    0x00128293, // 1: addi   t0, t0, 1
+    0x00534333, //    xor    t1, t1, t0
+    0x00331393, //    slli   t2, t1, 3
+    0x007e0e33, //    add    t3, t3, t2
+    0x005e5e93, //    srli   t4, t3, 5
+    0x01df6f33, //    or     t5, t5, t4
+    0xfff50513, //    addi   a0, a0, -1
+    0xfe0512e3, //    bnez   a0, 1b
+    0x00100073, //    ebreak
+};
+static const uint32_t kernel_memcpy[] = {
+    0x00004437, //    lui    s0, 0x4
+    0x000054b7, //    lui    s1, 0x5
+    0x00000293, //    li     t0, 0
+    0x40000313, //    li     t1, 1024
+    0x00229393, // 1: slli   t2, t0, 2
+    0x008383b3, //    add    t2, t2, s0
+    0x0053a023, //    sw     t0, 0(t2)
+    0x00128293, //    addi   t0, t0, 1
+    0xfe6298e3, //    bne    t0, t1, 1b
+    0x00040593, // 2: mv     a1, s0
+    0x00048613, //    mv     a2, s1
+    0x000016b7, //    lui    a3, 0x1
+    0x008686b3, //    add    a3, a3, s0
+    0x0005a283, // 3: lw     t0, 0(a1)
+    0x0045a303, //    lw     t1, 4(a1)
+    0x0085a383, //    lw     t2, 8(a1)
+    0x00c5ae03, //    lw     t3, 12(a1)
+    0x00562023, //    sw     t0, 0(a2)
+    0x00662223, //    sw     t1, 4(a2)
+    0x00762423, //    sw     t2, 8(a2)
+    0x01c62623, //    sw     t3, 12(a2)
+    0x01058593, //    addi   a1, a1, 16
+    0x01060613, //    addi   a2, a2, 16
+    0xfcd5ece3, //    bltu   a1, a3, 3b
+    0xfff50513, //    addi   a0, a0, -1
+    0xfc0510e3, //    bnez   a0, 2b
+    0x00100073, //    ebreak
+};
+static const uint32_t kernel_sort[] = {
+    0x00004437, //    lui    s0, 0x4
+    0x10000493, //    li     s1, 256
+    0x00012937, //    lui    s2, 0x12
+    0x34590913, //    addi   s2, s2, 837
+    0x00000293, // 1: li     t0, 0
+    0x00d91313, // 2: slli   t1, s2, 13
+    0x00694933, //    xor    s2, s2, t1
+    0x01195313, //    srli   t1, s2, 17
+    0x00694933, //    xor    s2, s2, t1
+    0x00591313, //    slli   t1, s2, 5
+    0x00694933, //    xor    s2, s2, t1
+    0x00229313, //    slli   t1, t0, 2
+    0x00830333, //    add    t1, t1, s0
+    0x01232023, //    sw     s2, 0(t1)
+    0x00128293, //    addi   t0, t0, 1
+    0xfc929ce3, //    bne    t0, s1, 2b
+    0x00100293, //    li     t0, 1
+    0x00229313, // 3: slli   t1, t0, 2
+    0x00830333, //    add    t1, t1, s0
+    0x00032383, //    lw     t2, 0(t1)
+    0x00830c63, // 4: beq    t1, s0, 5f
+    0xffc32e03, //    lw     t3, -4(t1)
+    0x01c3f863, //    bgeu   t2, t3, 5f
+    0x01c32023, //    sw     t3, 0(t1)
+    0xffc30313, //    addi   t1, t1, -4
+    0xfedff06f, //    j      4b
+    0x00732023, // 5: sw     t2, 0(t1)
+    0x00128293, //    addi   t0, t0, 1
+    0xfc929ae3, //    bne    t0, s1, 3b
+    0xfff50513, //    addi   a0, a0, -1
+    0xf8051ce3, //    bnez   a0, 1b
+    0x00100073, //    ebreak
+};
+static const uint32_t kernel_crc[] = {
+    0x00004437, //    lui    s0, 0x4
+    0x00000293, //    li     t0, 0
+    0x40000313, //    li     t1, 1024
+    0x008283b3, // 1: add    t2, t0, s0
+    0x05a2ce13, //    xori   t3, t0, 90
+    0x01c38023, //    sb     t3, 0(t2)
+    0x00128293, //    addi   t0, t0, 1
+    0xfe6298e3, //    bne    t0, t1, 1b
+    0xedb884b7, //    lui    s1, 0xedb88
+    0x32048493, //    addi   s1, s1, 800
+    0xfff00593, // 2: li     a1, -1
+    0x00040613, //    mv     a2, s0
+    0x006406b3, //    add    a3, s0, t1
+    0x00064283, // 3: lbu    t0, 0(a2)
+    0x0055c5b3, //    xor    a1, a1, t0
+    0x00800393, //    li     t2, 8
+    0x0015fe13, // 4: andi   t3, a1, 1
+    0x0015d593, //    srli   a1, a1, 1
+    0x000e0463, //    beqz   t3, 5f
+    0x0095c5b3, //    xor    a1, a1, s1
+    0xfff38393, // 5: addi   t2, t2, -1
+    0xfe0396e3, //    bnez   t2, 4b
+    0x00160613, //    addi   a2, a2, 1
+    0xfcd61ce3, //    bne    a2, a3, 3b
+    0xfff50513, //    addi   a0, a0, -1
+    0xfc0512e3, //    bnez   a0, 2b
+    0x00100073, //    ebreak
+};
+static const uint32_t kernel_chase[] = {
+    0x00008437, //    lui    s0, 0x8
+    0x000014b7, //    lui    s1, 0x1
+    0xfff48493, //    addi   s1, s1, -1
+    0x00000293, //    li     t0, 0
+    0x20328313, // 1: addi   t1, t0, 515
+    0x00937333, //    and    t1, t1, s1
+    0x00231313, //    slli   t1, t1, 2
+    0x00830333, //    add    t1, t1, s0
+    0x00229393, //    slli   t2, t0, 2
+    0x008383b3, //    add    t2, t2, s0
+    0x0063a023, //    sw     t1, 0(t2)
+    0x00128293, //    addi   t0, t0, 1
+    0xfe54f0e3, //    bgeu   s1, t0, 1b
+    0x00040593, //    mv     a1, s0
+    0x000012b7, // 2: lui    t0, 0x1
+    0x0005a583, // 3: lw     a1, 0(a1)
+    0x0005a583, //    lw     a1, 0(a1)
+    0x0005a583, //    lw     a1, 0(a1)
+    0x0005a583, //    lw     a1, 0(a1)
+    0xffc28293, //    addi   t0, t0, -4
+    0xfe0296e3, //    bnez   t0, 3b
+    0xfff50513, //    addi   a0, a0, -1
+    0xfe0510e3, //    bnez   a0, 2b
+    0x00100073, //    ebreak
+};
+static const uint32_t kernel_branchy[] = {
+    0x00002937, //    lui    s2, 0x2
+    0x54590913, //    addi   s2, s2, 1349
+    0x00d91313, // 1: slli   t1, s2, 13
+    0x00694933, //    xor    s2, s2, t1
+    0x01195313, //    srli   t1, s2, 17
+    0x00694933, //    xor    s2, s2, t1
+    0x00591313, //    slli   t1, s2, 5
+    0x00694933, //    xor    s2, s2, t1
+    0x00197293, //    andi   t0, s2, 1
+    0x00028463, //    beqz   t0, 2f
+    0x00158593, //    addi   a1, a1, 1
+    0x00297293, // 2: andi   t0, s2, 2
+    0x00029663, //    bnez   t0, 3f
+    0x00160613, //    addi   a2, a2, 1
+    0x0080006f, //    j      4f
+    0x00168693, // 3: addi   a3, a3, 1
+    0x03097293, // 4: andi   t0, s2, 48
+    0x02000393, //    li     t2, 32
+    0x0072c463, //    blt    t0, t2, 5f
+    0x01274733, //    xor    a4, a4, s2
+    0x00795293, // 5: srli   t0, s2, 7
+    0x0032f293, //    andi   t0, t0, 3
+    0x00028863, //    beqz   t0, 6f
+    0xfff28293, //    addi   t0, t0, -1
+    0x00028463, //    beqz   t0, 6f
+    0x00178793, //    addi   a5, a5, 1
+    0xfff50513, // 6: addi   a0, a0, -1
+    0xf8051ee3, //    bnez   a0, 1b
+    0x00100073, //    ebreak
+};
+
+struct kernel
+{
+    const char* name; 
+    const uint32_t* code; 
+    uint32_t words; 
+    uint32_t iterations; // a0 at scale 1
+};
+
+#define KERNEL(k, n) { #k, kernel_##k, sizeof(kernel_##k) / 4, n }
+static const kernel kernels[] = {
+    KERNEL(loop, 4000000),
+    KERNEL(memcpy, 10000),
+    KERNEL(sort, 200),
+    KERNEL(crc, 500),
+    KERNEL(chase, 5000),
+    KERNEL(branchy, 1500000),
+};
+static const char* const engines[] = { "switch", "timing" };
+
+/**
+ * Throws away everything written to it, used to keep the halt messages of the harts out of the
+ * report
+ ********************************************************************************/
+class null_buffer : public std::streambuf
+{
+protected:
+    int overflow(int c) override { return c; }
+};
+
+struct result
+{
+    std::string kernel; 
+    std::string engine; 
+    uint64_t insns; 
+    double seconds; // best of the repetitions
+    long peak_rss_kb; // of the whole process after the kernel ran
+};
+
+/**
+ * Print a summary of how to invoke the benchmark
+ * @param none
+ * @return none
+ ********************************************************************************/
+static void usage()
+{
+    std::cerr << "Usage: rv32i-bench [-e engine] [-j json-file] [-k kernel] [-n scale] [-r repetitions]" << std::endl;
+    std::cerr << "   -e run only this engine (switch or timing), may be given more than once" << std::endl;
+    std::cerr << "   -j also write the results as JSON to json-file (- for standard output)" << std::endl;
+    std::cerr << "   -k run only this kernel, may be given more than once, kernels are:" << std::endl;
+    std::cerr << "     ";
+    for (const kernel& k : kernels)
+        std::cerr << " " << k.name;
+    std::cerr << std::endl;
+    std::cerr << "   -n multiply the work done by every kernel by scale (default 1)" << std::endl;
+    std::cerr << "   -r run each kernel this many times and keep the fastest (default 3)" << std::endl;
+    exit(1);
+}
+
+/**
+ * Load kernel k into a fresh memory and run it to its ebreak with the given engine
+ * @param const kernel& k, const std::string& engine, uint32_t scale, uint64_t& insns
+ * @return the run time in seconds, loading is not counted
+ ********************************************************************************/
+static double run_kernel(const kernel& k, const std::string& engine, uint32_t scale, uint64_t& insns)
+{
+    memory mem(bench_mem_size);
+    memcpy(mem.get_ptr(0, k.words * 4), k.code, k.words * 4);
+    rv32i sim(&mem);
+    timing model;
+    sim.start();
+    sim.set_register(10, k.iterations * scale);
+    null_buffer discard;
+    std::streambuf* saved = std::cout.rdbuf(&discard);
+    auto t0 = std::chrono::steady_clock::now();
+    if (engine == "timing")
+        sim.resume_detailed(0, &model);
+    else
+        sim.resume(0);
+    auto t1 = std::chrono::steady_clock::now();
+    std::cout.rdbuf(saved);
+    insns = sim.get_insn_counter();
+    return std::chrono::duration<double>(t1 - t0).count();
+}
+
+/**
+ * getter peak_rss_kb
+ * @param none
+ * @return the largest resident set size of the process so far, in KiB
+ ********************************************************************************/
+static long peak_rss_kb()
+{
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_maxrss;
+}
+
+/**
+ * Write the results as JSON, one object per kernel and engine
+ * @param std::ostream& os, const std::vector<result>& results, uint32_t scale
+ * @return none
+ ********************************************************************************/
+static void write_json(std::ostream& os, const std::vector<result>& results, uint32_t scale)
+{
+    os << "{" << std::endl << "  \"scale\": " << scale << "," << std::endl << "  \"results\": [" << std::endl;
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const result& r = results[i];
+        os << "    {\"kernel\": \"" << r.kernel << "\", \"engine\": \"" << r.engine
+           << "\", \"instructions\": " << r.insns << std::fixed << std::setprecision(6)
+           << ", \"seconds\": " << r.seconds << std::setprecision(3)
+           << ", \"mips\": " << r.insns / r.seconds / 1e6
+           << ", \"ns_per_insn\": " << r.seconds * 1e9 / r.insns
+           << ", \"peak_rss_kb\": " << r.peak_rss_kb << "}" << (i + 1 < results.size() ? "," : "") << std::endl;
+    }
+    os << "  ]" << std::endl << "}" << std::endl;
+    os.unsetf(std::ios::floatfield);
+}
+
+/**
+ * Run every selected kernel with every selected engine and report MIPS, ns per instruction and
+ * peak RSS. The instruction counts only depend on the kernels and the scale, so any change in
+ * them between two builds means an engine executes differently.
+ * @param int argc, char** argv
+ * @return 0 on success, 1 on bad arguments or when the JSON file can't be written
+ ********************************************************************************/
+int main(int argc, char** argv)
+{
+    std::vector<std::string> want_kernels, want_engines;
+    std::string json_file;
+    uint32_t scale = 1;
+    uint32_t repetitions = 3;
+    int opt;
+    while ((opt = getopt(argc, argv, "e:j:k:n:r:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'e':
+                want_engines.push_back(optarg);
+                break;
+            case 'j':
+                json_file = optarg;
+                break;
+            case 'k':
+                want_kernels.push_back(optarg);
+                break;
+            case 'n':
+                scale = std::stoul(optarg);
+                break;
+            case 'r':
+                repetitions = std::stoul(optarg);
+                break;
+            default:
+                usage();
+        }
+    }
+    if (optind != argc || scale == 0 || repetitions == 0)
+        usage();
+    for (const std::string& e : want_engines)
+    {
+        if (e != engines[0] && e != engines[1])
+        {
+            std::cerr << "Unknown engine " << e << "." << std::endl;
+            usage();
+        }
+    }
+    for (const std::string& name : want_kernels)
+    {
+        bool found = false;
+        for (const kernel& k : kernels)
+            found |= name == k.name;
+        if (!found)
+        {
+            std::cerr << "Unknown kernel " << name << "." << std::endl;
+            usage();
+        }
+    }
+    std::vector<result> results;
+    std::cout << std::left << std::setw(10) << "kernel" << std::setw(8) << "engine" << std::right
+              << std::setw(14) << "instructions" << std::setw(10) << "seconds" << std::setw(10) << "MIPS"
+              << std::setw(10) << "ns/insn" << std::setw(14) << "peak RSS KiB" << std::endl;
+    for (const kernel& k : kernels)
+    {
+        if (!want_kernels.empty() && std::find(want_kernels.begin(), want_kernels.end(), k.name) == want_kernels.end())
+            continue;
+        for (const char* e : engines)
+        {
+            if (!want_engines.empty() && std::find(want_engines.begin(), want_engines.end(), e) == want_engines.end())
+                continue;
+            result r { k.name, e, 0, 0, 0 };
+            for (uint32_t i = 0; i < repetitions; i++)
+            {
+                double s = run_kernel(k, e, scale, r.insns);
+                if (i == 0 || s < r.seconds)
+                    r.seconds = s;
+            }
+            r.peak_rss_kb = peak_rss_kb();
+            std::cout << std::left << std::setw(10) << r.kernel << std::setw(8) << r.engine << std::right
+                      << std::setw(14) << r.insns << std::fixed << std::setprecision(4) << std::setw(10) << r.seconds
+                      << std::setprecision(1) << std::setw(10) << r.insns / r.seconds / 1e6
+                      << std::setprecision(2) << std::setw(10) << r.seconds * 1e9 / r.insns
+                      << std::setw(14) << r.peak_rss_kb << std::endl;
+            std::cout.unsetf(std::ios::floatfield);
+            results.push_back(r);
+        }
+    }
+    if (json_file == "-")
+    {
+        write_json(std::cout, results, scale);
+    }
+    else if (!json_file.empty())
+    {
+        std::ofstream out(json_file);
+        if (!out)
+        {
+            std::cerr << "Can't open file " << json_file << " for writing." << std::endl;
+            return 1;
+        }
+        write_json(out, results, scale);
+    }
+    return 0;
+}
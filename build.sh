@@ -1,6 +1,56 @@
-g++ -g -ansi -pedantic -Wall -Werror -std=c++14 -c -o main.o main.cpp
+# everything but main.cpp
+sources="rv32i memory registerfile hex hostio device eventqueue clint plic symtab gdbstub replaylog timing simpoint cosim fuzzer coverage regtrace tracefilter lzblock insntrace reuse vregfile mmu insnobserver"
+if [ "$1" = bench ]
+then
+    # optimized throughput benchmark, see bench.cpp
+    g++ -O2 -DNDEBUG -ansi -pedantic -Wall -Werror -std=c++14 -pthread -o rv32i-bench bench.cpp $(for f in $sources; do echo $f.cpp; done)
+    exit
+fi
+if [ "$1" = fuzz ]
+then
+    # coverage-guided fuzzer for guest code, see fuzz.cpp
+    g++ -O2 -DNDEBUG -ansi -pedantic -Wall -Werror -std=c++14 -pthread -o rv32i-fuzz fuzz.cpp $(for f in $sources; do echo $f.cpp; done)
+    exit
+fi
+if [ "$1" = lib ]
+then
+    # librv32i.a and librv32i.so for embedding, the C interface is in rv32iapi.h
+    for f in rv32iapi $sources
+    do
+        g++ -O2 -fPIC -ansi -pedantic -Wall -Werror -std=c++14 -c -o lib-$f.o $f.cpp
+    done
+    rm -f librv32i.a
+    ar rcs librv32i.a lib-*.o
+    g++ -shared -pthread -o librv32i.so lib-*.o
+    exit
+fi
+g++ -g -ansi -pedantic -Wall -Werror -std=c++14 -pthread -c -o main.o main.cpp
 g++ -g -ansi -pedantic -Wall -Werror -std=c++14 -c -o rv32i.o rv32i.cpp
 g++ -g -ansi -pedantic -Wall -Werror -std=c++14 -c -o memory.o memory.cpp
 g++ -g -ansi -pedantic -Wall -Werror -std=c++14 -c -o registerfile.o registerfile.cpp
 g++ -g -ansi -pedantic -Wall -Werror -std=c++14 -c -o hex.o hex.cpp
-g++ -g -ansi -pedantic -Wall -Werror -std=c++14 -o rv32i main.o rv32i.o memory.o registerfile.o hex.o
\ No newline at end of file
+g++ -g -ansi -pedantic -Wall -Werror -std=c++14 -c -o hostio.o hostio.cpp
+g++ -g -ansi -pedantic -Wall -Werror -std=c++14 -c -o device.o device.cpp
+g++ -g -ansi -pedantic -Wall -Werror -std=c++14 -c -o eventqueue.o eventqueue.cpp
+g++ -g -ansi -pedantic -Wall -Werror -std=c++14 -c -o clint.o clint.cpp
+g++ -g -ansi -pedantic -Wall -Werror -std=c++14 -c -o plic.o plic.cpp
+g++ -g -ansi -pedantic -Wall -Werror -std=c++14 -c -o symtab.o symtab.cpp
+g++ -g -ansi -pedantic -Wall -Werror -std=c++14 -c -o gdbstub.o gdbstub.cpp
+g++ -g -ansi -pedantic -Wall -Werror -std=c++14 -c -o replaylog.o replaylog.cpp
+g++ -g -ansi -pedantic -Wall -Werror -std=c++14 -c -o timing.o timing.cpp
+g++ -g -ansi -pedantic -Wall -Werror -std=c++14 -c -o simpoint.o simpoint.cpp
+g++ -g -ansi -pedantic -Wall -Werror -std=c++14 -c -o cosim.o cosim.cpp
+g++ -g -ansi -pedantic -Wall -Werror -std=c++14 -c -o coverage.o coverage.cpp
+g++ -g -ansi -pedantic -Wall -Werror -std=c++14 -c -o regtrace.o regtrace.cpp
+g++ -g -ansi -pedantic -Wall -Werror -std=c++14 -c -o tracefilter.o tracefilter.cpp
+g++ -g -ansi -pedantic -Wall -Werror -std=c++14 -c -o lzblock.o lzblock.cpp
+g++ -g -ansi -pedantic -Wall -Werror -std=c++14 -c -o insntrace.o insntrace.cpp
+g++ -g -ansi -pedantic -Wall -Werror -std=c++14 -c -o reuse.o reuse.cpp
+g++ -g -ansi -pedantic -Wall -Werror -std=c++14 -c -o vregfile.o vregfile.cpp
+g++ -g -ansi -pedantic -Wall -Werror -std=c++14 -c -o mmu.o mmu.cpp
+g++ -g -ansi -pedantic -Wall -Werror -std=c++14 -c -o insnobserver.o insnobserver.cpp
+g++ -g -ansi -pedantic -Wall -Werror -std=c++14 -c -o regstate.o regstate.cpp
+g++ -g -ansi -pedantic -Wall -Werror -std=c++14 -c -o untrace.o untrace.cpp
+g++ -g -ansi -pedantic -Wall -Werror -std=c++14 -pthread -o rv32i main.o rv32i.o memory.o registerfile.o hex.o hostio.o device.o eventqueue.o clint.o plic.o symtab.o gdbstub.o replaylog.o timing.o simpoint.o cosim.o coverage.o regtrace.o tracefilter.o lzblock.o insntrace.o reuse.o vregfile.o mmu.o insnobserver.o
+g++ -g -ansi -pedantic -Wall -Werror -std=c++14 -o rv32i-regstate regstate.o rv32i.o memory.o registerfile.o hex.o hostio.o device.o eventqueue.o clint.o plic.o symtab.o gdbstub.o replaylog.o timing.o simpoint.o cosim.o coverage.o regtrace.o tracefilter.o lzblock.o insntrace.o reuse.o vregfile.o mmu.o insnobserver.o
+g++ -g -ansi -pedantic -Wall -Werror -std=c++14 -o rv32i-untrace untrace.o rv32i.o memory.o registerfile.o hex.o hostio.o device.o eventqueue.o clint.o plic.o symtab.o gdbstub.o replaylog.o timing.o simpoint.o cosim.o coverage.o regtrace.o tracefilter.o lzblock.o insntrace.o reuse.o vregfile.o mmu.o insnobserver.o
\ No newline at end of file
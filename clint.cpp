@@ -0,0 +1,118 @@
+
+#include "clint.h"
+
+/**
+ * clint constructor
+ * @param rv32i* h
+ * @return nothing
+ ********************************************************************************/
+clint::clint(rv32i* h)
+{
+    hart = h;
+}
+
+/**
+ * clint reset
+ * no software interrupt and no timer compare, the hart's reset() has already dropped the timer
+ * event so none is scheduled any more
+ * @param none
+ * @return none
+ ********************************************************************************/
+void clint::reset()
+{
+    msip = 0;
+    mtimecmp = ~(uint64_t)0;
+    scheduled = event_queue::never;
+}
+
+/**
+ * clint read
+ * 64-bit registers are read as two 32-bit halves
+ * @param uint32_t offset, uint32_t len
+ * @return the register value
+ ********************************************************************************/
+uint32_t clint::read(uint32_t offset, uint32_t len)
+{
+    switch (offset)
+    {
+        case reg_msip:
+            return msip;
+        case reg_mtimecmp:
+            return mtimecmp;
+        case reg_mtimecmp + 4:
+            return mtimecmp >> 32;
+        case reg_mtime:
+            return hart->get_mtime();
+        case reg_mtime + 4:
+            return hart->get_mtime() >> 32;
+        default:
+            return 0;
+    }
+}
+
+/**
+ * clint write
+ * msip drives MSIP directly, writing mtimecmp or mtime re-evaluates MTIP and the timer event
+ * @param uint32_t offset, uint32_t len, uint32_t val
+ * @return none
+ ********************************************************************************/
+void clint::write(uint32_t offset, uint32_t len, uint32_t val)
+{
+    uint64_t mtime = hart->get_mtime();
+    switch (offset)
+    {
+        case reg_msip:
+            msip = val & 1;
+            hart->set_interrupt_pending(rv32i::mip_msip, msip != 0);
+            return;
+        case reg_mtimecmp:
+            mtimecmp = (mtimecmp & 0xffffffff00000000) | val;
+            break;
+        case reg_mtimecmp + 4:
+            mtimecmp = (mtimecmp & 0xffffffff) | (uint64_t)val << 32;
+            break;
+        case reg_mtime:
+            hart->set_mtime((mtime & 0xffffffff00000000) | val);
+            break;
+        case reg_mtime + 4:
+            hart->set_mtime((mtime & 0xffffffff) | (uint64_t)val << 32);
+            break;
+        default:
+            return;
+    }
+    update();
+}
+
+/**
+ * The timer event came due
+ * the event may be stale (mtimecmp was moved since), update() sorts that out
+ * @param uint64_t now
+ * @return none
+ ********************************************************************************/
+void clint::fire(uint64_t now)
+{
+    scheduled = event_queue::never;
+    update();
+}
+
+/**
+ * Set MTIP if mtime has reached mtimecmp, otherwise clear it and make sure an event is
+ * scheduled for the instruction count at which it will.
+ * @param none
+ * @return none
+ ********************************************************************************/
+void clint::update()
+{
+    if (hart->get_mtime() >= mtimecmp)
+    {
+        hart->set_interrupt_pending(rv32i::mip_mtip, true);
+        return;
+    }
+    hart->set_interrupt_pending(rv32i::mip_mtip, false);
+    uint64_t due = hart->mtime_to_insn(mtimecmp);
+    if (due < scheduled)
+    {
+        scheduled = due;
+        hart->schedule_event(due, this);
+    }
+}
@@ -0,0 +1,32 @@
+
+#ifndef CLINT_H
+#define CLINT_H
+#include "device.h"
+#include "eventqueue.h"
+#include "rv32i.h"
+/**
+ * Core-local interruptor for a single hart: msip, mtimecmp and mtime.
+ * mtime is the hart's instruction-count based timer. Instead of comparing mtime with
+ * mtimecmp on every instruction the CLINT schedules an event for the instruction count at
+ * which mtime reaches mtimecmp and raises MTIP when it fires.
+ ********************************************************************************/
+class clint : public device, public event_target
+{
+public:
+    static constexpr uint32_t reg_msip = 0x0000; 
+    static constexpr uint32_t reg_mtimecmp = 0x4000; 
+    static constexpr uint32_t reg_mtime = 0xbff8; 
+    static constexpr uint32_t size = 0x10000; // bytes of address space used
+    clint(rv32i* h); // constructor prototype
+    void reset() override; 
+    uint32_t read(uint32_t offset, uint32_t len) override; 
+    void write(uint32_t offset, uint32_t len, uint32_t val) override; 
+    void fire(uint64_t now) override; 
+private:
+    void update(); 
+    rv32i* hart; // the hart whose timer and software interrupt this is
+    uint32_t msip = 0; 
+    uint64_t mtimecmp = ~(uint64_t)0; 
+    uint64_t scheduled = event_queue::never; // earliest event this CLINT has pending
+};
+#endif
@@ -0,0 +1,191 @@
+
+#include "cosim.h"
+#include "hex.h"
+#include <string.h>
+
+static constexpr uint32_t opcode_store = 0b0100011;
+static constexpr uint32_t opcode_amo = 0b0101111;
+
+/**
+ * Turn an engine name from the command line into an engine
+ * "switch" is the plain interpreter behind tick(), "timing" runs through tick_detailed()
+ * @param const std::string& name, engine& e
+ * @return false if there is no engine with that name
+ ********************************************************************************/
+bool cosim::parse_engine(const std::string& name, engine& e)
+{
+    if (name == "switch")
+        e = engine_switch;
+    else if (name == "timing")
+        e = engine_timing;
+    else
+        return false;
+    return true;
+}
+
+/**
+ * cosim constructor
+ * the test hart and memory must hold the same program as the reference ones and the test hart
+ * must replay what the reference hart records (see replaylog::follow())
+ * @param rv32i* r, memory* rm, engine re, rv32i* t, memory* tm, engine te,
+ * uint64_t n (compare pc and registers every n instructions)
+ * @return nothing
+ ********************************************************************************/
+cosim::cosim(rv32i* r, memory* rm, engine re, rv32i* t, memory* tm, engine te, uint64_t n)
+{
+    ref = r;
+    ref_mem = rm;
+    ref_engine = re;
+    test = t;
+    test_mem = tm;
+    test_engine = te;
+    every = n;
+}
+
+/**
+ * Run both harts in lockstep until the reference hart halts, the limit is reached or they
+ * diverge, at the end the whole memories are compared as well
+ * @param uint64_t limit (0 = no limit)
+ * @return false if a divergence was found (it has been reported)
+ ********************************************************************************/
+bool cosim::run(uint64_t limit)
+{
+    std::string what;
+    ref->start();
+    test->start();
+    while ((limit == 0 || ref->get_insn_counter() < limit) && !ref->is_halted())
+    {
+        uint32_t slot = traced % history;
+        trace_pc[slot] = ref->get_pc();
+        trace_insn[slot] = ref_mem->fetch32(trace_pc[slot]);
+        test_trace_pc[slot] = test->get_pc();
+        test_trace_insn[slot] = test_mem->fetch32(test_trace_pc[slot]);
+        traced++;
+        uint32_t insn = trace_insn[slot];
+        uint32_t addr = ref->get_register(rv32i::get_rs1(insn));
+        if ((insn & 0x7f) == opcode_store)
+        {
+            addr += rv32i::get_imm_s(insn);
+        }
+        step(ref, ref_engine, &ref_model);
+        step(test, test_engine, &test_model);
+        if (!compare_store(insn, addr, what)
+            || ((ref->get_insn_counter() % every == 0 || ref->is_halted() || test->is_halted())
+                && !compare_state(what)))
+        {
+            report(what);
+            return false;
+        }
+    }
+    uint32_t size = ref_mem->get_size();
+    const uint8_t* a = ref_mem->get_ptr(0, size);
+    const uint8_t* b = test_mem->get_ptr(0, size);
+    for (uint32_t i = 0; what.empty() && i < size; i++)
+    {
+        if (a[i] != b[i])
+            what = "memory at " + hex0x32(i) + " " + hex8(a[i]) + " vs " + hex8(b[i]);
+    }
+    if (!what.empty() || !compare_state(what))
+    {
+        report(what);
+        return false;
+    }
+    std::cout << std::endl << std::dec << ref->get_insn_counter()
+              << " instructions executed in lockstep without a divergence" << std::endl;
+    return true;
+}
+
+/**
+ * Execute one instruction on hart with the given engine
+ * @param rv32i* hart, engine e, timing* model (for engine_timing)
+ * @return none
+ ********************************************************************************/
+void cosim::step(rv32i* hart, engine e, timing* model)
+{
+    switch (e)
+    {
+        case engine_switch:
+            hart->tick();
+            break;
+        case engine_timing:
+            hart->tick_detailed(model);
+            break;
+    }
+}
+
+/**
+ * Compare the architectural state of the two harts
+ * @param std::string& what (set to a description of the first difference)
+ * @return false if they differ
+ ********************************************************************************/
+bool cosim::compare_state(std::string& what) const
+{
+    std::ostringstream os;
+    if (ref->is_halted() != test->is_halted())
+        os << "halted " << ref->is_halted() << " vs " << test->is_halted();
+    else if (ref->get_insn_counter() != test->get_insn_counter())
+        os << "instruction count " << std::dec << ref->get_insn_counter() << " vs " << test->get_insn_counter();
+    else if (ref->get_pc() != test->get_pc())
+        os << "pc " << hex0x32(ref->get_pc()) << " vs " << hex0x32(test->get_pc());
+    for (uint32_t r = 1; r < 32 && os.str().empty(); r++)
+    {
+        if (ref->get_register(r) != test->get_register(r))
+            os << "x" << std::dec << r << " " << hex0x32(ref->get_register(r)) << " vs "
+               << hex0x32(test->get_register(r));
+    }
+    what = os.str();
+    return what.empty();
+}
+
+/**
+ * Compare what a store or AMO left in both memories, devices and bad addresses are skipped
+ * @param uint32_t insn, uint32_t addr (effective address in the reference hart), std::string& what
+ * @return false if the stored bytes differ
+ ********************************************************************************/
+bool cosim::compare_store(uint32_t insn, uint32_t addr, std::string& what) const
+{
+    uint32_t len;
+    if ((insn & 0x7f) == opcode_store)
+        len = 1 << (rv32i::get_funct3(insn) & 3);
+    else if ((insn & 0x7f) == opcode_amo)
+        len = 4;
+    else
+        return true;
+    const uint8_t* a = ref_mem->get_ptr(addr, len);
+    const uint8_t* b = test_mem->get_ptr(addr, len);
+    if (a == nullptr || b == nullptr || memcmp(a, b, len) == 0)
+        return true;
+    uint32_t va = 0, vb = 0;
+    memcpy(&va, a, len);
+    memcpy(&vb, b, len);
+    what = "memory at " + hex0x32(addr) + " " + hex0x32(va) + " vs " + hex0x32(vb);
+    return false;
+}
+
+/**
+ * Print the divergence and the last instructions of both harts
+ * @param const std::string& what
+ * @return none
+ ********************************************************************************/
+void cosim::report(const std::string& what) const
+{
+    std::cout << std::endl << "Divergence after " << std::dec << ref->get_insn_counter()
+              << " instructions: " << what << std::endl;
+    uint64_t first = traced > history ? traced - history : 0;
+    for (int side = 0; side < 2; side++)
+    {
+        rv32i* hart = side == 0 ? ref : test;
+        const uint32_t* pcs = side == 0 ? trace_pc : test_trace_pc;
+        const uint32_t* insns = side == 0 ? trace_insn : test_trace_insn;
+        std::cout << (side == 0 ? "reference:" : "test:") << std::endl;
+        uint32_t saved_pc = hart->get_pc();
+        for (uint64_t i = first; i < traced; i++)
+        {
+            hart->set_pc(pcs[i % history]); // decode() renders branch targets relative to pc
+            std::cout << "  " << hex32(pcs[i % history]) << ": " << hex32(insns[i % history]) << "  "
+                      << hart->decode(insns[i % history]) << std::endl;
+        }
+        hart->set_pc(saved_pc);
+        hart->dump();
+    }
+}
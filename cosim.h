@@ -0,0 +1,44 @@
+
+#ifndef COSIM_H
+#define COSIM_H
+#include <string>
+#include <stdint.h>
+#include "rv32i.h"
+#include "memory.h"
+#include "timing.h"
+/**
+ * Lockstep differential co-simulation. A reference hart and a test hart run the same program
+ * over their own copies of the memory, each with its own execution engine. The test hart replays
+ * the syscall results, device reads and interrupts the reference hart records, and after every
+ * instruction the stored values are compared and every few instructions pc and registers, the
+ * first divergence is reported with the recent trace of both harts.
+ ********************************************************************************/
+class cosim
+{
+public:
+    enum engine { engine_switch, engine_timing }; 
+    static bool parse_engine(const std::string& name, engine& e); 
+    cosim(rv32i* ref, memory* ref_mem, engine ref_engine, rv32i* test, memory* test_mem, engine test_engine, uint64_t every); // constructor prototype
+    bool run(uint64_t limit); 
+private:
+    static constexpr uint32_t history = 8; // trace entries kept for the report
+    rv32i* ref; 
+    memory* ref_mem; 
+    engine ref_engine; 
+    rv32i* test; 
+    memory* test_mem; 
+    engine test_engine; 
+    uint64_t every; // compare pc and registers every this many instructions
+    timing ref_model; // used by engine_timing
+    timing test_model; 
+    uint32_t trace_pc[history]; // ring buffer of the reference hart's recent instructions
+    uint32_t trace_insn[history]; 
+    uint32_t test_trace_pc[history]; 
+    uint32_t test_trace_insn[history]; 
+    uint64_t traced = 0; // instructions in the ring buffers
+    void step(rv32i* hart, engine e, timing* model); 
+    bool compare_state(std::string& what) const; 
+    bool compare_store(uint32_t insn, uint32_t addr, std::string& what) const; 
+    void report(const std::string& what) const; 
+};
+#endif
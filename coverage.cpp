@@ -0,0 +1,206 @@
+
+#include "coverage.h"
+#include "rv32i.h"
+#include "hex.h"
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <string.h>
+
+static const char magic[] = "RV32COV1"; // first bytes of a coverage file
+
+/**
+ * coverage constructor
+ * @param uint32_t mem_size (the bitmap covers addresses 0 to mem_size - 1)
+ * @return nothing
+ ********************************************************************************/
+coverage::coverage(uint32_t mem_size)
+{
+    slots = ((uint64_t)mem_size + (1u << slot_shift) - 1) >> slot_shift;
+    bits.assign((slots + 63) / 64, 0);
+}
+
+/**
+ * Start the first block where the hart is
+ * @param rv32i* hart
+ * @return none
+ ********************************************************************************/
+void coverage::begin(rv32i* hart)
+{
+    block = block_end = hart->get_pc();
+}
+
+/**
+ * An instruction anywhere but right after the last one starts a new block, the one it leaves is
+ * marked
+ * @param const rv32i* hart, const step_info& s
+ * @return none
+ ********************************************************************************/
+void coverage::after(const rv32i*, const step_info& s)
+{
+    if (s.pc != block_end)
+    {
+        if (block_end > block)
+        {
+            mark(block, block_end - 4);
+        }
+        block = s.pc;
+    }
+    block_end = s.pc + 4;
+}
+
+/**
+ * Mark the block in progress
+ * @param rv32i* hart
+ * @return none
+ ********************************************************************************/
+void coverage::end(rv32i*)
+{
+    if (block_end > block)
+    {
+        mark(block, block_end - 4);
+    }
+    block = block_end;
+}
+
+/**
+ * getter is_covered
+ * @param uint32_t addr
+ * @return true if the instruction at addr was executed
+ ********************************************************************************/
+bool coverage::is_covered(uint32_t addr) const
+{
+    uint32_t s = addr >> slot_shift;
+    return s < slots && (bits[s / 64] >> (s % 64) & 1);
+}
+
+/**
+ * OR the bitmap saved in fname into this one, a missing file counts as empty so that the first
+ * run of a suite can start it
+ * @param const std::string& fname
+ * @return false if the file exists but is not a coverage file or is for a different memory size
+ ********************************************************************************/
+bool coverage::merge_file(const std::string& fname)
+{
+    std::ifstream in(fname, std::ios::in | std::ios::binary);
+    if (!in)
+    {
+        return true;
+    }
+    char head[8];
+    uint32_t file_slots = 0;
+    in.read(head, 8);
+    in.read(reinterpret_cast<char*>(&file_slots), 4);
+    if (!in || memcmp(head, magic, 8) != 0 || file_slots != slots)
+    {
+        std::cerr << fname << " is not a coverage file for this memory size." << std::endl;
+        return false;
+    }
+    std::vector<uint64_t> other(bits.size());
+    in.read(reinterpret_cast<char*>(other.data()), other.size() * 8);
+    if (!in)
+    {
+        std::cerr << fname << " is truncated." << std::endl;
+        return false;
+    }
+    for (size_t i = 0; i < bits.size(); i++)
+    {
+        bits[i] |= other[i];
+    }
+    return true;
+}
+
+/**
+ * Write the bitmap to fname: the magic, the number of slots and the bits, little-endian
+ * @param const std::string& fname
+ * @return false if the file can't be written
+ ********************************************************************************/
+bool coverage::save_file(const std::string& fname) const
+{
+    std::ofstream out(fname, std::ios::out | std::ios::binary | std::ios::trunc);
+    out.write(magic, 8);
+    out.write(reinterpret_cast<const char*>(&slots), 4);
+    out.write(reinterpret_cast<const char*>(bits.data()), bits.size() * 8);
+    if (!out)
+    {
+        std::cerr << "Can't write file " << fname << "." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Number of executed slots between two addresses
+ * @param uint32_t start, uint32_t end (not included)
+ * @return the executed slots
+ ********************************************************************************/
+uint32_t coverage::count(uint32_t start, uint32_t end) const
+{
+    uint32_t n = 0;
+    for (uint32_t addr = start; addr < end; addr += 1u << slot_shift)
+    {
+        n += is_covered(addr);
+    }
+    return n;
+}
+
+/**
+ * Print how much of the loaded image was executed, then with symbols every function that never
+ * ran and, for the ones that partly ran, the address ranges that did not (addr2line turns these
+ * into source lines)
+ * @param std::ostream& os, const symtab& symbols (may be empty), uint32_t image_end (end of the
+ * last function)
+ * @return none
+ ********************************************************************************/
+void coverage::report(std::ostream& os, const symtab& symbols, uint32_t image_end) const
+{
+    uint32_t slot = 1u << slot_shift;
+    uint32_t total = image_end / slot;
+    uint32_t covered = count(0, image_end);
+    os << std::dec << covered << " of " << total << " instruction slots executed";
+    if (total != 0)
+    {
+        os << " (" << std::fixed << std::setprecision(1) << 100.0 * covered / total << "%)";
+        os.unsetf(std::ios::floatfield);
+    }
+    os << std::endl;
+    const std::map<uint32_t, std::string>& functions = symbols.functions();
+    for (auto it = functions.begin(); it != functions.end(); ++it)
+    {
+        auto next = std::next(it);
+        uint32_t start = it->first;
+        uint32_t end = (next == functions.end()) ? image_end : next->first;
+        if (start >= end)
+        {
+            continue;
+        }
+        uint32_t n = count(start, end);
+        uint32_t size = (end - start) / slot;
+        if (n == 0)
+        {
+            os << "never executed: " << it->second << " " << hex0x32(start) << std::endl;
+        }
+        else if (n < size)
+        {
+            os << "partly executed: " << it->second << " " << std::dec << n << "/" << size << ", not run:";
+            for (uint32_t addr = start; addr < end; addr += slot)
+            {
+                if (is_covered(addr))
+                {
+                    continue;
+                }
+                uint32_t first = addr;
+                while (addr + slot < end && !is_covered(addr + slot))
+                {
+                    addr += slot;
+                }
+                os << " " << hex0x32(first);
+                if (addr != first)
+                {
+                    os << "-" << hex0x32(addr);
+                }
+            }
+            os << std::endl;
+        }
+    }
+}
@@ -0,0 +1,61 @@
+
+#ifndef COVERAGE_H
+#define COVERAGE_H
+#include <iostream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "symtab.h"
+#include "insnobserver.h"
+/**
+ * Which instructions were executed, one bit per 4-byte slot of the memory. As an observer it
+ * marks whole basic blocks when they end so the cost per instruction is one compare. The bitmap
+ * can be merged with the one in a file so that a whole test suite adds up.
+ ********************************************************************************/
+class coverage : public insn_observer
+{
+public:
+    static constexpr uint32_t slot_shift = 2; // bytes per slot = 1 << slot_shift
+    coverage(uint32_t mem_size); // constructor prototype
+    void begin(rv32i* hart) override; 
+    void after(const rv32i* hart, const step_info& s) override; 
+    void end(rv32i* hart) override; 
+    void mark(uint32_t first, uint32_t last); 
+    bool is_covered(uint32_t addr) const; 
+    bool merge_file(const std::string& fname); 
+    bool save_file(const std::string& fname) const; 
+    void report(std::ostream& os, const symtab& symbols, uint32_t image_end) const; 
+private:
+    uint32_t slots; 
+    std::vector<uint64_t> bits; 
+    uint32_t block = 0; // first instruction of the block in progress
+    uint32_t block_end = 0; // the instruction after the last one executed in it
+    uint32_t count(uint32_t start, uint32_t end) const; 
+};
+
+/**
+ * Mark the instructions from first to last (both included) as executed
+ * @param uint32_t first, uint32_t last (addresses, first <= last)
+ * @return none
+ ********************************************************************************/
+inline void coverage::mark(uint32_t first, uint32_t last)
+{
+    uint32_t a = first >> slot_shift;
+    uint32_t b = last >> slot_shift;
+    if (b >= slots)
+    {
+        if (a >= slots)
+            return; // a device or a bad address
+        b = slots - 1;
+    }
+    if (a / 64 == b / 64)
+    {
+        bits[a / 64] |= (~0ull >> (63 - (b - a))) << (a % 64);
+        return;
+    }
+    bits[a / 64] |= ~0ull << (a % 64);
+    for (uint32_t w = a / 64 + 1; w < b / 64; w++)
+        bits[w] = ~0ull;
+    bits[b / 64] |= ~0ull >> (63 - b % 64);
+}
+#endif
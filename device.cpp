@@ -0,0 +1,196 @@
+
+#include "device.h"
+#include "plic.h"
+#include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+/**
+ * device destructor
+ * @param none
+ * @return nothing
+ ********************************************************************************/
+device::~device()
+{
+}
+
+/**
+ * Back to the state the device is in when it is attached, for a run that starts over. Devices
+ * without state need not override it.
+ * @param none
+ * @return none
+ ********************************************************************************/
+void device::reset()
+{
+}
+
+/**
+ * uart read
+ * LSR always reports an empty transmitter and no received data, every other register reads
+ * as zero.
+ * @param uint32_t offset, uint32_t len
+ * @return the register value
+ ********************************************************************************/
+uint32_t uart::read(uint32_t offset, uint32_t len)
+{
+    if (offset == reg_lsr)
+    {
+        return 0x60; // THRE | TEMT
+    }
+    return 0;
+}
+
+/**
+ * uart write
+ * a byte written to THR is printed on stdout, other registers ignore writes
+ * @param uint32_t offset, uint32_t len, uint32_t val
+ * @return none
+ ********************************************************************************/
+void uart::write(uint32_t offset, uint32_t len, uint32_t val)
+{
+    if (offset == reg_thr)
+    {
+        std::cout.put((char)(val & 0xff));
+    }
+}
+
+/**
+ * blockdev constructor
+ * @param none
+ * @return nothing
+ ********************************************************************************/
+blockdev::blockdev()
+{
+    reset();
+}
+
+/**
+ * blockdev reset clears the registers and the sector buffer, the image file stays open
+ * @param none
+ * @return none
+ ********************************************************************************/
+void blockdev::reset()
+{
+    sector = 0;
+    status = 0;
+    for (uint32_t i = 0; i < sector_size; i++)
+    {
+        data[i] = 0;
+    }
+}
+
+/**
+ * blockdev destructor closes the image file
+ * @param none
+ * @return nothing
+ ********************************************************************************/
+blockdev::~blockdev()
+{
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+}
+
+/**
+ * Open the disk image
+ * The image is opened read/write, its size is rounded down to whole sectors.
+ * @param const std::string& fname
+ * @return true if the file could be opened
+ ********************************************************************************/
+bool blockdev::open_file(const std::string& fname)
+{
+    fd = open(fname.c_str(), O_RDWR);
+    if (fd < 0)
+    {
+        std::cerr << "Can't open disk image " << fname << "." << std::endl;
+        return false;
+    }
+    struct stat st;
+    fstat(fd, &st);
+    sector_count = st.st_size / sector_size;
+    return true;
+}
+
+/**
+ * Connect the completion interrupt to source src of p
+ * @param plic* p, uint32_t src
+ * @return none
+ ********************************************************************************/
+void blockdev::set_irq(plic* p, uint32_t src)
+{
+    irq = p;
+    irq_src = src;
+}
+
+/**
+ * blockdev read
+ * returns a register or little-endian bytes from the sector buffer
+ * @param uint32_t offset, uint32_t len
+ * @return the value read
+ ********************************************************************************/
+uint32_t blockdev::read(uint32_t offset, uint32_t len)
+{
+    if (offset >= buffer)
+    {
+        uint32_t val = 0;
+        for (uint32_t i = 0; i < len && offset - buffer + i < sector_size; i++)
+        {
+            val |= (uint32_t)data[offset - buffer + i] << (8 * i);
+        }
+        return val;
+    }
+    switch (offset)
+    {
+        case reg_sector:
+            return sector;
+        case reg_status:
+            return status;
+        case reg_count:
+            return sector_count;
+        default:
+            return 0;
+    }
+}
+
+/**
+ * blockdev write
+ * fills the sector buffer, sets the sector number or runs a read/write command against the
+ * image file. Commands complete immediately, report success in the status register and raise
+ * the completion interrupt.
+ * @param uint32_t offset, uint32_t len, uint32_t val
+ * @return none
+ ********************************************************************************/
+void blockdev::write(uint32_t offset, uint32_t len, uint32_t val)
+{
+    if (offset >= buffer)
+    {
+        for (uint32_t i = 0; i < len && offset - buffer + i < sector_size; i++)
+        {
+            data[offset - buffer + i] = (val >> (8 * i)) & 0xff;
+        }
+        return;
+    }
+    if (offset == reg_sector)
+    {
+        sector = val;
+    }
+    else if (offset == reg_command)
+    {
+        off_t pos = (off_t)sector * sector_size;
+        ssize_t n = -1;
+        if (fd >= 0 && sector < sector_count)
+        {
+            if (val == cmd_read)
+                n = pread(fd, data, sector_size, pos);
+            else if (val == cmd_write)
+                n = pwrite(fd, data, sector_size, pos);
+        }
+        status = (n == (ssize_t)sector_size) ? 0 : 1;
+        if (irq != nullptr)
+        {
+            irq->raise(irq_src);
+        }
+    }
+}
@@ -0,0 +1,69 @@
+
+#ifndef DEVICE_H
+#define DEVICE_H
+#include <string>
+#include <stdint.h>
+class plic;
+/**
+ * A memory-mapped device. The memory calls read() and write() for accesses that fall inside
+ * the address range the device was attached to, offset is relative to the start of that range
+ * and len is 1, 2 or 4 bytes.
+ ********************************************************************************/
+class device
+{
+public:
+    virtual ~device(); 
+    virtual void reset(); 
+    virtual uint32_t read(uint32_t offset, uint32_t len) = 0; 
+    virtual void write(uint32_t offset, uint32_t len, uint32_t val) = 0; 
+};
+
+/**
+ * Minimal 16550-style UART, only THR/RBR and LSR are implemented. Transmitted bytes go to
+ * stdout, nothing is ever received.
+ ********************************************************************************/
+class uart : public device
+{
+public:
+    static constexpr uint32_t reg_thr = 0; // transmit holding / receive buffer
+    static constexpr uint32_t reg_lsr = 5; // line status
+    static constexpr uint32_t size = 8; // bytes of address space used
+    uint32_t read(uint32_t offset, uint32_t len) override; 
+    void write(uint32_t offset, uint32_t len, uint32_t val) override; 
+};
+
+/**
+ * Sector based block device backed by a host file.
+ * The guest writes a sector number, issues a read or write command and moves the data through
+ * a 512-byte window in the device's address range. If an interrupt line is connected it is
+ * raised whenever a command completes.
+ ********************************************************************************/
+class blockdev : public device
+{
+public:
+    static constexpr uint32_t reg_sector = 0x00; // sector number for the next command
+    static constexpr uint32_t reg_command = 0x04; // write cmd_read or cmd_write to start
+    static constexpr uint32_t reg_status = 0x08; // 0 = ok, 1 = error
+    static constexpr uint32_t reg_count = 0x0c; // number of sectors in the image (read only)
+    static constexpr uint32_t buffer = 0x200; // start of the sector buffer
+    static constexpr uint32_t sector_size = 512; 
+    static constexpr uint32_t size = buffer + sector_size; // bytes of address space used
+    static constexpr uint32_t cmd_read = 1; 
+    static constexpr uint32_t cmd_write = 2; 
+    blockdev(); // constructor prototype
+    ~blockdev(); // destructor prototype
+    bool open_file(const std::string& fname); 
+    void set_irq(plic* p, uint32_t src); 
+    void reset() override; 
+    uint32_t read(uint32_t offset, uint32_t len) override; 
+    void write(uint32_t offset, uint32_t len, uint32_t val) override; 
+private:
+    int fd = -1; // host file holding the disk image
+    uint32_t sector = 0; 
+    uint32_t status = 0; 
+    uint32_t sector_count = 0; 
+    plic* irq = nullptr; // interrupt controller to signal completion to
+    uint32_t irq_src = 0; // source number on irq
+    uint8_t data[sector_size]; // sector buffer
+};
+#endif
@@ -0,0 +1,71 @@
+
+#include "eventqueue.h"
+#include <algorithm>
+
+/**
+ * comparison used to keep the earliest event at the front of the heap
+ ********************************************************************************/
+static bool later(const event_queue::event& a, const event_queue::event& b);
+
+/**
+ * event_target destructor
+ * @param none
+ * @return nothing
+ ********************************************************************************/
+event_target::~event_target()
+{
+}
+
+/**
+ * Schedule target to fire when the instruction counter reaches when.
+ * Events scheduled for the same count fire in no particular order.
+ * @param uint64_t when, event_target* target
+ * @return none
+ ********************************************************************************/
+void event_queue::schedule(uint64_t when, event_target* target)
+{
+    heap.push_back(event { when, target });
+    std::push_heap(heap.begin(), heap.end(), later);
+}
+
+/**
+ * getter next_due
+ * @param none
+ * @return the instruction count of the earliest pending event or never
+ ********************************************************************************/
+uint64_t event_queue::next_due() const
+{
+    return heap.empty() ? never : heap.front().when;
+}
+
+/**
+ * Fire every event that is due at instruction count now. A target may schedule new events
+ * from fire(), those run in the same call if they are already due.
+ * @param uint64_t now
+ * @return none
+ ********************************************************************************/
+void event_queue::run_due(uint64_t now)
+{
+    while (!heap.empty() && heap.front().when <= now)
+    {
+        event_target* target = heap.front().target;
+        std::pop_heap(heap.begin(), heap.end(), later);
+        heap.pop_back();
+        target->fire(now);
+    }
+}
+
+/**
+ * Drop all pending events
+ * @param none
+ * @return none
+ ********************************************************************************/
+void event_queue::clear()
+{
+    heap.clear();
+}
+
+static bool later(const event_queue::event& a, const event_queue::event& b)
+{
+    return a.when > b.when;
+}
@@ -0,0 +1,37 @@
+
+#ifndef EVENTQUEUE_H
+#define EVENTQUEUE_H
+#include <vector>
+#include <stdint.h>
+/**
+ * Something that wants to be called back when the instruction counter reaches a given value.
+ ********************************************************************************/
+class event_target
+{
+public:
+    virtual ~event_target(); 
+    virtual void fire(uint64_t now) = 0; 
+};
+
+/**
+ * Discrete-event queue keyed on the hart's instruction counter.
+ * The run loop only compares the instruction counter with next_due(), the queue itself is a
+ * binary min-heap so scheduling and popping are O(log n) in the number of pending events.
+ ********************************************************************************/
+class event_queue
+{
+public:
+    static constexpr uint64_t never = ~(uint64_t)0; // next_due() when nothing is scheduled
+    struct event
+    {
+        uint64_t when; // instruction count at which the event fires
+        event_target* target; 
+    };
+    void schedule(uint64_t when, event_target* target); 
+    uint64_t next_due() const; 
+    void run_due(uint64_t now); 
+    void clear(); 
+private:
+    std::vector<event> heap; // min-heap on when
+};
+#endif
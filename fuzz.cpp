@@ -0,0 +1,202 @@
+
+#include "fuzzer.h"
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <chrono>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+/**
+ * Print a summary of how to invoke the fuzzer
+ * @param none
+ * @return none
+ ********************************************************************************/
+static void usage()
+{
+    std::cerr << "Usage: rv32i-fuzz [-a hex-buf-addr] [-d seconds] [-i seed-dir] [-j threads] [-l exec-limit] [-m hex-mem-size] [-n max-len] [-o out-dir] [-r runs] [-s seed] infile" << std::endl;
+    std::cerr << "   The program in infile gets the address of the input in a0 and its length in a1," << std::endl;
+    std::cerr << "   ebreak or exit(0) ends a run normally, any other halt is a crash." << std::endl;
+    std::cerr << "   -a put the input at this address (default: the first page after the program)" << std::endl;
+    std::cerr << "   -d stop after this many seconds (default: run until interrupted or -r)" << std::endl;
+    std::cerr << "   -i start from the files in seed-dir" << std::endl;
+    std::cerr << "   -j run this many instances on their own threads (default 1)" << std::endl;
+    std::cerr << "   -l instructions per run before it counts as a hang (default 1000000)" << std::endl;
+    std::cerr << "   -m memory size (default 0x10000)" << std::endl;
+    std::cerr << "   -n longest input (default 4096)" << std::endl;
+    std::cerr << "   -o write inputs with new coverage to out-dir/queue and crashes to out-dir/crashes" << std::endl;
+    std::cerr << "   -r stop after this many runs" << std::endl;
+    std::cerr << "   -s random seed (default 1)" << std::endl;
+    exit(1);
+}
+
+/**
+ * Read a whole file
+ * @param const std::string& fname, std::string& data
+ * @return false if it can't be read
+ ********************************************************************************/
+static bool read_file(const std::string& fname, std::string& data)
+{
+    std::ifstream in(fname, std::ios::in | std::ios::binary);
+    if (!in)
+    {
+        std::cerr << "Can't open file " << fname << " for reading." << std::endl;
+        return false;
+    }
+    data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    return true;
+}
+
+/**
+ * Fuzz the program in infile, see usage()
+ * @param int argc, char** argv
+ * @return 0 when done, 1 on bad arguments or files
+ ********************************************************************************/
+int main(int argc, char** argv)
+{
+    uint32_t buf_addr = 0;
+    bool buf_given = false;
+    uint64_t duration = 0;
+    std::string seed_dir;
+    uint32_t threads = 1;
+    uint64_t limit = 1000000;
+    uint32_t mem_size = 0x10000;
+    uint32_t max_len = 4096;
+    uint64_t runs = 0;
+    uint64_t seed = 1;
+    fuzzer::campaign c;
+    int opt;
+    while ((opt = getopt(argc, argv, "a:d:i:j:l:m:n:o:r:s:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'a':
+                buf_addr = std::stoul(optarg, nullptr, 16);
+                buf_given = true;
+                break;
+            case 'd':
+                duration = std::stoull(optarg);
+                break;
+            case 'i':
+                seed_dir = optarg;
+                break;
+            case 'j':
+                threads = std::stoul(optarg);
+                break;
+            case 'l':
+                limit = std::stoull(optarg);
+                break;
+            case 'm':
+                mem_size = std::stoul(optarg, nullptr, 16);
+                break;
+            case 'n':
+                max_len = std::stoul(optarg);
+                break;
+            case 'o':
+                c.out_dir = optarg;
+                break;
+            case 'r':
+                runs = std::stoull(optarg);
+                break;
+            case 's':
+                seed = std::stoull(optarg);
+                break;
+            default:
+                usage();
+        }
+    }
+    if (optind != argc - 1 || threads == 0 || max_len == 0)
+        usage();
+    std::string program;
+    if (!read_file(argv[optind], program))
+        return 1;
+    std::vector<uint8_t> image(program.begin(), program.end());
+    if (!buf_given)
+        buf_addr = (image.size() + 4095) & ~4095u;
+    if (!c.out_dir.empty())
+    {
+        mkdir(c.out_dir.c_str(), 0777);
+        mkdir((c.out_dir + "/queue").c_str(), 0777);
+        mkdir((c.out_dir + "/crashes").c_str(), 0777);
+    }
+    std::vector<std::unique_ptr<fuzzer>> instances;
+    for (uint32_t i = 0; i < threads; i++)
+    {
+        instances.emplace_back(new fuzzer(&c, mem_size, buf_addr, max_len, limit, seed * 0x9e3779b97f4a7c15ull + i));
+        if (!instances.back()->load(image))
+            return 1;
+    }
+    // the seeds go in whatever coverage they have, so the campaign starts from all of them
+    std::vector<std::string> seeds;
+    DIR* dir = seed_dir.empty() ? nullptr : opendir(seed_dir.c_str());
+    if (!seed_dir.empty() && dir == nullptr)
+    {
+        std::cerr << "Can't open directory " << seed_dir << "." << std::endl;
+        return 1;
+    }
+    while (dir != nullptr)
+    {
+        struct dirent* e = readdir(dir);
+        if (e == nullptr)
+        {
+            closedir(dir);
+            break;
+        }
+        std::string data;
+        struct stat st;
+        std::string fname = seed_dir + "/" + e->d_name;
+        if (stat(fname.c_str(), &st) == 0 && S_ISREG(st.st_mode) && read_file(fname, data))
+            seeds.push_back(data);
+    }
+    if (seeds.empty())
+        seeds.push_back("");
+    for (const std::string& s : seeds)
+    {
+        bool interesting;
+        if (instances[0]->execute(s, interesting) == fuzzer::outcome_crash)
+            std::cerr << "A seed crashes the program." << std::endl;
+        c.corpus.push_back(s);
+    }
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    std::atomic<uint32_t> running { threads };
+    for (uint32_t i = 0; i < threads; i++)
+    {
+        uint64_t share = runs / threads + (i < runs % threads ? 1 : 0);
+        fuzzer* f = instances[i].get();
+        workers.emplace_back([f, share, runs, &running]() {
+            if (runs == 0 || share != 0)
+                f->loop(share);
+            running--;
+        });
+    }
+    uint64_t last_execs = 0;
+    auto last = t0;
+    while (running != 0)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        auto now = std::chrono::steady_clock::now();
+        double elapsed = std::chrono::duration<double>(now - t0).count();
+        if (duration != 0 && elapsed >= duration)
+            c.stop = true;
+        if (std::chrono::duration<double>(now - last).count() >= 1.0 || running == 0 || c.stop)
+        {
+            uint64_t execs = c.execs;
+            std::lock_guard<std::mutex> guard(c.lock);
+            std::cout << std::fixed << std::setprecision(0) << elapsed << "s: " << execs << " execs ("
+                      << (execs - last_execs) / std::chrono::duration<double>(now - last).count() << "/s), corpus "
+                      << c.corpus.size() << ", edges " << c.edges << ", crashes " << c.crashes << ", hangs "
+                      << c.hangs << std::endl;
+            last = now;
+            last_execs = execs;
+        }
+    }
+    for (std::thread& t : workers)
+        t.join();
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    std::cout << std::dec << c.execs << " execs in " << std::setprecision(1) << elapsed << " s ("
+              << std::setprecision(0) << c.execs / elapsed << "/s), " << c.crashes << " crashes" << std::endl;
+    return 0;
+}
@@ -0,0 +1,344 @@
+
+#include "fuzzer.h"
+#include <algorithm>
+#include <fstream>
+#include <string.h>
+
+static constexpr uint32_t insn_ebreak = 0x00100073;
+static constexpr uint32_t opcode_branch = 0b1100011;
+static constexpr uint32_t opcode_jal = 0b1101111;
+static constexpr uint32_t opcode_jalr = 0b1100111;
+static constexpr uint64_t sync_interval = 1024; // executions between two fuzzer::sync() calls
+static const uint8_t interesting_bytes[] = { 0x00, 0x01, 0x20, 0x40, 0x7f, 0x80, 0xfe, 0xff };
+
+/**
+ * Bucket of an edge counter, each bucket is one bit so that a run that takes an edge a very
+ * different number of times counts as new coverage (1, 2, 3, 4-7, 8-15, 16-31, 32-127, 128+)
+ * @param uint8_t count (not 0)
+ * @return the bit of the bucket
+ ********************************************************************************/
+static uint8_t bucket(uint8_t count)
+{
+    if (count <= 2)
+        return count;
+    if (count == 3)
+        return 4;
+    if (count < 8)
+        return 8;
+    if (count < 16)
+        return 16;
+    if (count < 32)
+        return 32;
+    return count < 128 ? 64 : 128;
+}
+
+/**
+ * fuzzer constructor
+ * @param campaign* c, uint32_t mem_size, uint32_t buf (guest address of the input),
+ * uint32_t len (longest input), uint64_t lim (instructions per execution), uint64_t seed
+ * @return nothing
+ ********************************************************************************/
+fuzzer::fuzzer(campaign* c, uint32_t mem_size, uint32_t buf, uint32_t len, uint64_t lim, uint64_t seed)
+    : mem(mem_size), hart(&mem), io(&mem, (buf + len + 15) & 0xfffffff0)
+{
+    shared = c;
+    buf_addr = buf;
+    max_len = len;
+    limit = lim;
+    rng = seed != 0 ? seed : 1;
+    trace.assign(map_size, 0);
+    hart.set_hostio(&io);
+    hart.set_output(&discard);
+    mem.set_output(&discard);
+    io.set_output(&discard, &discard);
+}
+
+/**
+ * Load the program under test, the memory as it is now is what every execution starts from
+ * @param const std::vector<uint8_t>& image (loaded at address 0)
+ * @return false if the image or the input buffer does not fit in the memory
+ ********************************************************************************/
+bool fuzzer::load(const std::vector<uint8_t>& image)
+{
+    if (buf_addr > mem.get_size() || max_len > mem.get_size() - buf_addr)
+    {
+        std::cerr << "The input buffer does not fit in the memory." << std::endl;
+        return false;
+    }
+    if (!mem.load_image(image.data(), image.size()))
+    {
+        return false;
+    }
+    mem.snapshot();
+    return true;
+}
+
+/**
+ * Run the program on one input
+ * ebreak and exit(0) end a run normally, any other halt (illegal instruction, exit with another
+ * status, wfi with nothing to wake the hart) is a crash and running into the limit is a hang
+ * @param const std::string& input (cut to the longest input), bool& interesting (set if the run
+ * found coverage no run of the campaign had before)
+ * @return how the run ended
+ ********************************************************************************/
+fuzzer::outcome fuzzer::execute(const std::string& input, bool& interesting)
+{
+    mem.restore();
+    mem.reset_devices();
+    hart.start(); // fresh registers, nothing carries over from the previous input
+    io.reset((buf_addr + max_len + 15) & 0xfffffff0);
+    uint32_t len = std::min<size_t>(input.size(), max_len);
+    if (len != 0)
+    {
+        memcpy(mem.get_ptr(buf_addr, len), input.data(), len);
+    }
+    hart.set_register(10, buf_addr);
+    hart.set_register(11, len);
+    hart.resume_observed(limit, observers);
+    interesting = has_new_bits();
+    for (uint32_t i : touched)
+    {
+        trace[i] = 0;
+    }
+    touched.clear();
+    if (!hart.is_halted())
+    {
+        return outcome_hang;
+    }
+    if (io.has_exited())
+    {
+        return io.get_exit_code() == 0 ? outcome_ok : outcome_crash;
+    }
+    return mem.fetch32(hart.get_pc()) == insn_ebreak ? outcome_ok : outcome_crash;
+}
+
+/**
+ * Fuzz until the campaign is stopped or runs executions were done: take a corpus entry, mutate
+ * it, run it and keep it if it found new coverage. Crashes with new coverage are saved.
+ * @param uint64_t runs (0 = until stopped)
+ * @return none
+ ********************************************************************************/
+void fuzzer::loop(uint64_t runs)
+{
+    for (uint64_t n = 0; (runs == 0 || n < runs) && !shared->stop; n++)
+    {
+        if (n % sync_interval == 0)
+        {
+            sync();
+        }
+        std::string input;
+        if (!corpus.empty())
+        {
+            input = corpus[random_below(corpus.size())];
+        }
+        input = mutate(input);
+        bool interesting;
+        outcome o = execute(input, interesting);
+        unreported++;
+        if (o == outcome_crash)
+        {
+            shared->crashes++;
+            if (interesting)
+            {
+                save("crashes", input);
+            }
+        }
+        else if (o == outcome_hang)
+        {
+            shared->hangs++;
+        }
+        else if (interesting)
+        {
+            {
+                std::lock_guard<std::mutex> guard(shared->lock);
+                shared->corpus.push_back(input);
+            }
+            save("queue", input);
+        }
+    }
+    sync();
+}
+
+/**
+ * Add the executions done since the last call to the campaign's count and pick up the corpus
+ * entries other instances found, the campaign's lock is only taken here and when something new
+ * turns up so that instances on different threads don't slow each other down
+ * @param none
+ * @return none
+ ********************************************************************************/
+void fuzzer::sync()
+{
+    shared->execs += unreported;
+    unreported = 0;
+    std::lock_guard<std::mutex> guard(shared->lock);
+    corpus.insert(corpus.end(), shared->corpus.begin() + corpus.size(), shared->corpus.end());
+}
+
+/**
+ * Next number of the xorshift64 generator
+ * @param none
+ * @return a pseudo-random number
+ ********************************************************************************/
+uint64_t fuzzer::random()
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 7;
+    rng ^= rng << 17;
+    return rng;
+}
+
+/**
+ * Pseudo-random number below n
+ * @param uint32_t n (not 0)
+ * @return a number in 0..n-1
+ ********************************************************************************/
+uint32_t fuzzer::random_below(uint32_t n)
+{
+    return random() % n;
+}
+
+/**
+ * Apply a random stack of 2 to 16 mutations (bit flips, random or interesting bytes, small
+ * additions, inserts, deletes, block copies and splices with another corpus entry)
+ * @param const std::string& input
+ * @return the mutated input, never longer than the longest input
+ ********************************************************************************/
+std::string fuzzer::mutate(const std::string& input)
+{
+    std::string out = input;
+    uint32_t ops = 2u << random_below(4);
+    for (uint32_t i = 0; i < ops; i++)
+    {
+        uint32_t op = out.empty() ? 4 : random_below(8);
+        uint32_t at = out.empty() ? 0 : random_below(out.size());
+        switch (op)
+        {
+            case 0:
+                out[at] ^= 1 << random_below(8);
+                break;
+            case 1:
+                out[at] = random();
+                break;
+            case 2:
+                out[at] = interesting_bytes[random_below(sizeof(interesting_bytes))];
+                break;
+            case 3:
+                out[at] += (random_below(2) ? 1 : -1) * (int)(1 + random_below(35));
+                break;
+            case 4:
+                if (out.size() < max_len)
+                {
+                    out.insert(out.begin() + at, (char)random());
+                }
+                break;
+            case 5:
+                if (out.size() > 1)
+                {
+                    out.erase(at, 1);
+                }
+                break;
+            case 6:
+            {
+                uint32_t from = random_below(out.size());
+                uint32_t len = 1 + random_below(std::min<size_t>(out.size() - std::max(from, at), 16));
+                std::string block = out.substr(from, len);
+                out.replace(at, len, block);
+                break;
+            }
+            case 7:
+                if (!corpus.empty())
+                {
+                    const std::string& other = corpus[random_below(corpus.size())];
+                    if (at < other.size())
+                    {
+                        out = out.substr(0, at) + other.substr(at);
+                    }
+                }
+                break;
+        }
+    }
+    if (out.size() > max_len)
+    {
+        out.resize(max_len);
+    }
+    return out;
+}
+
+/**
+ * Count every control-flow edge taken by a branch (either way), jal or jalr in trace, indexed
+ * by a hash of the source and target pc. The counters stop at 255 and the index of every counter
+ * that goes up from 0 is added to touched, so that only those have to be looked at and cleared.
+ * @param const rv32i* hart, const step_info& s
+ * @return none
+ ********************************************************************************/
+void fuzzer::after(const rv32i*, const step_info& s)
+{
+    uint32_t opcode = s.insn & 0x7f;
+    if (opcode == opcode_branch || opcode == opcode_jal || opcode == opcode_jalr)
+    {
+        uint32_t h = (s.pc >> 1) * 0x9e3779b1u ^ s.next_pc;
+        uint32_t i = (h ^ h >> 16) & (map_size - 1);
+        if (trace[i] == 0)
+        {
+            touched.push_back(i);
+        }
+        if (trace[i] != 255)
+        {
+            trace[i]++;
+        }
+    }
+}
+
+/**
+ * Check the trace of the last run against what the campaign has seen and merge it in
+ * @param none
+ * @return true if some edge was taken for the first time or a very different number of times
+ ********************************************************************************/
+bool fuzzer::has_new_bits()
+{
+    bool found = false;
+    for (uint32_t i : touched)
+    {
+        uint8_t b = bucket(trace[i]);
+        if (!(__atomic_load_n(&shared->virgin[i], __ATOMIC_RELAXED) & b))
+        {
+            continue;
+        }
+        uint8_t old = __atomic_fetch_and(&shared->virgin[i], (uint8_t)~b, __ATOMIC_RELAXED);
+        if (old & b)
+        {
+            found = true;
+            if (old == 0xff)
+            {
+                shared->edges++;
+            }
+        }
+    }
+    return found;
+}
+
+/**
+ * Write an input to a new file in the out_dir/dir directory of the campaign
+ * @param const std::string& dir (queue or crashes), const std::string& input
+ * @return none
+ ********************************************************************************/
+void fuzzer::save(const std::string& dir, const std::string& input)
+{
+    if (shared->out_dir.empty())
+    {
+        return;
+    }
+    std::string fname;
+    {
+        std::lock_guard<std::mutex> guard(shared->lock);
+        std::ostringstream os;
+        os << shared->out_dir << "/" << dir << "/id-" << std::setw(6) << std::setfill('0') << shared->files++;
+        fname = os.str();
+    }
+    std::ofstream out(fname, std::ios::out | std::ios::binary);
+    out.write(input.data(), input.size());
+    if (!out)
+    {
+        std::cerr << "Can't write " << fname << "." << std::endl;
+    }
+}
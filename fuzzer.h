@@ -0,0 +1,67 @@
+
+#ifndef FUZZER_H
+#define FUZZER_H
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "memory.h"
+#include "rv32i.h"
+#include "hostio.h"
+
+/**
+ * Coverage-guided fuzzer for guest code. Each instance owns a memory and a hart and runs one
+ * input at a time: the input is copied to a guest buffer (a0 = its address, a1 = its length),
+ * the hart runs to a halt or the instruction limit with edge coverage on, and the memory is put
+ * back with memory::restore(). Instances on different threads share the coverage seen so far and
+ * the corpus through a campaign.
+ ********************************************************************************/
+class fuzzer : public insn_observer
+{
+public:
+    static constexpr uint32_t map_size = 1 << 16; // edge counters per execution
+    // what the instances of one fuzzing run share
+    struct campaign
+    {
+        std::vector<uint8_t> virgin = std::vector<uint8_t>(map_size, 0xff); // count buckets never seen per edge
+        std::vector<std::string> corpus;
+        std::mutex lock; // guards corpus and files
+        uint64_t files = 0; // names what is written to out_dir
+        std::string out_dir; // queue/ and crashes/ go here, nothing is written when empty
+        std::atomic<uint64_t> execs { 0 };
+        std::atomic<uint64_t> crashes { 0 };
+        std::atomic<uint64_t> hangs { 0 };
+        std::atomic<uint32_t> edges { 0 }; // edges seen at least once
+        std::atomic<bool> stop { false };
+    };
+    // how an execution ended
+    enum outcome { outcome_ok, outcome_crash, outcome_hang };
+    fuzzer(campaign* c, uint32_t mem_size, uint32_t buf_addr, uint32_t max_len, uint64_t limit, uint64_t seed); // constructor prototype
+    bool load(const std::vector<uint8_t>& image);
+    outcome execute(const std::string& input, bool& interesting);
+    void loop(uint64_t runs);
+    void after(const rv32i* hart, const step_info& s) override;
+private:
+    campaign* shared;
+    memory mem;
+    rv32i hart;
+    hostio io; 
+    uint32_t buf_addr; // where inputs go
+    uint32_t max_len; // longest input
+    uint64_t limit; // instructions per execution before it counts as a hang
+    uint64_t rng; // xorshift64 state
+    std::vector<uint8_t> trace; // edge counters of the last execution
+    std::vector<uint32_t> touched; // the counters in trace that are not 0
+    std::vector<insn_observer*> observers { this }; // the hart only reports to after()
+    std::vector<std::string> corpus; // copy of the campaign's corpus, brought up to date now and then
+    uint64_t unreported = 0; // executions not added to the campaign's count yet
+    void sync();
+    std::ostream discard { nullptr }; // has no buffer, what the hart and the guest print is dropped
+    uint64_t random();
+    uint32_t random_below(uint32_t n);
+    std::string mutate(const std::string& input);
+    bool has_new_bits();
+    void save(const std::string& dir, const std::string& input);
+};
+#endif
@@ -0,0 +1,514 @@
+
+#include "gdbstub.h"
+#include "hex.h"
+#include <algorithm>
+#include <ctype.h>
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+static constexpr uint64_t poll_interval = 100000; // instructions between looks for a ^C from gdb
+static constexpr uint32_t reg_pc = 32; // gdb register number of the pc
+static const char* const abi_names[32] = { "zero", "ra", "sp", "gp", "tp", "t0", "t1", "t2", "fp",
+    "s1", "a0", "a1", "a2", "a3", "a4", "a5", "a6", "a7", "s2", "s3", "s4", "s5", "s6", "s7", "s8",
+    "s9", "s10", "s11", "t3", "t4", "t5", "t6" };
+
+/**
+ * Format a 32-bit value the way gdb expects registers, as 8 hex digits in target (little-endian)
+ * byte order
+ * @param uint32_t val
+ * @return the hex string
+ ********************************************************************************/
+static std::string hex_le32(uint32_t val)
+{
+    static const char digits[] = "0123456789abcdef";
+    std::string s;
+    for (int i = 0; i < 4; i++)
+    {
+        s += digits[(val >> (8 * i + 4)) & 0xf];
+        s += digits[(val >> (8 * i)) & 0xf];
+    }
+    return s;
+}
+
+/**
+ * Parse a hex number out of a packet, which can hold anything the other side sent
+ * @param const std::string& s, size_t pos, size_t len (std::string::npos for the rest of s),
+ * uint32_t& val
+ * @return false if the field is empty, has something else than hex digits or does not fit in
+ * 32 bits
+ ********************************************************************************/
+static bool parse_hex(const std::string& s, size_t pos, size_t len, uint32_t& val)
+{
+    if (pos >= s.size())
+        return false;
+    std::string field = s.substr(pos, len);
+    val = 0;
+    for (char c : field)
+    {
+        if (!isxdigit((unsigned char)c) || (val >> 28) != 0)
+            return false;
+        val = (val << 4) | (isdigit((unsigned char)c) ? c - '0' : tolower((unsigned char)c) - 'a' + 10);
+    }
+    return !field.empty();
+}
+
+/**
+ * Parse 8 hex digits in target byte order as written by hex_le32()
+ * @param const std::string& s, size_t pos, uint32_t& val
+ * @return false if there are not 8 hex digits at pos
+ ********************************************************************************/
+static bool parse_le32(const std::string& s, size_t pos, uint32_t& val)
+{
+    if (s.size() < pos + 8)
+        return false;
+    val = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        uint32_t byte;
+        if (!parse_hex(s, pos + 2 * i, 2, byte))
+            return false;
+        val |= byte << (8 * i);
+    }
+    return true;
+}
+
+/**
+ * gdbstub constructor
+ * @param rv32i* h, memory* m, hostio* i (nullptr if there is no syscall proxy), uint64_t l
+ * (execution limit of the whole run, 0 = no limit)
+ * @return nothing
+ ********************************************************************************/
+gdbstub::gdbstub(rv32i* h, memory* m, hostio* i, uint64_t l)
+{
+    hart = h;
+    mem = m;
+    io = i;
+    limit = l;
+}
+
+/**
+ * gdbstub destructor
+ * closes the sockets and removes the Unix socket file
+ * @param none
+ * @return nothing
+ ********************************************************************************/
+gdbstub::~gdbstub()
+{
+    if (fd >= 0)
+        close(fd);
+    if (listen_fd >= 0)
+        close(listen_fd);
+    if (!unix_path.empty())
+        unlink(unix_path.c_str());
+}
+
+/**
+ * Open the socket gdb connects to
+ * a number is a TCP port on the loopback interface, anything else is the path of a Unix socket
+ * (connect with "target remote :port" or "target remote path")
+ * @param const std::string& where
+ * @return false if the socket can't be set up
+ ********************************************************************************/
+bool gdbstub::listen(const std::string& where)
+{
+    bool tcp = !where.empty() && where.find_first_not_of("0123456789") == std::string::npos;
+    if (tcp)
+    {
+        listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+        int one = 1;
+        setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        sockaddr_in sa;
+        memset(&sa, 0, sizeof(sa));
+        sa.sin_family = AF_INET;
+        sa.sin_port = htons(std::stoul(where));
+        sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (listen_fd < 0 || bind(listen_fd, (sockaddr*)&sa, sizeof(sa)) != 0)
+        {
+            std::cerr << "Can't listen on port " << where << ": " << strerror(errno) << std::endl;
+            return false;
+        }
+    }
+    else
+    {
+        listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un sa;
+        memset(&sa, 0, sizeof(sa));
+        sa.sun_family = AF_UNIX;
+        if (where.size() >= sizeof(sa.sun_path))
+        {
+            std::cerr << "Socket path " << where << " is too long." << std::endl;
+            return false;
+        }
+        strcpy(sa.sun_path, where.c_str());
+        unlink(where.c_str());
+        if (listen_fd < 0 || bind(listen_fd, (sockaddr*)&sa, sizeof(sa)) != 0)
+        {
+            std::cerr << "Can't listen on " << where << ": " << strerror(errno) << std::endl;
+            return false;
+        }
+        unix_path = where;
+    }
+    if (::listen(listen_fd, 1) != 0)
+    {
+        std::cerr << "Can't listen on " << where << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    std::cerr << "Waiting for gdb on " << where << std::endl;
+    return true;
+}
+
+/**
+ * Accept one gdb connection and answer its packets until it kills the program, detaches or
+ * goes away
+ * @param none
+ * @return true if the program should run on (detach), false if it was killed
+ ********************************************************************************/
+bool gdbstub::serve()
+{
+    fd = accept(listen_fd, nullptr, nullptr);
+    if (fd < 0)
+    {
+        std::cerr << "accept: " << strerror(errno) << std::endl;
+        return true;
+    }
+    bool done = false;
+    bool keep_running = true;
+    std::string packet;
+    while (!done && get_packet(packet))
+    {
+        std::string reply = handle(packet, done, keep_running);
+        put_packet(reply);
+    }
+    close(fd);
+    fd = -1;
+    return keep_running;
+}
+
+/**
+ * Called from the hart's event queue every poll_interval instructions while it runs, stops the
+ * hart if gdb sent an interrupt (^C)
+ * @param uint64_t now
+ * @return none
+ ********************************************************************************/
+void gdbstub::fire(uint64_t now)
+{
+    pollfd p = { fd, POLLIN, 0 };
+    if (fd >= 0 && poll(&p, 1, 0) > 0)
+    {
+        char c;
+        if (read(fd, &c, 1) != 1 || c == 3)
+        {
+            hart->request_stop();
+        }
+    }
+    hart->schedule_event(now + poll_interval, this);
+}
+
+/**
+ * Read the next packet ($data#checksum) and acknowledge it
+ * @param std::string& packet (the data)
+ * @return false if the connection was closed
+ ********************************************************************************/
+bool gdbstub::get_packet(std::string& packet)
+{
+    char c;
+    for (;;)
+    {
+        do
+        {
+            if (read(fd, &c, 1) != 1)
+                return false;
+        } while (c != '$');
+        packet.clear();
+        uint8_t sum = 0;
+        while (read(fd, &c, 1) == 1 && c != '#')
+        {
+            packet += c;
+            sum += c;
+        }
+        char cksum[3] = { 0, 0, 0 };
+        if (c != '#' || read(fd, cksum, 2) != 2)
+            return false;
+        bool good = std::strtoul(cksum, nullptr, 16) == sum;
+        if (write(fd, good ? "+" : "-", 1) != 1)
+            return false;
+        if (good)
+            return true;
+    }
+}
+
+/**
+ * Send a packet, the '+' gdb sends back is skipped by get_packet()
+ * @param const std::string& data
+ * @return none
+ ********************************************************************************/
+void gdbstub::put_packet(const std::string& data)
+{
+    uint8_t sum = 0;
+    for (char c : data)
+        sum += c;
+    std::string out = "$" + data + "#" + hex8(sum);
+    if (write(fd, out.data(), out.size()) != (ssize_t)out.size())
+    {
+        std::cerr << "gdb connection: " << strerror(errno) << std::endl;
+    }
+}
+
+/**
+ * Answer one packet
+ * @param const std::string& packet, bool& done (set when the session ends), bool& keep_running
+ * (set to false when gdb kills the program)
+ * @return the reply, an empty reply tells gdb the packet is not supported
+ ********************************************************************************/
+std::string gdbstub::handle(const std::string& packet, bool& done, bool& keep_running)
+{
+    if (packet.empty())
+        return "";
+    std::string args = packet.substr(1);
+    switch (packet[0])
+    {
+        case '?':
+            return stop_reply();
+        case 'g':
+        {
+            std::string s;
+            for (uint32_t r = 0; r < 32; r++)
+                s += hex_le32(hart->get_register(r));
+            return s + hex_le32(hart->get_pc());
+        }
+        case 'G':
+        {
+            uint32_t vals[33];
+            for (uint32_t r = 0; r < 33; r++)
+                if (!parse_le32(args, 8 * r, vals[r]))
+                    return "E01";
+            for (uint32_t r = 1; r < 32; r++)
+                hart->set_register(r, vals[r]);
+            hart->set_pc(vals[reg_pc]);
+            return "OK";
+        }
+        case 'p':
+        {
+            uint32_t r;
+            if (!parse_hex(args, 0, std::string::npos, r))
+                return "E01";
+            if (r < 32)
+                return hex_le32(hart->get_register(r));
+            if (r == reg_pc)
+                return hex_le32(hart->get_pc());
+            return "xxxxxxxx";
+        }
+        case 'P':
+        {
+            size_t eq = args.find('=');
+            uint32_t r, val;
+            if (eq == std::string::npos || !parse_hex(args, 0, eq, r) || r > reg_pc
+                || !parse_le32(args, eq + 1, val))
+                return "E01";
+            if (r == reg_pc)
+                hart->set_pc(val);
+            else
+                hart->set_register(r, val);
+            return "OK";
+        }
+        case 'm':
+        {
+            size_t comma = args.find(',');
+            uint32_t addr, len;
+            if (comma == std::string::npos || !parse_hex(args, 0, comma, addr)
+                || !parse_hex(args, comma + 1, std::string::npos, len))
+                return "E01";
+            return read_memory(addr, len);
+        }
+        case 'M':
+        {
+            size_t comma = args.find(',');
+            size_t colon = args.find(':');
+            uint32_t addr, len;
+            if (comma == std::string::npos || colon == std::string::npos || colon < comma
+                || !parse_hex(args, 0, comma, addr) || !parse_hex(args, comma + 1, colon - comma - 1, len))
+                return "E01";
+            return write_memory(addr, len, args.substr(colon + 1));
+        }
+        case 'c':
+        case 's':
+            if (!args.empty())
+            {
+                uint32_t addr;
+                if (!parse_hex(args, 0, std::string::npos, addr))
+                    return "E01";
+                hart->set_pc(addr);
+            }
+            if (packet[0] == 's')
+            {
+                uint64_t next = hart->get_insn_counter() + 1;
+                hart->resume(limit != 0 ? std::min(next, limit) : next);
+            }
+            else
+            {
+                if (!poll_scheduled)
+                {
+                    hart->schedule_event(hart->get_insn_counter() + poll_interval, this);
+                    poll_scheduled = true;
+                }
+                hart->resume(limit);
+            }
+            return stop_reply();
+        case 'Z':
+        case 'z':
+            return breakpoint(packet[0] == 'Z', args);
+        case 'k':
+            done = true;
+            keep_running = false;
+            return "OK";
+        case 'D':
+            done = true;
+            return "OK";
+        case 'H':
+            return "OK"; // there is only one thread
+        case 'q':
+            if (packet.compare(0, 10, "qSupported") == 0)
+                return "PacketSize=1000;qXfer:features:read+";
+            if (packet == "qAttached")
+                return "1";
+            if (packet == "qC")
+                return "QC1";
+            if (packet == "qOffsets")
+                return "Text=0;Data=0;Bss=0";
+            if (packet.compare(0, 31, "qXfer:features:read:target.xml:") == 0)
+            {
+                std::string xml = target_xml();
+                size_t comma = packet.find(',', 31);
+                uint32_t offset, len;
+                if (comma == std::string::npos || !parse_hex(packet, 31, comma - 31, offset)
+                    || !parse_hex(packet, comma + 1, std::string::npos, len))
+                    return "E01";
+                if (offset >= xml.size())
+                    return "l";
+                return ((size_t)offset + len >= xml.size() ? "l" : "m") + xml.substr(offset, len);
+            }
+            return "";
+        default:
+            return "";
+    }
+}
+
+/**
+ * Describe the registers so gdb knows it talks to an RV32 target without being told
+ * @param none
+ * @return the target description
+ ********************************************************************************/
+std::string gdbstub::target_xml() const
+{
+    std::string xml = "<?xml version=\"1.0\"?><!DOCTYPE target SYSTEM \"gdb-target.dtd\">"
+                      "<target version=\"1.0\"><architecture>riscv:rv32</architecture>"
+                      "<feature name=\"org.gnu.gdb.riscv.cpu\">";
+    for (uint32_t r = 0; r < 32; r++)
+    {
+        xml += std::string("<reg name=\"") + abi_names[r] + "\" bitsize=\"32\" type=\"int\"/>";
+    }
+    xml += "<reg name=\"pc\" bitsize=\"32\" type=\"code_ptr\"/></feature></target>";
+    return xml;
+}
+
+/**
+ * Tell gdb why the hart is not running
+ * @param none
+ * @return the stop reply packet
+ ********************************************************************************/
+std::string gdbstub::stop_reply() const
+{
+    if (hart->is_halted())
+    {
+        if (io != nullptr && io->has_exited())
+            return "W" + hex8(io->get_exit_code());
+        return "X05"; // ebreak or an illegal instruction ended the simulation
+    }
+    if (limit != 0 && hart->get_insn_counter() >= limit)
+    {
+        return "X05"; // the execution limit ended the simulation
+    }
+    switch (hart->get_stop_reason())
+    {
+        case rv32i::stop_watchpoint:
+            return std::string("T05") + (hart->get_stop_kind() == memory::watch_read ? "rwatch" : "watch")
+                + ":" + hex32(hart->get_stop_addr()) + ";";
+        case rv32i::stop_request:
+            return "S02";
+        default:
+            return "S05";
+    }
+}
+
+/**
+ * Read len bytes of simulated memory for gdb
+ * devices are left alone so that looking at them has no side effects
+ * @param uint32_t addr, uint32_t len
+ * @return the bytes in hex or an error if none of them is in the memory
+ ********************************************************************************/
+std::string gdbstub::read_memory(uint32_t addr, uint32_t len)
+{
+    std::string s;
+    for (uint32_t i = 0; i < len; i++)
+    {
+        uint8_t* p = mem->get_ptr(addr + i, 1);
+        if (p == nullptr)
+            break;
+        s += hex8(*p);
+    }
+    return s.empty() && len != 0 ? "E01" : s;
+}
+
+/**
+ * Write len bytes of simulated memory for gdb
+ * @param uint32_t addr, uint32_t len, const std::string& data (2 hex digits per byte)
+ * @return OK or an error if the range is not entirely in the memory
+ ********************************************************************************/
+std::string gdbstub::write_memory(uint32_t addr, uint32_t len, const std::string& data)
+{
+    uint8_t* p = mem->get_ptr(addr, len);
+    if (p == nullptr || data.size() < 2 * (size_t)len
+        || data.find_first_not_of("0123456789abcdefABCDEF") < 2 * (size_t)len)
+        return "E01";
+    for (uint32_t i = 0; i < len; i++)
+    {
+        uint32_t byte;
+        parse_hex(data, 2 * i, 2, byte);
+        p[i] = byte;
+    }
+    return "OK";
+}
+
+/**
+ * Insert or remove a breakpoint (types 0 and 1) or a watchpoint (2 write, 3 read, 4 access)
+ * @param bool insert, const std::string& args (type,addr,kind)
+ * @return OK, an error, or empty for unsupported types
+ ********************************************************************************/
+std::string gdbstub::breakpoint(bool insert, const std::string& args)
+{
+    size_t c1 = args.find(',');
+    size_t c2 = args.find(',', c1 + 1);
+    uint32_t type, addr, len;
+    if (c1 == std::string::npos || c2 == std::string::npos || !parse_hex(args, 0, c1, type)
+        || !parse_hex(args, c1 + 1, c2 - c1 - 1, addr) || !parse_hex(args, c2 + 1, std::string::npos, len))
+        return "E01";
+    if (type <= 1)
+    {
+        if (insert)
+            hart->add_breakpoint(addr);
+        else if (!hart->remove_breakpoint(addr))
+            return "E01";
+        return "OK";
+    }
+    if (type > 4)
+        return "";
+    uint32_t kind = type == 2 ? memory::watch_write
+        : type == 3 ? memory::watch_read : memory::watch_read | memory::watch_write;
+    bool ok = insert ? hart->add_watchpoint(addr, len, kind) : hart->remove_watchpoint(addr, len, kind);
+    return ok ? "OK" : "E01";
+}
@@ -0,0 +1,40 @@
+
+#ifndef GDBSTUB_H
+#define GDBSTUB_H
+#include <string>
+#include <stdint.h>
+#include "rv32i.h"
+#include "memory.h"
+#include "hostio.h"
+#include "eventqueue.h"
+/**
+ * GDB remote serial protocol stub for one hart. Listens on a loopback TCP port or a Unix socket,
+ * serves a single debugger connection and drives the hart with rv32i::resume().
+ ********************************************************************************/
+class gdbstub : public event_target
+{
+public:
+    gdbstub(rv32i* h, memory* m, hostio* i, uint64_t l); // constructor prototype
+    ~gdbstub(); // destructor prototype
+    bool listen(const std::string& where); 
+    bool serve(); 
+    void fire(uint64_t now) override; 
+private:
+    rv32i* hart; 
+    memory* mem; 
+    hostio* io; // for the exit code, may be nullptr
+    uint64_t limit; // the hart never runs past this instruction count (0 = no limit)
+    int listen_fd = -1; 
+    int fd = -1; // the debugger connection
+    std::string unix_path; // socket file to remove when done
+    bool poll_scheduled = false; // fire() is in the hart's event queue
+    bool get_packet(std::string& packet); 
+    void put_packet(const std::string& data); 
+    std::string handle(const std::string& packet, bool& done, bool& keep_running); 
+    std::string target_xml() const; 
+    std::string stop_reply() const; 
+    std::string read_memory(uint32_t addr, uint32_t len); 
+    std::string write_memory(uint32_t addr, uint32_t len, const std::string& data); 
+    std::string breakpoint(bool insert, const std::string& args); 
+};
+#endif
@@ -46,3 +46,24 @@ std::string hex0x32(uint32_t i)
 {
     return std::string("0x") + hex32(i);
 }
+/**
+* string hex64(uint64_t i) takes an uint64_t i and prints the 16 hex digits of the argument i,
+* used for the registers of an RV64 hart
+* @param x uint64_t i
+* @return 16 hex digits of argument i
+*************************************************************************************************************/
+std::string hex64(uint64_t i)
+{
+    std::ostringstream os;
+    os << std::hex << std::setfill('0') << std::setw(16) << i;
+    return os.str();
+}
+/**
+* string hex0x64(uint64_t i) prints "0x" and the 16 hex digits of the argument i
+* @param x uint64_t i
+* @return 16 hex digits of argument i with string"0x"in front
+*************************************************************************************************************/
+std::string hex0x64(uint64_t i)
+{
+    return std::string("0x") + hex64(i);
+}
@@ -9,5 +9,7 @@
 std::string hex8(uint8_t i); 
 std::string hex32(uint32_t i); 
 std::string hex0x32(uint32_t i); 
+std::string hex64(uint64_t i); 
+std::string hex0x64(uint64_t i); 
 
 #endif
@@ -0,0 +1,528 @@
+
+#include "hostio.h"
+#include <algorithm>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+static constexpr size_t out_buf_limit = 64 * 1024; // flush guest stdout when this much is buffered
+static constexpr int32_t at_fdcwd = -100; // AT_FDCWD as seen by the guest
+// open flags as defined by the Linux asm-generic ABI used by RISC-V
+static constexpr uint32_t guest_o_accmode = 03;
+static constexpr uint32_t guest_o_creat = 0100;
+static constexpr uint32_t guest_o_excl = 0200;
+static constexpr uint32_t guest_o_trunc = 01000;
+static constexpr uint32_t guest_o_append = 02000;
+
+/**
+ * hostio constructor
+ * Remembers the guest memory and sets the initial program break, which is normally the end
+ * of the loaded image.
+ * @param memory* m, uint32_t brk
+ * @return nothing
+ * @note
+ * @warning
+ * @bug
+ ********************************************************************************/
+hostio::hostio(memory* m, uint32_t brk)
+{
+    mem = m;
+    initial_brk = brk;
+    cur_brk = brk;
+    out_buf.reserve(out_buf_limit);
+}
+
+/**
+ * hostio destructor
+ * makes sure nothing the guest wrote to stdout is lost
+ * @param none
+ * @return nothing
+ ********************************************************************************/
+hostio::~hostio()
+{
+    flush();
+    close_files();
+}
+
+/**
+ * Execute a guest system call
+ * Dispatches on the syscall number (a7) and returns the value the guest sees in a0. Failing
+ * calls return -errno like the Linux kernel does, unknown calls return -ENOSYS. All buffers
+ * are used in place in the simulated memory so read() and write() don't copy anything.
+ * @param uint32_t nr, const uint64_t* args (a0-a5)
+ * @return the syscall result
+ * @note
+ * @warning
+ * @bug
+ ********************************************************************************/
+int64_t hostio::call(uint32_t nr, const uint64_t* args)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    written.clear();
+    switch (nr)
+    {
+        default:
+            return -ENOSYS;
+        case sys_openat:
+            return do_openat(args);
+        case sys_close:
+            return do_close(args);
+        case sys_lseek:
+            return do_lseek(args);
+        case sys_read:
+            return do_read(args);
+        case sys_write:
+            return do_write(args);
+        case sys_fstat:
+            return do_fstat(args);
+        case sys_brk:
+            return do_brk(args);
+        case sys_clock_gettime:
+            return do_clock_gettime(args, false);
+        case sys_clock_gettime64:
+            return do_clock_gettime(args, true);
+        case sys_exit:
+        case sys_exit_group:
+            exited = true;
+            exit_code = args[0];
+            return 0;
+    }
+}
+
+/**
+ * Select the ABI of the guest, rv32i guests use the ILP32 layouts and rv64i guests the LP64 ones
+ * (64-bit lseek offsets, the 128-byte struct stat and the 16-byte timespec)
+ * @param bool on (true for LP64)
+ * @return none
+ ********************************************************************************/
+void hostio::set_lp64(bool on)
+{
+    lp64 = on;
+}
+
+/**
+ * Flush the buffered guest stdout
+ * @param none
+ * @return none
+ ********************************************************************************/
+void hostio::flush()
+{
+    if (!out_buf.empty())
+    {
+        std::ostream& os = out != nullptr ? *out : std::cout;
+        os.write(out_buf.data(), out_buf.size());
+        os.flush();
+        out_buf.clear();
+    }
+}
+
+/**
+ * Close every file the guest opened and did not close itself
+ * @param none
+ * @return none
+ ********************************************************************************/
+void hostio::close_files()
+{
+    for (int fd : files)
+    {
+        if (fd != -1)
+        {
+            ::close(fd);
+        }
+    }
+    files.clear();
+}
+
+/**
+ * Forget everything a previous run did (exit status, program break, unflushed stdout, open
+ * files) so that the next run starts like a new process. A fuzzing campaign resets once per
+ * input, so files a crashing guest left open must not pile up until the host runs out of fds.
+ * @param uint32_t brk (lowest legal program break)
+ * @return none
+ ********************************************************************************/
+void hostio::reset(uint32_t brk)
+{
+    initial_brk = brk;
+    cur_brk = brk;
+    exited = false;
+    exit_code = 0;
+    out_buf.clear();
+    close_files();
+}
+
+/**
+ * Send the guest's stdout and stderr somewhere else than the host's
+ * @param std::ostream* out, std::ostream* err (nullptr for the host's stdout or stderr)
+ * @return none
+ ********************************************************************************/
+void hostio::set_output(std::ostream* o, std::ostream* e)
+{
+    flush();
+    out = o;
+    err = e;
+}
+
+/**
+ * getter has_exited
+ * @param none
+ * @return true once the guest called exit or exit_group
+ ********************************************************************************/
+bool hostio::has_exited() const
+{
+    return exited;
+}
+
+/**
+ * getter get_exit_code
+ * @param none
+ * @return the status the guest passed to exit
+ ********************************************************************************/
+int32_t hostio::get_exit_code() const
+{
+    return exit_code;
+}
+
+/**
+ * getter get_written
+ * lets a recorder save what a read(), fstat() or clock_gettime() put into guest memory
+ * @param none
+ * @return the pieces of guest memory written by the last call
+ ********************************************************************************/
+const std::vector<hostio::guest_range>& hostio::get_written() const
+{
+    return written;
+}
+
+/**
+ * The host fd behind a guest fd
+ * guest fds 0, 1 and 2 are the host's, the others are the ones openat() handed out
+ * @param int32_t fd
+ * @return the host fd, -1 if the guest has no such fd open
+ ********************************************************************************/
+int hostio::host_fd(int32_t fd) const
+{
+    if (fd >= 0 && fd <= 2)
+    {
+        return fd;
+    }
+    if (fd < 3 || (uint32_t)(fd - 3) >= files.size())
+    {
+        return -1;
+    }
+    return files[fd - 3];
+}
+
+/**
+ * The host address of a guest buffer
+ * @param uint64_t addr, uint64_t len
+ * @return nullptr if any of the len bytes at addr is outside the simulated memory
+ ********************************************************************************/
+uint8_t* hostio::guest_ptr(uint64_t addr, uint64_t len) const
+{
+    if (addr > 0xffffffffu || len > 0xffffffffu)
+    {
+        return nullptr;
+    }
+    return mem->get_ptr(addr, len);
+}
+
+/**
+ * openat(dirfd, path, flags, mode)
+ * The path has to be NUL terminated inside the simulated memory. The open flags are
+ * translated from the guest ABI values to the host ones. The guest gets the lowest free guest
+ * fd, not the host one.
+ * @param const uint64_t* args
+ * @return a guest file descriptor or -errno
+ ********************************************************************************/
+int32_t hostio::do_openat(const uint64_t* args)
+{
+    uint64_t addr = args[1];
+    std::string path;
+    for (;;)
+    {
+        const uint8_t* p = guest_ptr(addr, 1);
+        if (p == nullptr)
+        {
+            return -EFAULT;
+        }
+        if (*p == 0)
+        {
+            break;
+        }
+        path += (char)*p;
+        addr++;
+    }
+    uint32_t gflags = args[2];
+    int flags = (gflags & guest_o_accmode) == 1 ? O_WRONLY
+        : (gflags & guest_o_accmode) == 2       ? O_RDWR
+                                                : O_RDONLY;
+    if (gflags & guest_o_creat)
+        flags |= O_CREAT;
+    if (gflags & guest_o_excl)
+        flags |= O_EXCL;
+    if (gflags & guest_o_trunc)
+        flags |= O_TRUNC;
+    if (gflags & guest_o_append)
+        flags |= O_APPEND;
+    int dirfd = ((int32_t)args[0] == at_fdcwd) ? AT_FDCWD : host_fd(args[0]);
+    if (dirfd == -1)
+    {
+        return -EBADF;
+    }
+    int fd = ::openat(dirfd, path.c_str(), flags, (mode_t)args[3]);
+    if (fd < 0)
+    {
+        return -errno;
+    }
+    uint32_t i = std::find(files.begin(), files.end(), -1) - files.begin();
+    if (i == files.size())
+    {
+        files.push_back(fd);
+    }
+    else
+    {
+        files[i] = fd;
+    }
+    return i + 3;
+}
+
+/**
+ * close(fd)
+ * closing stdin, stdout or stderr is accepted but does not close the simulator's streams
+ * @param const uint64_t* args
+ * @return 0 or -errno
+ ********************************************************************************/
+int32_t hostio::do_close(const uint64_t* args)
+{
+    int32_t fd = args[0];
+    int hfd = host_fd(fd);
+    if (hfd == -1)
+    {
+        return -EBADF;
+    }
+    if (fd <= 2)
+    {
+        return 0;
+    }
+    files[fd - 3] = -1;
+    return ::close(hfd) < 0 ? -errno : 0;
+}
+
+/**
+ * lseek(fd, offset, whence)
+ * the offset is a long, 32 bits for rv32i guests and 64 bits for rv64i ones. SEEK_SET/CUR/END
+ * have the same values on the host.
+ * @param const uint64_t* args
+ * @return the new offset or -errno
+ ********************************************************************************/
+int64_t hostio::do_lseek(const uint64_t* args)
+{
+    int fd = host_fd(args[0]);
+    if (fd == -1)
+    {
+        return -EBADF;
+    }
+    off_t off = ::lseek(fd, lp64 ? (int64_t)args[1] : (int32_t)args[1], (int32_t)args[2]);
+    if (off < 0)
+    {
+        return -errno;
+    }
+    return lp64 ? (int64_t)off : (int32_t)off;
+}
+
+/**
+ * read(fd, buf, count)
+ * reads straight into the simulated memory. Reading stdin flushes the guest stdout first so
+ * prompts show up before the program blocks.
+ * @param const uint64_t* args
+ * @return number of bytes read or -errno
+ ********************************************************************************/
+int32_t hostio::do_read(const uint64_t* args)
+{
+    int fd = host_fd(args[0]);
+    if (fd == -1)
+    {
+        return -EBADF;
+    }
+    uint8_t* p = guest_ptr(args[1], args[2]);
+    if (p == nullptr)
+    {
+        return -EFAULT;
+    }
+    if (args[0] == 0)
+    {
+        flush();
+    }
+    ssize_t n = ::read(fd, p, args[2]);
+    if (n < 0)
+    {
+        return -errno;
+    }
+    written.push_back(guest_range { (uint32_t)args[1], (uint32_t)n });
+    return n;
+}
+
+/**
+ * write(fd, buf, count)
+ * stdout is collected in out_buf and written out in large chunks, stderr flushes stdout and
+ * is written through immediately (to err if set), anything else goes straight to the host file.
+ * @param const uint64_t* args
+ * @return number of bytes written or -errno
+ ********************************************************************************/
+int32_t hostio::do_write(const uint64_t* args)
+{
+    int fd = host_fd(args[0]);
+    if (fd == -1)
+    {
+        return -EBADF;
+    }
+    const uint8_t* p = guest_ptr(args[1], args[2]);
+    if (p == nullptr)
+    {
+        return -EFAULT;
+    }
+    if (args[0] == 1)
+    {
+        out_buf.append(reinterpret_cast<const char*>(p), args[2]);
+        if (out_buf.size() >= out_buf_limit)
+        {
+            flush();
+        }
+        return args[2];
+    }
+    if (args[0] == 2)
+    {
+        flush();
+        if (err != nullptr)
+        {
+            err->write(reinterpret_cast<const char*>(p), args[2]);
+            err->flush();
+            return args[2];
+        }
+    }
+    ssize_t n = ::write(fd, p, args[2]);
+    return n < 0 ? -errno : (int32_t)n;
+}
+
+/**
+ * fstat(fd, statbuf)
+ * fills in the 80-byte struct stat of the 32-bit Linux asm-generic ABI, or the 128-byte one of
+ * the 64-bit ABI for rv64i guests
+ * @param const uint64_t* args
+ * @return 0 or -errno
+ ********************************************************************************/
+int32_t hostio::do_fstat(const uint64_t* args)
+{
+    struct stat st;
+    int fd = host_fd(args[0]);
+    if (fd == -1)
+    {
+        return -EBADF;
+    }
+    if (::fstat(fd, &st) < 0)
+    {
+        return -errno;
+    }
+    uint32_t len = lp64 ? 128 : 80;
+    if (guest_ptr(args[1], len) == nullptr)
+    {
+        return -EFAULT;
+    }
+    uint32_t buf = args[1];
+    if (lp64)
+    {
+        for (uint32_t i = 0; i < len; i += 8)
+        {
+            mem->set64(buf + i, 0);
+        }
+        mem->set64(buf + 0, st.st_dev);
+        mem->set64(buf + 8, st.st_ino);
+        mem->set32(buf + 16, st.st_mode);
+        mem->set32(buf + 20, st.st_nlink);
+        mem->set32(buf + 24, st.st_uid);
+        mem->set32(buf + 28, st.st_gid);
+        mem->set64(buf + 32, st.st_rdev);
+        mem->set64(buf + 48, st.st_size);
+        mem->set32(buf + 56, st.st_blksize);
+        mem->set64(buf + 64, st.st_blocks);
+        mem->set64(buf + 72, st.st_atime);
+        mem->set64(buf + 88, st.st_mtime);
+        mem->set64(buf + 104, st.st_ctime);
+        written.push_back(guest_range { buf, len });
+        return 0;
+    }
+    for (uint32_t i = 0; i < 80; i += 4)
+    {
+        mem->set32(buf + i, 0);
+    }
+    mem->set32(buf + 0, st.st_dev);
+    mem->set32(buf + 4, st.st_ino);
+    mem->set32(buf + 8, st.st_mode);
+    mem->set32(buf + 12, st.st_nlink);
+    mem->set32(buf + 16, st.st_uid);
+    mem->set32(buf + 20, st.st_gid);
+    mem->set32(buf + 24, st.st_rdev);
+    mem->set32(buf + 32, st.st_size);
+    mem->set32(buf + 36, st.st_blksize);
+    mem->set32(buf + 44, st.st_blocks);
+    mem->set32(buf + 48, st.st_atime);
+    mem->set32(buf + 56, st.st_mtime);
+    mem->set32(buf + 64, st.st_ctime);
+    written.push_back(guest_range { buf, 80 });
+    return 0;
+}
+
+/**
+ * brk(addr)
+ * moves the program break if addr is between the end of the image and the end of the
+ * simulated memory, brk(0) just returns the current break
+ * @param const uint64_t* args
+ * @return the (possibly unchanged) program break
+ ********************************************************************************/
+int32_t hostio::do_brk(const uint64_t* args)
+{
+    if (args[0] >= initial_brk && args[0] <= mem->get_size())
+    {
+        cur_brk = args[0];
+    }
+    return cur_brk;
+}
+
+/**
+ * clock_gettime(clock, tp)
+ * the guest clock ids 0 (realtime) and 1 (monotonic) match the host ones. time64 (and every
+ * rv64i guest) gets the 16-byte __kernel_timespec layout, otherwise the 8-byte 32-bit one is
+ * written.
+ * @param const uint64_t* args, bool time64
+ * @return 0 or -errno
+ ********************************************************************************/
+int32_t hostio::do_clock_gettime(const uint64_t* args, bool time64)
+{
+    struct timespec ts;
+    if (::clock_gettime((int32_t)args[0] == 1 ? CLOCK_MONOTONIC : CLOCK_REALTIME, &ts) < 0)
+    {
+        return -errno;
+    }
+    time64 = time64 || lp64;
+    if (guest_ptr(args[1], time64 ? 16 : 8) == nullptr)
+    {
+        return -EFAULT;
+    }
+    uint32_t tp = args[1];
+    if (time64)
+    {
+        mem->set32(tp, (uint64_t)ts.tv_sec);
+        mem->set32(tp + 4, (uint64_t)ts.tv_sec >> 32);
+        mem->set32(tp + 8, ts.tv_nsec);
+        mem->set32(tp + 12, 0);
+    }
+    else
+    {
+        mem->set32(tp, ts.tv_sec);
+        mem->set32(tp + 4, ts.tv_nsec);
+    }
+    written.push_back(guest_range { tp, time64 ? 16u : 8u });
+    return 0;
+}
@@ -0,0 +1,67 @@
+
+#ifndef HOSTIO_H
+#define HOSTIO_H
+#include <atomic>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "memory.h"
+class hostio
+{
+public:
+    // syscall numbers of the Linux/newlib RISC-V ABI (a7 holds the number)
+    static constexpr uint32_t sys_openat = 56; 
+    static constexpr uint32_t sys_close = 57; 
+    static constexpr uint32_t sys_lseek = 62; 
+    static constexpr uint32_t sys_read = 63; 
+    static constexpr uint32_t sys_write = 64; 
+    static constexpr uint32_t sys_fstat = 80; 
+    static constexpr uint32_t sys_exit = 93; 
+    static constexpr uint32_t sys_exit_group = 94; 
+    static constexpr uint32_t sys_clock_gettime = 113; 
+    static constexpr uint32_t sys_brk = 214; 
+    static constexpr uint32_t sys_clock_gettime64 = 403; 
+    // a piece of guest memory written by the last call
+    struct guest_range
+    {
+        uint32_t addr; 
+        uint32_t len; 
+    };
+    hostio(memory* m, uint32_t brk); // constructor prototype
+    ~hostio(); // destructor prototype
+    int64_t call(uint32_t nr, const uint64_t* args); 
+    void set_lp64(bool on); 
+    void flush(); 
+    void reset(uint32_t brk); 
+    void set_output(std::ostream* out, std::ostream* err); 
+    bool has_exited() const; 
+    int32_t get_exit_code() const; 
+    const std::vector<guest_range>& get_written() const; 
+private:
+    int32_t do_openat(const uint64_t* args); 
+    int32_t do_close(const uint64_t* args); 
+    int64_t do_lseek(const uint64_t* args); 
+    int32_t do_read(const uint64_t* args); 
+    int32_t do_write(const uint64_t* args); 
+    int32_t do_fstat(const uint64_t* args); 
+    int32_t do_brk(const uint64_t* args); 
+    int32_t do_clock_gettime(const uint64_t* args, bool time64); 
+    int host_fd(int32_t fd) const; 
+    uint8_t* guest_ptr(uint64_t addr, uint64_t len) const; 
+    void close_files(); 
+    memory* mem; // guest memory the buffers live in
+    bool lp64 = false; // the guest is rv64i, longs and pointers are 64 bits wide
+    uint32_t initial_brk; // lowest legal program break (end of the loaded image)
+    uint32_t cur_brk; // current program break
+    std::atomic<bool> exited { false }; // set by exit/exit_group, other harts look at it
+    int32_t exit_code = 0; // status passed to exit/exit_group
+    std::string out_buf; // buffered guest stdout
+    std::ostream* out = nullptr; // guest stdout goes here, std::cout when nullptr
+    std::ostream* err = nullptr; // guest stderr goes here, host fd 2 when nullptr
+    std::vector<guest_range> written; // filled in by the call that just returned
+    std::vector<int> files; // host fd behind guest fd 3 + i, -1 when closed
+    std::mutex lock; // harts on different host threads share one hostio
+};
+#endif
@@ -0,0 +1,50 @@
+
+#include "insnobserver.h"
+
+/**
+ * insn_observer destructor
+ * @param none
+ * @return nothing
+ ********************************************************************************/
+insn_observer::~insn_observer()
+{
+}
+
+/**
+ * Called once before the hart runs the first instruction, after rv32i::start()
+ * @param rv32i* hart
+ * @return none
+ ********************************************************************************/
+void insn_observer::begin(rv32i*)
+{
+}
+
+/**
+ * Called before the instruction runs, interrupts have been taken already so it is the one that
+ * runs next. The default does nothing.
+ * @param rv32i* hart, const step_info& s
+ * @return true to stop the run without executing the instruction, the default never stops
+ ********************************************************************************/
+bool insn_observer::before(rv32i*, const step_info&)
+{
+    return false;
+}
+
+/**
+ * Called after the instruction retired (not after a fetch that faulted). The default does
+ * nothing.
+ * @param const rv32i* hart, const step_info& s
+ * @return none
+ ********************************************************************************/
+void insn_observer::after(const rv32i*, const step_info&)
+{
+}
+
+/**
+ * Called once when the run is over, before rv32i::finish()
+ * @param rv32i* hart
+ * @return none
+ ********************************************************************************/
+void insn_observer::end(rv32i*)
+{
+}
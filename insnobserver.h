@@ -0,0 +1,32 @@
+
+#ifndef INSNOBSERVER_H
+#define INSNOBSERVER_H
+#include <stdint.h>
+template<uint32_t XLEN> class rvhart;
+typedef rvhart<32> rv32i;
+/**
+ * Something that looks at every instruction rv32i::resume_observed() executes: the coverage
+ * bitmaps, the register and instruction traces, the trace filter, the reuse analyzer and the
+ * SimPoint profiler. One run loop serves any mix of them, each observer is called in the order
+ * it was given, before() ahead of the instruction and after() once it has retired.
+ ********************************************************************************/
+class insn_observer
+{
+public:
+    // the instruction being executed
+    struct step_info
+    {
+        uint32_t pc; // where it is
+        uint32_t insn; 
+        uint32_t data_addr; // what a load, store or AMO accesses (rs1 + offset), rs1 for the rest
+        uint32_t next_pc; // where the hart went on, only set for after()
+    };
+    virtual ~insn_observer(); 
+    // begin(), before() and end() may change how the hart shows what it does, after() only looks.
+    // before() returns true to stop the run ahead of the instruction.
+    virtual void begin(rv32i* hart); 
+    virtual bool before(rv32i* hart, const step_info& s); 
+    virtual void after(const rv32i* hart, const step_info& s); 
+    virtual void end(rv32i* hart); 
+};
+#endif
@@ -0,0 +1,383 @@
+
+#include "insntrace.h"
+#include "rv32i.h"
+#include "lzblock.h"
+#include <string.h>
+
+static const char magic[] = "RV32ITR1"; // first bytes of a trace
+static constexpr size_t record_max = 256; // longest record, a block is cut before it could overflow
+
+/**
+ * Append v to s as an unsigned LEB128 number
+ * @param std::string& s, uint64_t v
+ * @return none
+ ********************************************************************************/
+static void append_leb(std::string& s, uint64_t v)
+{
+    while (v >= 0x80)
+    {
+        s += (char)(v | 0x80);
+        v >>= 7;
+    }
+    s += (char)v;
+}
+
+/**
+ * Read an unsigned LEB128 number from in
+ * @param std::istream& in, uint32_t& v
+ * @return false if the file ends first
+ ********************************************************************************/
+static bool read_leb(std::istream& in, uint32_t& v)
+{
+    v = 0;
+    for (uint32_t shift = 0; shift < 35; shift += 7)
+    {
+        int c = in.get();
+        if (c == EOF)
+            return false;
+        v |= (uint32_t)(c & 0x7f) << shift;
+        if (!(c & 0x80))
+            return true;
+    }
+    return false;
+}
+
+/**
+ * insntrace destructor
+ * writes out the last block
+ * @param none
+ * @return nothing
+ ********************************************************************************/
+insntrace::~insntrace()
+{
+    end(nullptr);
+}
+
+/**
+ * Create the trace file (truncated)
+ * @param const std::string& fname
+ * @return false if the file can't be created
+ ********************************************************************************/
+bool insntrace::open(const std::string& fname)
+{
+    file.open(fname, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        std::cerr << "Can't open file " << fname << " for writing." << std::endl;
+        return false;
+    }
+    file.write(magic, 8);
+    writing = true;
+    return true;
+}
+
+/**
+ * Record where the hart starts: its pc and all its registers
+ * @param rv32i* hart
+ * @return none
+ ********************************************************************************/
+void insntrace::begin(rv32i* hart)
+{
+    index = hart->get_insn_counter();
+    next_pc = hart->get_pc();
+    put((uint32_t)index);
+    put(next_pc);
+    for (uint32_t r = 0; r < 32; r++)
+    {
+        shadow[r] = hart->get_register(r);
+        put(shadow[r]);
+    }
+}
+
+/**
+ * Record the instruction that just executed
+ * @param const rv32i* hart, const step_info& s
+ * @return none
+ ********************************************************************************/
+void insntrace::after(const rv32i* hart, const step_info& s)
+{
+    uint32_t pc = s.pc;
+    uint32_t insn = s.insn;
+    size_t at = raw.size();
+    uint8_t flags = 0;
+    raw += (char)0; // filled in below
+    if (pc != next_pc)
+    {
+        flags |= flag_jump;
+        put_delta(pc, next_pc);
+    }
+    next_pc = pc + 4;
+    uint32_t& cached = cache[(pc >> 2) & (cache_size - 1)];
+    if (cached != insn)
+    {
+        flags |= flag_insn;
+        raw.append(reinterpret_cast<const char*>(&insn), 4);
+        cached = insn;
+    }
+    if ((insn & 0x7f) == 0b1110011 && (insn & 0x7000) == 0)
+    {
+        // ecall and friends may change any register
+        size_t count_at = raw.size();
+        raw += (char)0;
+        uint32_t count = 0;
+        for (uint32_t r = 1; r < 32; r++)
+        {
+            uint32_t val = hart->get_register(r);
+            if (val != shadow[r])
+            {
+                raw += (char)r;
+                put_delta(val, shadow[r]);
+                shadow[r] = val;
+                count++;
+            }
+        }
+        if (count != 0)
+        {
+            flags |= flag_regs;
+            raw[count_at] = (char)count;
+        }
+        else
+        {
+            raw.resize(count_at);
+        }
+    }
+    else
+    {
+        uint32_t rd = rv32i::get_rd(insn);
+        uint32_t val = hart->get_register(rd);
+        if (val != shadow[rd])
+        {
+            flags |= flag_rd;
+            put_delta(val, shadow[rd]);
+            shadow[rd] = val;
+        }
+    }
+    raw[at] = (char)flags;
+    if (raw.size() + record_max > lzblock::max_block)
+    {
+        flush();
+    }
+}
+
+/**
+ * Write out the last block, a trace is complete once this has been called
+ * @param rv32i* hart (not used)
+ * @return none
+ ********************************************************************************/
+void insntrace::end(rv32i*)
+{
+    if (writing)
+    {
+        flush();
+        file.flush();
+    }
+}
+
+/**
+ * Open a trace for reading and load the start of the run
+ * @param const std::string& fname
+ * @return false if the file can't be read or is not an instruction trace
+ ********************************************************************************/
+bool insntrace::open_read(const std::string& fname)
+{
+    file.open(fname, std::ios::in | std::ios::binary);
+    if (!file)
+    {
+        std::cerr << "Can't open file " << fname << " for reading." << std::endl;
+        return false;
+    }
+    char head[8];
+    file.read(head, 8);
+    uint32_t first;
+    if (!file || memcmp(head, magic, 8) != 0 || !read_block() || !get(first) || !get(next_pc))
+    {
+        std::cerr << fname << " is not an instruction trace." << std::endl;
+        return false;
+    }
+    index = first;
+    for (uint32_t r = 0; r < 32; r++)
+    {
+        get(shadow[r]);
+    }
+    return !bad;
+}
+
+/**
+ * Decode the next record
+ * @param entry& e
+ * @return false at the end of the trace or if it is corrupt (see failed())
+ ********************************************************************************/
+bool insntrace::next(entry& e)
+{
+    if (pos >= raw.size() && !read_block())
+    {
+        return false;
+    }
+    uint8_t flags = raw[pos++];
+    uint32_t pc = next_pc;
+    if (flags & flag_jump)
+    {
+        get_delta(pc);
+    }
+    next_pc = pc + 4;
+    uint32_t& cached = cache[(pc >> 2) & (cache_size - 1)];
+    if (flags & flag_insn)
+    {
+        if (raw.size() - pos < 4)
+        {
+            bad = true;
+            return false;
+        }
+        memcpy(&cached, &raw[pos], 4);
+        pos += 4;
+    }
+    e.index = index++;
+    e.pc = pc;
+    e.insn = cached;
+    uint32_t opcode = e.insn & 0x7f;
+    e.access = opcode == 0b0000011 || opcode == 0b0100011 || opcode == 0b0101111;
+    e.addr = shadow[rv32i::get_rs1(e.insn)];
+    if (opcode == 0b0000011)
+        e.addr += rv32i::get_imm_i(e.insn);
+    else if (opcode == 0b0100011)
+        e.addr += rv32i::get_imm_s(e.insn);
+    e.changed = 0;
+    if (flags & flag_rd)
+    {
+        uint32_t rd = rv32i::get_rd(e.insn);
+        get_delta(shadow[rd]);
+        e.changed |= 1u << rd;
+    }
+    if ((flags & flag_regs) && pos < raw.size())
+    {
+        uint32_t count = (uint8_t)raw[pos++];
+        for (uint32_t i = 0; i < count && pos < raw.size(); i++)
+        {
+            uint32_t r = (uint8_t)raw[pos++] & 31;
+            get_delta(shadow[r]);
+            e.changed |= 1u << r;
+        }
+    }
+    memcpy(e.regs, shadow, sizeof(shadow));
+    return !bad;
+}
+
+/**
+ * getter failed
+ * @param none
+ * @return true if the trace turned out to be corrupt or truncated
+ ********************************************************************************/
+bool insntrace::failed() const
+{
+    return bad;
+}
+
+/**
+ * Append v as an unsigned LEB128 number
+ * @param uint32_t v
+ * @return none
+ ********************************************************************************/
+void insntrace::put(uint32_t v)
+{
+    append_leb(raw, v);
+}
+
+/**
+ * Append v - old, zigzag encoded so that small steps back stay short too
+ * @param uint32_t v, uint32_t old
+ * @return none
+ ********************************************************************************/
+void insntrace::put_delta(uint32_t v, uint32_t old)
+{
+    int32_t d = v - old;
+    put(((uint32_t)d << 1) ^ (uint32_t)(d >> 31));
+}
+
+/**
+ * Compress the records of the current block and write them out, preceded by the raw and the
+ * compressed size
+ * @param none
+ * @return none
+ ********************************************************************************/
+void insntrace::flush()
+{
+    if (raw.empty())
+    {
+        return;
+    }
+    packed.clear();
+    lzblock::compress(reinterpret_cast<const uint8_t*>(raw.data()), raw.size(), packed);
+    std::string head;
+    append_leb(head, raw.size());
+    append_leb(head, packed.size());
+    file.write(head.data(), head.size());
+    file.write(packed.data(), packed.size());
+    raw.clear();
+}
+
+/**
+ * Read the LEB128 number at the current position
+ * @param uint32_t& v
+ * @return false (and the trace is marked bad) at the end of the block
+ ********************************************************************************/
+bool insntrace::get(uint32_t& v)
+{
+    v = 0;
+    for (uint32_t shift = 0; pos < raw.size() && shift < 35; shift += 7)
+    {
+        uint8_t b = raw[pos++];
+        v |= (uint32_t)(b & 0x7f) << shift;
+        if (!(b & 0x80))
+        {
+            return true;
+        }
+    }
+    bad = true;
+    return false;
+}
+
+/**
+ * Read a zigzag delta and add it to v
+ * @param uint32_t& v
+ * @return false at the end of the block
+ ********************************************************************************/
+bool insntrace::get_delta(uint32_t& v)
+{
+    uint32_t z;
+    if (!get(z))
+    {
+        return false;
+    }
+    v += (z >> 1) ^ -(z & 1);
+    return true;
+}
+
+/**
+ * Read the next block from the file and decompress it into raw
+ * @param none
+ * @return false at the end of the file (the trace is marked bad if it is cut short or corrupt)
+ ********************************************************************************/
+bool insntrace::read_block()
+{
+    uint32_t raw_len, packed_len;
+    if (file.peek() == EOF)
+    {
+        return false;
+    }
+    if (!read_leb(file, raw_len) || !read_leb(file, packed_len) || raw_len > lzblock::max_block || raw_len == 0)
+    {
+        bad = true;
+        return false;
+    }
+    packed.resize(packed_len);
+    raw.resize(raw_len);
+    pos = 0;
+    if (!file.read(&packed[0], packed_len)
+        || !lzblock::decompress(reinterpret_cast<const uint8_t*>(packed.data()), packed_len,
+            reinterpret_cast<uint8_t*>(&raw[0]), raw_len))
+    {
+        bad = true;
+        return false;
+    }
+    return true;
+}
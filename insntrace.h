@@ -0,0 +1,64 @@
+
+#ifndef INSNTRACE_H
+#define INSNTRACE_H
+#include <fstream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "insnobserver.h"
+/**
+ * Compressed trace of every executed instruction. A record is a flags byte and only what the
+ * reader can't work out itself: the pc when it is not the next one (as a delta), the
+ * instruction word when the last one seen at that pc's slot of a small cache differs, and the
+ * change of rd (a delta, rd comes from the instruction) or, after ecall and the like, of every
+ * register that changed. Load and store addresses follow from the registers. The records are
+ * cut into blocks of lzblock::max_block bytes and compressed with lzblock. The reader streams
+ * them back one block at a time.
+ ********************************************************************************/
+class insntrace : public insn_observer
+{
+public:
+    // one decoded record
+    struct entry
+    {
+        uint64_t index; // instruction count before it ran
+        uint32_t pc; 
+        uint32_t insn; 
+        uint32_t regs[32]; // after it ran
+        uint32_t changed; // bit n set when it changed xn
+        bool access; // it is a load, store or AMO
+        uint32_t addr; // the address it accessed
+    };
+    ~insntrace(); // destructor prototype
+    bool open(const std::string& fname); 
+    void begin(rv32i* hart) override; 
+    void after(const rv32i* hart, const step_info& s) override; 
+    void end(rv32i* hart) override; 
+    bool open_read(const std::string& fname); 
+    bool next(entry& e); 
+    bool failed() const; 
+private:
+    static constexpr uint32_t cache_size = 1024; // instruction words remembered, by pc
+    // flags of a record
+    static constexpr uint8_t flag_jump = 1; // a pc delta follows
+    static constexpr uint8_t flag_insn = 2; // the instruction word follows
+    static constexpr uint8_t flag_rd = 4; // the change of rd follows
+    static constexpr uint8_t flag_regs = 8; // a count and (register, change) pairs follow
+    std::fstream file; 
+    std::string raw; // records of the current block
+    std::string packed; 
+    uint32_t shadow[32] = {}; // registers as of the last record
+    uint32_t next_pc = 0; // where the last record's instruction would go on
+    uint32_t cache[cache_size] = {}; 
+    uint64_t index = 0; 
+    size_t pos = 0; // reading position in raw
+    bool writing = false; // opened with open()
+    bool bad = false; 
+    void put(uint32_t v); 
+    void put_delta(uint32_t v, uint32_t old); 
+    void flush(); 
+    bool get(uint32_t& v); 
+    bool get_delta(uint32_t& v); 
+    bool read_block(); 
+};
+#endif
@@ -0,0 +1,145 @@
+
+#include "lzblock.h"
+#include <string.h>
+#include <algorithm>
+
+static constexpr uint32_t min_match = 4; 
+static constexpr uint32_t hash_bits = 12; 
+
+/**
+ * Read 4 bytes at p in host order
+ * @param const uint8_t* p
+ * @return them as one word
+ ********************************************************************************/
+static inline uint32_t read32(const uint8_t* p)
+{
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+/**
+ * Append a length that did not fit in its nibble, 255 per byte until the rest is smaller
+ * @param std::string& out, uint32_t n (what is left after the nibble's 15)
+ * @return none
+ ********************************************************************************/
+static void put_length(std::string& out, uint32_t n)
+{
+    while (n >= 255)
+    {
+        out += (char)255;
+        n -= 255;
+    }
+    out += (char)n;
+}
+
+/**
+ * Read a length that did not fit in its nibble
+ * @param const uint8_t*& p, const uint8_t* end, uint32_t& n (15 on entry, the length on return)
+ * @return false if the block ends first
+ ********************************************************************************/
+static bool get_length(const uint8_t*& p, const uint8_t* end, uint32_t& n)
+{
+    uint8_t b;
+    do
+    {
+        if (p >= end)
+            return false;
+        b = *p++;
+        n += b;
+    } while (b == 255);
+    return true;
+}
+
+/**
+ * Append one sequence to out
+ * @param std::string& out, const uint8_t* lit, uint32_t lit_len, uint32_t offset,
+ * uint32_t match_len (0 for the last sequence, which has literals only)
+ * @return none
+ ********************************************************************************/
+static void put_sequence(std::string& out, const uint8_t* lit, uint32_t lit_len, uint32_t offset, uint32_t match_len)
+{
+    uint32_t m = match_len == 0 ? 0 : match_len - min_match;
+    out += (char)((std::min(lit_len, 15u) << 4) | std::min(m, 15u));
+    if (lit_len >= 15)
+        put_length(out, lit_len - 15);
+    out.append(reinterpret_cast<const char*>(lit), lit_len);
+    if (match_len == 0)
+        return;
+    out += (char)(offset & 0xff);
+    out += (char)(offset >> 8);
+    if (m >= 15)
+        put_length(out, m - 15);
+}
+
+/**
+ * Compress one block and append it to out
+ * @param const uint8_t* in, uint32_t len (at most max_block), std::string& out
+ * @return none
+ ********************************************************************************/
+void lzblock::compress(const uint8_t* in, uint32_t len, std::string& out)
+{
+    uint32_t table[1 << hash_bits] = {};
+    uint32_t anchor = 0; // first byte not covered by a sequence yet
+    uint32_t misses = 0;
+    uint32_t i = 0;
+    while (i + min_match <= len)
+    {
+        uint32_t word = read32(in + i);
+        uint32_t h = (word * 2654435761u) >> (32 - hash_bits);
+        uint32_t cand = table[h];
+        table[h] = i;
+        if (cand >= i || i - cand > 0xffff || read32(in + cand) != word)
+        {
+            i += 1 + (misses++ >> 5);
+            continue;
+        }
+        misses = 0;
+        uint32_t n = min_match;
+        while (i + n < len && in[cand + n] == in[i + n])
+            n++;
+        put_sequence(out, in + anchor, i - anchor, i - cand, n);
+        i += n;
+        anchor = i;
+    }
+    put_sequence(out, in + anchor, len - anchor, 0, 0);
+}
+
+/**
+ * Decompress one block
+ * @param const uint8_t* in, uint32_t len, uint8_t* out, uint32_t out_len (the size the block
+ * had before compress())
+ * @return false if the block is corrupt
+ ********************************************************************************/
+bool lzblock::decompress(const uint8_t* in, uint32_t len, uint8_t* out, uint32_t out_len)
+{
+    const uint8_t* end = in + len;
+    uint32_t o = 0;
+    while (in < end)
+    {
+        uint8_t token = *in++;
+        uint32_t lit_len = token >> 4;
+        if (lit_len == 15 && !get_length(in, end, lit_len))
+            return false;
+        if (lit_len > (uint32_t)(end - in) || lit_len > out_len - o)
+            return false;
+        memcpy(out + o, in, lit_len);
+        in += lit_len;
+        o += lit_len;
+        if (in == end)
+            break; // the last sequence
+        if (end - in < 2)
+            return false;
+        uint32_t offset = in[0] | in[1] << 8;
+        in += 2;
+        uint32_t n = token & 15;
+        if (n == 15 && !get_length(in, end, n))
+            return false;
+        n += min_match;
+        if (offset == 0 || offset > o || n > out_len - o)
+            return false;
+        for (uint32_t k = 0; k < n; k++, o++)
+            out[o] = out[o - offset]; // byte by byte, the match may overlap what it writes
+    }
+    return o == out_len;
+}
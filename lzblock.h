@@ -0,0 +1,20 @@
+
+#ifndef LZBLOCK_H
+#define LZBLOCK_H
+#include <string>
+#include <stdint.h>
+/**
+ * Small LZ77 block compressor for traces, so that they need no external library. A block is a
+ * series of sequences: a token byte (literal count in the high nibble, match length - 4 in the
+ * low one, 15 = more bytes of 255 follow), the literals, a 2-byte offset back into the block
+ * and the match length. Matches are found with one hash table probe per position, which skips
+ * ahead faster the longer it finds nothing.
+ ********************************************************************************/
+class lzblock
+{
+public:
+    static constexpr uint32_t max_block = 64 * 1024; // largest block compress() takes
+    static void compress(const uint8_t* in, uint32_t len, std::string& out); 
+    static bool decompress(const uint8_t* in, uint32_t len, uint8_t* out, uint32_t out_len); 
+};
+#endif
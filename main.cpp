@@ -3,10 +3,33 @@
 #include "memory.h"
 #include "rv32i.h"
 #include "registerfile.h"
+#include "hostio.h"
+#include "device.h"
+#include "clint.h"
+#include "plic.h"
+#include "symtab.h"
+#include "gdbstub.h"
+#include "replaylog.h"
+#include "simpoint.h"
+#include "cosim.h"
+#include "coverage.h"
+#include "regtrace.h"
+#include "tracefilter.h"
+#include "insntrace.h"
+#include "reuse.h"
 #include <unistd.h>
 #include <stdlib.h>
 #include <ctype.h>
 #include <stdio.h>
+#include <thread>
+#include <vector>
+#include <memory>
+static constexpr uint32_t uart_base = 0x10000000; // where -u maps the UART
+static constexpr uint32_t blockdev_base = 0x10001000; // where -k maps the block device
+static constexpr uint32_t clint_base = 0x02000000; // where -c maps the CLINT
+static constexpr uint32_t plic_base = 0x0c000000; // where -c maps the PLIC
+static constexpr uint32_t blockdev_irq = 1; // PLIC source of the block device
+
 /**  usage() prints summary of how to invoke the program from a shell prompt.
  * usage() will print a description of all the possible command-line arguments that the program
  * takes.
@@ -15,17 +38,63 @@
  *************************************************************************************************************/
 static void usage()
 {
-    cerr << "Usage: rv32i [-d] [-i] [-l execution-limit] [-m hex-mem-size] [-r] [-z] infile" << endl;
+    cerr << "Usage: rv32i [-6] [-b break-addr] [-B interval[,k]] [-c] [-C coverage-file] [-d] [-D interval] [-e record-log] [-E replay-log] [-f fast-forward] [-g port|socket] [-i] [-I trace-filter] [-k disk-image] [-l execution-limit] [-m hex-mem-size] [-o bbv-file] [-p harts] [-r] [-R] [-s symbol-file] [-t insns-per-tick] [-T [text:]reg-trace] [-u] [-V vlen[,simd]] [-w watch-addr[,len]] [-W warmup] [-x ref-engine,test-engine[,every]] [-X insn-trace] [-z] infile" << endl;
+    cerr << "   -6 run the program on an RV64I hart (with -d, -i, -k, -l, -m, -r, -t, -u, -V and -z only)" << endl;
+    cerr << "   -b stop before executing the instruction at break-addr (hex or a symbol), may be" << endl;
+    cerr << "      given more than once" << endl;
+    cerr << "   -B sampled simulation: profile the run in intervals of this many instructions, pick up" << endl;
+    cerr << "      to k (default 5) representative intervals and run only those with the timing model" << endl;
+    cerr << "   -c attach a CLINT at " << hex0x32(clint_base) << " and a PLIC at " << hex0x32(plic_base)
+         << endl;
+    cerr << "      for timer and external interrupts (single hart only)" << endl;
+    cerr << "   -C record which instructions run, merged into coverage-file (created if missing)" << endl;
     cerr << "   -d show a disassembly before simulation begins(default not disassemble)." << endl;
+    cerr << "   -D print the reuse distances of the data accesses (64-byte lines) and the working set" << endl;
+    cerr << "      in every interval of this many instructions when the simulation ends" << endl;
+    cerr << "   -e record syscall results, device reads and interrupts in record-log" << endl;
+    cerr << "   -E replay a run recorded with -e without host i/o or devices (use the same" << endl;
+    cerr << "      options otherwise, single hart only)" << endl;
+    cerr << "   -f run this many instructions in the functional engine, then switch to the timing" << endl;
+    cerr << "      model and report its statistics at the end" << endl;
+    cerr << "   -g wait for gdb on this loopback TCP port or Unix socket path (single hart only)" << endl;
     cerr << "   -i Show instruction printing during execution(default do not print instructions). "<< endl;
+    cerr << "   -I show only the instructions that match trace-filter, comma separated terms that" << endl;
+    cerr << "      may be given more than once: pc=lo-hi, pc=function or pc=addr (hex or symbols)," << endl;
+    cerr << "      mem (loads, stores, AMOs), control (branches, jumps, traps), from=n and to=n" << endl;
+    cerr << "      (instruction counts), every=n (every nth of the rest)" << endl;
+    cerr << "   -k attach a block device backed by disk-image at " << hex0x32(blockdev_base) << endl;
     cerr << "   -l specify the maximum limit (default = no limit)" << endl;
     cerr << "   -m specify memory size (default = 0x10000)" << endl;
+    cerr << "   -o write the basic block vectors collected by -B to bbv-file (SimPoint format)" << endl;
+    cerr << "   -p run this many harts on separate host threads sharing the memory, each hart" << endl;
+    cerr << "      starts at address zero with its hart id in a0 (default = 1)" << endl;
     cerr << "   -r show a dump of the hart (GP-rgisters and PC) status" << endl;
+    cerr << "   -R print which part of the program ran (with -s, the functions that never ran and" << endl;
+    cerr << "      what did not run of the others), after merging with -C" << endl;
+    cerr << "   -s read symbols for -b, -w and -R from symbol-file (the output of nm)" << endl;
+    cerr << "   -t number of instructions per mtime tick (default = 1)" << endl;
+    cerr << "   -T write every register change (and every jump of the pc) to reg-trace, in binary" << endl;
+    cerr << "      or with text: one change per line, rv32i-regstate rebuilds the registers from it" << endl;
+    cerr << "   -u attach a UART at " << hex0x32(uart_base) << endl;
+    cerr << "   -V vector register length in bits (a power of 2 from " << vregfile::min_vlen << " to "
+         << vregfile::max_vlen << ", default 128) and" << endl;
+    cerr << "      the host instructions of the vector element loops: scalar, sse2 or avx2 (default the" << endl;
+    cerr << "      best the host has)" << endl;
+    cerr << "   -w stop after an instruction writes to the len (default 4) bytes at watch-addr" << endl;
+    cerr << "      (hex or a symbol), may be given more than once" << endl;
+    cerr << "   -W warm the timing model up for this many instructions before its statistics start" << endl;
+    cerr << "      (after -f, or before each interval of -B)" << endl;
+    cerr << "   -x run a second hart in lockstep over a copy of the memory and stop at the first" << endl;
+    cerr << "      difference in stores, pc or registers (compared every n instructions, default 1)," << endl;
+    cerr << "      engines are switch (the interpreter) and timing (interpreter + timing model)" << endl;
+    cerr << "   -X write every executed instruction and what it changed to insn-trace, compressed," << endl;
+    cerr << "      rv32i-untrace prints it" << endl;
     cerr << "   -z show a dump of the hart status and memory after the simulation has halted."<< endl;
     exit(1);
 }
 /**
  * Read a file of RV32I instructions and execute them.
+ * The exit status is the one the program passed to the exit syscall (0 if it never called it).
 ********************************************************************/
 int main(int argc, char** argv)
 {
@@ -35,18 +104,89 @@ int main(int argc, char** argv)
     bool show_instructions = false; // flag for show_instruction
     bool show_option_r = false; // flag for show a dumo of the hart (gp registers and pc)
     bool show_option_z = false; // flag for show a dump of the hart after simulation has halted
+    uint32_t hart_count = 1; // number of harts sharing the memory
+    bool rv64 = false; // flag for -6
+    bool attach_uart = false; // flag for -u
+    bool attach_intc = false; // flag for -c
+    uint32_t insns_per_tick = 1; // -t
+    uint32_t vlen = 128; // -V
+    vregfile::simd_level vector_simd = vregfile::host_simd(); // -V
+    std::string disk_image; // image file for the block device (-k)
+    std::string gdb_socket; // -g
+    std::string record_log; // -e
+    uint64_t simpoint_interval = 0; // -B
+    uint32_t simpoint_k = 5; // -B
+    std::string bbv_file; // -o
+    bool detailed = false; // -f or -W given
+    uint64_t fast_forward = 0; // -f
+    uint64_t warmup = 0; // -W
+    std::string cosim_spec; // -x
+    std::string coverage_file; // -C
+    bool coverage_report = false; // -R
+    std::string regtrace_file; // -T
+    std::vector<std::string> trace_filters; // -I
+    std::string insntrace_file; // -X
+    uint64_t reuse_interval = 0; // -D
+    std::string replay_log; // -E
+    std::string symbol_file; // -s
+    std::vector<std::string> break_addrs; // -b
+    std::vector<std::string> watch_addrs; // -w
     int opt;
     // while loop to get all the inputed arguments
-    while ((opt = getopt(argc, argv, "m:dil:rz")) != -1)
+    while ((opt = getopt(argc, argv, "6b:B:cC:m:dD:e:E:f:g:iI:k:l:o:p:rRs:t:T:uV:w:W:x:X:z")) != -1)
     {
         switch (opt) // switch case to see which arguments where procided by the user
         {
+            case '6':
+                rv64 = true;
+                break;
+            case 'b':
+                break_addrs.push_back(optarg); // -b breakpoint
+                break;
+            case 'B':
+            {
+                std::string arg = optarg; // -B interval[,k]
+                size_t comma = arg.find(',');
+                simpoint_interval = std::stoull(arg.substr(0, comma), nullptr, 10);
+                if (comma != std::string::npos)
+                    simpoint_k = std::stoul(arg.substr(comma + 1), nullptr, 10);
+                if (simpoint_interval == 0 || simpoint_k == 0)
+                    usage();
+                break;
+            }
+            case 'c':
+                attach_intc = true; // -c attach the interrupt controllers
+                break;
             case 'd':
                 show_disassembly = true; // if the option-d is included change the flag to true
                 break;
+            case 'D':
+                reuse_interval = std::stoull(optarg, nullptr, 10); // -D reuse distances
+                if (reuse_interval == 0)
+                    usage();
+                break;
+            case 'e':
+                record_log = optarg; // -e record
+                break;
+            case 'E':
+                replay_log = optarg; // -E replay
+                break;
+            case 'f':
+                fast_forward = std::stoull(optarg, nullptr, 10); // -f
+                detailed = true;
+                break;
+            case 'g':
+                gdb_socket = optarg; // -g wait for gdb
+                break;
             case 'i':
                 show_instructions = true; // if the option -i is entered change the flag to true
                 break;
+            case 'I':
+                trace_filters.push_back(optarg); // -I trace filter
+                break;
+            case 'k':
+                disk_image = optarg; // -k attach a block device
+                break;
             case 'l':
                 execution_limit = std::stoul(optarg, nullptr,
                     10); // if the option -l is given the execution limit will be the new value
@@ -55,9 +195,64 @@ int main(int argc, char** argv)
                 memory_limit = std::stoul(
                     optarg, nullptr, 16); //-m the memory_limit will be the entered value
                 break;
+            case 'o':
+                bbv_file = optarg; // -o basic block vectors
+                break;
+            case 'p':
+                hart_count = std::stoul(optarg, nullptr, 10); // -p number of harts
+                if (hart_count == 0)
+                    usage();
+                break;
             case 'r':
                 show_option_r = true; // if the option -r is entered change the value to true
                 break;
+            case 's':
+                symbol_file = optarg; // -s symbol file
+                break;
+            case 't':
+                insns_per_tick = std::stoul(optarg, nullptr, 10); // -t timer rate
+                if (insns_per_tick == 0)
+                    usage();
+                break;
+            case 'u':
+                attach_uart = true; // -u attach a UART
+                break;
+            case 'V':
+            {
+                // -V vlen[,simd]
+                std::string spec = optarg;
+                size_t comma = spec.find(',');
+                vlen = std::stoul(spec.substr(0, comma), nullptr, 10);
+                if ((comma != std::string::npos && !vregfile::parse_simd(spec.substr(comma + 1), vector_simd))
+                    || vector_simd > vregfile::host_simd() || !vregfile().set_vlen(vlen))
+                {
+                    cerr << "Bad -V " << spec << "." << endl;
+                    usage();
+                }
+                break;
+            }
+            case 'w':
+                watch_addrs.push_back(optarg); // -w watchpoint
+                break;
+            case 'W':
+                warmup = std::stoull(optarg, nullptr, 10); // -W
+                detailed = true;
+                break;
+            case 'C':
+                coverage_file = optarg; // -C coverage
+                break;
+            case 'R':
+                coverage_report = true; // -R coverage report
+                break;
+            case 'T':
+                regtrace_file = optarg; // -T register trace
+                break;
+            case 'x':
+                cosim_spec = optarg; // -x lockstep
+                break;
+            case 'X':
+                insntrace_file = optarg; // -X instruction trace
+                break;
             case 'z':
                 show_option_z = true; // if the option -z is entered change the value to true
                 break;
@@ -69,8 +264,178 @@ int main(int argc, char** argv)
     memory mem(memory_limit);
     if (!mem.load_file(argv[optind]))
         usage();
+    uart console;
+    blockdev disk;
+    if (attach_uart && !mem.add_device(uart_base, uart::size, &console))
+    {
+        cerr << "Can't map the UART at " << hex0x32(uart_base) << "." << endl;
+        usage();
+    }
+    if (!disk_image.empty()
+        && (!disk.open_file(disk_image) || !mem.add_device(blockdev_base, blockdev::size, &disk)))
+    {
+        cerr << "Can't map the block device at " << hex0x32(blockdev_base) << "." << endl;
+        usage();
+    }
 
+    // the program break starts right after the loaded image
+    hostio io(&mem, (mem.get_image_size() + 15) & 0xfffffff0);
+    if (rv64)
+    {
+        if (hart_count > 1 || attach_intc || !gdb_socket.empty() || !record_log.empty() || !replay_log.empty()
+            || simpoint_interval != 0 || detailed || !cosim_spec.empty() || !coverage_file.empty()
+            || coverage_report || !regtrace_file.empty() || !trace_filters.empty() || !insntrace_file.empty()
+            || reuse_interval != 0 || !break_addrs.empty() || !watch_addrs.empty())
+        {
+            cerr << "-6 can only be combined with -d, -i, -k, -l, -m, -r, -t, -u, -V and -z." << endl;
+            usage();
+        }
+        rv64i sim64(&mem);
+        sim64.set_hostio(&io);
+        sim64.set_insns_per_tick(insns_per_tick);
+        sim64.set_vlen(vlen);
+        sim64.set_vector_simd(vector_simd);
+        sim64.set_show_instructions(show_instructions);
+        sim64.set_show_registers(show_option_r);
+        if (show_disassembly)
+        {
+            sim64.disasm();
+            sim64.reset();
+        }
+        sim64.run(execution_limit);
+        mem.report_faults();
+        if (show_option_z)
+        {
+            sim64.dump();
+            mem.dump();
+        }
+        return io.get_exit_code();
+    }
     rv32i sim(&mem);
+    sim.set_hostio(&io);
+    sim.set_insns_per_tick(insns_per_tick);
+    sim.set_vlen(vlen);
+    sim.set_vector_simd(vector_simd);
+    clint timer(&sim);
+    plic intc(&sim);
+    if (attach_intc)
+    {
+        if (hart_count > 1 || !mem.add_device(clint_base, clint::size, &timer)
+            || !mem.add_device(plic_base, plic::size, &intc))
+        {
+            cerr << "Can't map the interrupt controllers." << endl;
+            usage();
+        }
+        disk.set_irq(&intc, blockdev_irq);
+    }
+    symtab symbols;
+    if (!symbol_file.empty() && !symbols.load_file(symbol_file))
+        usage();
+    for (const std::string& b : break_addrs)
+    {
+        uint32_t addr;
+        if (!symbols.parse_address(b, addr))
+        {
+            cerr << "Unknown breakpoint address " << b << "." << endl;
+            usage();
+        }
+        sim.add_breakpoint(addr);
+    }
+    for (const std::string& w : watch_addrs)
+    {
+        size_t comma = w.find(',');
+        uint32_t addr;
+        uint32_t len = (comma == std::string::npos) ? 4 : std::stoul(w.substr(comma + 1), nullptr, 0);
+        if (!symbols.parse_address(w.substr(0, comma), addr) || !sim.add_watchpoint(addr, len, memory::watch_write))
+        {
+            cerr << "Bad watchpoint " << w << "." << endl;
+            usage();
+        }
+    }
+    replaylog log;
+    if (!record_log.empty() || !replay_log.empty())
+    {
+        if (hart_count > 1 || !(record_log.empty() ? log.replay(replay_log) : log.record(record_log)))
+        {
+            cerr << "Can't record or replay this run." << endl;
+            usage();
+        }
+        mem.set_log(&log);
+        sim.set_log(&log);
+    }
+    if (simpoint_interval != 0 && (hart_count > 1 || !gdb_socket.empty() || !record_log.empty() || !replay_log.empty()))
+    {
+        cerr << "-B can't be combined with -p, -g, -e or -E." << endl;
+        usage();
+    }
+    if (detailed && simpoint_interval == 0 && (hart_count > 1 || !gdb_socket.empty()))
+    {
+        cerr << "-f and -W can't be combined with -p or -g." << endl;
+        usage();
+    }
+    cosim::engine ref_engine = cosim::engine_switch;
+    cosim::engine test_engine = cosim::engine_switch;
+    uint64_t cosim_every = 1;
+    if (!cosim_spec.empty())
+    {
+        size_t c1 = cosim_spec.find(',');
+        size_t c2 = cosim_spec.find(',', c1 + 1);
+        if (c1 == std::string::npos || !cosim::parse_engine(cosim_spec.substr(0, c1), ref_engine)
+            || !cosim::parse_engine(cosim_spec.substr(c1 + 1, c2 - c1 - 1), test_engine)
+            || (c2 != std::string::npos && (cosim_every = std::stoull(cosim_spec.substr(c2 + 1))) == 0))
+        {
+            cerr << "Bad -x " << cosim_spec << "." << endl;
+            usage();
+        }
+        if (hart_count > 1 || !gdb_socket.empty() || !record_log.empty() || !replay_log.empty()
+            || simpoint_interval != 0 || detailed)
+        {
+            cerr << "-x can't be combined with -p, -g, -e, -E, -B, -f or -W." << endl;
+            usage();
+        }
+    }
+    // the analyses all watch the same run loop, so any mix of them works
+    bool collect_coverage = !coverage_file.empty() || coverage_report;
+    if ((collect_coverage || !regtrace_file.empty() || !trace_filters.empty() || !insntrace_file.empty()
+        || reuse_interval != 0) && (hart_count > 1 || !gdb_socket.empty() || simpoint_interval != 0 || detailed
+        || !cosim_spec.empty()))
+    {
+        cerr << "-C, -R, -T, -I, -X and -D can't be combined with -p, -g, -B, -f, -W or -x." << endl;
+        usage();
+    }
+    std::vector<insn_observer*> observers;
+    tracefilter filter(memory_limit);
+    for (const std::string& f : trace_filters)
+    {
+        if (!filter.parse(f, symbols))
+            usage();
+    }
+    if (!trace_filters.empty())
+        observers.push_back(&filter);
+    reuse data_reuse(reuse_interval != 0 ? memory_limit : 0, reuse_interval);
+    if (reuse_interval != 0)
+        observers.push_back(&data_reuse);
+    insntrace executed_insns;
+    if (!insntrace_file.empty() && !executed_insns.open(insntrace_file))
+        usage();
+    if (!insntrace_file.empty())
+        observers.push_back(&executed_insns);
+    regtrace changes;
+    bool text_trace = regtrace_file.compare(0, 5, "text:") == 0;
+    if (!regtrace_file.empty() && !changes.open(text_trace ? regtrace_file.substr(5) : regtrace_file, text_trace))
+        usage();
+    if (!regtrace_file.empty())
+        observers.push_back(&changes);
+    coverage executed(collect_coverage ? memory_limit : 0);
+    if (!coverage_file.empty() && !executed.merge_file(coverage_file))
+        usage();
+    if (collect_coverage)
+        observers.push_back(&executed);
+    if (!gdb_socket.empty() && hart_count > 1)
+    {
+        cerr << "gdb can only debug a single hart." << endl;
+        usage();
+    }
     // call set_show_instructions to set the value of show_instructions
     sim.set_show_instructions(show_instructions);
     // call set_show_option_registers to set the value of show_option_r
@@ -81,13 +446,134 @@ int main(int argc, char** argv)
         sim.disasm();
         sim.reset();
     }
-    // call run with execution_limit as its parameter
-    sim.run(execution_limit);
+    if (hart_count > 1)
+    {
+        // hart 0 is sim, the others get their own registers but share mem, every hart runs
+        // on its own host thread
+        std::vector<std::unique_ptr<rv32i>> others;
+        std::vector<std::thread> threads;
+        for (uint32_t i = 1; i < hart_count; i++)
+        {
+            others.emplace_back(new rv32i(&mem));
+            others.back()->set_show_instructions(show_instructions);
+            others.back()->set_show_registers(show_option_r);
+            others.back()->set_hartid(i);
+            others.back()->set_hostio(&io);
+            others.back()->set_vlen(vlen);
+            others.back()->set_vector_simd(vector_simd);
+        }
+        // start() resets the registers, so a0 = hart id goes in between start() and resume()
+        for (uint32_t i = 1; i < hart_count; i++)
+        {
+            rv32i* hart = others[i - 1].get();
+            threads.emplace_back([hart, i, execution_limit]() {
+                hart->start();
+                hart->set_register(10, i);
+                hart->resume(execution_limit);
+                hart->finish();
+            });
+        }
+        sim.start();
+        sim.set_register(10, 0);
+        sim.resume(execution_limit);
+        sim.finish();
+        for (auto& t : threads)
+        {
+            t.join();
+        }
+    }
+    else if (!cosim_spec.empty())
+    {
+        // the test hart gets its own copy of the memory with the same device map, it never
+        // touches the devices because it replays what the reference hart records
+        memory test_mem(memory_limit);
+        test_mem.load_file(argv[optind]);
+        if (attach_uart)
+            test_mem.add_device(uart_base, uart::size, &console);
+        if (!disk_image.empty())
+            test_mem.add_device(blockdev_base, blockdev::size, &disk);
+        if (attach_intc)
+        {
+            test_mem.add_device(clint_base, clint::size, &timer);
+            test_mem.add_device(plic_base, plic::size, &intc);
+        }
+        rv32i test(&test_mem);
+        test.set_hostio(&io);
+        test.set_insns_per_tick(insns_per_tick);
+        test.set_vlen(vlen);
+        test.set_vector_simd(vector_simd);
+        replaylog leader, follower;
+        leader.record("");
+        follower.follow(&leader);
+        mem.set_log(&leader);
+        sim.set_log(&leader);
+        test_mem.set_log(&follower);
+        test.set_log(&follower);
+        cosim check(&sim, &mem, ref_engine, &test, &test_mem, test_engine, cosim_every);
+        if (!check.run(execution_limit))
+            return 2;
+    }
+    else if (simpoint_interval != 0)
+    {
+        simpoint sp(simpoint_interval, simpoint_k);
+        std::ofstream bbv_out;
+        if (!bbv_file.empty())
+        {
+            bbv_out.open(bbv_file);
+            if (!bbv_out)
+            {
+                cerr << "Can't open file " << bbv_file << " for writing." << endl;
+                usage();
+            }
+        }
+        if (!sp.run(&sim, &mem, execution_limit, warmup, bbv_file.empty() ? nullptr : &bbv_out))
+            return 1;
+    }
+    else if (!gdb_socket.empty())
+    {
+        gdbstub stub(&sim, &mem, &io, execution_limit);
+        if (!stub.listen(gdb_socket))
+            usage();
+        sim.start();
+        if (stub.serve())
+        {
+            sim.resume(execution_limit); // gdb detached, run to the end
+        }
+        sim.finish();
+    }
+    else if (detailed)
+    {
+        timing model;
+        sim.run(execution_limit, fast_forward, warmup, &model);
+        model.report(std::cout);
+    }
+    else if (!observers.empty())
+    {
+        sim.start();
+        for (insn_observer* o : observers)
+            o->begin(&sim);
+        sim.resume_observed(execution_limit, observers);
+        for (insn_observer* o : observers)
+            o->end(&sim);
+        sim.finish();
+        if (reuse_interval != 0)
+            data_reuse.report(std::cout);
+        if (!coverage_file.empty() && !executed.save_file(coverage_file))
+            return 1;
+        if (coverage_report)
+            executed.report(std::cout, symbols, mem.get_image_size());
+    }
+    else
+    {
+        // call run with execution_limit as its parameter
+        sim.run(execution_limit);
+    }
+    mem.report_faults(); // accesses out of range are summed up here instead of warned about one by one
     // if -z is entered call dump() for the simulation and memory
     if (show_option_z)
     {
         sim.dump();
         mem.dump();
     }
-    return 0;
+    return io.get_exit_code();
 }
\ No newline at end of file
@@ -1,6 +1,8 @@
 
 #include "memory.h"
 #include "hex.h"
+#include "replaylog.h"
+#include <algorithm>
 
 
 // An array of bytes representing the simulated memory
@@ -23,6 +25,9 @@ memory::memory(uint32_t siz)
     size = (siz + 15) & 0xfffffff0;
     // allocates siz bytes for the array
     mem = new uint8_t[size];
+    dirty.assign(((uint64_t)size + (1u << page_shift) - 1) >> page_shift, 0);
+    dirty_pages.resize(dirty.size()); // a page is listed at most once between two restore()s
+    update_fast_path();
     // initiliazes every byte to 0xa5
     for (unsigned int i = 0; i < size; i++)
     {
@@ -46,8 +51,8 @@ memory::~memory()
 
 /** 
 *  bool_check_addres(uint32_t i) check if the given address is in the simulated memory
-*  return true if the address is in the simulated memory and when its not on the simulated memory,
-*  prints a warning and returns false
+*  return true if the address is in the simulated memory and false when its not, the accessors
+*  record the faults themselves
 * @param x uint32_t i
 * @return true or false
 * @note
@@ -56,15 +61,7 @@ memory::~memory()
 *************************************************************************************************************/
 bool memory::check_address(uint32_t i) const
 {
-    if (i < size)
-    {
-        return true;
-    }
-    else
-    {
-        std::cout << "WARNING: Address out of range: " << hex0x32(i) << std::endl;
-        return false;
-    }
+    return i < size;
 }
 
 /**  
@@ -80,115 +77,232 @@ uint32_t memory::get_size() const
     return size;
 }
 
-/** 
-* memory::get8(uint32_t addr) check if the given addr is in the mem array
-* if the addr is inside the mem array then return the value of the byte, if not
-* return zero.
-* @param uint32_t addr
-* @return value of the bye from the memoryat that addres or zero
+/**
+* memory::add_device(uint32_t base, uint32_t len, device* dev) attaches dev to the address range
+* [base, base+len). The range must not overlap the simulated RAM or another device, accesses
+* inside it are passed to the device instead of the memory array.
+* @param uint32_t base, uint32_t len, device* dev
+* @return true if the device was attached
 * @note
-* @warning
+* @warning the memory does not take ownership of dev
 * @bug
 *************************************************************************************************************/
-uint8_t memory::get8(uint32_t addr) const
+bool memory::add_device(uint32_t base, uint32_t len, device* dev)
 {
-    if (check_address(addr))
+    if (len == 0 || base < size || base + len - 1 < base)
     {
-        return mem[addr];
+        return false;
     }
-    else
+    for (const region& r : regions)
     {
-        return 0;
+        if (base <= r.base + r.len - 1 && r.base <= base + len - 1)
+        {
+            return false;
+        }
     }
+    regions.push_back(region { base, len, dev });
+    last_region = 0;
+    return true;
 }
 
-/** 
-* memory::get16(uint32_t addr) get the two bytes from get8 and combines them in little-endian
-* to create a 16-bit return value
-* @param uint32_t addr
-* @return 16-bit in little endian
+/**
+* memory::reset_devices() puts every attached device back to its state after reset, for runs that
+* start the program over. Call it after the harts have been reset, the CLINT relies on that.
+* @param none
+* @return nothing
 * @note
 * @warning
 * @bug
 *************************************************************************************************************/
-uint16_t memory::get16(uint32_t addr) const
+void memory::reset_devices()
 {
+    for (const region& r : regions)
+    {
+        r.dev->reset();
+    }
+}
 
-    int16_t value = (uint8_t)get8(addr);
-    value =value | get8(addr+1)<<8;
-    return value;
+/**
+* memory::set_log(replaylog* l) makes device reads go through a record/replay log
+* @param replaylog* l (nullptr to turn logging off)
+* @return nothing
+* @note
+* @warning
+* @bug
+*************************************************************************************************************/
+void memory::set_log(replaylog* l)
+{
+    log = l;
+}
+
+/**
+* memory::set_output(std::ostream* os) sends warnings and dumps to os instead of std::cout
+* @param std::ostream* os
+* @return nothing
+* @note
+* @warning
+* @bug
+*************************************************************************************************************/
+void memory::set_output(std::ostream* os)
+{
+    out = os;
 }
 
 /**
-* memory::get32(uint32_t addr) get the four bytes from get16 and combines them in little-endian
-* to create a 32-bit return value
+* memory::find_region(uint32_t addr) finds the device covering addr. The region that matched last
+* time is checked first since device accesses usually come in runs to the same device.
 * @param uint32_t addr
-* @return 32-bit in little endian
+* @return the device region or nullptr if no device covers addr
 * @note
 * @warning
 * @bug
 *************************************************************************************************************/
-uint32_t memory::get32(uint32_t addr) const
+const memory::region* memory::find_region(uint32_t addr) const
 {
-    uint32_t value = (uint32_t)get16(addr);
-    value = value | ((uint32_t)get16(addr+2))<<16;
-    return value;
+    uint32_t last = last_region.load(std::memory_order_relaxed);
+    if (last < regions.size() && addr - regions[last].base < regions[last].len)
+    {
+        return &regions[last];
+    }
+    for (uint32_t i = 0; i < regions.size(); i++)
+    {
+        if (addr - regions[i].base < regions[i].len)
+        {
+            last_region.store(i, std::memory_order_relaxed);
+            return &regions[i];
+        }
+    }
+    return nullptr;
 }
 
-/**  
-* memory::set8(uint32_t addr, uint8_t val) sets the bytes in the simulated memory
-* it calls check_address() to verfy that the addr argumn is valid if addr is valid then set
-* the byte in the simulated memory  to the given value val  if its not valid then return to
-* the caller
-* @param uint32_t addr, uint8_t val
-* @return nothing
+/**
+* memory::io_read(uint32_t addr, uint32_t len, bool data) is the slow path of get8/get16/get32 for
+* accesses that are not entirely inside the simulated RAM or that happen while a watchpoint is set.
+* Data accesses are checked against the watchpoints first. If a device covers the whole access it
+* is asked for the value, otherwise the value is put together one byte at a time in little-endian
+* order with bytes outside the simulated memory reading as zero.
+* @param uint32_t addr, uint32_t len, uint32_t& val (set to the value read), bool data (false for
+* instruction fetches)
+* @return false if a byte is outside the simulated memory, the fault is recorded
 * @note
 * @warning
 * @bug
 *************************************************************************************************************/
-void memory::set8(uint32_t addr, uint8_t val)
+bool memory::io_read(uint32_t addr, uint32_t len, uint32_t& val, bool data) const
 {
-    if (check_address(addr))
+    if (data && !watches.empty())
     {
-        mem[addr] = val;
+        check_watch(addr, len, watch_read);
     }
-    else
+    const region* r = find_region(addr);
+    if (r != nullptr && addr - r->base <= r->len - len)
     {
-        return;
+        if (log == nullptr)
+        {
+            val = r->dev->read(addr - r->base, len);
+            return true;
+        }
+        val = log->is_replaying() ? 0 : r->dev->read(addr - r->base, len);
+        log->value(replaylog::rec_device, val);
+        return true;
+    }
+    val = 0;
+    bool ok = true;
+    for (uint32_t i = 0; i < len; i++)
+    {
+        if (check_address(addr + i))
+        {
+            val |= (uint32_t)mem[addr + i] << (8 * i);
+        }
+        else
+        {
+            ok = false;
+        }
     }
+    if (!ok)
+    {
+        note_fault(addr, len, data ? fault_load : fault_fetch);
+    }
+    return ok;
 }
 
-/**  
-* memory::set16(uint32_t addr,uint16_t val) stores the given value in little endian
-*calls set8 twice to storve the given value val in little endian starting at add
-* @param uint32_t addr, uint16_t val
-* @return nothing
+/**
+* memory::io_write(uint32_t addr, uint32_t len, uint32_t val) is the slow path of set8/set16/set32
+* for accesses that are not entirely inside the simulated RAM or that happen while a watchpoint is
+* set. The access is checked against the watchpoints first. If a device covers the whole access
+* it gets the value, otherwise the bytes are stored one at a time in little-endian order. If any
+* byte is outside the simulated memory none is stored, so a store that faults changes nothing.
+* @param uint32_t addr, uint32_t len, uint32_t val
+* @return false if a byte is outside the simulated memory, the fault is recorded
 * @note
 * @warning
 * @bug
 *************************************************************************************************************/
-void memory::set16(uint32_t addr, uint16_t val)
+bool memory::io_write(uint32_t addr, uint32_t len, uint32_t val)
 {
-    set8(addr, val&0x00ff0000);
-    set8(addr+1, (val>>8)&0x00ff);
-    mem[addr] = val;
+    if (!watches.empty())
+    {
+        check_watch(addr, len, watch_write);
+    }
+    const region* r = find_region(addr);
+    if (r != nullptr && addr - r->base <= r->len - len)
+    {
+        if (log == nullptr || !log->is_replaying())
+        {
+            r->dev->write(addr - r->base, len, val); // replays leave the devices alone
+        }
+        return true;
+    }
+    if (!check_address(addr) || !check_address(addr + len - 1))
+    {
+        note_fault(addr, len, fault_store);
+        return false;
+    }
+    mark_dirty(addr, len);
+    for (uint32_t i = 0; i < len; i++)
+    {
+        mem[addr + i] = (val >> (8 * i)) & 0xff;
+    }
+    return true;
 }
 
-/**  
-* memory::set32(uint32_t addr,uint32_t val) stores the given value into memory in little endian
-* it calls set16() twice and stores the given value into memory in little endian format starting
-* at addr
-* @param uint32_t addr, uint32_t val
-* @return nothing
+/**
+* memory::io_covers(uint32_t addr, uint32_t len) tells whether io_write() would take an access,
+* that is a device covers all of it or all of it is inside the simulated memory
+* @param uint32_t addr, uint32_t len
+* @return true if the access would not fault
+* @note
+* @warning
+* @bug
+*************************************************************************************************************/
+bool memory::io_covers(uint32_t addr, uint32_t len) const
+{
+    const region* r = find_region(addr);
+    if (r != nullptr && addr - r->base <= r->len - len)
+    {
+        return true;
+    }
+    return check_address(addr) && check_address(addr + len - 1);
+}
+
+/**
+* memory::io_write64(uint32_t addr, uint64_t val) is the slow path of 8-byte stores, done as two
+* 32-bit io_write() calls so devices and watchpoints see them the same way as 8-byte loads. Both
+* halves are checked first, if either one would fault nothing is written.
+* @param uint32_t addr, uint64_t val
+* @return false if a byte is outside the simulated memory and every device, the fault is recorded
 * @note
 * @warning
 * @bug
 *************************************************************************************************************/
-void memory::set32(uint32_t addr, uint32_t val)
+bool memory::io_write64(uint32_t addr, uint64_t val)
 {
-    set16(addr, val&0x0000ffff);
-    set16(addr+2, (val>>16)&0x0000ffff);
-    mem[addr] = val;
+    if (addr > 0xfffffff8u || !io_covers(addr, 4) || !io_covers(addr + 4, 4))
+    {
+        note_fault(addr, 8, fault_store);
+        return false;
+    }
+    return io_write(addr, 4, val) && io_write(addr + 4, 4, val >> 32);
 }
 
 /**  
@@ -213,26 +327,26 @@ void memory::dump() const
         {
             if (i != 0)
             {
-                std::cout << " *";
+                *out << " *";
                 // loop through the ascii array and print whats there
-                    std::cout << ascii;   
-                std::cout << "*" << endl;
+                    *out << ascii;   
+                *out << "*" << endl;
             }
-            std::cout << hex32(i) << ":"; // prints register number
+            *out << hex32(i) << ":"; // prints register number
         }
         // ch is the value of the byte at i
         uint8_t ch = get8(i);
         // print 2 spaces every 8 bytes and 1 space after every 1 byte
-        std::cout << (i % 16 == 8 ? "  " : " ") << hex8(ch);
+        *out << (i % 16 == 8 ? "  " : " ") << hex8(ch);
         // if its printable print that character otherwise print '.'
         ascii[i % 16] = isprint(ch) ? ch : '.';
     }
-    std::cout << " *";
+    *out << " *";
     // loop through the ascii array and print whats there
     
-        std::cout << ascii;
+        *out << ascii;
     
-    std::cout << "*" << endl;
+    *out << "*" << endl;
 }
 
 /** 
@@ -268,6 +382,7 @@ bool memory::load_file(const std::string& fname)
         if (check_address(index))
         {
             // if the address is available sets val into memory[index]
+            mark_dirty(index, 1);
             mem[index] = val;
         }
         else
@@ -282,5 +397,447 @@ bool memory::load_file(const std::string& fname)
     }
     // close thefile
     infile.close();
+    image_size = index;
+    return true;
+}
+
+/**
+* memory::load_image() copies len bytes from data to address 0 of the simulated memory, the same
+* as load_file() does with the contents of a file
+* @param const uint8_t* data, uint32_t len
+* @return false if the image does not fit
+* @note
+* @warning
+* @bug
+*************************************************************************************************************/
+bool memory::load_image(const uint8_t* data, uint32_t len)
+{
+    if (len > size)
+    {
+        std::cerr << "Program too big." << std::endl;
+        return false;
+    }
+    if (len != 0)
+    {
+        mark_dirty(0, len);
+    }
+    std::copy(data, data + len, mem);
+    image_size = len;
+    return true;
+}
+
+/**
+* memory::snapshot() keeps a copy of the whole RAM for restore() and starts tracking writes from
+* here
+* @param none
+* @return nothing
+* @note
+* @warning
+* @bug
+*************************************************************************************************************/
+void memory::snapshot()
+{
+    pristine.assign(mem, mem + size);
+    std::fill(dirty.begin(), dirty.end(), 0);
+    dirty_count = 0;
+}
+
+/**
+* memory::restore() puts the RAM back to the last snapshot() by copying back only the pages that
+* were written since then, which mark_dirty() listed, so the cost follows what the run touched
+* rather than the memory size
+* @param none
+* @return number of pages copied back (0 when there is no snapshot)
+* @note
+* @warning
+* @bug
+*************************************************************************************************************/
+uint32_t memory::restore()
+{
+    uint32_t restored = 0;
+    if (pristine.empty())
+    {
+        return restored;
+    }
+    uint32_t page_size = 1u << page_shift;
+    for (uint32_t i = 0; i < dirty_count; i++)
+    {
+        uint32_t page = dirty_pages[i];
+        uint32_t addr = page << page_shift;
+        uint32_t len = std::min(page_size, size - addr);
+        std::copy(pristine.begin() + addr, pristine.begin() + addr + len, mem + addr);
+        dirty[page] = 0;
+        restored++;
+    }
+    dirty_count = 0;
+    return restored;
+}
+
+/**
+* memory::get_image_size() returns how many bytes load_file() put into the simulated memory
+* @param none
+* @return size of the loaded image
+* @note
+* @warning
+* @bug
+*************************************************************************************************************/
+uint32_t memory::get_image_size() const
+{
+    return image_size;
+}
+
+/**
+* memory::get_ptr(uint32_t addr, uint32_t len) gives direct access to len bytes of the simulated
+* memory starting at addr so that host I/O can read into or write from guest buffers without
+* copying them byte by byte. Returns nullptr if any part of the range is outside the memory.
+* @param uint32_t addr, uint32_t len
+* @return host pointer to the byte at addr or nullptr
+* @note
+* @warning the bytes are stored in guest (little-endian) order
+* @bug
+*************************************************************************************************************/
+uint8_t* memory::get_ptr(uint32_t addr, uint32_t len)
+{
+    if (addr > size || len > size - addr)
+    {
+        return nullptr;
+    }
+    if (len != 0)
+    {
+        mark_dirty(addr, len); // the caller may write through the pointer
+    }
+    return mem + addr;
+}
+
+/**
+* memory::load_reserved32(uint32_t addr) atomically loads the 32-bit word at addr
+* used by lr.w so that the value observed by the reservation is never torn by a store from a hart
+* running on another host thread.
+* @param uint32_t addr (must be 4-byte aligned), uint32_t& val (set to the word)
+* @return false if the word is not entirely inside the simulated memory, the fault is recorded
+* @note
+* @warning the host word is used directly, so this assumes a little-endian host like the rest of
+* the atomic helpers
+* @bug
+*************************************************************************************************************/
+bool memory::load_reserved32(uint32_t addr, uint32_t& val) const
+{
+    if (!check_address(addr) || !check_address(addr + 3))
+    {
+        note_fault(addr, 4, fault_load);
+        return false;
+    }
+    val = __atomic_load_n(reinterpret_cast<uint32_t*>(mem + addr), __ATOMIC_ACQUIRE);
+    return true;
+}
+
+/**
+* memory::store_conditional32(uint32_t addr, uint32_t expected, uint32_t val) stores val at addr
+* only if the word still holds the value that was observed by the matching lr.w. This is done with
+* a single host compare-and-swap so two harts racing on the same reservation can't both succeed.
+* The reservation was made by load_reserved32(), so the word is inside the simulated memory.
+* @param uint32_t addr (must be 4-byte aligned), uint32_t expected, uint32_t val
+* @return true if the store was performed, false otherwise
+* @note
+* @warning
+* @bug a store that writes back the reserved value in between (ABA) is not detected
+*************************************************************************************************************/
+bool memory::store_conditional32(uint32_t addr, uint32_t expected, uint32_t val)
+{
+    if (!check_address(addr) || !check_address(addr + 3))
+    {
+        return false;
+    }
+    mark_dirty(addr, 4);
+    return __atomic_compare_exchange_n(reinterpret_cast<uint32_t*>(mem + addr), &expected, val,
+        false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+
+/**
+* memory::amo32(uint32_t addr, amo_op op, uint32_t val) performs the given read-modify-write
+* operation on the word at addr as one host atomic operation and returns the previous value.
+* swap/add/xor/and/or map straight onto host atomics, min/max use a compare-and-swap loop.
+* @param uint32_t addr (must be 4-byte aligned), amo_op op, uint32_t val, uint32_t& old (set to
+* the value of the word before the operation)
+* @return false if the word is not entirely inside the simulated memory, nothing is written then
+* and the fault is recorded
+* @note
+* @warning
+* @bug
+*************************************************************************************************************/
+bool memory::amo32(uint32_t addr, amo_op op, uint32_t val, uint32_t& old)
+{
+    if (!check_address(addr) || !check_address(addr + 3))
+    {
+        note_fault(addr, 4, fault_store);
+        return false;
+    }
+    mark_dirty(addr, 4);
+    uint32_t* p = reinterpret_cast<uint32_t*>(mem + addr);
+    switch (op)
+    {
+        case amo_swap:
+            old = __atomic_exchange_n(p, val, __ATOMIC_ACQ_REL);
+            return true;
+        case amo_add:
+            old = __atomic_fetch_add(p, val, __ATOMIC_ACQ_REL);
+            return true;
+        case amo_xor:
+            old = __atomic_fetch_xor(p, val, __ATOMIC_ACQ_REL);
+            return true;
+        case amo_and:
+            old = __atomic_fetch_and(p, val, __ATOMIC_ACQ_REL);
+            return true;
+        case amo_or:
+            old = __atomic_fetch_or(p, val, __ATOMIC_ACQ_REL);
+            return true;
+        default:
+            break;
+    }
+    old = __atomic_load_n(p, __ATOMIC_ACQUIRE);
+    uint32_t result;
+    do
+    {
+        switch (op)
+        {
+            case amo_min:
+                result = ((int32_t)old < (int32_t)val) ? old : val;
+                break;
+            case amo_max:
+                result = ((int32_t)old > (int32_t)val) ? old : val;
+                break;
+            case amo_minu:
+                result = (old < val) ? old : val;
+                break;
+            default:
+                result = (old > val) ? old : val;
+                break;
+        }
+    } while (!__atomic_compare_exchange_n(p, &old, result, true, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+    return true;
+}
+
+/**
+* memory::update_fast_path() sets the limits used by the inline accessors. Without watchpoints
+* every access that is entirely inside the RAM is done inline, with watchpoints only the ones
+* touching the pages from the lowest to the highest watched one go through the slow path.
+* @param none
+* @return nothing
+* @note
+* @warning
+* @bug
+*************************************************************************************************************/
+void memory::update_fast_path()
+{
+    uint64_t low = size; // first byte of the lowest watched page
+    uint64_t high = 0; // first byte after the highest watched page
+    for (const watch& w : watches)
+    {
+        low = std::min<uint64_t>(low, w.addr & ~0xfffu);
+        high = std::max<uint64_t>(high, ((uint64_t)w.addr + w.len + 0xfff) & ~0xfffull);
+    }
+    fast_end8 = low;
+    fast_end16 = low > 0 ? low - 1 : 0;
+    fast_end32 = low > 2 ? low - 3 : 0;
+    fast_end64 = low > 6 ? low - 7 : 0;
+    fast_resume = watches.empty() ? size : std::min<uint64_t>(high, size);
+}
+
+/**
+* memory::add_watch(uint32_t addr, uint32_t len, uint32_t kind) sets a watchpoint on the len bytes
+* at addr. Reads (watch_read), writes (watch_write) or both that touch the range are recorded and
+* can be picked up with take_watch_hit().
+* @param uint32_t addr, uint32_t len, uint32_t kind
+* @return false if len or kind is zero
+* @note
+* @warning lr.w, sc.w, amo*.w and host I/O into guest buffers are not watched
+* @bug
+*************************************************************************************************************/
+bool memory::add_watch(uint32_t addr, uint32_t len, uint32_t kind)
+{
+    if (len == 0 || kind == 0)
+    {
+        return false;
+    }
+    if (watch_pages.empty())
+    {
+        watch_pages.resize((1u << 20) / 64);
+    }
+    watches.push_back(watch { addr, len, kind });
+    for (uint64_t page = addr >> 12; page <= ((uint64_t)addr + len - 1) >> 12; page++)
+    {
+        watch_pages[page / 64] |= 1ull << (page % 64);
+    }
+    update_fast_path();
     return true;
 }
+
+/**
+* memory::remove_watch(uint32_t addr, uint32_t len, uint32_t kind) removes a watchpoint set by
+* add_watch() with the same arguments
+* @param uint32_t addr, uint32_t len, uint32_t kind
+* @return false if there was no such watchpoint
+* @note
+* @warning
+* @bug
+*************************************************************************************************************/
+bool memory::remove_watch(uint32_t addr, uint32_t len, uint32_t kind)
+{
+    for (auto it = watches.begin(); it != watches.end(); ++it)
+    {
+        if (it->addr == addr && it->len == len && it->kind == kind)
+        {
+            watches.erase(it);
+            std::fill(watch_pages.begin(), watch_pages.end(), 0);
+            for (const watch& w : watches)
+            {
+                for (uint64_t page = w.addr >> 12; page <= ((uint64_t)w.addr + w.len - 1) >> 12; page++)
+                {
+                    watch_pages[page / 64] |= 1ull << (page % 64);
+                }
+            }
+            update_fast_path();
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+* memory::watching() tells if any watchpoint is set
+* @param none
+* @return true if there is at least one watchpoint
+* @note
+* @warning
+* @bug
+*************************************************************************************************************/
+bool memory::watching() const
+{
+    return !watches.empty();
+}
+
+/**
+* memory::take_watch_hit(uint32_t& addr, uint32_t& kind) reports the first watched access since
+* the last call and forgets it
+* @param uint32_t& addr, uint32_t& kind (set to the address and kind of the access)
+* @return true if a watched access happened
+* @note
+* @warning
+* @bug
+*************************************************************************************************************/
+bool memory::take_watch_hit(uint32_t& addr, uint32_t& kind)
+{
+    if (!watch_hit)
+    {
+        return false;
+    }
+    addr = watch_hit_addr;
+    kind = watch_hit_kind;
+    watch_hit = false;
+    return true;
+}
+
+/**
+* memory::check_watch(uint32_t addr, uint32_t len, uint32_t kind) records the access if it touches
+* a watchpoint of the same kind. The page bitmap rules out most accesses with a single test.
+* @param uint32_t addr, uint32_t len, uint32_t kind
+* @return nothing
+* @note
+* @warning
+* @bug
+*************************************************************************************************************/
+void memory::check_watch(uint32_t addr, uint32_t len, uint32_t kind) const
+{
+    uint32_t first = addr >> 12;
+    uint32_t last = (addr + len - 1) >> 12;
+    if (!(watch_pages[first / 64] >> (first % 64) & 1) && !(watch_pages[last / 64] >> (last % 64) & 1))
+    {
+        return;
+    }
+    for (const watch& w : watches)
+    {
+        if ((w.kind & kind) && addr <= w.addr + (w.len - 1) && w.addr <= addr + (len - 1))
+        {
+            if (!watch_hit)
+            {
+                watch_hit = true;
+                watch_hit_addr = addr;
+                watch_hit_kind = kind;
+            }
+            return;
+        }
+    }
+}
+
+/**
+* memory::note_fault(uint32_t addr, uint32_t len, fault_kind kind) counts an access outside the
+* memory and every device, the first fault_log_size different ones are also counted one by one
+* @param uint32_t addr, uint32_t len, fault_kind kind
+* @return nothing
+* @note
+* @warning
+* @bug
+*************************************************************************************************************/
+void memory::note_fault(uint32_t addr, uint32_t len, fault_kind kind) const
+{
+    std::lock_guard<std::mutex> guard(fault_lock);
+    fault_count++;
+    for (fault& f : fault_log)
+    {
+        if (f.addr == addr && f.len == len && f.kind == kind)
+        {
+            f.count++;
+            return;
+        }
+    }
+    if (fault_log.size() < fault_log_size)
+    {
+        fault_log.push_back(fault { addr, len, kind, 1 });
+    }
+}
+
+/**
+* memory::get_fault_count() tells how many accesses were outside the memory and every device
+* @param none
+* @return the number of faults
+* @note
+* @warning
+* @bug
+*************************************************************************************************************/
+uint64_t memory::get_fault_count() const
+{
+    std::lock_guard<std::mutex> guard(fault_lock);
+    return fault_count;
+}
+
+/**
+* memory::report_faults() prints how many accesses were outside the memory and every device and
+* the first few different ones, nothing if there were none. Called once the harts have stopped,
+* instead of a warning per access while they run.
+* @param none
+* @return nothing
+* @note
+* @warning
+* @bug
+*************************************************************************************************************/
+void memory::report_faults() const
+{
+    static const char* const kinds[] = { "load", "store", "fetch" };
+    std::lock_guard<std::mutex> guard(fault_lock);
+    if (fault_count == 0)
+    {
+        return;
+    }
+    *out << "WARNING: " << fault_count << (fault_count == 1 ? " access" : " accesses") << " out of range:" << std::endl;
+    uint64_t listed = 0;
+    for (const fault& f : fault_log)
+    {
+        *out << "    " << f.count << " x " << kinds[f.kind] << " of " << f.len << " bytes at " << hex0x32(f.addr)
+             << std::endl;
+        listed += f.count;
+    }
+    if (listed < fault_count)
+    {
+        *out << "    " << fault_count - listed << " x elsewhere" << std::endl;
+    }
+}
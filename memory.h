@@ -9,8 +9,14 @@
 #include <fstream>
 #include <stdio.h>
 #include <cstdlib>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include "device.h"
 using namespace std;
 
+class replaylog;
+
 class memory
 {
 public:
@@ -18,17 +24,378 @@ public:
     ~memory(); // destructor protopye
     bool check_address(uint32_t i) const; 
     uint32_t get_size() const; 
+    bool read(uint32_t addr, uint32_t len, uint64_t& val) const; 
+    bool write(uint32_t addr, uint32_t len, uint64_t val); 
+    bool fetch(uint32_t addr, uint32_t& insn) const; 
     uint8_t get8(uint32_t addr) const; 
     uint16_t get16(uint32_t addr) const; 
     uint32_t get32(uint32_t addr) const; 
+    uint64_t get64(uint32_t addr) const; 
+    uint32_t fetch32(uint32_t addr) const; 
     void set8(uint32_t addr, uint8_t val); 
     void set16(uint32_t addr, uint16_t val); 
     void set32(uint32_t addr, uint32_t val); 
+    void set64(uint32_t addr, uint64_t val); 
     void dump() const; 
     bool load_file(const string& fname); 
+    bool load_image(const uint8_t* data, uint32_t len); 
+    uint32_t get_image_size() const; 
+    uint8_t* get_ptr(uint32_t addr, uint32_t len); 
+    bool add_device(uint32_t base, uint32_t len, device* dev); 
+    void reset_devices(); 
+    void set_log(replaylog* l); 
+    void set_output(std::ostream* os); 
+    // read-modify-write operations performed by the RV32A amo*.w instructions
+    enum amo_op { amo_swap, amo_add, amo_xor, amo_and, amo_or, amo_min, amo_max, amo_minu, amo_maxu };
+    bool load_reserved32(uint32_t addr, uint32_t& val) const; 
+    bool store_conditional32(uint32_t addr, uint32_t expected, uint32_t val); 
+    bool amo32(uint32_t addr, amo_op op, uint32_t val, uint32_t& old); 
+    // accesses outside the memory and every device are not printed when they happen, they are
+    // counted and report_faults() sums them up at the end
+    enum fault_kind : uint8_t { fault_load, fault_store, fault_fetch };
+    uint64_t get_fault_count() const; 
+    void report_faults() const; 
+    // kinds of access a watchpoint stops on
+    static constexpr uint32_t watch_read = 1; 
+    static constexpr uint32_t watch_write = 2; 
+    bool add_watch(uint32_t addr, uint32_t len, uint32_t kind); 
+    bool remove_watch(uint32_t addr, uint32_t len, uint32_t kind); 
+    bool watching() const; 
+    bool take_watch_hit(uint32_t& addr, uint32_t& kind); 
+    // writes are tracked per page so that restore() only copies back what changed
+    static constexpr uint32_t page_shift = 12; 
+    void snapshot(); 
+    uint32_t restore(); 
 private:
     uint8_t* mem; // memory simulator array
     uint32_t size; // size of memory
+    // accesses below these addresses take the inline fast path, while watchpoints are set they
+    // stop below the lowest watched page
+    uint32_t fast_end8; 
+    uint32_t fast_end16; 
+    uint32_t fast_end32; 
+    uint32_t fast_end64; 
+    uint32_t fast_resume; // the fast path covers the RAM from here on again (the end of the highest watched page)
+    bool above_watches(uint32_t addr, uint32_t len) const; 
+    uint32_t image_size = 0; // number of bytes read by load_file()
+    struct region
+    {
+        uint32_t base; // first address of the device
+        uint32_t len; // bytes of address space the device covers
+        device* dev; 
+    };
+    std::vector<region> regions; // memory-mapped devices, none of them overlaps the RAM
+    std::ostream* out = &std::cout; // where the fault summary and dumps go
+    replaylog* log = nullptr; // records device reads, or replays them without touching the devices
+    mutable std::atomic<uint32_t> last_region { 0 }; // index of the region that matched last
+    const region* find_region(uint32_t addr) const; 
+    struct watch
+    {
+        uint32_t addr; // first watched byte
+        uint32_t len; 
+        uint32_t kind; // watch_read, watch_write or both
+    };
+    std::vector<watch> watches; 
+    std::vector<uint64_t> watch_pages; // one bit per 4 KiB page that has a watch on it
+    mutable bool watch_hit = false; // set by the slow path, cleared by take_watch_hit()
+    mutable uint32_t watch_hit_addr = 0; 
+    mutable uint32_t watch_hit_kind = 0; 
+    void check_watch(uint32_t addr, uint32_t len, uint32_t kind) const; 
+    struct fault
+    {
+        uint32_t addr; 
+        uint32_t len; 
+        fault_kind kind; 
+        uint64_t count; // times this access faulted
+    };
+    static constexpr uint32_t fault_log_size = 8; 
+    mutable std::mutex fault_lock; // harts on other host threads fault too
+    mutable uint64_t fault_count = 0; 
+    mutable std::vector<fault> fault_log; // the first fault_log_size different faults
+    void note_fault(uint32_t addr, uint32_t len, fault_kind kind) const; 
+    void update_fast_path(); 
+    std::vector<uint8_t> dirty; // one byte per page, set by every write to the RAM
+    std::vector<uint32_t> dirty_pages; // the pages whose dirty byte went up, in that order
+    uint32_t dirty_count = 0; // entries of dirty_pages in use
+    std::vector<uint8_t> pristine; // copy of the RAM taken by snapshot()
+    void mark_dirty(uint32_t addr, uint32_t len); 
+    static uint32_t le32(const uint8_t* p); 
+    bool io_read(uint32_t addr, uint32_t len, uint32_t& val, bool data = true) const; 
+    bool io_write(uint32_t addr, uint32_t len, uint32_t val); 
+    bool io_write64(uint32_t addr, uint64_t val); 
+    bool io_covers(uint32_t addr, uint32_t len) const; 
 };
 
+/*
+ * The accessors are inline so that a RAM access costs one compare against the size, anything
+ * outside the RAM (devices or bad addresses) or any access to the pages between the lowest and
+ * the highest watchpoint goes to the out-of-line io_read()/io_write(). read(), write() and
+ * fetch() tell the caller when an access faulted, the get and set functions are for callers that
+ * don't care.
+ */
+
+/** 
+* memory::above_watches(uint32_t addr, uint32_t len) is the second chance of the fast path for
+* accesses above the watched pages, it is only asked when the access is not below them
+* @param uint32_t addr, uint32_t len
+* @return true if the access is in the RAM and past the highest watched page
+*************************************************************************************************************/
+inline bool memory::above_watches(uint32_t addr, uint32_t len) const
+{
+    return addr >= fast_resume && addr <= size - len;
+}
+
+/** 
+* memory::mark_dirty(uint32_t addr, uint32_t len) flags the pages holding addr..addr+len-1 as
+* written and lists every page whose flag goes up, the flags are updated with relaxed atomics
+* because harts on other host threads write too. Pages that are already dirty cost one load.
+* @param uint32_t addr, uint32_t len (the range must be inside the RAM)
+* @return nothing
+*************************************************************************************************************/
+inline void memory::mark_dirty(uint32_t addr, uint32_t len)
+{
+    for (uint32_t page = addr >> page_shift; page <= (addr + len - 1) >> page_shift; page++)
+    {
+        if (__atomic_load_n(&dirty[page], __ATOMIC_RELAXED) == 0
+            && __atomic_exchange_n(&dirty[page], 1, __ATOMIC_RELAXED) == 0)
+        {
+            dirty_pages[__atomic_fetch_add(&dirty_count, 1, __ATOMIC_RELAXED)] = page;
+        }
+    }
+}
+
+/** 
+* memory::le32(const uint8_t* p) combines the four bytes at p in little-endian
+* @param const uint8_t* p
+* @return 32-bit in little endian
+*************************************************************************************************************/
+inline uint32_t memory::le32(const uint8_t* p)
+{
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+/** 
+* memory::read(uint32_t addr, uint32_t len, uint64_t& val) loads len (1, 2, 4 or 8) bytes at addr
+* combined in little-endian. 8 bytes outside the RAM are read as two 32-bit reads so devices and
+* watchpoints see them the same way.
+* @param uint32_t addr, uint32_t len, uint64_t& val (bytes outside the memory read as zero)
+* @return false if part of the access is outside the memory and every device
+*************************************************************************************************************/
+inline bool memory::read(uint32_t addr, uint32_t len, uint64_t& val) const
+{
+    uint32_t lo, hi;
+    bool ok;
+    switch (len)
+    {
+        case 1:
+            if (addr < fast_end8 || above_watches(addr, 1))
+            {
+                val = mem[addr];
+                return true;
+            }
+            break;
+        case 2:
+            if (addr < fast_end16 || above_watches(addr, 2))
+            {
+                val = mem[addr] | mem[addr + 1] << 8;
+                return true;
+            }
+            break;
+        case 4:
+            if (addr < fast_end32 || above_watches(addr, 4))
+            {
+                val = le32(mem + addr);
+                return true;
+            }
+            break;
+        case 8:
+            if (addr < fast_end64 || above_watches(addr, 8))
+            {
+                val = le32(mem + addr) | (uint64_t)le32(mem + addr + 4) << 32;
+                return true;
+            }
+            ok = io_read(addr, 4, lo);
+            ok = io_read(addr + 4, 4, hi) && ok;
+            val = lo | (uint64_t)hi << 32;
+            return ok;
+        default:
+            break;
+    }
+    ok = io_read(addr, len, lo);
+    val = lo;
+    return ok;
+}
+
+/** 
+* memory::write(uint32_t addr, uint32_t len, uint64_t val) stores the low len (1, 2, 4 or 8) bytes
+* of val at addr in little endian, 8 bytes outside the RAM as two 32-bit writes
+* @param uint32_t addr, uint32_t len, uint64_t val
+* @return false if part of the access is outside the memory and every device, nothing is written
+* then
+*************************************************************************************************************/
+inline bool memory::write(uint32_t addr, uint32_t len, uint64_t val)
+{
+    switch (len)
+    {
+        case 1:
+            if (addr < fast_end8 || above_watches(addr, 1))
+            {
+                mark_dirty(addr, 1);
+                mem[addr] = val & 0xff;
+                return true;
+            }
+            break;
+        case 2:
+            if (addr < fast_end16 || above_watches(addr, 2))
+            {
+                mark_dirty(addr, 2);
+                mem[addr] = val & 0xff;
+                mem[addr + 1] = (val >> 8) & 0xff;
+                return true;
+            }
+            break;
+        case 4:
+            if (addr < fast_end32 || above_watches(addr, 4))
+            {
+                mark_dirty(addr, 4);
+                mem[addr] = val & 0xff;
+                mem[addr + 1] = (val >> 8) & 0xff;
+                mem[addr + 2] = (val >> 16) & 0xff;
+                mem[addr + 3] = (val >> 24) & 0xff;
+                return true;
+            }
+            break;
+        case 8:
+            if (addr < fast_end64 || above_watches(addr, 8))
+            {
+                mark_dirty(addr, 8);
+                for (uint32_t i = 0; i < 8; i++)
+                {
+                    mem[addr + i] = (val >> (8 * i)) & 0xff;
+                }
+                return true;
+            }
+            return io_write64(addr, val);
+        default:
+            break;
+    }
+    return io_write(addr, len, val);
+}
+
+/** 
+* memory::fetch(uint32_t addr, uint32_t& insn) loads the instruction word at addr, like read() but
+* instruction fetches never trigger a data watchpoint
+* @param uint32_t addr, uint32_t& insn
+* @return false if part of the word is outside the memory and every device
+*************************************************************************************************************/
+inline bool memory::fetch(uint32_t addr, uint32_t& insn) const
+{
+    if (addr < size - 3)
+    {
+        insn = le32(mem + addr);
+        return true;
+    }
+    return io_read(addr, 4, insn, false);
+}
+
+/** 
+* memory::get8(uint32_t addr) returns the byte at addr
+* @param uint32_t addr
+* @return value of the byte at that address (zero if nothing is there)
+*************************************************************************************************************/
+inline uint8_t memory::get8(uint32_t addr) const
+{
+    uint64_t val;
+    read(addr, 1, val);
+    return val;
+}
+
+/** 
+* memory::get16(uint32_t addr) returns the two bytes at addr combined in little-endian
+* @param uint32_t addr
+* @return 16-bit in little endian
+*************************************************************************************************************/
+inline uint16_t memory::get16(uint32_t addr) const
+{
+    uint64_t val;
+    read(addr, 2, val);
+    return val;
+}
+
+/** 
+* memory::get32(uint32_t addr) returns the four bytes at addr combined in little-endian
+* @param uint32_t addr
+* @return 32-bit in little endian
+*************************************************************************************************************/
+inline uint32_t memory::get32(uint32_t addr) const
+{
+    uint64_t val;
+    read(addr, 4, val);
+    return val;
+}
+
+/** 
+* memory::get64(uint32_t addr) returns the eight bytes at addr combined in little-endian
+* @param uint32_t addr
+* @return 64-bit in little endian
+*************************************************************************************************************/
+inline uint64_t memory::get64(uint32_t addr) const
+{
+    uint64_t val;
+    read(addr, 8, val);
+    return val;
+}
+
+/** 
+* memory::fetch32(uint32_t addr) returns the instruction word at addr (zero if nothing is there)
+* @param uint32_t addr
+* @return 32-bit in little endian
+*************************************************************************************************************/
+inline uint32_t memory::fetch32(uint32_t addr) const
+{
+    uint32_t insn;
+    fetch(addr, insn);
+    return insn;
+}
+
+/** 
+* memory::set8(uint32_t addr, uint8_t val) stores the byte val at addr
+* @param uint32_t addr, uint8_t val
+* @return nothing
+*************************************************************************************************************/
+inline void memory::set8(uint32_t addr, uint8_t val)
+{
+    write(addr, 1, val);
+}
+
+/** 
+* memory::set16(uint32_t addr, uint16_t val) stores val at addr in little endian
+* @param uint32_t addr, uint16_t val
+* @return nothing
+*************************************************************************************************************/
+inline void memory::set16(uint32_t addr, uint16_t val)
+{
+    write(addr, 2, val);
+}
+
+/** 
+* memory::set32(uint32_t addr, uint32_t val) stores val at addr in little endian
+* @param uint32_t addr, uint32_t val
+* @return nothing
+*************************************************************************************************************/
+inline void memory::set32(uint32_t addr, uint32_t val)
+{
+    write(addr, 4, val);
+}
+
+/** 
+* memory::set64(uint32_t addr, uint64_t val) stores val at addr in little endian
+* @param uint32_t addr, uint64_t val
+* @return nothing
+*************************************************************************************************************/
+inline void memory::set64(uint32_t addr, uint64_t val)
+{
+    write(addr, 8, val);
+}
+
 #endif
@@ -0,0 +1,221 @@
+
+#include "mmu.h"
+
+static constexpr uint32_t satp_mode_sv32 = 1u << 31;
+static constexpr uint32_t satp_ppn = 0x003fffff;
+// PTE fields
+static constexpr uint32_t pte_v = 1 << 0;
+static constexpr uint32_t pte_r = 1 << 1;
+static constexpr uint32_t pte_w = 1 << 2;
+static constexpr uint32_t pte_x = 1 << 3;
+static constexpr uint32_t pte_u = 1 << 4;
+static constexpr uint32_t pte_a = 1 << 6;
+static constexpr uint32_t pte_d = 1 << 7;
+// mcause of the faults, by access_type
+static constexpr uint32_t access_fault[mmu::access_count] = { 1, 5, 7 };
+static constexpr uint32_t page_fault[mmu::access_count] = { 12, 13, 15 };
+
+/**
+ * mmu constructor
+ * @param memory* m (where the page tables are)
+ * @return nothing
+ ********************************************************************************/
+mmu::mmu(memory* m)
+{
+    mem = m;
+    filled = true; // the entries are not initialized yet
+    reset();
+}
+
+/**
+ * Back to Bare mode in M-mode with an empty TLB
+ * @param none
+ * @return none
+ ********************************************************************************/
+void mmu::reset()
+{
+    satp = 0;
+    set_privilege(priv_m, priv_m, false, false);
+    flush();
+}
+
+/**
+ * getter get_satp
+ * @param none
+ * @return the value of the satp CSR
+ ********************************************************************************/
+uint32_t mmu::get_satp() const
+{
+    return satp;
+}
+
+/**
+ * Write satp, which also drops every translation (there are no ASIDs to keep them apart)
+ * @param uint32_t val
+ * @return none
+ ********************************************************************************/
+void mmu::set_satp(uint32_t val)
+{
+    satp = val & (satp_mode_sv32 | satp_ppn);
+    flush();
+    set_privilege(fetch_priv, data_priv, sum, mxr);
+}
+
+/**
+ * Tell the mmu what the next accesses are checked for, called whenever the privilege level or
+ * mstatus changes. Changing the privilege or SUM only picks another part of the TLB, a change of
+ * MXR empties it.
+ * @param uint32_t fetch_priv (the privilege level), uint32_t data_priv (MPP if mstatus.MPRV is
+ * set, else the privilege level), bool sum, bool mxr (mstatus.SUM and mstatus.MXR)
+ * @return none
+ ********************************************************************************/
+void mmu::set_privilege(uint32_t fetch_priv, uint32_t data_priv, bool sum, bool mxr)
+{
+    if (mxr != this->mxr)
+    {
+        flush();
+    }
+    this->fetch_priv = fetch_priv;
+    this->data_priv = data_priv;
+    this->sum = sum;
+    this->mxr = mxr;
+    fetch_on = (satp & satp_mode_sv32) && fetch_priv != priv_m;
+    data_on = (satp & satp_mode_sv32) && data_priv != priv_m;
+    fetch_set = fetch_priv == priv_u ? 0 : 1;
+    data_set = data_priv == priv_u ? 0 : sum ? 2 : 1;
+}
+
+/**
+ * Translate vaddr, from the TLB or by walking the page table (sfence.vma, watchpoints and
+ * satp writes empty the TLB, see flush())
+ * @param uint32_t vaddr, access_type access, uint32_t& paddr (set to the physical address)
+ * @return 0, or the mcause of the page fault or access fault the access raises
+ ********************************************************************************/
+uint32_t mmu::translate(uint32_t vaddr, access_type access, uint32_t& paddr)
+{
+    uint32_t set = access == access_fetch ? fetch_set : data_set;
+    entry& e = tlb[set][access][(vaddr >> page_shift) & (tlb_size - 1)];
+    if ((vaddr & ~offset_mask) != e.vpage)
+    {
+        uint32_t cause = walk(vaddr, access, access == access_fetch ? fetch_priv : data_priv, e);
+        if (cause != 0)
+        {
+            return cause;
+        }
+    }
+    paddr = e.ppage | (vaddr & offset_mask);
+    return 0;
+}
+
+/**
+ * Walk the two-level Sv32 page table for vaddr, check the permissions of the leaf PTE and set
+ * its A bit (and D for stores), then put the translation in e
+ * @param uint32_t vaddr, access_type access, uint32_t priv (checked against the U bit),
+ * entry& e (the TLB entry of vaddr)
+ * @return 0, or the mcause of the fault
+ ********************************************************************************/
+uint32_t mmu::walk(uint32_t vaddr, access_type access, uint32_t priv, entry& e)
+{
+    uint64_t table = (uint64_t)(satp & satp_ppn) << page_shift;
+    uint64_t pte_addr;
+    uint32_t pte;
+    int level = 1;
+    for (;;)
+    {
+        pte_addr = table + ((vaddr >> (page_shift + 10 * level)) & 0x3ff) * 4;
+        if (pte_addr + 4 > mem->get_size())
+        {
+            return access_fault[access]; // page tables have to be in the RAM
+        }
+        pte = mem->get32(pte_addr);
+        if (!(pte & pte_v) || (!(pte & pte_r) && (pte & pte_w)))
+        {
+            return page_fault[access];
+        }
+        if (pte & (pte_r | pte_x))
+        {
+            break; // a leaf
+        }
+        if (level == 0)
+        {
+            return page_fault[access];
+        }
+        level--;
+        table = (uint64_t)(pte >> 10) << page_shift;
+    }
+    bool allowed;
+    switch (access)
+    {
+        case access_fetch:
+            allowed = pte & pte_x;
+            break;
+        case access_load:
+            allowed = (pte & pte_r) || (mxr && (pte & pte_x));
+            break;
+        default:
+            allowed = pte & pte_w;
+            break;
+    }
+    if (pte & pte_u)
+    {
+        allowed = allowed && (priv == priv_u || (access != access_fetch && sum));
+    }
+    else
+    {
+        allowed = allowed && priv != priv_u;
+    }
+    uint64_t ppn = pte >> 10;
+    if (level == 1)
+    {
+        if (ppn & 0x3ff)
+        {
+            return page_fault[access]; // a misaligned megapage
+        }
+        ppn |= (vaddr >> page_shift) & 0x3ff;
+    }
+    if (!allowed)
+    {
+        return page_fault[access];
+    }
+    if (ppn >> (32 - page_shift))
+    {
+        return access_fault[access];
+    }
+    uint32_t ad = access == access_store ? pte_a | pte_d : pte_a;
+    if ((pte & ad) != ad)
+    {
+        mem->set32(pte_addr, pte | ad);
+    }
+    e.vpage = vaddr & ~offset_mask;
+    e.ppage = ppn << page_shift;
+    // get_ptr() marks the page written, which for loads and fetches only costs memory::restore()
+    // a copy
+    e.host = mem->watching() ? nullptr : mem->get_ptr(e.ppage, page_size);
+    filled = true;
+    return 0;
+}
+
+/**
+ * Empty the TLB, for sfence.vma and whenever watchpoints change (watched pages must not be
+ * reached through host pointers)
+ * @param none
+ * @return none
+ ********************************************************************************/
+void mmu::flush()
+{
+    if (!filled)
+    {
+        return;
+    }
+    for (auto& set : tlb)
+    {
+        for (auto& kind : set)
+        {
+            for (entry& e : kind)
+            {
+                e.vpage = no_page;
+            }
+        }
+    }
+    filled = false;
+}
@@ -0,0 +1,113 @@
+
+#ifndef MMU_H
+#define MMU_H
+#include <stdint.h>
+#include "memory.h"
+/**
+ * Sv32 address translation for one hart: satp, the page-table walk and a software TLB. The TLB
+ * is direct-mapped and split by kind of access (fetch, load, store) and by the privilege the
+ * access is checked for, so a hit needs no permission check: it is one compare of the page tag
+ * and, for RAM pages, an add to a host pointer. Misaligned accesses never hit and go through
+ * translate(). The walk sets the A and D bits of the PTEs itself. Only RAM below 4 GiB is
+ * reachable, a physical page above it (Sv32 has 34-bit physical addresses) is an access fault.
+ ********************************************************************************/
+class mmu
+{
+public:
+    // privilege levels as they are encoded in mstatus.MPP
+    static constexpr uint32_t priv_u = 0;
+    static constexpr uint32_t priv_s = 1;
+    static constexpr uint32_t priv_m = 3;
+    enum access_type { access_fetch, access_load, access_store, access_count };
+    static constexpr uint32_t page_shift = 12;
+    static constexpr uint32_t page_size = 1 << page_shift;
+    static constexpr uint32_t offset_mask = page_size - 1;
+    mmu(memory* m); // constructor prototype
+    void reset();
+    uint32_t get_satp() const;
+    void set_satp(uint32_t val);
+    void set_privilege(uint32_t fetch_priv, uint32_t data_priv, bool sum, bool mxr);
+    bool fetch_translated() const;
+    bool data_translated() const;
+    uint8_t* find_fetch(uint32_t vaddr) const;
+    uint8_t* find_data(uint32_t vaddr, uint32_t size, access_type access) const;
+    uint32_t translate(uint32_t vaddr, access_type access, uint32_t& paddr);
+    void flush();
+private:
+    static constexpr uint32_t tlb_size = 256; // entries per kind of access, a power of 2
+    static constexpr uint32_t no_page = 1; // tag of an empty entry, no access matches it
+    // what the TLB is split by: U-mode, S-mode, S-mode with mstatus.SUM set
+    static constexpr uint32_t set_count = 3;
+    struct entry
+    {
+        uint32_t vpage; // virtual address of the page, no_page when empty
+        uint32_t ppage; // physical address of the page
+        uint8_t* host; // the page in the host, nullptr if it is not all RAM or is watched
+    };
+    memory* mem;
+    uint32_t satp = 0; // MODE and PPN, the ASID is not kept so it reads as 0
+    bool fetch_on = false; // Sv32 is on and the hart is below M-mode
+    bool data_on = false; // the same for loads and stores, which may run as MPP with MPRV
+    uint32_t fetch_priv = priv_m;
+    uint32_t data_priv = priv_m;
+    bool sum = false; // S-mode may load and store to U pages
+    bool mxr = false; // loads from execute-only pages are allowed
+    uint32_t fetch_set = 1; // index in tlb of fetch_priv
+    uint32_t data_set = 1; // index in tlb of data_priv and sum
+    bool filled = false; // something has been put into the TLB since the last flush()
+    entry tlb[set_count][access_count][tlb_size];
+    uint32_t walk(uint32_t vaddr, access_type access, uint32_t priv, entry& e);
+};
+
+/**
+ * Is instruction fetch translated
+ * @param none
+ * @return true if satp selects Sv32 and the hart is below M-mode
+ ********************************************************************************/
+inline bool mmu::fetch_translated() const
+{
+    return fetch_on;
+}
+
+/**
+ * Are loads and stores translated
+ * @param none
+ * @return true if satp selects Sv32 and loads and stores run below M-mode (mstatus.MPRV counts)
+ ********************************************************************************/
+inline bool mmu::data_translated() const
+{
+    return data_on;
+}
+
+/**
+ * Look the page of an instruction fetch up in the TLB
+ * @param uint32_t vaddr
+ * @return host pointer to the instruction, nullptr if translate() has to be asked (always for a
+ * pc that is not 4-byte aligned)
+ ********************************************************************************/
+inline uint8_t* mmu::find_fetch(uint32_t vaddr) const
+{
+    const entry& e = tlb[fetch_set][access_fetch][(vaddr >> page_shift) & (tlb_size - 1)];
+    if ((vaddr & (~offset_mask | 3)) == e.vpage && e.host != nullptr)
+    {
+        return e.host + (vaddr & offset_mask);
+    }
+    return nullptr;
+}
+
+/**
+ * Look the page of a load or store up in the TLB, an access that is not aligned to its size
+ * never matches
+ * @param uint32_t vaddr, uint32_t size (1, 2, 4 or 8), access_type access
+ * @return host pointer to the data, nullptr if translate() has to be asked
+ ********************************************************************************/
+inline uint8_t* mmu::find_data(uint32_t vaddr, uint32_t size, access_type access) const
+{
+    const entry& e = tlb[data_set][access][(vaddr >> page_shift) & (tlb_size - 1)];
+    if ((vaddr & (~offset_mask | (size - 1))) == e.vpage && e.host != nullptr)
+    {
+        return e.host + (vaddr & offset_mask);
+    }
+    return nullptr;
+}
+#endif
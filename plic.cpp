@@ -0,0 +1,134 @@
+
+#include "plic.h"
+
+/**
+ * plic constructor
+ * @param rv32i* h
+ * @return nothing
+ ********************************************************************************/
+plic::plic(rv32i* h)
+{
+    hart = h;
+    reset();
+}
+
+/**
+ * plic reset
+ * nothing pending or enabled and every priority 0
+ * @param none
+ * @return none
+ ********************************************************************************/
+void plic::reset()
+{
+    for (uint32_t i = 0; i < sources; i++)
+    {
+        priority[i] = 0;
+    }
+    pending = 0;
+    enable = 0;
+    threshold = 0;
+}
+
+/**
+ * Make interrupt source src pending
+ * @param uint32_t src (1-31)
+ * @return none
+ ********************************************************************************/
+void plic::raise(uint32_t src)
+{
+    if (src > 0 && src < sources)
+    {
+        pending |= 1u << src;
+        update();
+    }
+}
+
+/**
+ * plic read
+ * reading the claim register returns the best pending source and clears its pending bit
+ * @param uint32_t offset, uint32_t len
+ * @return the register value
+ ********************************************************************************/
+uint32_t plic::read(uint32_t offset, uint32_t len)
+{
+    if (offset < reg_priority + 4 * sources)
+    {
+        return priority[offset / 4];
+    }
+    switch (offset)
+    {
+        case reg_pending:
+            return pending;
+        case reg_enable:
+            return enable;
+        case reg_threshold:
+            return threshold;
+        case reg_claim:
+        {
+            uint32_t src = best();
+            pending &= ~(1u << src);
+            update();
+            return src;
+        }
+        default:
+            return 0;
+    }
+}
+
+/**
+ * plic write
+ * priorities, enables and the threshold can be written, writing the claim register
+ * completes an interrupt (nothing to do since sources are edge triggered)
+ * @param uint32_t offset, uint32_t len, uint32_t val
+ * @return none
+ ********************************************************************************/
+void plic::write(uint32_t offset, uint32_t len, uint32_t val)
+{
+    if (offset < reg_priority + 4 * sources)
+    {
+        if (offset >= 4)
+        {
+            priority[offset / 4] = val & 7;
+        }
+    }
+    else if (offset == reg_enable)
+    {
+        enable = val & ~1u;
+    }
+    else if (offset == reg_threshold)
+    {
+        threshold = val & 7;
+    }
+    update();
+}
+
+/**
+ * The pending, enabled source with the highest priority above the threshold
+ * @param none
+ * @return the source number or 0 if there is none
+ ********************************************************************************/
+uint32_t plic::best() const
+{
+    uint32_t src = 0;
+    uint32_t prio = threshold;
+    uint32_t ready = pending & enable;
+    for (uint32_t i = 1; i < sources; i++)
+    {
+        if ((ready & (1u << i)) && priority[i] > prio)
+        {
+            src = i;
+            prio = priority[i];
+        }
+    }
+    return src;
+}
+
+/**
+ * Drive MEIP of the hart
+ * @param none
+ * @return none
+ ********************************************************************************/
+void plic::update()
+{
+    hart->set_interrupt_pending(rv32i::mip_meip, best() != 0);
+}
@@ -0,0 +1,35 @@
+
+#ifndef PLIC_H
+#define PLIC_H
+#include "device.h"
+#include "rv32i.h"
+/**
+ * Platform-level interrupt controller with 31 sources and a single (machine mode) context.
+ * Devices call raise() to make a source pending, the guest claims and completes it through
+ * the claim register. MEIP follows whether a pending, enabled source is above the threshold.
+ ********************************************************************************/
+class plic : public device
+{
+public:
+    static constexpr uint32_t sources = 32; // source 0 does not exist
+    static constexpr uint32_t reg_priority = 0x000000; // 4 bytes per source
+    static constexpr uint32_t reg_pending = 0x001000; 
+    static constexpr uint32_t reg_enable = 0x002000; // context 0
+    static constexpr uint32_t reg_threshold = 0x200000; // context 0
+    static constexpr uint32_t reg_claim = 0x200004; // context 0
+    static constexpr uint32_t size = 0x400000; // bytes of address space used
+    plic(rv32i* h); // constructor prototype
+    void reset() override; 
+    void raise(uint32_t src); 
+    uint32_t read(uint32_t offset, uint32_t len) override; 
+    void write(uint32_t offset, uint32_t len, uint32_t val) override; 
+private:
+    uint32_t best() const; 
+    void update(); 
+    rv32i* hart; // the hart whose MEIP this drives
+    uint32_t priority[sources]; 
+    uint32_t pending = 0; // bit per source
+    uint32_t enable = 0; // bit per source
+    uint32_t threshold = 0; 
+};
+#endif
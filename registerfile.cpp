@@ -6,13 +6,13 @@
  * @param none
  * @return none
  *************************************************************************************************************/
-void registerfile::reset()
+template<uint32_t XLEN>
+void basic_registerfile<XLEN>::reset()
 {
-    reg = new int32_t[32]; // allocate memory
     reg[0] = 0x00000000; // set register 0 to 0x000000
     for (uint32_t i = 1; i < 32; i++)
     {
-        reg[i] = 0xf0f0f0f0; //set the rest of the registers to 0xf0f0f0f0
+        reg[i] = (sreg_t)0xf0f0f0f0f0f0f0f0ull; //set the rest of the registers to 0xf0f0f0f0...
     }
 }
 /**
@@ -22,17 +22,20 @@ void registerfile::reset()
  * @param none
  * @return none
  *************************************************************************************************************/
-registerfile::registerfile()
+template<uint32_t XLEN>
+basic_registerfile<XLEN>::basic_registerfile()
 {
+    reg = new sreg_t[32]; // allocate memory
     reset(); //call reset 
 }
 /**
  * Sets register r to the given value
  * This function sets register r to the given value, if r is zero then we do nothing
- * @param uint32_t r, int32_t val
+ * @param uint32_t r, sreg_t val
  * @return nothing
  *************************************************************************************************************/
-void registerfile::set(uint32_t r, int32_t val)
+template<uint32_t XLEN>
+void basic_registerfile<XLEN>::set(uint32_t r, sreg_t val)
 {
     if (r != 0)
     {
@@ -45,7 +48,8 @@ void registerfile::set(uint32_t r, int32_t val)
  * @param uint32_t r
  * @return the value of register r
  *************************************************************************************************************/
-int32_t registerfile::get(uint32_t r) const
+template<uint32_t XLEN>
+typename basic_registerfile<XLEN>::sreg_t basic_registerfile<XLEN>::get(uint32_t r) const
 {
     if (r == 0)
     {
@@ -59,13 +63,15 @@ int32_t registerfile::get(uint32_t r) const
 /**
  * Dump the registers
  * this function with dump the values of the 32 registers printing 8 registers
- * per line.
- * @param none
+ * per line (4 when they are 64 bits wide).
+ * @param std::ostream& os (std::cout by default)
  * @return none
  *************************************************************************************************************/
-void registerfile::dump() const
+template<uint32_t XLEN>
+void basic_registerfile<XLEN>::dump(std::ostream& os) const
 {
-    int32_t count = 0;
+    const uint32_t per_line = 256 / XLEN;
+    uint32_t count = 0;
     string s = " ";
     uint32_t i = 0;
     while (i < 32)
@@ -74,18 +80,21 @@ void registerfile::dump() const
         {
             s = ""; //no spaces
         }
-        if (count == 8)
+        if (count == per_line)
         {
-            cout << endl; //print a new line after printing 8 registers
+            os << endl; //print a new line after printing a line of registers
             count = 0;
         }
-        if ((i % 8) == 0)
+        if ((i % per_line) == 0)
         {
-            cout << s << "x" << i << " "; //format the numbers x0 x8 x16 x24
+            os << s << "x" << i << " "; //format the numbers x0 x8 x16 x24
         }
         count++;
-        (count % 8 == 0) ? cout << hex32(reg[i]) : cout << hex32(reg[i]) << " "; // print the values of registers
+        std::string val = XLEN == 32 ? hex32(reg[i]) : hex64(reg[i]);
+        (count % per_line == 0) ? os << val : os << val << " "; // print the values of registers
         i++;
     }
-    cout << endl;
+    os << endl;
 }
+template class basic_registerfile<32>;
+template class basic_registerfile<64>;
@@ -4,15 +4,23 @@
 #include <iostream>
 #include "memory.h"
 #include "hex.h"
-class registerfile
+#include <type_traits>
+/**
+ * The 32 integer registers of a hart with XLEN-bit registers (32 or 64)
+ ********************************************************************************/
+template<uint32_t XLEN>
+class basic_registerfile
 {
 public:
-    registerfile(); // constructor
+    // the value of a register as the hart sees it
+    typedef typename std::conditional<XLEN == 64, int64_t, int32_t>::type sreg_t;
+    basic_registerfile(); // constructor
     void reset(); 
-    void set(uint32_t r, int32_t val); 
-    int32_t get(uint32_t r) const; 
-    void dump() const; // function dump prototype
+    void set(uint32_t r, sreg_t val); 
+    sreg_t get(uint32_t r) const; 
+    void dump(std::ostream& os = std::cout) const; // function dump prototype
 private:
-    int32_t* reg; // private array of int32_t elements
+    sreg_t* reg; // private array of XLEN-bit elements
 };
+typedef basic_registerfile<32> registerfile;
 #endif
\ No newline at end of file
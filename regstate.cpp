@@ -0,0 +1,37 @@
+
+#include "regtrace.h"
+#include "registerfile.h"
+#include "hex.h"
+#include <stdlib.h>
+
+/**
+ * Print the registers and the pc after a given instruction of a trace written with rv32i -T, in
+ * the same layout as rv32i -r
+ * usage: rv32i-regstate reg-trace instruction
+ * @param int argc, char** argv
+ * @return 0 on success, 1 on bad arguments or a bad trace
+ ********************************************************************************/
+int main(int argc, char** argv)
+{
+    if (argc != 3)
+    {
+        std::cerr << "Usage: rv32i-regstate reg-trace instruction" << std::endl;
+        std::cerr << "   print the registers as they were after that many instructions (0 = at the start)" << std::endl;
+        return 1;
+    }
+    uint32_t state[33];
+    uint64_t executed;
+    if (!regtrace::reconstruct(argv[1], std::stoull(argv[2]), state, executed))
+    {
+        return 1;
+    }
+    registerfile regs;
+    for (uint32_t r = 0; r < 32; r++)
+    {
+        regs.set(r, state[r]);
+    }
+    std::cout << "after " << std::dec << executed << " instructions" << std::endl;
+    regs.dump();
+    std::cout << " pc " << hex32(state[regtrace::pc_reg]) << std::endl;
+    return 0;
+}
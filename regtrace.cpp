@@ -0,0 +1,274 @@
+
+#include "regtrace.h"
+#include "rv32i.h"
+#include "hex.h"
+#include <sstream>
+#include <ctype.h>
+#include <string.h>
+#include <algorithm>
+
+static constexpr size_t out_buf_limit = 64 * 1024; // write the trace out when this much is buffered
+static const char magic[] = "RV32RTR2"; // first bytes of a binary trace
+
+/**
+ * regtrace destructor
+ * writes out what is still buffered
+ * @param none
+ * @return nothing
+ ********************************************************************************/
+regtrace::~regtrace()
+{
+    flush();
+}
+
+/**
+ * Create the trace file (truncated)
+ * @param const std::string& fname, bool as_text (one change per line instead of binary records)
+ * @return false if the file can't be created
+ ********************************************************************************/
+bool regtrace::open(const std::string& fname, bool as_text)
+{
+    out.open(fname, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!out)
+    {
+        std::cerr << "Can't open file " << fname << " for writing." << std::endl;
+        return false;
+    }
+    text = as_text;
+    if (!text)
+    {
+        buf.append(magic, 8);
+    }
+    return true;
+}
+
+/**
+ * Record the whole state of the hart as instruction 0
+ * @param rv32i* hart
+ * @return none
+ ********************************************************************************/
+void regtrace::begin(rv32i* hart)
+{
+    last = 0;
+    std::fill(shadow, shadow + 33, 0); // reconstruct() starts from all zeros
+    for (uint32_t r = 0; r < 32; r++)
+    {
+        record(0, r, hart->get_register(r));
+    }
+    record(0, pc_reg, hart->get_pc());
+    next_pc = hart->get_pc();
+}
+
+/**
+ * Record what the instruction that just executed changed. The pc is compared with where the
+ * previous instruction left it, a trap or an interrupt taken in between counts as part of this
+ * instruction's jump as reconstruct() can't see it otherwise.
+ * @param const rv32i* hart, const step_info& s
+ * @return none
+ ********************************************************************************/
+void regtrace::after(const rv32i* hart, const step_info& s)
+{
+    uint64_t index = hart->get_insn_counter();
+    shadow[pc_reg] = next_pc + 4;
+    for (uint32_t r = 1; r < 32; r++)
+    {
+        uint32_t val = hart->get_register(r);
+        if (val != shadow[r])
+        {
+            record(index, r, val);
+        }
+    }
+    if (s.next_pc != next_pc + 4)
+    {
+        record(index, pc_reg, s.next_pc);
+    }
+    next_pc = s.next_pc;
+}
+
+/**
+ * Mark where the run ended so that reconstruct() knows how far the pc went on after the last
+ * change
+ * @param rv32i* hart
+ * @return none
+ ********************************************************************************/
+void regtrace::end(rv32i* hart)
+{
+    uint64_t index = hart->get_insn_counter();
+    if (text)
+    {
+        out << std::dec << index << " end\n";
+    }
+    else
+    {
+        put(index - last);
+        buf += (char)end_reg;
+    }
+    last = index;
+    flush();
+}
+
+/**
+ * Add one change to the trace
+ * @param uint64_t index (instruction count after the change), uint32_t r, uint32_t val
+ * (the pc is stored relative to the instruction after the one that changed it, which shadow holds)
+ * @return none
+ ********************************************************************************/
+void regtrace::record(uint64_t index, uint32_t r, uint32_t val)
+{
+    if (text)
+    {
+        out << std::dec << index << " " << (r == pc_reg ? std::string("pc") : "x" + std::to_string(r)) << " "
+            << hex0x32(val) << "\n";
+    }
+    else
+    {
+        put(index - last);
+        buf += (char)r;
+        int32_t d = val - shadow[r];
+        put(((uint32_t)d << 1) ^ (uint32_t)(d >> 31)); // zigzag so small decrements stay short
+        if (buf.size() >= out_buf_limit)
+        {
+            flush();
+        }
+    }
+    last = index;
+    shadow[r] = val;
+}
+
+/**
+ * Append v as an unsigned LEB128 number
+ * @param uint64_t v
+ * @return none
+ ********************************************************************************/
+void regtrace::put(uint64_t v)
+{
+    while (v >= 0x80)
+    {
+        buf += (char)(v | 0x80);
+        v >>= 7;
+    }
+    buf += (char)v;
+}
+
+/**
+ * Write the buffered binary records to the file
+ * @param none
+ * @return none
+ ********************************************************************************/
+void regtrace::flush()
+{
+    if (!buf.empty())
+    {
+        out.write(buf.data(), buf.size());
+        buf.clear();
+    }
+    out.flush();
+}
+
+/**
+ * Read the LEB128 number at p and move p past it
+ * @param const std::string& data, size_t& p, uint64_t& v
+ * @return false at the end of the data
+ ********************************************************************************/
+static bool get_leb(const std::string& data, size_t& p, uint64_t& v)
+{
+    v = 0;
+    for (uint32_t shift = 0; p < data.size() && shift < 64; shift += 7)
+    {
+        uint8_t b = data[p++];
+        v |= (uint64_t)(b & 0x7f) << shift;
+        if (!(b & 0x80))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Rebuild the registers and the pc as they were after index instructions from a trace in either
+ * form
+ * @param const std::string& fname, uint64_t index, uint32_t state[33] (x0-x31 then the pc),
+ * uint64_t& executed (set to index, or to the end of the trace if it ended sooner)
+ * @return false if the file can't be read or is not a register trace
+ ********************************************************************************/
+bool regtrace::reconstruct(const std::string& fname, uint64_t index, uint32_t state[33], uint64_t& executed)
+{
+    std::ifstream in(fname, std::ios::in | std::ios::binary);
+    if (!in)
+    {
+        std::cerr << "Can't open file " << fname << " for reading." << std::endl;
+        return false;
+    }
+    std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    bool binary = data.size() >= 8 && memcmp(data.data(), magic, 8) == 0;
+    std::istringstream lines(binary ? std::string() : data);
+    size_t p = 8;
+    memset(state, 0, 33 * sizeof(uint32_t));
+    uint64_t now = 0; // instructions state[] accounts for
+    uint64_t end = index; // lowered by an end record
+    while (true)
+    {
+        uint64_t i;
+        uint32_t r;
+        uint32_t val = 0;
+        if (binary)
+        {
+            uint64_t delta, z;
+            if (!get_leb(data, p, delta) || p >= data.size())
+                break;
+            r = (uint8_t)data[p++];
+            if (r != end_reg && (r > pc_reg || !get_leb(data, p, z)))
+            {
+                std::cerr << fname << " is not a register trace." << std::endl;
+                return false;
+            }
+            i = now + delta;
+            if (r != end_reg)
+            {
+                // the pc is stored relative to the instruction after the one that changed it (also
+                // when that instruction wrote rd, which moved state[] to i already), the others to
+                // their last value
+                uint32_t base = r == pc_reg ? state[r] + 4 * (i - now) : state[r];
+                val = base + (int32_t)((z >> 1) ^ -(z & 1));
+            }
+        }
+        else
+        {
+            std::string line, name, value;
+            if (!std::getline(lines, line))
+                break;
+            std::istringstream fields(line);
+            fields >> i >> name;
+            r = ~0u;
+            if (name == "pc")
+                r = pc_reg;
+            else if (name == "end")
+                r = end_reg;
+            else if (name.size() > 1 && name[0] == 'x' && isdigit(name[1]))
+                r = std::stoul(name.substr(1));
+            if (r != end_reg)
+                fields >> value;
+            if (!fields || (r > pc_reg && r != end_reg) || i < now)
+            {
+                std::cerr << fname << " is not a register trace." << std::endl;
+                return false;
+            }
+            if (r != end_reg)
+                val = std::stoul(value, nullptr, 16);
+        }
+        if (i > index)
+            break;
+        state[pc_reg] += 4 * (i - now); // no pc record means the pc moved to the next instruction
+        now = i;
+        if (r == end_reg)
+        {
+            end = i;
+            break;
+        }
+        state[r] = val;
+    }
+    executed = std::min(index, end);
+    state[pc_reg] += 4 * (executed - now);
+    return true;
+}
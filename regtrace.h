@@ -0,0 +1,37 @@
+
+#ifndef REGTRACE_H
+#define REGTRACE_H
+#include <fstream>
+#include <string>
+#include <stdint.h>
+#include "insnobserver.h"
+/**
+ * Register trace that only holds changes: the full state once, then (instruction, register, new
+ * value) whenever an instruction changes a register and the pc whenever it does not just move to
+ * the next instruction. The binary form packs every record into a few bytes (LEB128 instruction
+ * delta, register number, zigzag LEB128 value delta), the text form has one change per line.
+ * reconstruct() rebuilds the full state after any instruction.
+ ********************************************************************************/
+class regtrace : public insn_observer
+{
+public:
+    static constexpr uint32_t pc_reg = 32; // register number used for the pc
+    static constexpr uint32_t end_reg = 0xff; // register number of the record that ends a trace
+    ~regtrace(); // destructor prototype
+    bool open(const std::string& fname, bool as_text); 
+    void begin(rv32i* hart) override; 
+    void after(const rv32i* hart, const step_info& s) override; 
+    void end(rv32i* hart) override; 
+    static bool reconstruct(const std::string& fname, uint64_t index, uint32_t state[33], uint64_t& executed); 
+private:
+    std::ofstream out; 
+    bool text = false; 
+    std::string buf; // binary records not written yet
+    uint32_t shadow[33] = {}; // registers and pc as last recorded
+    uint64_t last = 0; // instruction of the last record
+    uint32_t next_pc = 0; // where the pc was after the last instruction
+    void record(uint64_t index, uint32_t r, uint32_t val); 
+    void put(uint64_t v); 
+    void flush(); 
+};
+#endif
@@ -0,0 +1,369 @@
+
+#include "replaylog.h"
+#include "eventqueue.h"
+#include <string.h>
+
+static constexpr size_t out_buf_limit = 64 * 1024; // write the log out when this much is buffered
+static const char magic[] = "RV32LOG1"; // first bytes of every log file
+
+/**
+ * replaylog destructor
+ * makes sure a recording is complete on disk
+ * @param none
+ * @return nothing
+ ********************************************************************************/
+replaylog::~replaylog()
+{
+    flush();
+}
+
+/**
+ * Start recording into fname (truncated)
+ * @param const std::string& fname (empty to keep the log in memory for a follower only)
+ * @return false if the file can't be created
+ ********************************************************************************/
+bool replaylog::record(const std::string& fname)
+{
+    if (!fname.empty())
+    {
+        out.open(fname, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!out)
+        {
+            std::cerr << "Can't open file " << fname << " for writing." << std::endl;
+            return false;
+        }
+    }
+    data.reserve(out_buf_limit);
+    data.append(magic, 8);
+    mode = mode_record;
+    return true;
+}
+
+/**
+ * Load the log in fname and start replaying it
+ * @param const std::string& fname
+ * @return false if the file can't be read or is not a log
+ ********************************************************************************/
+bool replaylog::replay(const std::string& fname)
+{
+    std::ifstream infile(fname, std::ios::in | std::ios::binary);
+    if (!infile)
+    {
+        std::cerr << "Can't open file " << fname << " for reading." << std::endl;
+        return false;
+    }
+    data.assign(std::istreambuf_iterator<char>(infile), std::istreambuf_iterator<char>());
+    if (data.size() < 8 || memcmp(data.data(), magic, 8) != 0)
+    {
+        std::cerr << fname << " is not a replay log." << std::endl;
+        return false;
+    }
+    pos = 8;
+    mode = mode_replay;
+    return true;
+}
+
+/**
+ * Replay the records of leader as it writes them, used to run a second hart in lockstep with
+ * the one that does the real i/o
+ * @param replaylog* leader (recording)
+ * @return none
+ ********************************************************************************/
+void replaylog::follow(replaylog* leader)
+{
+    src = &leader->data;
+    leader->followed = true;
+    pos = 8;
+    mode = mode_replay;
+}
+
+/**
+ * getter is_recording
+ * @param none
+ * @return true in record mode
+ ********************************************************************************/
+bool replaylog::is_recording() const
+{
+    return mode == mode_record;
+}
+
+/**
+ * getter is_replaying
+ * @param none
+ * @return true in replay mode
+ ********************************************************************************/
+bool replaylog::is_replaying() const
+{
+    return mode == mode_replay;
+}
+
+/**
+ * getter is_following
+ * @param none
+ * @return true when replaying another log while it is being recorded
+ ********************************************************************************/
+bool replaylog::is_following() const
+{
+    return src != &data;
+}
+
+/**
+ * getter failed
+ * @param none
+ * @return true once the run asked for something the log does not have next
+ ********************************************************************************/
+bool replaylog::failed() const
+{
+    return bad;
+}
+
+/**
+ * Record or replay a 32-bit input (a device read or a CSR read)
+ * @param uint8_t kind (rec_device or rec_csr), uint32_t& val (recorded, or replaced when
+ * replaying)
+ * @return none
+ ********************************************************************************/
+void replaylog::value(uint8_t kind, uint32_t& val)
+{
+    if (mode == mode_record)
+    {
+        data += kind;
+        put(val);
+    }
+    else if (mode == mode_replay)
+    {
+        uint64_t v;
+        if (expect(kind) && get(v))
+        {
+            val = v;
+        }
+    }
+}
+
+/**
+ * Record or replay a syscall made at instruction when
+ * @param uint64_t when, int32_t& ret (the result, replaced when replaying), memory* mem,
+ * const std::vector<hostio::guest_range>* written (what the call put into guest memory, only used
+ * when recording)
+ * @return none
+ ********************************************************************************/
+void replaylog::syscall(uint64_t when, int32_t& ret, memory* mem, const std::vector<hostio::guest_range>* written)
+{
+    if (mode == mode_record)
+    {
+        data += rec_syscall;
+        put(when);
+        put(((uint32_t)ret << 1) ^ (uint32_t)(ret >> 31)); // zigzag so small negative errors stay short
+        put(written->size());
+        for (const hostio::guest_range& r : *written)
+        {
+            put(r.addr);
+            put(r.len);
+            data.append(reinterpret_cast<const char*>(mem->get_ptr(r.addr, r.len)), r.len);
+        }
+    }
+    else if (mode == mode_replay)
+    {
+        uint64_t w, z, n, addr, len;
+        if (!expect(rec_syscall) || !get(w) || w != when || !get(z) || !get(n))
+        {
+            mismatch();
+            return;
+        }
+        ret = (int32_t)((z >> 1) ^ -(z & 1));
+        for (uint64_t i = 0; i < n; i++)
+        {
+            uint8_t* p;
+            if (!get(addr) || !get(len) || len > src->size() - pos || (p = mem->get_ptr(addr, len)) == nullptr)
+            {
+                mismatch();
+                return;
+            }
+            memcpy(p, &(*src)[pos], len);
+            pos += len;
+        }
+    }
+}
+
+/**
+ * Record or replay something that happened at instruction when (an interrupt or a wfi wake-up)
+ * @param uint8_t kind (rec_interrupt or rec_wfi), uint64_t when, uint64_t& val (the cause or the
+ * wake-up instruction, replaced when replaying)
+ * @return none
+ ********************************************************************************/
+void replaylog::event(uint8_t kind, uint64_t when, uint64_t& val)
+{
+    if (mode == mode_record)
+    {
+        data += kind;
+        put(when);
+        put(val);
+    }
+    else if (mode == mode_replay)
+    {
+        uint64_t w;
+        if (!expect(kind) || !get(w) || w != when || !get(val))
+        {
+            mismatch();
+        }
+    }
+}
+
+/**
+ * Find when the next recorded interrupt has to be delivered
+ * the log is scanned ahead from the current record once per interrupt
+ * @param none
+ * @return the instruction count of the next interrupt or event_queue::never
+ ********************************************************************************/
+uint64_t replaylog::next_interrupt()
+{
+    if (mode != mode_replay || bad)
+    {
+        return event_queue::never;
+    }
+    if (irq_known && irq_pos >= pos)
+    {
+        return irq_when;
+    }
+    size_t p = pos;
+    uint64_t v, n, len;
+    irq_known = true;
+    while (p < src->size())
+    {
+        size_t start = p;
+        switch ((uint8_t)(*src)[p++])
+        {
+            case rec_device:
+            case rec_csr:
+                get_at(p, v);
+                break;
+            case rec_syscall:
+                get_at(p, v);
+                get_at(p, v);
+                get_at(p, n);
+                for (uint64_t i = 0; i < n && p < src->size(); i++)
+                {
+                    get_at(p, v);
+                    get_at(p, len);
+                    p += len;
+                }
+                break;
+            case rec_wfi:
+                get_at(p, v);
+                get_at(p, v);
+                break;
+            case rec_interrupt:
+                get_at(p, irq_when);
+                irq_pos = start;
+                return irq_when;
+            default:
+                p = src->size();
+                break;
+        }
+    }
+    irq_known = !is_following(); // a leader may still record one
+    irq_pos = src->size();
+    irq_when = event_queue::never;
+    return irq_when;
+}
+
+/**
+ * Write the buffered records to the log file
+ * the buffer is only kept when a follower still has to read it
+ * @param none
+ * @return none
+ ********************************************************************************/
+void replaylog::flush()
+{
+    if (mode == mode_record && out.is_open() && data.size() > flushed)
+    {
+        out.write(data.data() + flushed, data.size() - flushed);
+        out.flush();
+        flushed = data.size();
+        if (!followed)
+        {
+            data.clear();
+            flushed = 0;
+        }
+    }
+}
+
+/**
+ * Append v as an unsigned LEB128 number, 7 bits per byte with the top bit set on all but the last
+ * and write the buffer out once it is big enough
+ * @param uint64_t v
+ * @return none
+ ********************************************************************************/
+void replaylog::put(uint64_t v)
+{
+    while (v >= 0x80)
+    {
+        data += (char)(v | 0x80);
+        v >>= 7;
+    }
+    data += (char)v;
+    if (data.size() - flushed >= out_buf_limit)
+    {
+        flush();
+    }
+}
+
+/**
+ * Read the LEB128 number at the current position
+ * @param uint64_t& v
+ * @return false at the end of the log
+ ********************************************************************************/
+bool replaylog::get(uint64_t& v)
+{
+    return get_at(pos, v);
+}
+
+/**
+ * Read the LEB128 number at p and move p past it
+ * @param size_t& p, uint64_t& v
+ * @return false at the end of the log
+ ********************************************************************************/
+bool replaylog::get_at(size_t& p, uint64_t& v) const
+{
+    v = 0;
+    for (uint32_t shift = 0; p < src->size() && shift < 64; shift += 7)
+    {
+        uint8_t b = (*src)[p++];
+        v |= (uint64_t)(b & 0x7f) << shift;
+        if (!(b & 0x80))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Consume the kind byte of the next record
+ * @param uint8_t kind
+ * @return false (after reporting it) if the next record is of a different kind
+ ********************************************************************************/
+bool replaylog::expect(uint8_t kind)
+{
+    if (bad || pos >= src->size() || (uint8_t)(*src)[pos] != kind)
+    {
+        mismatch();
+        return false;
+    }
+    pos++;
+    return true;
+}
+
+/**
+ * Report that the run no longer matches the log, only the first time
+ * @param none
+ * @return none
+ ********************************************************************************/
+void replaylog::mismatch()
+{
+    if (!bad)
+    {
+        std::cerr << "Replay log out of sync at byte " << pos << "." << std::endl;
+    }
+    bad = true;
+}
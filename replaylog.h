@@ -0,0 +1,56 @@
+
+#ifndef REPLAYLOG_H
+#define REPLAYLOG_H
+#include <fstream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "memory.h"
+#include "hostio.h"
+/**
+ * Append-only log of everything that makes a run nondeterministic: syscall results and the guest
+ * memory they wrote, device register reads, reads of CSRs that follow device state, interrupt
+ * delivery points and wfi wake-ups. Recording a run and replaying the log gives the same
+ * instruction stream without touching the host or the devices.
+ ********************************************************************************/
+class replaylog
+{
+public:
+    // record kinds, each record starts with one of these bytes
+    static constexpr uint8_t rec_syscall = 'S'; 
+    static constexpr uint8_t rec_device = 'D'; 
+    static constexpr uint8_t rec_csr = 'C'; 
+    static constexpr uint8_t rec_interrupt = 'I'; 
+    static constexpr uint8_t rec_wfi = 'W'; 
+    ~replaylog(); // destructor prototype
+    bool record(const std::string& fname); 
+    bool replay(const std::string& fname); 
+    void follow(replaylog* leader); 
+    bool is_recording() const; 
+    bool is_replaying() const; 
+    bool is_following() const; 
+    bool failed() const; 
+    void value(uint8_t kind, uint32_t& val); 
+    void syscall(uint64_t when, int32_t& ret, memory* mem, const std::vector<hostio::guest_range>* written); 
+    void event(uint8_t kind, uint64_t when, uint64_t& val); 
+    uint64_t next_interrupt(); 
+    void flush(); 
+private:
+    enum { mode_off, mode_record, mode_replay } mode = mode_off; 
+    std::ofstream out; // record mode, may be closed when only a follower reads the records
+    std::string data; // record mode: records not written to out yet, replay mode: the whole log
+    size_t flushed = 0; // bytes of data already written to out
+    bool followed = false; // a follower reads data, so it is never cleared
+    const std::string* src = &data; // the records being replayed (another log's data when following)
+    size_t pos = 0; // next record in *src
+    size_t irq_pos = 0; // position of the next interrupt record (valid when irq_when is set)
+    uint64_t irq_when = 0; 
+    bool irq_known = false; 
+    bool bad = false; // the replay went out of sync
+    void put(uint64_t v); 
+    bool get(uint64_t& v); 
+    bool get_at(size_t& p, uint64_t& v) const; 
+    bool expect(uint8_t kind); 
+    void mismatch(); 
+};
+#endif
@@ -0,0 +1,255 @@
+
+#include "reuse.h"
+#include "rv32i.h"
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+static constexpr uint32_t opcode_load = 0b0000011; 
+static constexpr uint32_t opcode_store = 0b0100011; 
+static constexpr uint32_t opcode_amo = 0b0101111; 
+static constexpr uint32_t funct5_lr = 0b00010; 
+
+/**
+ * Print a number of bytes with a binary unit
+ * @param std::ostream& os, uint64_t bytes
+ * @return none
+ ********************************************************************************/
+static void print_size(std::ostream& os, uint64_t bytes)
+{
+    static const char* const units[] = { "B", "KiB", "MiB", "GiB" };
+    uint32_t u = 0;
+    while (u < 3 && bytes >= 1024 && bytes % 1024 == 0)
+    {
+        bytes /= 1024;
+        u++;
+    }
+    os << bytes << " " << units[u];
+}
+
+/**
+ * reuse constructor
+ * @param uint32_t mem_size (accesses at or above it, to devices, are not counted),
+ * uint64_t insns_per_interval (instructions per working-set interval)
+ * @return nothing
+ ********************************************************************************/
+reuse::reuse(uint32_t mem_size, uint64_t insns_per_interval)
+{
+    lines = ((uint64_t)mem_size + (1u << line_shift) - 1) >> line_shift;
+    last.assign(lines, 0);
+    seen_in.assign(lines, 0);
+    tree.assign(lines == 0 ? 0 : std::max(2 * lines, 1u << 16) + 1, 0);
+    interval = insns_per_interval;
+}
+
+/**
+ * Start the first working-set interval
+ * @param rv32i* hart
+ * @return none
+ ********************************************************************************/
+void reuse::begin(rv32i* hart)
+{
+    interval_end = hart->get_insn_counter() + interval;
+}
+
+/**
+ * Count the access of a load, store or AMO and close the working-set interval every interval
+ * instructions
+ * @param const rv32i* hart, const step_info& s
+ * @return none
+ ********************************************************************************/
+void reuse::after(const rv32i* hart, const step_info& s)
+{
+    switch (s.insn & 0x7f)
+    {
+        case opcode_load:
+            access(s.data_addr, false);
+            break;
+        case opcode_store:
+            access(s.data_addr, true);
+            break;
+        case opcode_amo:
+            access(s.data_addr, s.insn >> 27 != funct5_lr);
+            break;
+    }
+    if (hart->get_insn_counter() >= interval_end)
+    {
+        end_interval();
+        interval_end += interval;
+    }
+}
+
+/**
+ * Count one load or store
+ * @param uint32_t addr, bool is_store
+ * @return none
+ ********************************************************************************/
+void reuse::access(uint32_t addr, bool is_store)
+{
+    uint32_t line = addr >> line_shift;
+    if (line >= lines)
+    {
+        return;
+    }
+    (is_store ? stores : loads)++;
+    if (seen_in[line] != current)
+    {
+        seen_in[line] = current;
+        touched++;
+    }
+    if (now + 1 == tree.size())
+    {
+        renumber();
+    }
+    now++;
+    if (last[line] == 0)
+    {
+        histogram[buckets - 1]++;
+        distinct++;
+    }
+    else
+    {
+        uint32_t d = sum(now - 1) - sum(last[line]); // lines whose latest access is in between
+        uint32_t b = 0;
+        while (d != 0)
+        {
+            d >>= 1;
+            b++;
+        }
+        histogram[b]++;
+        add(last[line], -1);
+    }
+    add(now, 1);
+    last[line] = now;
+}
+
+/**
+ * Close the current working-set interval
+ * @param none
+ * @return none
+ ********************************************************************************/
+void reuse::end_interval()
+{
+    working_sets.push_back(touched);
+    touched = 0;
+    current++;
+}
+
+/**
+ * getter get_interval
+ * @param none
+ * @return instructions per working-set interval
+ ********************************************************************************/
+uint64_t reuse::get_interval() const
+{
+    return interval;
+}
+
+/**
+ * Print the reuse distance histogram, with the hit ratio of a fully associative LRU cache of
+ * every power-of-two size, and the working set statistics
+ * @param std::ostream& os
+ * @return none
+ ********************************************************************************/
+void reuse::report(std::ostream& os) const
+{
+    uint64_t total = loads + stores;
+    os << std::dec << total << " data accesses (" << loads << " loads, " << stores << " stores) to " << distinct
+       << " distinct " << (1u << line_shift) << "-byte lines" << std::endl;
+    if (total == 0)
+    {
+        return;
+    }
+    os << std::setw(24) << "reuse distance" << std::setw(14) << "accesses" << std::setw(9) << "share"
+       << "   LRU hit ratio with that many lines" << std::endl;
+    uint64_t hits = 0;
+    uint32_t top = buckets - 2;
+    while (top > 0 && histogram[top] == 0)
+        top--;
+    os << std::fixed << std::setprecision(2);
+    for (uint32_t b = 0; b <= top; b++)
+    {
+        uint64_t lo = b == 0 ? 0 : 1ull << (b - 1);
+        uint64_t hi = b == 0 ? 0 : (1ull << b) - 1;
+        hits += histogram[b];
+        std::ostringstream range;
+        range << lo;
+        if (hi != lo)
+            range << "-" << hi;
+        os << std::setw(24) << range.str() << std::setw(14) << histogram[b] << std::setw(8)
+           << 100.0 * histogram[b] / total << "%" << std::setw(10) << 100.0 * hits / total << "% at "
+           << (hi + 1) << " (";
+        print_size(os, (hi + 1) << line_shift);
+        os << ")" << std::endl;
+    }
+    os << std::setw(24) << "cold" << std::setw(14) << histogram[buckets - 1] << std::setw(8)
+       << 100.0 * histogram[buckets - 1] / total << "%" << std::endl;
+    if (!working_sets.empty())
+    {
+        std::vector<uint32_t> sorted = working_sets;
+        std::sort(sorted.begin(), sorted.end());
+        double mean = 0;
+        for (uint32_t w : sorted)
+            mean += w;
+        mean /= sorted.size();
+        os << "working set over " << sorted.size() << " intervals of " << interval << " instructions, in lines: mean "
+           << std::setprecision(1) << mean << ", median " << sorted[sorted.size() / 2] << ", 90th percentile "
+           << sorted[sorted.size() * 9 / 10] << ", max " << sorted.back() << " (";
+        print_size(os, (uint64_t)sorted.back() << line_shift);
+        os << ")" << std::endl;
+    }
+    os.unsetf(std::ios::floatfield);
+}
+
+/**
+ * Add v at time t of the Fenwick tree
+ * @param uint64_t t (1 or more), int32_t v
+ * @return none
+ ********************************************************************************/
+void reuse::add(uint64_t t, int32_t v)
+{
+    for (; t < tree.size(); t += t & -t)
+    {
+        tree[t] += v;
+    }
+}
+
+/**
+ * Sum of the Fenwick tree from time 1 to t
+ * @param uint64_t t
+ * @return the number of lines whose latest access is at or before t
+ ********************************************************************************/
+uint32_t reuse::sum(uint64_t t) const
+{
+    uint32_t s = 0;
+    for (; t > 0; t -= t & -t)
+    {
+        s += tree[t];
+    }
+    return s;
+}
+
+/**
+ * The tree is full: give the lines new times 1, 2, ... in the order of their latest access and
+ * rebuild it, which keeps every distance the same
+ * @param none
+ * @return none
+ ********************************************************************************/
+void reuse::renumber()
+{
+    std::vector<std::pair<uint64_t, uint32_t>> order;
+    for (uint32_t line = 0; line < lines; line++)
+    {
+        if (last[line] != 0)
+            order.push_back(std::make_pair(last[line], line));
+    }
+    std::sort(order.begin(), order.end());
+    std::fill(tree.begin(), tree.end(), 0);
+    now = 0;
+    for (const auto& o : order)
+    {
+        now++;
+        last[o.second] = now;
+        add(now, 1);
+    }
+}
@@ -0,0 +1,47 @@
+
+#ifndef REUSE_H
+#define REUSE_H
+#include <iostream>
+#include <vector>
+#include <stdint.h>
+#include "insnobserver.h"
+/**
+ * Reuse distances and working sets of the data accesses, at cache-line granularity. The reuse
+ * distance of an access is the number of distinct lines touched since the previous access to its
+ * line, so a fully associative LRU cache of n lines hits exactly the accesses with a distance
+ * below n. Distances are counted in a Fenwick tree over access times holding a 1 at the latest
+ * access of every line (O(log n) per access), the times are renumbered when the tree fills up.
+ * The working set is the number of distinct lines touched in each interval of instructions.
+ ********************************************************************************/
+class reuse : public insn_observer
+{
+public:
+    static constexpr uint32_t line_shift = 6; // 64-byte lines
+    reuse(uint32_t mem_size, uint64_t interval); // constructor prototype
+    void begin(rv32i* hart) override; 
+    void after(const rv32i* hart, const step_info& s) override; 
+    void access(uint32_t addr, bool is_store); 
+    void end_interval(); 
+    uint64_t get_interval() const; 
+    void report(std::ostream& os) const; 
+private:
+    static constexpr uint32_t buckets = 34; // distance 0, then 1, 2-3, 4-7, ... and cold misses last
+    uint32_t lines; // lines in the memory
+    std::vector<uint64_t> last; // time of the latest access of each line, 0 = never
+    std::vector<uint32_t> tree; // Fenwick tree over times 1 .. tree.size() - 1
+    uint64_t now = 0; // time of the latest access
+    uint64_t histogram[buckets] = {}; 
+    uint64_t loads = 0; 
+    uint64_t stores = 0; 
+    uint64_t distinct = 0; // lines touched at least once
+    uint64_t interval; // instructions per working-set interval
+    uint64_t interval_end = 0; // instruction count that closes the current interval
+    std::vector<uint32_t> seen_in; // interval in which each line was last touched, + 1
+    uint32_t current = 1; // current interval + 1
+    uint32_t touched = 0; // lines touched in the current interval
+    std::vector<uint32_t> working_sets; // lines touched in every interval that is over
+    void add(uint64_t t, int32_t v); 
+    uint32_t sum(uint64_t t) const; 
+    void renumber(); 
+};
+#endif
@@ -7,11 +7,12 @@
 #include <assert.h>
 #include <iostream>
 #include <bitset>
+#include <algorithm>
+#include <cstring>
 using namespace std;
 static constexpr int mnemonic_width = 8; // width used for formatting
 static constexpr int instruction_width = 35; // width of instruction
 
-static constexpr uint32_t XLEN = 32;
 static constexpr uint32_t opcode_lui = 0b0110111;
 static constexpr uint32_t opcode_auipc = 0b0010111;
 static constexpr uint32_t opcode_jal = 0b1101111;
@@ -23,12 +24,20 @@ static constexpr uint32_t opcode_itype_imm_shamt = 0b0010011;
 static constexpr uint32_t opcode_stype = 0b0100011;
 static constexpr uint32_t opcode_ecall = 0b1110011;
 static constexpr uint32_t opcode_fence = 0b0001111;
+static constexpr uint32_t opcode_amo = 0b0101111;
+static constexpr uint32_t opcode_itype_w = 0b0011011; // RV64I addiw, slliw, srliw, sraiw
+static constexpr uint32_t opcode_rtype_w = 0b0111011; // RV64I addw, subw, sllw, srlw, sraw
+static constexpr uint32_t opcode_vload = 0b0000111; // LOAD-FP, there is no F so only vector loads
+static constexpr uint32_t opcode_vstore = 0b0100111; // STORE-FP
+static constexpr uint32_t opcode_op_v = 0b1010111;
 // I_TYPE LOAD
 static constexpr uint32_t funct3_lb = 0b000;
 static constexpr uint32_t funct3_lh = 0b001;
 static constexpr uint32_t funct3_lw = 0b010;
 static constexpr uint32_t funct3_lbu = 0b100;
 static constexpr uint32_t funct3_lhu = 0b101;
+static constexpr uint32_t funct3_ld = 0b011;
+static constexpr uint32_t funct3_lwu = 0b110;
 // I-TYPE ALU
 static constexpr uint32_t funct3_addi = 0b000;
 static constexpr uint32_t funct3_slti = 0b010;
@@ -62,6 +71,43 @@ static constexpr uint32_t funct3_or = 0b110;
 static constexpr uint32_t funct7_or = 0b0000000;
 static constexpr uint32_t funct3_and = 0b111;
 static constexpr uint32_t funct7_and = 0b0000000;
+// ZBA / ZBB, funct7 in OP and OP-IMM, the unary ones are told apart by the rs2 field
+static constexpr uint32_t funct7_shadd = 0b0010000; // sh1add, sh2add, sh3add
+static constexpr uint32_t funct7_andn = 0b0100000; // andn, orn, xnor
+static constexpr uint32_t funct7_minmax = 0b0000101; // min, minu, max, maxu
+static constexpr uint32_t funct7_zext_h = 0b0000100;
+static constexpr uint32_t funct7_rotate = 0b0110000; // rol, ror, rori and clz, ctz, cpop, sext.b, sext.h
+static constexpr uint32_t funct7_orc_b = 0b0010100;
+static constexpr uint32_t funct7_rev8_32 = 0b0110100;
+static constexpr uint32_t funct7_rev8_64 = 0b0110101;
+static constexpr uint32_t rs2_orc_b = 0b00111;
+static constexpr uint32_t rs2_rev8 = 0b11000;
+// V-EXTENSION, funct3 of OP-V says where the operands come from, funct6 is bits 31-26 and vm
+// (bit 25) must be 1, masked instructions are not in the subset
+static constexpr uint32_t funct3_opivv = 0b000;
+static constexpr uint32_t funct3_opmvv = 0b010;
+static constexpr uint32_t funct3_opivi = 0b011;
+static constexpr uint32_t funct3_opivx = 0b100;
+static constexpr uint32_t funct3_opmvx = 0b110;
+static constexpr uint32_t funct3_opcfg = 0b111;
+static constexpr uint32_t funct6_vadd = 0b000000;
+static constexpr uint32_t funct6_vsub = 0b000010;
+static constexpr uint32_t funct6_vrsub = 0b000011;
+static constexpr uint32_t funct6_vminu = 0b000100;
+static constexpr uint32_t funct6_vmin = 0b000101;
+static constexpr uint32_t funct6_vmaxu = 0b000110;
+static constexpr uint32_t funct6_vmax = 0b000111;
+static constexpr uint32_t funct6_vand = 0b001001;
+static constexpr uint32_t funct6_vor = 0b001010;
+static constexpr uint32_t funct6_vxor = 0b001011;
+static constexpr uint32_t funct6_vmv = 0b010111; // vmv.v.v, vmv.v.x, vmv.v.i
+static constexpr uint32_t funct6_vredmax = 0b000111; // vredsum .. vredmax are 0 .. 7 in OPMVV
+static constexpr uint32_t funct6_vxunary0 = 0b010000; // vmv.x.s in OPMVV, vmv.s.x in OPMVX
+static constexpr uint32_t funct6_vmul = 0b100101;
+// loads and stores, funct3 is the element width and funct7 = nf, mew, mop, vm
+static constexpr uint32_t funct7_vunit = 0b0000001;
+static constexpr uint32_t funct7_vstrided = 0b0000101;
+static constexpr uint8_t vmem_eew[8] = { 8, 0, 0, 0, 0, 16, 32, 64 }; // by funct3, 0 = not a vector width
 // B-TYPE
 static constexpr uint32_t funct3_beq = 0b000;
 static constexpr uint32_t funct3_bne = 0b001;
@@ -73,255 +119,862 @@ static constexpr uint32_t funct3_bgeu = 0b111;
 static constexpr uint32_t funct3_sb = 0b000;
 static constexpr uint32_t funct3_sh = 0b001;
 static constexpr uint32_t funct3_sw = 0b010;
+static constexpr uint32_t funct3_sd = 0b011;
+// A-EXTENSION (funct5 is bits 31-27, aq/rl are bits 26-25)
+static constexpr uint32_t funct3_amo_w = 0b010;
+static constexpr uint32_t funct5_lr = 0b00010;
+static constexpr uint32_t funct5_sc = 0b00011;
+static constexpr uint32_t funct5_amoswap = 0b00001;
+static constexpr uint32_t funct5_amoadd = 0b00000;
+static constexpr uint32_t funct5_amoxor = 0b00100;
+static constexpr uint32_t funct5_amoand = 0b01100;
+static constexpr uint32_t funct5_amoor = 0b01000;
+static constexpr uint32_t funct5_amomin = 0b10000;
+static constexpr uint32_t funct5_amomax = 0b10100;
+static constexpr uint32_t funct5_amominu = 0b11000;
+static constexpr uint32_t funct5_amomaxu = 0b11100;
+// SYSTEM (opcode_ecall), funct3 = 0 is told apart by the 12-bit immediate
+static constexpr uint32_t funct3_priv = 0b000;
+static constexpr uint32_t funct3_csrrw = 0b001;
+static constexpr uint32_t funct3_csrrs = 0b010;
+static constexpr uint32_t funct3_csrrc = 0b011;
+static constexpr uint32_t funct3_csrrwi = 0b101;
+static constexpr uint32_t funct3_csrrsi = 0b110;
+static constexpr uint32_t funct3_csrrci = 0b111;
+static constexpr uint32_t funct12_ecall = 0x000;
+static constexpr uint32_t funct12_ebreak = 0x001;
+static constexpr uint32_t funct12_mret = 0x302;
+static constexpr uint32_t funct12_sret = 0x102;
+static constexpr uint32_t funct12_wfi = 0x105;
+static constexpr uint32_t funct7_sfence_vma = 0b0001001; // rs1 and rs2 in the low bits of funct12
+// CSR numbers
+static constexpr uint32_t csr_sstatus = 0x100;
+static constexpr uint32_t csr_sie = 0x104;
+static constexpr uint32_t csr_stvec = 0x105;
+static constexpr uint32_t csr_scounteren = 0x106;
+static constexpr uint32_t csr_sscratch = 0x140;
+static constexpr uint32_t csr_sepc = 0x141;
+static constexpr uint32_t csr_scause = 0x142;
+static constexpr uint32_t csr_stval = 0x143;
+static constexpr uint32_t csr_sip = 0x144;
+static constexpr uint32_t csr_mstatus = 0x300;
+static constexpr uint32_t csr_misa = 0x301;
+static constexpr uint32_t csr_medeleg = 0x302;
+static constexpr uint32_t csr_mideleg = 0x303;
+static constexpr uint32_t csr_mie = 0x304;
+static constexpr uint32_t csr_mtvec = 0x305;
+static constexpr uint32_t csr_mcounteren = 0x306;
+static constexpr uint32_t csr_mscratch = 0x340;
+static constexpr uint32_t csr_mepc = 0x341;
+static constexpr uint32_t csr_mcause = 0x342;
+static constexpr uint32_t csr_mtval = 0x343;
+static constexpr uint32_t csr_mip = 0x344;
+static constexpr uint32_t csr_mcycle = 0xb00;
+static constexpr uint32_t csr_minstret = 0xb02;
+static constexpr uint32_t csr_mcycleh = 0xb80;
+static constexpr uint32_t csr_minstreth = 0xb82;
+static constexpr uint32_t csr_cycle = 0xc00;
+static constexpr uint32_t csr_time = 0xc01;
+static constexpr uint32_t csr_instret = 0xc02;
+static constexpr uint32_t csr_cycleh = 0xc80;
+static constexpr uint32_t csr_timeh = 0xc81;
+static constexpr uint32_t csr_instreth = 0xc82;
+static constexpr uint32_t csr_mhartid = 0xf14;
+static constexpr uint32_t csr_satp = 0x180;
+static constexpr uint32_t csr_vstart = 0x008;
+static constexpr uint32_t csr_vl = 0xc20;
+static constexpr uint32_t csr_vtype = 0xc21;
+static constexpr uint32_t csr_vlenb = 0xc22;
+// mstatus fields
+static constexpr uint32_t mstatus_sie = 1 << 1;
+static constexpr uint32_t mstatus_mie = 1 << 3;
+static constexpr uint32_t mstatus_spie = 1 << 5;
+static constexpr uint32_t mstatus_mpie = 1 << 7;
+static constexpr uint32_t mstatus_spp = 1 << 8;
+static constexpr uint32_t mstatus_mpp = 3 << 11;
+static constexpr uint32_t mstatus_mprv = 1 << 17;
+static constexpr uint32_t mstatus_sum = 1 << 18;
+static constexpr uint32_t mstatus_mxr = 1 << 19;
+static constexpr uint32_t mstatus_tvm = 1 << 20;
+static constexpr uint32_t mstatus_tw = 1 << 21;
+static constexpr uint32_t mstatus_tsr = 1 << 22;
+static constexpr uint32_t mstatus_mpp_shift = 11;
+static constexpr uint32_t mstatus_writable = mstatus_sie | mstatus_mie | mstatus_spie | mstatus_mpie | mstatus_spp
+    | mstatus_mpp | mstatus_mprv | mstatus_sum | mstatus_mxr | mstatus_tvm | mstatus_tw | mstatus_tsr;
+static constexpr uint32_t sstatus_fields = mstatus_sie | mstatus_spie | mstatus_spp | mstatus_sum | mstatus_mxr;
+// interrupts that can go to S-mode, and the exceptions (all but ecall from M-mode)
+static constexpr uint32_t mideleg_writable = rv32i::mip_ssip | rv32i::mip_stip | rv32i::mip_seip;
+static constexpr uint32_t medeleg_writable = 0xb3ff;
+static constexpr uint32_t counteren_writable = 0b111; // cycle, time, instret
+// mcause of the exceptions
+static constexpr uint32_t cause_insn_misaligned = 0;
+static constexpr uint32_t cause_illegal = 2;
+static constexpr uint32_t cause_load_misaligned = 4;
+static constexpr uint32_t cause_store_misaligned = 6;
+static constexpr uint32_t cause_ecall_u = 8; // plus the privilege level
+// mcause of an access outside the memory and every device, by mmu::access_type
+static constexpr uint32_t cause_access_fault[mmu::access_count] = { 1, 5, 7 };
+static constexpr uint32_t cause_tval_address = 0xb0f3; // the exceptions whose mtval is an address
+// what the trace says about an exception, by mcause
+static const char* const exception_names[] = {
+    "instruction address misaligned", "instruction access fault", "illegal instruction", "breakpoint",
+    "load address misaligned", "load access fault", "store address misaligned", "store access fault",
+    "ecall from U-mode", "ecall from S-mode", "reserved", "ecall from M-mode",
+    "instruction page fault", "load page fault", "reserved", "store page fault"
+};
+static constexpr uint32_t misa_extensions = (1 << 0) | (1 << 8) | (1 << 18) | (1 << 20) | (1 << 21); // AISUV
 
-/**
- * rv32i constructor
- * saves the m argumen in the mem variable which will be used later for disassembling
- * @param memory* m
- * @return nothing
- * @note
- * @warning
- * @bug
- *
- ********************************************************************************/
-rv32i::rv32i(memory* m)
+// what an instruction decodes to, one entry of insn_infos per value
+enum insn_op : uint8_t
 {
-    mem = m;
-}
-
-/**
- * dissambles the instruction in the simulated memory
- * For every 32-bit word in the memory it prints the 32-bit hex address, fetches the 32-bit
- * instruction from memory at the address in the pc register, prints the instruction, passes
- * te fetched instruction to decode and render the instruction into a string.
- * @param none
- * @return none
- * @note
- * @warning
- * @bug
- ********************************************************************************/
-void rv32i::disasm(void)
+    op_illegal, op_lui, op_auipc, op_jal, op_jalr,
+    op_beq, op_bne, op_blt, op_bge, op_bltu, op_bgeu,
+    op_lb, op_lh, op_lw, op_lbu, op_lhu,
+    op_sb, op_sh, op_sw,
+    op_addi, op_slti, op_sltiu, op_xori, op_ori, op_andi, op_slli, op_srli, op_srai,
+    op_add, op_sub, op_sll, op_slt, op_sltu, op_xor, op_srl, op_sra, op_or, op_and,
+    op_fence,
+    op_priv, // ecall, ebreak, mret, sret, wfi or sfence.vma, told apart by funct12 in lookup()
+    op_ecall, op_ebreak, op_mret, op_sret, op_wfi, op_sfence_vma,
+    op_csrrw, op_csrrs, op_csrrc, op_csrrwi, op_csrrsi, op_csrrci,
+    op_lr_w, op_sc_w, op_amoswap_w, op_amoadd_w, op_amoxor_w, op_amoand_w, op_amoor_w,
+    op_amomin_w, op_amomax_w, op_amominu_w, op_amomaxu_w,
+    op_ld, op_lwu, op_sd, op_addiw, op_slliw, op_srliw, op_sraiw, // RV64I only
+    op_addw, op_subw, op_sllw, op_srlw, op_sraw,
+    op_sh1add, op_sh2add, op_sh3add, // Zba
+    op_andn, op_orn, op_xnor, op_min, op_minu, op_max, op_maxu, op_rol, op_ror, op_rori, // Zbb
+    op_clz, op_ctz, op_cpop, op_sext_b, op_sext_h,
+    op_vsetvli, op_vsetivli, op_vsetvl, // V, the vv, vx and vi forms of an operation are in this order
+    op_vlse8_v, op_vlse16_v, op_vlse32_v, op_vlse64_v, op_vsse8_v, op_vsse16_v, op_vsse32_v, op_vsse64_v,
+    op_vadd_vv, op_vadd_vx, op_vadd_vi, op_vsub_vv, op_vsub_vx, op_vrsub_vx, op_vrsub_vi,
+    op_vminu_vv, op_vminu_vx, op_vmin_vv, op_vmin_vx, op_vmaxu_vv, op_vmaxu_vx, op_vmax_vv, op_vmax_vx,
+    op_vand_vv, op_vand_vx, op_vand_vi, op_vor_vv, op_vor_vx, op_vor_vi, op_vxor_vv, op_vxor_vx, op_vxor_vi,
+    op_vmul_vv, op_vmul_vx,
+    op_vredsum_vs, op_vredand_vs, op_vredor_vs, op_vredxor_vs,
+    op_vredminu_vs, op_vredmin_vs, op_vredmaxu_vs, op_vredmax_vs,
+    op_unary, // clz, ctz, cpop, sext.b or sext.h, told apart by rs2 in lookup()
+    op_orc_b, op_rev8, op_vmv_x_s, // from op_unary on lookup() checks more fields, see refine()
+    op_zext_h, op_vle8_v, op_vle16_v, op_vle32_v, op_vle64_v, op_vse8_v, op_vse16_v, op_vse32_v, op_vse64_v,
+    op_vmv_v_v, op_vmv_v_x, op_vmv_v_i, op_vmv_s_x,
+    op_count
+};
+// which render_xxx() decode() uses for an instruction
+enum insn_format : uint8_t
 {
-    while (pc < (mem->get_size()))
-    {
-        std::cout << hex32(pc) << " : "; // prints the 32-bit hex address
-        std::cout << decode(mem->get32(pc)) << std::endl; // prints the decoded instructions
-        pc += 4; // increment pc by 4
-    }
-}
+    format_illegal, format_lui, format_auipc, format_jal, format_jalr, format_btype, format_load,
+    format_stype, format_alu, format_shamt, format_rtype, format_fence, format_bare, format_mret,
+    format_sret, format_wfi, format_sfence, format_csr, format_csri, format_lr, format_amo, format_unary, format_vsetvl, format_vmem,
+    format_varith, format_vmv
+};
+template<uint32_t XLEN>
+struct insn_info
+{
+    const char* mnemonic; 
+    insn_format format; 
+    void (rvhart<XLEN>::*exec)(uint32_t insn, std::ostream* pos); 
+};
+// indexed by insn_op, one per XLEN
+template<uint32_t XLEN>
+static constexpr insn_info<XLEN> insn_infos[op_count] = {
+    { "", format_illegal, &rvhart<XLEN>::exec_illegal_insn },
+    { "lui", format_lui, &rvhart<XLEN>::exec_lui },
+    { "auipc", format_auipc, &rvhart<XLEN>::exec_auipc },
+    { "jal", format_jal, &rvhart<XLEN>::exec_jal },
+    { "jalr", format_jalr, &rvhart<XLEN>::exec_jalr },
+    { "beq", format_btype, &rvhart<XLEN>::exec_beq },
+    { "bne", format_btype, &rvhart<XLEN>::exec_bne },
+    { "blt", format_btype, &rvhart<XLEN>::exec_blt },
+    { "bge", format_btype, &rvhart<XLEN>::exec_bge },
+    { "bltu", format_btype, &rvhart<XLEN>::exec_bltu },
+    { "bgeu", format_btype, &rvhart<XLEN>::exec_bgeu },
+    { "lb", format_load, &rvhart<XLEN>::exec_lb },
+    { "lh", format_load, &rvhart<XLEN>::exec_lh },
+    { "lw", format_load, &rvhart<XLEN>::exec_lw },
+    { "lbu", format_load, &rvhart<XLEN>::exec_lbu },
+    { "lhu", format_load, &rvhart<XLEN>::exec_lhu },
+    { "sb", format_stype, &rvhart<XLEN>::exec_sb },
+    { "sh", format_stype, &rvhart<XLEN>::exec_sh },
+    { "sw", format_stype, &rvhart<XLEN>::exec_sw },
+    { "addi", format_alu, &rvhart<XLEN>::exec_addi },
+    { "slti", format_alu, &rvhart<XLEN>::exec_slti },
+    { "sltiu", format_alu, &rvhart<XLEN>::exec_sltiu },
+    { "xori", format_alu, &rvhart<XLEN>::exec_xori },
+    { "ori", format_alu, &rvhart<XLEN>::exec_ori },
+    { "andi", format_alu, &rvhart<XLEN>::exec_andi },
+    { "slli", format_shamt, &rvhart<XLEN>::exec_slli },
+    { "srli", format_shamt, &rvhart<XLEN>::exec_srli },
+    { "srai", format_shamt, &rvhart<XLEN>::exec_srai },
+    { "add", format_rtype, &rvhart<XLEN>::exec_add },
+    { "sub", format_rtype, &rvhart<XLEN>::exec_sub },
+    { "sll", format_rtype, &rvhart<XLEN>::exec_sll },
+    { "slt", format_rtype, &rvhart<XLEN>::exec_slt },
+    { "sltu", format_rtype, &rvhart<XLEN>::exec_sltu },
+    { "xor", format_rtype, &rvhart<XLEN>::exec_xor },
+    { "srl", format_rtype, &rvhart<XLEN>::exec_srl },
+    { "sra", format_rtype, &rvhart<XLEN>::exec_sra },
+    { "or", format_rtype, &rvhart<XLEN>::exec_or },
+    { "and", format_rtype, &rvhart<XLEN>::exec_and },
+    { "fence", format_fence, &rvhart<XLEN>::exec_fence },
+    { "", format_illegal, &rvhart<XLEN>::exec_illegal_insn }, // op_priv never gets past lookup()
+    { "ecall", format_bare, &rvhart<XLEN>::exec_ecall },
+    { "ebreak", format_bare, &rvhart<XLEN>::exec_ebreak },
+    { "mret", format_mret, &rvhart<XLEN>::exec_mret },
+    { "sret", format_sret, &rvhart<XLEN>::exec_sret },
+    { "wfi", format_wfi, &rvhart<XLEN>::exec_wfi },
+    { "sfence.vma", format_sfence, &rvhart<XLEN>::exec_sfence_vma },
+    { "csrrw", format_csr, &rvhart<XLEN>::exec_csrrw },
+    { "csrrs", format_csr, &rvhart<XLEN>::exec_csrrs },
+    { "csrrc", format_csr, &rvhart<XLEN>::exec_csrrc },
+    { "csrrwi", format_csri, &rvhart<XLEN>::exec_csrrwi },
+    { "csrrsi", format_csri, &rvhart<XLEN>::exec_csrrsi },
+    { "csrrci", format_csri, &rvhart<XLEN>::exec_csrrci },
+    { "lr.w", format_lr, &rvhart<XLEN>::exec_lr_w },
+    { "sc.w", format_amo, &rvhart<XLEN>::exec_sc_w },
+    { "amoswap.w", format_amo, &rvhart<XLEN>::exec_amoswap_w },
+    { "amoadd.w", format_amo, &rvhart<XLEN>::exec_amoadd_w },
+    { "amoxor.w", format_amo, &rvhart<XLEN>::exec_amoxor_w },
+    { "amoand.w", format_amo, &rvhart<XLEN>::exec_amoand_w },
+    { "amoor.w", format_amo, &rvhart<XLEN>::exec_amoor_w },
+    { "amomin.w", format_amo, &rvhart<XLEN>::exec_amomin_w },
+    { "amomax.w", format_amo, &rvhart<XLEN>::exec_amomax_w },
+    { "amominu.w", format_amo, &rvhart<XLEN>::exec_amominu_w },
+    { "amomaxu.w", format_amo, &rvhart<XLEN>::exec_amomaxu_w },
+    { "ld", format_load, &rvhart<XLEN>::exec_ld },
+    { "lwu", format_load, &rvhart<XLEN>::exec_lwu },
+    { "sd", format_stype, &rvhart<XLEN>::exec_sd },
+    { "addiw", format_alu, &rvhart<XLEN>::exec_addiw },
+    { "slliw", format_shamt, &rvhart<XLEN>::exec_slliw },
+    { "srliw", format_shamt, &rvhart<XLEN>::exec_srliw },
+    { "sraiw", format_shamt, &rvhart<XLEN>::exec_sraiw },
+    { "addw", format_rtype, &rvhart<XLEN>::exec_addw },
+    { "subw", format_rtype, &rvhart<XLEN>::exec_subw },
+    { "sllw", format_rtype, &rvhart<XLEN>::exec_sllw },
+    { "srlw", format_rtype, &rvhart<XLEN>::exec_srlw },
+    { "sraw", format_rtype, &rvhart<XLEN>::exec_sraw },
+    { "sh1add", format_rtype, &rvhart<XLEN>::exec_sh1add },
+    { "sh2add", format_rtype, &rvhart<XLEN>::exec_sh2add },
+    { "sh3add", format_rtype, &rvhart<XLEN>::exec_sh3add },
+    { "andn", format_rtype, &rvhart<XLEN>::exec_andn },
+    { "orn", format_rtype, &rvhart<XLEN>::exec_orn },
+    { "xnor", format_rtype, &rvhart<XLEN>::exec_xnor },
+    { "min", format_rtype, &rvhart<XLEN>::exec_min },
+    { "minu", format_rtype, &rvhart<XLEN>::exec_minu },
+    { "max", format_rtype, &rvhart<XLEN>::exec_max },
+    { "maxu", format_rtype, &rvhart<XLEN>::exec_maxu },
+    { "rol", format_rtype, &rvhart<XLEN>::exec_rol },
+    { "ror", format_rtype, &rvhart<XLEN>::exec_ror },
+    { "rori", format_shamt, &rvhart<XLEN>::exec_rori },
+    { "clz", format_unary, &rvhart<XLEN>::exec_clz },
+    { "ctz", format_unary, &rvhart<XLEN>::exec_ctz },
+    { "cpop", format_unary, &rvhart<XLEN>::exec_cpop },
+    { "sext.b", format_unary, &rvhart<XLEN>::exec_sext_b },
+    { "sext.h", format_unary, &rvhart<XLEN>::exec_sext_h },
+    { "vsetvli", format_vsetvl, &rvhart<XLEN>::exec_vsetvl },
+    { "vsetivli", format_vsetvl, &rvhart<XLEN>::exec_vsetvl },
+    { "vsetvl", format_rtype, &rvhart<XLEN>::exec_vsetvl },
+    { "vlse8.v", format_vmem, &rvhart<XLEN>::exec_vload },
+    { "vlse16.v", format_vmem, &rvhart<XLEN>::exec_vload },
+    { "vlse32.v", format_vmem, &rvhart<XLEN>::exec_vload },
+    { "vlse64.v", format_vmem, &rvhart<XLEN>::exec_vload },
+    { "vsse8.v", format_vmem, &rvhart<XLEN>::exec_vstore },
+    { "vsse16.v", format_vmem, &rvhart<XLEN>::exec_vstore },
+    { "vsse32.v", format_vmem, &rvhart<XLEN>::exec_vstore },
+    { "vsse64.v", format_vmem, &rvhart<XLEN>::exec_vstore },
+    { "vadd.vv", format_varith, &rvhart<XLEN>::exec_varith },
+    { "vadd.vx", format_varith, &rvhart<XLEN>::exec_varith },
+    { "vadd.vi", format_varith, &rvhart<XLEN>::exec_varith },
+    { "vsub.vv", format_varith, &rvhart<XLEN>::exec_varith },
+    { "vsub.vx", format_varith, &rvhart<XLEN>::exec_varith },
+    { "vrsub.vx", format_varith, &rvhart<XLEN>::exec_varith },
+    { "vrsub.vi", format_varith, &rvhart<XLEN>::exec_varith },
+    { "vminu.vv", format_varith, &rvhart<XLEN>::exec_varith },
+    { "vminu.vx", format_varith, &rvhart<XLEN>::exec_varith },
+    { "vmin.vv", format_varith, &rvhart<XLEN>::exec_varith },
+    { "vmin.vx", format_varith, &rvhart<XLEN>::exec_varith },
+    { "vmaxu.vv", format_varith, &rvhart<XLEN>::exec_varith },
+    { "vmaxu.vx", format_varith, &rvhart<XLEN>::exec_varith },
+    { "vmax.vv", format_varith, &rvhart<XLEN>::exec_varith },
+    { "vmax.vx", format_varith, &rvhart<XLEN>::exec_varith },
+    { "vand.vv", format_varith, &rvhart<XLEN>::exec_varith },
+    { "vand.vx", format_varith, &rvhart<XLEN>::exec_varith },
+    { "vand.vi", format_varith, &rvhart<XLEN>::exec_varith },
+    { "vor.vv", format_varith, &rvhart<XLEN>::exec_varith },
+    { "vor.vx", format_varith, &rvhart<XLEN>::exec_varith },
+    { "vor.vi", format_varith, &rvhart<XLEN>::exec_varith },
+    { "vxor.vv", format_varith, &rvhart<XLEN>::exec_varith },
+    { "vxor.vx", format_varith, &rvhart<XLEN>::exec_varith },
+    { "vxor.vi", format_varith, &rvhart<XLEN>::exec_varith },
+    { "vmul.vv", format_varith, &rvhart<XLEN>::exec_varith },
+    { "vmul.vx", format_varith, &rvhart<XLEN>::exec_varith },
+    { "vredsum.vs", format_varith, &rvhart<XLEN>::exec_vred },
+    { "vredand.vs", format_varith, &rvhart<XLEN>::exec_vred },
+    { "vredor.vs", format_varith, &rvhart<XLEN>::exec_vred },
+    { "vredxor.vs", format_varith, &rvhart<XLEN>::exec_vred },
+    { "vredminu.vs", format_varith, &rvhart<XLEN>::exec_vred },
+    { "vredmin.vs", format_varith, &rvhart<XLEN>::exec_vred },
+    { "vredmaxu.vs", format_varith, &rvhart<XLEN>::exec_vred },
+    { "vredmax.vs", format_varith, &rvhart<XLEN>::exec_vred },
+    { "", format_illegal, &rvhart<XLEN>::exec_illegal_insn }, // op_unary never gets past lookup()
+    { "orc.b", format_unary, &rvhart<XLEN>::exec_orc_b },
+    { "rev8", format_unary, &rvhart<XLEN>::exec_rev8 },
+    { "vmv.x.s", format_vmv, &rvhart<XLEN>::exec_vmv_x_s },
+    { "zext.h", format_unary, &rvhart<XLEN>::exec_zext_h },
+    { "vle8.v", format_vmem, &rvhart<XLEN>::exec_vload },
+    { "vle16.v", format_vmem, &rvhart<XLEN>::exec_vload },
+    { "vle32.v", format_vmem, &rvhart<XLEN>::exec_vload },
+    { "vle64.v", format_vmem, &rvhart<XLEN>::exec_vload },
+    { "vse8.v", format_vmem, &rvhart<XLEN>::exec_vstore },
+    { "vse16.v", format_vmem, &rvhart<XLEN>::exec_vstore },
+    { "vse32.v", format_vmem, &rvhart<XLEN>::exec_vstore },
+    { "vse64.v", format_vmem, &rvhart<XLEN>::exec_vstore },
+    { "vmv.v.v", format_vmv, &rvhart<XLEN>::exec_vmv },
+    { "vmv.v.x", format_vmv, &rvhart<XLEN>::exec_vmv },
+    { "vmv.v.i", format_vmv, &rvhart<XLEN>::exec_vmv },
+    { "vmv.s.x", format_vmv, &rvhart<XLEN>::exec_vmv_s_x },
+};
 
 /**
- * The purpose of this function is to return a string containing the disassembled instructions text.
- * Using a switch statement with the opcode as the swith expression for each case we format the
- * instruction and its arguments when the opcode is enough. When the opcode isnt enogh to determine
- * the instructions we use sub-switch statement to further decode the instruction . For invalid
- *instructions
- * we print an error message.
- * @param uint32_t insn
- * @return a string containing the disassembled instruction text
- * @note
- * @warning
- * @bug
+ * Decode the fields the decode table is indexed by, this is the only place that knows which
+ * encodings are which instruction. The RV64I ones only decode when XLEN is 64, Zba, Zbb and the
+ * V subset decode for both.
+ * @param uint32_t opcode, uint32_t funct3, uint32_t funct7
+ * @return the insn_op
  ********************************************************************************/
-
-std::string rv32i::decode(uint32_t insn) const
+template<uint32_t XLEN>
+static constexpr uint8_t classify(uint32_t opcode, uint32_t funct3, uint32_t funct7)
 {
-    uint32_t opcode = get_opcode(insn); // gets the opcode bits
-    uint32_t funct3 = get_funct3(insn);
-    uint32_t funct7 = get_funct7(insn);
-    int32_t imm_i = get_imm_i(insn);
-
-    std::cout << hex32(insn) << "  "; // prints the instruction in hex
     switch (opcode)
     {
-        default:
-            return render_illegal_insn();
         case opcode_lui:
-            return render_lui(insn);
-            break;
+            return op_lui;
         case opcode_auipc:
-            return render_auipc(insn);
-            break;
+            return op_auipc;
         case opcode_jal:
-            return render_jal(insn);
-            break;
+            return op_jal;
         case opcode_jalr:
-            return render_jalr(insn);
-            break;
+            return op_jalr;
         case opcode_rtype:
             switch (funct3)
             {
-                default:
-                    return render_illegal_insn();
                 case funct3_add:
-                    switch (funct7)
-                    {
-                        default:
-                            return render_illegal_insn();
-                        case funct7_add:
-                            return render_rtype(insn, "add");
-                            break;
-                        case funct7_sub:
-                            return render_rtype(insn, "sub");
-                            break;
-                    }
-                    assert(0 && "unhandled funct7");
+                    return funct7 == funct7_add ? op_add : funct7 == funct7_sub ? op_sub : op_illegal;
                 case funct3_sll:
-                    return render_rtype(insn, "sll");
-                    break;
+                    return funct7 == funct7_rotate ? op_rol : op_sll;
                 case funct3_slt:
-                    return render_rtype(insn, "slt");
-                    break;
-
+                    return funct7 == funct7_shadd ? op_sh1add : op_slt;
                 case funct3_sltu:
-                    return render_rtype(insn, "sltu");
-                    break;
+                    return op_sltu;
                 case funct3_xor:
-                    return render_rtype(insn, "xor");
-                    break;
+                    switch (funct7)
+                    {
+                        case funct7_shadd:
+                            return op_sh2add;
+                        case funct7_andn:
+                            return op_xnor;
+                        case funct7_minmax:
+                            return op_min;
+                        case funct7_zext_h:
+                            return XLEN == 32 ? op_zext_h : op_illegal; // RV64 has it in OP-32
+                    }
+                    return op_xor;
                 case funct3_srl:
                     switch (funct7)
                     {
-                        default:
-                            return render_illegal_insn();
-                            break;
                         case funct7_srl:
-                            return render_rtype(insn, "srl");
-                            break;
+                            return op_srl;
                         case funct7_sra:
-                            return render_rtype(insn, "sra");
-                            break;
+                            return op_sra;
+                        case funct7_minmax:
+                            return op_minu;
+                        case funct7_rotate:
+                            return op_ror;
                     }
-                    assert(0 && "unhandled funct7");
+                    return op_illegal;
                 case funct3_or:
-                    return render_rtype(insn, "or");
-                    break;
+                    switch (funct7)
+                    {
+                        case funct7_shadd:
+                            return op_sh3add;
+                        case funct7_andn:
+                            return op_orn;
+                        case funct7_minmax:
+                            return op_max;
+                    }
+                    return op_or;
                 case funct3_and:
-                    return render_rtype(insn, "and");
-                    break;
+                    return funct7 == funct7_andn ? op_andn : funct7 == funct7_minmax ? op_maxu : op_and;
+            }
+            return op_illegal;
+        case opcode_btype:
+            switch (funct3)
+            {
+                case funct3_beq:
+                    return op_beq;
+                case funct3_bne:
+                    return op_bne;
+                case funct3_blt:
+                    return op_blt;
+                case funct3_bge:
+                    return op_bge;
+                case funct3_bltu:
+                    return op_bltu;
+                case funct3_bgeu:
+                    return op_bgeu;
             }
-            assert(0 && "unhandled funct3");
+            return op_illegal;
         case opcode_itype:
             switch (funct3)
             {
-                default:
-                    return render_illegal_insn();
                 case funct3_lb:
-                    return render_itype_load(insn, "lb");
-                    break;
+                    return op_lb;
                 case funct3_lh:
-                    return render_itype_load(insn, "lh");
-                    break;
+                    return op_lh;
                 case funct3_lw:
-                    return render_itype_load(insn, "lw");
-                    break;
+                    return op_lw;
                 case funct3_lbu:
-                    return render_itype_load(insn, "lbu");
-                    break;
+                    return op_lbu;
                 case funct3_lhu:
-                    return render_itype_load(insn, "lhu");
-                    break;
+                    return op_lhu;
+                case funct3_ld:
+                    return XLEN == 64 ? op_ld : op_illegal;
+                case funct3_lwu:
+                    return XLEN == 64 ? op_lwu : op_illegal;
             }
-            assert(0 && "unhandled funct3");
+            return op_illegal;
         case opcode_itype_imm_shamt:
             switch (funct3)
             {
-                default:
-                    return render_illegal_insn();
                 case funct3_addi:
-                    return render_itype_alu(insn, "addi", imm_i);
-                    break;
+                    return op_addi;
                 case funct3_slti:
-                    return render_itype_alu(insn, "slti", imm_i);
-                    break;
-                case funct3_xori:
-                    return render_itype_alu(insn, "xori", imm_i);
-                    break;
+                    return op_slti;
                 case funct3_sltiu:
-                    return render_itype_alu(insn, "sltiu", imm_i);
-                    break;
+                    return op_sltiu;
+                case funct3_xori:
+                    return op_xori;
                 case funct3_ori:
-                    return render_itype_alu(insn, "ori", imm_i);
-                    break;
+                    return op_ori;
                 case funct3_andi:
-                    return render_itype_alu(insn, "andi", imm_i);
-                    break;
+                    return op_andi;
                 case funct3_slli:
-                    return render_itype_shamt(insn, "slli");
-                    break;
+                    return funct7 == funct7_rotate ? op_unary : op_slli;
                 case funct3_srli:
-                    switch (funct7)
+                {
+                    uint32_t funct6 = XLEN == 64 ? funct7 & ~1u : funct7; // RV64I has shamt bit 5 here
+                    if (funct7 == funct7_orc_b)
+                        return op_orc_b;
+                    if (funct7 == (XLEN == 32 ? funct7_rev8_32 : funct7_rev8_64))
+                        return op_rev8;
+                    switch (funct6)
                     {
-                        default:
-                            return render_illegal_insn();
                         case funct7_srli:
-                            return render_itype_shamt(insn, "srli");
-                            break;
+                            return op_srli;
                         case funct7_srai:
-                            return render_itype_shamt(insn, "srai");
-                            break;
+                            return op_srai;
+                        case funct7_rotate:
+                            return op_rori;
                     }
-                    assert(0 && "unhandled funct7");
+                    return op_illegal;
+                }
             }
-            assert(0 && "unhandled funct3");            
-        case opcode_btype:
+            return op_illegal;
+        case opcode_itype_w:
+            if (XLEN != 64)
+                return op_illegal;
             switch (funct3)
             {
-                default:
-                    return render_illegal_insn();
-                case funct3_beq:
-                    return render_btype(insn, "beq");
-                    break;
-                case funct3_bne:
-                    return render_btype(insn, "bne");
-                    break;
-                case funct3_blt:
-                    return render_btype(insn, "blt");
-                    break;
-                case funct3_bge:
-                    return render_btype(insn, "bge");
-                    break;
-                case funct3_bltu:
-                    return render_btype(insn, "bltu");
-                    break;
-                case funct3_bgeu:
-                    return render_btype(insn, "bgeu");
-                    break;
+                case funct3_addi:
+                    return op_addiw;
+                case funct3_slli:
+                    return funct7 == 0 ? op_slliw : op_illegal;
+                case funct3_srli:
+                    return funct7 == funct7_srli ? op_srliw : funct7 == funct7_srai ? op_sraiw : op_illegal;
+            }
+            return op_illegal;
+        case opcode_rtype_w:
+            if (XLEN != 64)
+                return op_illegal;
+            switch (funct3)
+            {
+                case funct3_add:
+                    return funct7 == funct7_add ? op_addw : funct7 == funct7_sub ? op_subw : op_illegal;
+                case funct3_sll:
+                    return funct7 == funct7_sll ? op_sllw : op_illegal;
+                case funct3_srl:
+                    return funct7 == funct7_srl ? op_srlw : funct7 == funct7_sra ? op_sraw : op_illegal;
+                case funct3_xor:
+                    return funct7 == funct7_zext_h ? op_zext_h : op_illegal;
             }
-            assert(0 && "unhandled funct3");
+            return op_illegal;
         case opcode_stype:
             switch (funct3)
             {
-                default:
-                    return render_illegal_insn();
                 case funct3_sb:
-                    return render_stype(insn, "sb");
-                    break;
+                    return op_sb;
                 case funct3_sh:
-                    return render_stype(insn, "sh");
-                    break;
+                    return op_sh;
                 case funct3_sw:
-                    return render_stype(insn, "sw");
-                    break;
+                    return op_sw;
+                case funct3_sd:
+                    return XLEN == 64 ? op_sd : op_illegal;
+            }
+            return op_illegal;
+        case opcode_fence:
+            return op_fence;
+        case opcode_vload:
+        case opcode_vstore:
+        {
+            uint32_t width = vmem_eew[funct3] == 0 ? 4 : __builtin_ctz(vmem_eew[funct3] / 8); // 4 = none
+            uint32_t first = opcode == opcode_vload ? op_vle8_v : op_vse8_v;
+            uint32_t first_strided = opcode == opcode_vload ? op_vlse8_v : op_vsse8_v;
+            if (width == 4)
+                return op_illegal;
+            return funct7 == funct7_vunit ? first + width : funct7 == funct7_vstrided ? first_strided + width : op_illegal;
+        }
+        case opcode_op_v:
+        {
+            uint32_t funct6 = funct7 >> 1;
+            uint32_t form = funct3 == funct3_opivv ? 0 : funct3 == funct3_opivx ? 1 : 2; // vv, vx, vi
+            if (funct3 == funct3_opcfg)
+                return (funct7 >> 6) == 0 ? op_vsetvli : (funct7 >> 5) == 3 ? op_vsetivli : funct7 == 0x40 ? op_vsetvl : op_illegal;
+            if ((funct7 & 1) == 0)
+                return op_illegal; // masked
+            if (funct3 == funct3_opmvv)
+                return funct6 <= funct6_vredmax ? op_vredsum_vs + funct6 : funct6 == funct6_vxunary0 ? op_vmv_x_s
+                    : funct6 == funct6_vmul ? op_vmul_vv : op_illegal;
+            if (funct3 == funct3_opmvx)
+                return funct6 == funct6_vxunary0 ? op_vmv_s_x : funct6 == funct6_vmul ? op_vmul_vx : op_illegal;
+            if (funct3 != funct3_opivv && funct3 != funct3_opivx && funct3 != funct3_opivi)
+                return op_illegal;
+            switch (funct6)
+            {
+                case funct6_vadd:
+                    return op_vadd_vv + form;
+                case funct6_vsub:
+                    return form == 2 ? op_illegal : op_vsub_vv + form;
+                case funct6_vrsub:
+                    return form == 0 ? op_illegal : op_vrsub_vx + form - 1;
+                case funct6_vminu:
+                    return form == 2 ? op_illegal : op_vminu_vv + form;
+                case funct6_vmin:
+                    return form == 2 ? op_illegal : op_vmin_vv + form;
+                case funct6_vmaxu:
+                    return form == 2 ? op_illegal : op_vmaxu_vv + form;
+                case funct6_vmax:
+                    return form == 2 ? op_illegal : op_vmax_vv + form;
+                case funct6_vand:
+                    return op_vand_vv + form;
+                case funct6_vor:
+                    return op_vor_vv + form;
+                case funct6_vxor:
+                    return op_vxor_vv + form;
+                case funct6_vmv:
+                    return op_vmv_v_v + form;
             }
-            assert(0 && "unhandled funct3");
+            return op_illegal;
+        }
         case opcode_ecall:
-            switch (funct7 + get_rs2(insn))
+            switch (funct3)
             {
-                default:
-                    return render_illegal_insn();
-                case 0b000000000000:
-                    return "ecall";
-                    break;
-                case 0b000000000001:
-                    return "ebreak";
-                    break;
+                case funct3_priv:
+                    return op_priv;
+                case funct3_csrrw:
+                    return op_csrrw;
+                case funct3_csrrs:
+                    return op_csrrs;
+                case funct3_csrrc:
+                    return op_csrrc;
+                case funct3_csrrwi:
+                    return op_csrrwi;
+                case funct3_csrrsi:
+                    return op_csrrsi;
+                case funct3_csrrci:
+                    return op_csrrci;
             }
-        case opcode_fence:
-            return render_fence(insn);
+            return op_illegal;
+        case opcode_amo:
+            if (funct3 != funct3_amo_w)
+                return op_illegal;
+            switch (funct7 >> 2)
+            {
+                case funct5_lr:
+                    return op_lr_w;
+                case funct5_sc:
+                    return op_sc_w;
+                case funct5_amoswap:
+                    return op_amoswap_w;
+                case funct5_amoadd:
+                    return op_amoadd_w;
+                case funct5_amoxor:
+                    return op_amoxor_w;
+                case funct5_amoand:
+                    return op_amoand_w;
+                case funct5_amoor:
+                    return op_amoor_w;
+                case funct5_amomin:
+                    return op_amomin_w;
+                case funct5_amomax:
+                    return op_amomax_w;
+                case funct5_amominu:
+                    return op_amominu_w;
+                case funct5_amomaxu:
+                    return op_amomaxu_w;
+            }
+            return op_illegal;
+    }
+    return op_illegal;
+}
+
+// key = opcode bits 6:2 | funct3 << 5 | funct7 << 8, opcode bits 1:0 are checked in lookup()
+static constexpr uint32_t decode_keys = 1 << 15; 
+struct decode_table_t
+{
+    uint8_t op[decode_keys]; 
+};
+
+/**
+ * Build the decode table of an XLEN-bit hart, run by the compiler
+ * @param none
+ * @return a table with the insn_op of every key
+ ********************************************************************************/
+template<uint32_t XLEN>
+static constexpr decode_table_t make_decode_table()
+{
+    decode_table_t t {};
+    for (uint32_t key = 0; key < decode_keys; key++)
+    {
+        t.op[key] = classify<XLEN>((key & 0x1f) << 2 | 0b11, (key >> 5) & 0b111, key >> 8);
+    }
+    return t;
+}
+// 32 KiB each, but a program only ever touches the few cache lines of the encodings it uses
+template<uint32_t XLEN>
+static constexpr decode_table_t decode_table = make_decode_table<XLEN>();
+
+/**
+ * Second look at the ops that keep part of their encoding in a register field: the Zbb unary ops
+ * are told apart by rs2, orc.b, rev8, zext.h, vmv.s.x, vmv.v.* and the unit-stride vector loads
+ * and stores need a fixed rs2 (lumop and sumop are 0) and vmv.x.s needs rs1 = 0
+ * @param uint32_t op (op_unary or above), uint32_t insn
+ * @return the insn_op
+ ********************************************************************************/
+static inline uint32_t refine(uint32_t op, uint32_t insn)
+{
+    static constexpr uint8_t unary_ops[32] = { op_clz, op_ctz, op_cpop, op_illegal, op_sext_b, op_sext_h };
+    uint32_t rs2 = (insn >> 20) & 0x1f;
+    switch (op)
+    {
+        case op_unary:
+            return unary_ops[rs2];
+        case op_orc_b:
+            return rs2 == rs2_orc_b ? op : op_illegal;
+        case op_rev8:
+            return rs2 == rs2_rev8 ? op : op_illegal;
+        case op_vmv_x_s:
+            return ((insn >> 15) & 0x1f) == 0 ? op : op_illegal;
+    }
+    return rs2 == 0 ? op : op_illegal;
+}
+
+/**
+ * Find what insn is: one table load, plus a look at funct12 for ecall, ebreak, mret, sret, wfi
+ * and sfence.vma and at the register fields for the ops refine() knows
+ * @param uint32_t insn
+ * @return the insn_op
+ ********************************************************************************/
+template<uint32_t XLEN>
+static inline uint32_t lookup(uint32_t insn)
+{
+    uint32_t op = decode_table<XLEN>.op[((insn >> 2) & 0x1f) | ((insn >> 7) & 0xe0) | ((insn >> 17) & 0x7f00)];
+    if (op == op_priv)
+    {
+        switch (insn >> 20)
+        {
+            case funct12_ecall:
+                op = op_ecall;
+                break;
+            case funct12_ebreak:
+                op = op_ebreak;
+                break;
+            case funct12_mret:
+                op = op_mret;
+                break;
+            case funct12_sret:
+                op = op_sret;
+                break;
+            case funct12_wfi:
+                op = op_wfi;
+                break;
+            default:
+                op = (insn >> 25) == funct7_sfence_vma && ((insn >> 7) & 0x1f) == 0 ? op_sfence_vma : op_illegal;
+                break;
+        }
+    }
+    else if (op >= op_unary)
+    {
+        op = refine(op, insn);
+    }
+    return (insn & 0b11) == 0b11 ? op : op_illegal;
+}
+
+/**
+ * Name of a CSR for the disassembly
+ * @param uint32_t csr
+ * @return the name or nullptr if the CSR has none
+ ********************************************************************************/
+static const char* csr_name(uint32_t csr)
+{
+    switch (csr)
+    {
+        case csr_sstatus: return "sstatus";
+        case csr_sie: return "sie";
+        case csr_stvec: return "stvec";
+        case csr_scounteren: return "scounteren";
+        case csr_sscratch: return "sscratch";
+        case csr_sepc: return "sepc";
+        case csr_scause: return "scause";
+        case csr_stval: return "stval";
+        case csr_sip: return "sip";
+        case csr_mstatus: return "mstatus";
+        case csr_misa: return "misa";
+        case csr_medeleg: return "medeleg";
+        case csr_mideleg: return "mideleg";
+        case csr_mie: return "mie";
+        case csr_mtvec: return "mtvec";
+        case csr_mcounteren: return "mcounteren";
+        case csr_mscratch: return "mscratch";
+        case csr_mepc: return "mepc";
+        case csr_mcause: return "mcause";
+        case csr_mtval: return "mtval";
+        case csr_mip: return "mip";
+        case csr_mcycle: return "mcycle";
+        case csr_minstret: return "minstret";
+        case csr_mcycleh: return "mcycleh";
+        case csr_minstreth: return "minstreth";
+        case csr_cycle: return "cycle";
+        case csr_time: return "time";
+        case csr_instret: return "instret";
+        case csr_cycleh: return "cycleh";
+        case csr_timeh: return "timeh";
+        case csr_instreth: return "instreth";
+        case csr_mhartid: return "mhartid";
+        case csr_satp: return "satp";
+        case csr_vstart: return "vstart";
+        case csr_vl: return "vl";
+        case csr_vtype: return "vtype";
+        case csr_vlenb: return "vlenb";
+        default: return nullptr;
+    }
+}
+
+/**
+ * rv32i constructor
+ * saves the m argumen in the mem variable which will be used later for disassembling
+ * @param memory* m
+ * @return nothing
+ * @note
+ * @warning
+ * @bug
+ *
+ ********************************************************************************/
+template<uint32_t XLEN>
+rvhart<XLEN>::rvhart(memory* m) : vm(m)
+{
+    mem = m;
+}
+
+/**
+ * dissambles the instruction in the simulated memory
+ * For every 32-bit word in the memory it prints the 32-bit hex address, fetches the 32-bit
+ * instruction from memory at the address in the pc register, prints the instruction, passes
+ * te fetched instruction to decode and render the instruction into a string.
+ * @param none
+ * @return none
+ * @note
+ * @warning
+ * @bug
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::disasm(void)
+{
+    while (pc < (mem->get_size()))
+    {
+        *out << hex_xlen(pc) << " : "; // prints the hex address
+        *out << decode(mem->get32(pc)) << std::endl; // prints the decoded instructions
+        pc += 4; // increment pc by 4
+    }
+}
+
+/**
+ * The purpose of this function is to return a string containing the disassembled instructions text.
+ * The instruction is looked up in the decode table, which gives its mnemonic and the render_xxx()
+ * that formats its arguments. For invalid instructions we print an error message.
+ * @param uint32_t insn
+ * @return a string containing the disassembled instruction text
+ * @note
+ * @warning
+ * @bug
+ ********************************************************************************/
+
+template<uint32_t XLEN>
+std::string rvhart<XLEN>::decode(uint32_t insn) const
+{
+    const insn_info<XLEN>& info = insn_infos<XLEN>[lookup<XLEN>(insn)];
+
+    *out << hex32(insn) << "  "; // prints the instruction in hex
+    switch (info.format)
+    {
+        case format_illegal:
             break;
+        case format_lui:
+            return render_lui(insn);
+        case format_auipc:
+            return render_auipc(insn);
+        case format_jal:
+            return render_jal(insn);
+        case format_jalr:
+            return render_jalr(insn);
+        case format_btype:
+            return render_btype(insn, info.mnemonic);
+        case format_load:
+            return render_itype_load(insn, info.mnemonic);
+        case format_stype:
+            return render_stype(insn, info.mnemonic);
+        case format_alu:
+            return render_itype_alu(insn, info.mnemonic, get_imm_i(insn));
+        case format_shamt:
+            return render_itype_shamt(insn, info.mnemonic);
+        case format_rtype:
+            return render_rtype(insn, info.mnemonic);
+        case format_fence:
+            return render_fence(insn);
+        case format_bare:
+            return info.mnemonic;
+        case format_mret:
+            return render_mret();
+        case format_sret:
+            return render_sret();
+        case format_wfi:
+            return render_wfi();
+        case format_sfence:
+            return render_sfence_vma(insn);
+        case format_csr:
+            return render_csrrx(insn, info.mnemonic);
+        case format_csri:
+            return render_csrrxi(insn, info.mnemonic);
+        case format_lr:
+            return render_lr(insn, info.mnemonic);
+        case format_amo:
+            return render_amo(insn, info.mnemonic);
+        case format_unary:
+            return render_unary(insn, info.mnemonic);
+        case format_vsetvl:
+        case format_vmem:
+        case format_varith:
+        case format_vmv:
+            return render_vector(insn);
     }
-    assert(0 && "unhandled opcode");
+    return render_illegal_insn();
 }
 
 /**
@@ -334,7 +987,8 @@ std::string rv32i::decode(uint32_t insn) const
  * @bug
  ********************************************************************************/
 
-uint32_t rv32i::get_opcode(uint32_t insn)
+template<uint32_t XLEN>
+uint32_t rvhart<XLEN>::get_opcode(uint32_t insn)
 {
     return (insn & 0x0000007f); // extract bits 0-6
 }
@@ -351,7 +1005,8 @@ Extract and return the rd field from the given instruction.
  * @bug
  ********************************************************************************/
 
-uint32_t rv32i::get_rd(uint32_t insn)
+template<uint32_t XLEN>
+uint32_t rvhart<XLEN>::get_rd(uint32_t insn)
 {
 
     return (insn & 0x00000f80) >> 7; // extract bits bits 11-7
@@ -366,7 +1021,8 @@ uint32_t rv32i::get_rd(uint32_t insn)
  * @warning
  * @bug
  ********************************************************************************/
-uint32_t rv32i::get_funct3(uint32_t insn)
+template<uint32_t XLEN>
+uint32_t rvhart<XLEN>::get_funct3(uint32_t insn)
 {
     return (insn & 0x00007000) >> 12; // extracts bits bits 14-12
 }
@@ -379,7 +1035,8 @@ uint32_t rv32i::get_funct3(uint32_t insn)
  * @warning
  * @bug
  ********************************************************************************/
-uint32_t rv32i::get_rs1(uint32_t insn)
+template<uint32_t XLEN>
+uint32_t rvhart<XLEN>::get_rs1(uint32_t insn)
 {
     return (insn & 0x000f8000) >> 15; // bits 19-15
 }
@@ -393,7 +1050,8 @@ uint32_t rv32i::get_rs1(uint32_t insn)
  * @warning
  * @bug
  ********************************************************************************/
-uint32_t rv32i::get_rs2(uint32_t insn)
+template<uint32_t XLEN>
+uint32_t rvhart<XLEN>::get_rs2(uint32_t insn)
 {
     return (insn & 0x01f00000) >> 20; // bits 24-20
 }
@@ -407,7 +1065,8 @@ uint32_t rv32i::get_rs2(uint32_t insn)
  * @bug
  ********************************************************************************/
 
-uint32_t rv32i::get_funct7(uint32_t insn)
+template<uint32_t XLEN>
+uint32_t rvhart<XLEN>::get_funct7(uint32_t insn)
 {
     return (insn & 0xfe000000) >> 25; // extracts bits 31-25
 }
@@ -420,7 +1079,8 @@ uint32_t rv32i::get_funct7(uint32_t insn)
  * @warning
  * @bug
  ********************************************************************************/
-int32_t rv32i::get_imm_i(uint32_t insn)
+template<uint32_t XLEN>
+int32_t rvhart<XLEN>::get_imm_i(uint32_t insn)
 {
     int32_t imm_i = (insn & 0xfff00000) >> 20; // extract imm bits 31-20
     // check to see if bit 31 is 1, if so fil bits 31 to 12 with 1ns
@@ -439,7 +1099,8 @@ int32_t rv32i::get_imm_i(uint32_t insn)
  * @warning
  * @bug
  ********************************************************************************/
-int32_t rv32i::get_imm_u(uint32_t insn)
+template<uint32_t XLEN>
+int32_t rvhart<XLEN>::get_imm_u(uint32_t insn)
 {
     return (insn & 0xfffff000); // returns imm_u (extracts the values in bits 31-12 )and 11-0 will
                                 // be filled with 0s
@@ -453,7 +1114,8 @@ int32_t rv32i::get_imm_u(uint32_t insn)
  * @warning
  * @bug
  ********************************************************************************/
-int32_t rv32i::get_imm_b(uint32_t insn)
+template<uint32_t XLEN>
+int32_t rvhart<XLEN>::get_imm_b(uint32_t insn)
 {
     int32_t imm_b = (insn & 0x00000080) << 4; // extract bit 7 and move it to bit 11
     imm_b |= (insn & 0x00000f00) >> 7; // extracts bits 11-8 and moves them into 4-1
@@ -475,7 +1137,8 @@ int32_t rv32i::get_imm_b(uint32_t insn)
  * @warning
  * @bug
  ********************************************************************************/
-int32_t rv32i::get_imm_s(uint32_t insn)
+template<uint32_t XLEN>
+int32_t rvhart<XLEN>::get_imm_s(uint32_t insn)
 {
     int32_t imm_s = (insn & 0xfe000000) >> 20; // extract bits 31-25 and move them into bits 11-5
     imm_s |= (insn & 0x00000f80) >> (7 - 0); // extract bits 11-7 and move them into bits 4-0
@@ -495,7 +1158,8 @@ int32_t rv32i::get_imm_s(uint32_t insn)
  * @warning
  * @bug
  ********************************************************************************/
-int32_t rv32i::get_imm_j(uint32_t insn)
+template<uint32_t XLEN>
+int32_t rvhart<XLEN>::get_imm_j(uint32_t insn)
 {
     int32_t imm_j
         = (insn & 0x000ff000); // extracts bits 19-12 and keeps them on the positions that they are
@@ -520,7 +1184,8 @@ int32_t rv32i::get_imm_j(uint32_t insn)
  * @warning
  * @bug
  ********************************************************************************/
-std::string rv32i::render_illegal_insn() const
+template<uint32_t XLEN>
+std::string rvhart<XLEN>::render_illegal_insn() const
 {
     return "ERROR: UNIMPLEMENTED INSTRUCTION";
 }
@@ -532,7 +1197,8 @@ std::string rv32i::render_illegal_insn() const
  * @warning
  * @bug
  ********************************************************************************/
-std::string rv32i::render_lui(uint32_t insn) const
+template<uint32_t XLEN>
+std::string rvhart<XLEN>::render_lui(uint32_t insn) const
 {
     uint32_t rd = get_rd(insn);
     int32_t imm_u = get_imm_u(insn);
@@ -550,7 +1216,8 @@ std::string rv32i::render_lui(uint32_t insn) const
  * @warning
  * @bug
  ********************************************************************************/
-std::string rv32i::render_auipc(uint32_t insn) const
+template<uint32_t XLEN>
+std::string rvhart<XLEN>::render_auipc(uint32_t insn) const
 {
     uint32_t rd = get_rd(insn);
     int32_t imm_u = get_imm_u(insn);
@@ -568,7 +1235,8 @@ std::string rv32i::render_auipc(uint32_t insn) const
  * @warning
  * @bug
  ********************************************************************************/
-std::string rv32i::render_jal(uint32_t insn) const
+template<uint32_t XLEN>
+std::string rvhart<XLEN>::render_jal(uint32_t insn) const
 {
     uint32_t rd = get_rd(insn);
     int32_t imm_j = get_imm_j(insn);
@@ -585,7 +1253,8 @@ std::string rv32i::render_jal(uint32_t insn) const
  * @warning
  * @bug
  ********************************************************************************/
-std::string rv32i::render_jalr(uint32_t insn) const
+template<uint32_t XLEN>
+std::string rvhart<XLEN>::render_jalr(uint32_t insn) const
 {
     uint32_t rd = get_rd(insn);
     int32_t imm_i = get_imm_i(insn);
@@ -603,7 +1272,8 @@ std::string rv32i::render_jalr(uint32_t insn) const
  * @warning
  * @bug
  ********************************************************************************/
-std::string rv32i::render_rtype(uint32_t insn, const char* mnemonic) const
+template<uint32_t XLEN>
+std::string rvhart<XLEN>::render_rtype(uint32_t insn, const char* mnemonic) const
 {
     uint32_t rd = get_rd(insn);
     int32_t rs1 = get_rs1(insn);
@@ -621,7 +1291,8 @@ std::string rv32i::render_rtype(uint32_t insn, const char* mnemonic) const
  * @warning
  * @bug
  ********************************************************************************/
-std::string rv32i::render_btype(uint32_t insn, const char* mnemonic) const
+template<uint32_t XLEN>
+std::string rvhart<XLEN>::render_btype(uint32_t insn, const char* mnemonic) const
 {
     int32_t imm_b = get_imm_b(insn);
     int32_t rs1 = get_rs1(insn);
@@ -640,7 +1311,8 @@ std::string rv32i::render_btype(uint32_t insn, const char* mnemonic) const
  * @warning
  * @bug
  ********************************************************************************/
-std::string rv32i::render_itype_load(uint32_t insn, const char* mnemonic) const
+template<uint32_t XLEN>
+std::string rvhart<XLEN>::render_itype_load(uint32_t insn, const char* mnemonic) const
 {
     uint32_t rd = get_rd(insn);
     int32_t imm_i = get_imm_i(insn);
@@ -658,16 +1330,100 @@ std::string rv32i::render_itype_load(uint32_t insn, const char* mnemonic) const
  * @warning
  * @bug
  ********************************************************************************/
-std::string rv32i::render_itype_shamt(uint32_t insn, const char* mnemonic) const
+template<uint32_t XLEN>
+std::string rvhart<XLEN>::render_itype_shamt(uint32_t insn, const char* mnemonic) const
 {
     uint32_t rd = get_rd(insn);
     int32_t rs1 = get_rs1(insn);
-    int32_t rs2 = get_rs2(insn);
+    int32_t rs2 = get_imm_i(insn) & (XLEN - 1); // shamt, 6 bits in RV64I
     std::ostringstream os;
     os << std::setw(mnemonic_width) << std::setfill(' ') << std::left << mnemonic << "x" << std::dec
        << rd << ",x" << rs1 << "," << std::dec << rs2;
     return os.str();
 }
+/** Formats the disassembled instruction text for the Zbb instructions with one source register
+ * (clz, ctz, cpop, sext.b, sext.h, zext.h, orc.b and rev8)
+ * @param uint32_t insn, const char* mnemonic
+ * @return a string containing the disassembled instruction
+ ********************************************************************************/
+template<uint32_t XLEN>
+std::string rvhart<XLEN>::render_unary(uint32_t insn, const char* mnemonic) const
+{
+    uint32_t rd = get_rd(insn);
+    int32_t rs1 = get_rs1(insn);
+    std::ostringstream os;
+    os << std::setw(mnemonic_width) << std::setfill(' ') << std::left << mnemonic << "x" << std::dec
+       << rd << ",x" << rs1;
+    return os.str();
+}
+/** Formats the vtype immediate of vsetvli and vsetivli, like e32,m1,ta,ma
+ * @param uint32_t vtypei
+ * @return the text, or the number when it has reserved bits set
+ ********************************************************************************/
+static std::string render_vtype(uint32_t vtypei)
+{
+    static const char* const lmuls[8] = { "m1", "m2", "m4", "m8", "", "mf8", "mf4", "mf2" };
+    std::ostringstream os;
+    if ((vtypei >> 8) != 0 || (vtypei & 7) == 4 || ((vtypei >> 3) & 7) > 3)
+    {
+        os << std::dec << vtypei;
+        return os.str();
+    }
+    os << "e" << std::dec << (8 << ((vtypei >> 3) & 7)) << "," << lmuls[vtypei & 7] << ","
+       << ((vtypei & 0x40) ? "ta" : "tu") << "," << ((vtypei & 0x80) ? "ma" : "mu");
+    return os.str();
+}
+/** Formats the disassembled instruction text for the vector instructions
+ * vsetvli x1,x2,e32,m1,ta,ma / vle32.v v1,(x2) / vlse32.v v1,(x2),x3 / vadd.vv v1,v2,v3 /
+ * vadd.vx v1,v2,x3 / vadd.vi v1,v2,-1 / vmv.x.s x1,v2 and so on
+ * @param uint32_t insn
+ * @return a string containing the disassembled instruction
+ ********************************************************************************/
+template<uint32_t XLEN>
+std::string rvhart<XLEN>::render_vector(uint32_t insn) const
+{
+    const insn_info<XLEN>& info = insn_infos<XLEN>[lookup<XLEN>(insn)];
+    uint32_t rd = get_rd(insn);
+    uint32_t rs1 = get_rs1(insn);
+    uint32_t rs2 = get_rs2(insn);
+    uint32_t funct3 = get_funct3(insn);
+    int32_t simm5 = (int32_t)(insn << 12) >> 27;
+    std::string mnemonic = info.mnemonic;
+    mnemonic.resize(std::max<size_t>(mnemonic_width, mnemonic.size() + 1), ' '); // vredminu.vs is longer
+    std::ostringstream os;
+    os << mnemonic << std::dec;
+    switch (info.format)
+    {
+        case format_vsetvl:
+            os << "x" << rd << ",";
+            if ((insn >> 30) == 3)
+                os << rs1 << "," << render_vtype((insn >> 20) & 0x3ff); // vsetivli
+            else
+                os << "x" << rs1 << "," << render_vtype((insn >> 20) & 0x7ff);
+            break;
+        case format_vmem:
+            os << "v" << rd << ",(x" << rs1 << ")";
+            if (get_funct7(insn) == funct7_vstrided)
+                os << ",x" << rs2;
+            break;
+        case format_vmv:
+            if (funct3 == funct3_opmvv)
+                os << "x" << rd << ",v" << rs2; // vmv.x.s
+            else if (funct3 == funct3_opivi)
+                os << "v" << rd << "," << simm5;
+            else
+                os << "v" << rd << "," << (funct3 == funct3_opivv ? "v" : "x") << rs1;
+            break;
+        default:
+            os << "v" << rd << ",v" << rs2 << ",";
+            if (funct3 == funct3_opivi)
+                os << simm5;
+            else
+                os << (funct3 == funct3_opivx || funct3 == funct3_opmvx ? "x" : "v") << rs1;
+            break;
+    }
+    return os.str();
+}
 /** Formats the disassembled instruction text for the i-type alu instructions
  * this function will return a formated text of the disassembled i-type alu instructions
  * @param uint32_t insn
@@ -676,7 +1432,8 @@ std::string rv32i::render_itype_shamt(uint32_t insn, const char* mnemonic) const
  * @warning
  * @bug
  ********************************************************************************/
-std::string rv32i::render_itype_alu(uint32_t insn, const char* mnemonic, int32_t imm_i) const
+template<uint32_t XLEN>
+std::string rvhart<XLEN>::render_itype_alu(uint32_t insn, const char* mnemonic, int32_t imm_i) const
 {
     uint32_t rd = get_rd(insn);
     int32_t rs1 = get_rs1(insn);
@@ -693,7 +1450,8 @@ std::string rv32i::render_itype_alu(uint32_t insn, const char* mnemonic, int32_t
  * @warning
  * @bug
  ********************************************************************************/
-std::string rv32i::render_stype(uint32_t insn, const char* mnemonic) const
+template<uint32_t XLEN>
+std::string rvhart<XLEN>::render_stype(uint32_t insn, const char* mnemonic) const
 {
     int32_t rs1 = get_rs1(insn);
     int32_t rs2 = get_rs2(insn);
@@ -711,7 +1469,8 @@ std::string rv32i::render_stype(uint32_t insn, const char* mnemonic) const
  * @warning
  * @bug
  ********************************************************************************/
-std::string rv32i::render_fence(uint32_t insn) const
+template<uint32_t XLEN>
+std::string rvhart<XLEN>::render_fence(uint32_t insn) const
 {
     string pred = ""; // pred starts as an empty string
     string succ = ""; // succ starts as an empty string
@@ -769,7 +1528,8 @@ std::string rv32i::render_fence(uint32_t insn) const
  * @warning
  * @bug
  ********************************************************************************/
-std::string rv32i::render_ebreak() const
+template<uint32_t XLEN>
+std::string rvhart<XLEN>::render_ebreak() const
 {
     std::ostringstream os;
     os << std::setw(mnemonic_width) << std::setfill(' ') << std::left << "ebreak";
@@ -784,1308 +1544,4279 @@ std::string rv32i::render_ebreak() const
  * @warning
  * @bug
  ********************************************************************************/
-std::string rv32i::render_ecall() const
+template<uint32_t XLEN>
+std::string rvhart<XLEN>::render_ecall() const
 {
     std::ostringstream os;
     os << std::setw(mnemonic_width) << std::setfill(' ') << std::left << "ecall";
     return os.str();
 }
-/**
- * Setter show_instructions
- * sets the show instructions to bool b
- * @param bool b
- * @return none
-********************************************************************************/ 
-void rv32i::set_show_instructions(bool b)
-{
-    show_instructions = b;
-}
-/**
- * Seetter set_show_registers
- * set show_registers to bool b
- * @param bool b
- * @return none
+/** Formats the disassembled instruction text for the lr.w instruction
+ * this function will return a formated text of the disassembled lr.w instruction
+ * @param uint32_t insn, const char* mnemonic
+ * @return a string containing the disassembled instruction
+ * @note
+ * @warning
+ * @bug
  ********************************************************************************/
-void rv32i::set_show_registers(bool b)
+template<uint32_t XLEN>
+std::string rvhart<XLEN>::render_lr(uint32_t insn, const char* mnemonic) const
 {
-    show_registers = b;
+    uint32_t rd = get_rd(insn);
+    uint32_t rs1 = get_rs1(insn);
+    std::ostringstream os;
+    os << std::setw(mnemonic_width) << std::setfill(' ') << std::left << (std::string(mnemonic) + " ") << "x" << std::dec
+       << rd << ",(x" << rs1 << ")";
+    return os.str();
 }
-/**
- * getter is_halted
- * gets the value of the flag halt
- * @param none
- * @return bool halt
+/** Formats the disassembled instruction text for the sc.w and amo*.w instructions
+ * this function will return a formated text of the disassembled sc.w and amo*.w instructions
+ * @param uint32_t insn, const char* mnemonic
+ * @return a string containing the disassembled instruction
+ * @note
+ * @warning
+ * @bug
  ********************************************************************************/
-bool rv32i::is_halted() const
+template<uint32_t XLEN>
+std::string rvhart<XLEN>::render_amo(uint32_t insn, const char* mnemonic) const
+{
+    uint32_t rd = get_rd(insn);
+    uint32_t rs1 = get_rs1(insn);
+    uint32_t rs2 = get_rs2(insn);
+    std::ostringstream os;
+    os << std::setw(mnemonic_width) << std::setfill(' ') << std::left << (std::string(mnemonic) + " ") << "x" << std::dec
+       << rd << ",x" << rs2 << ",(x" << rs1 << ")";
+    return os.str();
+}
+/** Formats the disassembled instruction text for the csrrw, csrrs and csrrc instructions
+ * this function will return a formated text of the disassembled csr instruction, CSRs that have a
+ * name are shown by name, the others by number
+ * @param uint32_t insn, const char* mnemonic
+ * @return a string containing the disassembled instruction
+ * @note
+ * @warning
+ * @bug
+ ********************************************************************************/
+template<uint32_t XLEN>
+std::string rvhart<XLEN>::render_csrrx(uint32_t insn, const char* mnemonic) const
+{
+    uint32_t rd = get_rd(insn);
+    uint32_t rs1 = get_rs1(insn);
+    uint32_t csr = insn >> 20;
+    const char* name = csr_name(csr);
+    std::ostringstream os;
+    os << std::setw(mnemonic_width) << std::setfill(' ') << std::left << mnemonic << "x" << std::dec
+       << rd << ",";
+    if (name)
+        os << name;
+    else
+        os << "0x" << std::hex << csr;
+    os << ",x" << std::dec << rs1;
+    return os.str();
+}
+/** Formats the disassembled instruction text for the csrrwi, csrrsi and csrrci instructions
+ * this function will return a formated text of the disassembled csr immediate instruction
+ * @param uint32_t insn, const char* mnemonic
+ * @return a string containing the disassembled instruction
+ * @note
+ * @warning
+ * @bug
+ ********************************************************************************/
+template<uint32_t XLEN>
+std::string rvhart<XLEN>::render_csrrxi(uint32_t insn, const char* mnemonic) const
+{
+    uint32_t rd = get_rd(insn);
+    uint32_t zimm = get_rs1(insn);
+    uint32_t csr = insn >> 20;
+    const char* name = csr_name(csr);
+    std::ostringstream os;
+    os << std::setw(mnemonic_width) << std::setfill(' ') << std::left << mnemonic << "x" << std::dec
+       << rd << ",";
+    if (name)
+        os << name;
+    else
+        os << "0x" << std::hex << csr;
+    os << "," << std::dec << zimm;
+    return os.str();
+}
+/** Formats the disassembled instruction text for the mret instruction
+ * @param none
+ * @return a string containing the disassembled instruction
+ ********************************************************************************/
+template<uint32_t XLEN>
+std::string rvhart<XLEN>::render_mret() const
+{
+    std::ostringstream os;
+    os << std::setw(mnemonic_width) << std::setfill(' ') << std::left << "mret";
+    return os.str();
+}
+/** Formats the disassembled instruction text for the sret instruction
+ * @param none
+ * @return a string containing the disassembled instruction
+ ********************************************************************************/
+template<uint32_t XLEN>
+std::string rvhart<XLEN>::render_sret() const
+{
+    std::ostringstream os;
+    os << std::setw(mnemonic_width) << std::setfill(' ') << std::left << "sret";
+    return os.str();
+}
+/** Formats the disassembled instruction text for the wfi instruction
+ * @param none
+ * @return a string containing the disassembled instruction
+ ********************************************************************************/
+template<uint32_t XLEN>
+std::string rvhart<XLEN>::render_wfi() const
+{
+    std::ostringstream os;
+    os << std::setw(mnemonic_width) << std::setfill(' ') << std::left << "wfi";
+    return os.str();
+}
+/** Formats the disassembled instruction text for the sfence.vma instruction
+ * @param uint32_t insn
+ * @return a string containing the disassembled instruction
+ ********************************************************************************/
+template<uint32_t XLEN>
+std::string rvhart<XLEN>::render_sfence_vma(uint32_t insn) const
+{
+    std::ostringstream os;
+    os << std::setw(mnemonic_width + 3) << std::setfill(' ') << std::left << "sfence.vma" << "x" << std::dec
+       << get_rs1(insn) << ",x" << get_rs2(insn);
+    return os.str();
+}
+/**
+ * Setter show_instructions
+ * sets the show instructions to bool b
+ * @param bool b
+ * @return none
+********************************************************************************/ 
+template<uint32_t XLEN>
+void rvhart<XLEN>::set_show_instructions(bool b)
+{
+    show_instructions = b;
+}
+/**
+ * Seetter set_show_registers
+ * set show_registers to bool b
+ * @param bool b
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::set_show_registers(bool b)
+{
+    show_registers = b;
+}
+/**
+ * Setter set_register
+ * sets register r to val, used to hand per-hart arguments (like the hart id in a0) to the
+ * program before run() is called
+ * @param uint32_t r, sreg_t val
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::set_register(uint32_t r, sreg_t val)
+{
+    regs.set(r, val);
+}
+/**
+ * getter get_register
+ * @param uint32_t r
+ * @return the value of register r
+ ********************************************************************************/
+template<uint32_t XLEN>
+typename rvhart<XLEN>::sreg_t rvhart<XLEN>::get_register(uint32_t r) const
+{
+    return regs.get(r);
+}
+/**
+ * getter get_pc
+ * @param none
+ * @return the address of the next instruction
+ ********************************************************************************/
+template<uint32_t XLEN>
+typename rvhart<XLEN>::reg_t rvhart<XLEN>::get_pc() const
+{
+    return pc;
+}
+/**
+ * Setter set_pc
+ * @param reg_t addr
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::set_pc(reg_t addr)
+{
+    pc = addr;
+}
+/**
+ * Send everything the hart prints (traces, dumps, why it stopped) to os instead of std::cout
+ * @param std::ostream* os
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::set_output(std::ostream* os)
+{
+    out = os;
+}
+/**
+ * Setter set_hostio
+ * sets the host syscall proxy used by ecall and tells it which ABI the guest uses
+ * @param hostio* h
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::set_hostio(hostio* h)
+{
+    io = h;
+    if (io != nullptr)
+    {
+        io->set_lp64(XLEN == 64);
+    }
+}
+/**
+ * Setter set_log
+ * sets the record/replay log, syscalls, wfi wake-ups, interrupts and reads of mip, time and
+ * timeh go through it
+ * @param replaylog* l
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::set_log(replaylog* l)
+{
+    log = l;
+}
+/**
+ * Setter set_hartid
+ * sets the value read from the mhartid CSR
+ * @param uint32_t id
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::set_hartid(uint32_t id)
+{
+    hartid = id;
+}
+/**
+ * Setter set_insns_per_tick
+ * mtime advances by one every n instructions so time only depends on the instruction count
+ * @param uint32_t n (must not be 0)
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::set_insns_per_tick(uint32_t n)
+{
+    insns_per_tick = n;
+}
+/**
+ * getter get_insn_counter
+ * @param none
+ * @return number of instructions executed so far
+ ********************************************************************************/
+template<uint32_t XLEN>
+uint64_t rvhart<XLEN>::get_insn_counter() const
+{
+    return insn_counter;
+}
+/**
+ * getter get_mtime
+ * @param none
+ * @return the current machine timer value, derived from the instruction count
+ ********************************************************************************/
+template<uint32_t XLEN>
+uint64_t rvhart<XLEN>::get_mtime() const
+{
+    return insn_counter / insns_per_tick + mtime_offset;
+}
+/**
+ * Setter set_mtime
+ * makes get_mtime() return t now and count up from there
+ * @param uint64_t t
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::set_mtime(uint64_t t)
+{
+    mtime_offset = t - insn_counter / insns_per_tick;
+}
+/**
+ * Converts a machine timer value into the instruction count at which mtime reaches it
+ * @param uint64_t t
+ * @return the instruction count or event_queue::never if mtime never gets there
+ ********************************************************************************/
+template<uint32_t XLEN>
+uint64_t rvhart<XLEN>::mtime_to_insn(uint64_t t) const
+{
+    uint64_t ticks; // mtime ticks from insn_counter 0 until mtime reaches t
+    if (mtime_offset >= 0)
+    {
+        if (t <= (uint64_t)mtime_offset)
+        {
+            return 0;
+        }
+        ticks = t - mtime_offset;
+    }
+    else
+    {
+        ticks = t + (uint64_t)(-mtime_offset);
+        if (ticks < t)
+        {
+            return event_queue::never;
+        }
+    }
+    if (ticks > event_queue::never / insns_per_tick)
+    {
+        return event_queue::never;
+    }
+    return ticks * insns_per_tick;
+}
+/**
+ * Schedule target to fire once insn_counter reaches when
+ * @param uint64_t when, event_target* target
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::schedule_event(uint64_t when, event_target* target)
+{
+    events.schedule(when, target);
+    if (when < next_check)
+    {
+        next_check = when;
+    }
+}
+/**
+ * Raise or lower one of the interrupt pending bits in mip
+ * devices call this, the hart looks at the change before the next instruction
+ * @param uint32_t bit (mip_msip, mip_mtip or mip_meip), bool level
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::set_interrupt_pending(uint32_t bit, bool level)
+{
+    if (level)
+        mip |= bit;
+    else
+        mip &= ~bit;
+    next_check = 0;
+}
+/**
+ * getter is_halted
+ * gets the value of the flag halt
+ * @param none
+ * @return bool halt
+ ********************************************************************************/
+template<uint32_t XLEN>
+bool rvhart<XLEN>::is_halted() const
 {
     return halt;
 }
-/*
-Reset the rv32i object and the registerfile.
-To reset the rv32i hart, set the pc register to zero, the insn_counter to zero, and the halt flag to
-false;
-*/
+/*
+Reset the rv32i object and the registerfile.
+To reset the rv32i hart, set the pc register to zero, the insn_counter to zero, and the halt flag to
+false;
+*/
+/**
+ * Reset the rv32i object and the register file
+ * Does the reset by setting pc register to zero, insn_counter to 0 and halt flag to false,
+ * the integer and vector registers and the CSRs go back to their reset values and pending events
+ * are dropped
+ * @param none
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::reset()
+{
+    pc = 0;
+    insn_counter = 0;
+    halt = false;
+    mstatus = mstatus_mpp;
+    priv = mmu::priv_m;
+    vm.reset();
+    mie = 0;
+    mip = 0;
+    mtvec = 0;
+    mepc = 0;
+    mcause = 0;
+    mtval = 0;
+    medeleg = 0;
+    mideleg = 0;
+    mcounteren = 0;
+    stvec = 0;
+    sepc = 0;
+    scause = 0;
+    stval = 0;
+    scounteren = 0;
+    unhandled = false;
+    regs.reset();
+    mtime_offset = 0;
+    events.clear();
+    next_check = 0;
+    vec.reset();
+}
+/**
+ * Dumps the state of the hart
+ * This method which is a member of rv32i class will dump the sate of the hart. Will dump registers
+ * and pc register
+ * @param none
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::dump() const
+{
+    regs.dump(*out);
+    *out << " pc " << hex_xlen(pc) << std::endl;
+}
+/**
+ * Format a register value or an address with as many hex digits as the registers have
+ * @param reg_t v
+ * @return 8 or 16 hex digits
+ ********************************************************************************/
+template<uint32_t XLEN>
+std::string rvhart<XLEN>::hex_xlen(reg_t v)
+{
+    return XLEN == 32 ? hex32(v) : hex64(v);
+}
+/**
+ * Like hex_xlen() with "0x" in front
+ * @param reg_t v
+ * @return "0x" and 8 or 16 hex digits
+ ********************************************************************************/
+template<uint32_t XLEN>
+std::string rvhart<XLEN>::hex0x_xlen(reg_t v)
+{
+    return std::string("0x") + hex_xlen(v);
+}
+/**
+ * Execute the given RV32I instruction
+ * The instruction is looked up in the decode table (the same one decode() uses) and its exec_xx()
+ * is called, which also renders it when pos is not nullptr.
+ * @param uint32_t insn, std::ostream* pos
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::dcex(uint32_t insn, std::ostream* pos)
+{
+    (this->*insn_infos<XLEN>[lookup<XLEN>(insn)].exec)(insn, pos);
+}
+/**
+ * function to take care of illegal cases
+ * raises the illegal instruction exception with the instruction in mtval, if ostream* parameter
+ * is not nullptr then call render_illegal_insn() to print the message
+ * @param uint32_t insn, std::ostream* pos
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_illegal_insn(uint32_t insn, std::ostream* pos)
+{
+    take_exception(cause_illegal, insn);
+    if (pos != nullptr) // if pos is not nulltpr call render_illegal_insn()
+    {
+        render_fault(pos, render_illegal_insn());
+    }
+}
+/**
+ * Execute lui instruction
+ * IT executes the LUI RV32I instruction, renders the details of what it has simulated.
+ * it uses render() helper functions
+ * @param uint32_t insn, std::ostream* pos)
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_lui(uint32_t insn, std::ostream* pos)
+{
+    uint32_t rd = get_rd(insn); // get rd
+    int32_t imm_u = get_imm_u(insn); // get imm_u
+    if (pos)
+    {
+        std::string s = render_lui(insn); // call render_lui
+        s.resize(instruction_width, ' ');
+        *pos << s << "// "
+             << "x" << std::dec << rd << " = " << hex0x_xlen(imm_u);
+    }
+    regs.set(rd, imm_u); // set rd to imm_u
+    pc += 4; // increment pc by 4
+}
+/**
+ * Execute auipc instruction
+ * IT executes the AUIPC RV32I instruction, renders the details of what it has simulated.
+ * it uses render() helper functions
+ * @param uint32_t insn, std::ostream* pos)
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_auipc(uint32_t insn, std::ostream* pos)
+{
+    uint32_t rd = get_rd(insn); // get rd
+    reg_t imm_u = get_imm_u(insn) + pc; // get imm_u + pc
+    if (pos)
+    {
+        std::string s = render_auipc(insn);
+        s.resize(instruction_width, ' ');
+        *pos << s << "// "
+             << "x" << rd << " = " << hex0x_xlen(pc) << " + " << hex0x_xlen(get_imm_u(insn)) << " = "
+             << hex0x_xlen(imm_u);
+    }
+    regs.set(rd, imm_u); // set rd to imm_u
+    pc += 4; // increment pc by 4
+}
+/**
+ * Execute jal instruction
+ * IT executes the JAL RV32I instruction, renders the details of what it has simulated.
+ * it uses render() helper functions
+ * @param uint32_t insn, std::ostream* pos)
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_jal(uint32_t insn, std::ostream* pos)
+{
+    uint32_t rd = get_rd(insn); // rd
+    reg_t imm_j = get_imm_j(insn); // imm_j
+    reg_t old_pc = pc;
+    if (imm_j & 2)
+    {
+        take_exception(cause_insn_misaligned, pc + imm_j); // pc is always a multiple of 4
+        if (pos)
+            render_fault(pos, render_jal(insn));
+        return;
+    }
+    if (pos)
+    {
+        std::string s = render_jal(insn);
+        s.resize(instruction_width, ' ');
+        pc += imm_j;
+        *pos << s << "// "
+             << "x" << to_string(rd) << " = " << hex0x_xlen(old_pc + 4) << ", "
+             << " pc = " << hex0x_xlen(old_pc) << " + " << hex0x_xlen(imm_j) << " = " << hex0x_xlen(pc);
+    }
+    regs.set(rd, old_pc + 4);
+    pc = old_pc + imm_j;
+}
+/**
+ * Execute jalr instruction
+ * IT executes the JALR RV32I instruction, renders the details of what it has simulated.
+ * it uses render() helper functions
+ * @param uint32_t insn, std::ostream* pos)
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_jalr(uint32_t insn, std::ostream* pos)
+{
+   uint32_t rd = get_rd(insn); //get rd
+   uint32_t rs1 = get_rs1(insn); //register rs1
+   reg_t imm_i = get_imm_i(insn); //get imm_i
+   reg_t old_pc = pc; //old pc value
+   reg_t target = (regs.get(rs1) + imm_i) & ~(reg_t)1;
+   if (target & 2)
+   {
+       take_exception(cause_insn_misaligned, target);
+       if (pos)
+           render_fault(pos, render_jalr(insn));
+       return;
+   }
+   pc = target; // increment pc 
+   if (pos)
+   {
+    std::string s = render_jalr(insn) ;
+     s.resize(instruction_width,' ');
+     *pos << s << "// x" << to_string(rd) <<" = "<<hex0x_xlen(old_pc+4) << ", pc = (" << hex0x_xlen(imm_i)
+     <<" + " << hex0x_xlen(regs.get(rs1)) << ") & " << hex0x_xlen(~(reg_t)1) << " = " << hex0x_xlen(pc);
+
+   }
+   regs.set(rd,old_pc+4); //set rd to old_pc +4
+} 
+/**
+ * Execute add instruction
+ * IT executes the add RV32I instruction, renders the details of what it has simulated.
+ * it uses render() helper functions
+ * @param uint32_t insn, std::ostream* pos)
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_add(uint32_t insn, std::ostream* pos)
+{
+    uint32_t rd = get_rd(insn); // rd
+    reg_t rs1 = regs.get(get_rs1(insn)); // rs1
+    reg_t rs2 = regs.get(get_rs2(insn)); // rs2
+    if (pos)
+    {
+        std::string s = render_rtype(insn, "add");
+        s.resize(instruction_width, ' ');
+        *pos << s << "// "
+             << "x" << rd << " = " << hex0x_xlen(rs1) << " + " << hex0x_xlen(rs2) << " = "
+             << hex0x_xlen(rs1 + rs2);
+    }
+    regs.set(rd, (rs1 + rs2)); // set rd to (rs1+rs2)
+    pc += 4; // increment pc by 4
+}
+/**
+ * Execute addi instruction
+ * IT executes the ADDI RV32I instruction, renders the details of what it has simulated.
+ * it uses render() helper functions
+ * @param uint32_t insn, std::ostream* pos)
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_addi(uint32_t insn, std::ostream* pos)
+{
+    uint32_t rd = get_rd(insn); // rd
+    reg_t rs1 = regs.get(get_rs1(insn)); // rs1
+    int32_t imm_i = get_imm_i(insn); // imm_i
+    regs.set(rd, (rs1 + imm_i)); // set rd to rs1+imm_i
+    pc += 4; // increment pc by 4
+    if (pos)
+    {
+        std::string s = render_itype_alu(insn, "addi", imm_i);
+        ;
+        s.resize(instruction_width, ' ');
+        *pos << s << "// "
+             << "x" << rd << " = " << hex0x_xlen(rs1) << " + " << hex0x_xlen(imm_i) << " = "
+             << hex0x_xlen(regs.get(rd));
+    }
+}
+/**
+ * Execute srli instruction
+ * IT executes the SRLI RV32I instruction, renders the details of what it has simulated.
+ * it uses render() helper functions
+ * @param uint32_t insn, std::ostream* pos)
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_srli(uint32_t insn, std::ostream* pos)
+{
+    uint32_t rd = get_rd(insn); // rd
+    reg_t rs1 = regs.get(get_rs1(insn)); // rs1
+    uint32_t imm_i = get_imm_i(insn); // imm_i
+    regs.set(rd, rs1 >> (imm_i % XLEN)); // set rd to rs1>>imm_i
+    pc += 4; // increment pc by 4
+    if (pos)
+    {
+        std::string s = render_itype_shamt(insn, "srli");
+        s.resize(instruction_width, ' ');
+        *pos << s << "// "
+             << "x" << rd << " = " << hex0x_xlen(rs1) << " >> " << imm_i << " = "
+             << hex0x_xlen(regs.get(rd));
+    }
+}
+/**
+ * Execute and instruction
+ * IT executes the AND RV32I instruction, renders the details of what it has simulated.
+ * it uses render() helper functions
+ * @param uint32_t insn, std::ostream* pos)
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_and(uint32_t insn, std::ostream* pos)
+{
+    uint32_t rd = get_rd(insn); // rd
+    reg_t rs1 = regs.get(get_rs1(insn)); // rs1
+    reg_t rs2 = regs.get(get_rs2(insn)); // rs2
+    if (pos)
+    {
+        std::string s = render_rtype(insn, "and");
+        s.resize(instruction_width, ' ');
+        *pos << s << "// "
+             << "x" << rd << " = " << hex0x_xlen(rs1) << " & " << hex0x_xlen(rs2) << " = "
+             << hex0x_xlen(rs1 & rs2);
+    }
+    regs.set(rd, (rs1 & rs2)); // set rd to rs1 & rs2
+    pc += 4; // increment pc by 4
+}
+/**
+ * Execute andi instruction
+ * IT executes the ANDI RV32I instruction, renders the details of what it has simulated.
+ * it uses render() helper functions
+ * @param uint32_t insn, std::ostream* pos)
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_andi(uint32_t insn, std::ostream* pos)
+{
+    uint32_t rd = get_rd(insn); // rd
+    reg_t imm_i = get_imm_i(insn); // imm_i
+    reg_t rs1 = regs.get(get_rs1(insn)); // rs1
+    if (pos)
+    {
+        std::string s = render_itype_alu(insn, "andi", imm_i);
+        s.resize(instruction_width, ' ');
+        *pos << s << "// "
+             << "x" << rd << " = " << hex0x_xlen(rs1) << " & " << hex0x_xlen(imm_i) << " = "
+             << hex0x_xlen(rs1 & imm_i);
+    }
+    regs.set(rd, (rs1 & imm_i)); // set rd to rs1&imm_i
+    pc += 4; // increment pc by 4
+}
+/**
+ * Execute beq instruction
+ * IT executes the BEQ RV32I instruction, renders the details of what it has simulated.
+ * it uses render() helper functions
+ * @param uint32_t insn, std::ostream* pos)
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_beq(uint32_t insn, std::ostream* pos)
+{
+    reg_t rs1 = regs.get(get_rs1(insn)); // get register rs1
+    reg_t rs2 = regs.get(get_rs2(insn)); // get register rs2
+    int32_t imm_b = get_imm_b(insn); // get imm_b
+    if (pos)
+    {
+        std::string s = render_btype(insn, "beq");
+        ;
+        s.resize(instruction_width, ' ');
+        *pos << s << "// "
+             << "pc += (" << hex0x_xlen(regs.get(get_rs1(insn)))
+             << " == " << hex0x_xlen(regs.get(get_rs2(insn))) << " ? " << hex0x_xlen(imm_b)
+             << " : 4) = " << hex0x_xlen(rs1 == rs2 ? pc += imm_b : pc += 4);
+    }
+    if (pos == nullptr)
+    {
+        (rs1 == rs2 ? pc += imm_b : pc += 4);
+    }
+    if (pc & 2)
+    {
+        branch_misaligned(imm_b, pos); // taken, and bit 1 of imm_b is set
+    }
+}
+/**
+ * Execute bge instruction
+ * IT executes the BGE RV32I instruction, renders the details of what it has simulated.
+ * it uses render() helper functions
+ * @param uint32_t insn, std::ostream* pos)
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_bge(uint32_t insn, std::ostream* pos)
+{
+    sreg_t rs1 = regs.get(get_rs1(insn)); // get register rs1
+    sreg_t rs2 = regs.get(get_rs2(insn)); // get register rs2
+    int32_t imm_b = get_imm_b(insn); // get imm_b
+    if (pos)
+    {
+        std::string s = render_btype(insn, "bge");
+        s.resize(instruction_width, ' ');
+        *pos << s << "// " << std::dec << "pc += (" << hex0x_xlen(rs1) << " >= " << hex0x_xlen(rs2)
+             << " ? " << hex0x_xlen(imm_b)
+             << " : 4) = " << hex0x_xlen(rs1 >= rs2 ? pc += imm_b : pc += 4);
+    }
+    if (pos == nullptr)
+    {
+        (rs1 >= rs2 ? pc += imm_b : pc += 4); // increment pc
+    }
+    if (pc & 2)
+    {
+        branch_misaligned(imm_b, pos); // taken, and bit 1 of imm_b is set
+    }
+}
+/**
+ * Execute bgeu instruction
+ * IT executes the LUI RV32I instruction, renders the details of what it has simulated.
+ * it uses render() helper functions
+ * @param uint32_t insn, std::ostream* pos)
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_bgeu(uint32_t insn, std::ostream* pos)
+{
+    reg_t rs1 = regs.get(get_rs1(insn)); // get register rs1
+    reg_t rs2 = regs.get(get_rs2(insn)); // get register rs2
+    int32_t imm_b = get_imm_b(insn); // get imm_b
+    if (pos)
+    {
+        std::string s = render_btype(insn, "bgeu");
+        s.resize(instruction_width, ' ');
+        *pos << s << "// " << std::dec << "pc += (" << hex0x_xlen(rs1) << " >=U " << hex0x_xlen(rs2)
+             << " ? " << hex0x_xlen(imm_b)
+             << " : 4) = " << hex0x_xlen(rs1 >= rs2 ? pc += imm_b : pc += 4);
+    }
+    if (pos == nullptr)
+    {
+        (rs1 >= rs2 ? pc += imm_b : pc += 4); // increment pc
+    }
+    if (pc & 2)
+    {
+        branch_misaligned(imm_b, pos); // taken, and bit 1 of imm_b is set
+    }
+}
+/**
+ * Execute blt instruction
+ * IT executes the BLT RV32I instruction, renders the details of what it has simulated.
+ * it uses render() helper functions
+ * @param uint32_t insn, std::ostream* pos)
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_blt(uint32_t insn, std::ostream* pos)
+{
+    sreg_t rs1 = regs.get(get_rs1(insn)); // get register rs1
+    sreg_t rs2 = regs.get(get_rs2(insn)); // get register rs1
+    uint32_t imm_b = get_imm_b(insn); // get imm_b
+    if (pos)
+    {
+        std::string s = render_btype(insn, "blt");
+        s.resize(instruction_width, ' ');
+        *pos << s << "// " << std::dec << "pc += (" << hex0x_xlen(rs1) << " < " << hex0x_xlen(rs2)
+             << " ? " << hex0x_xlen(imm_b) << " : 4) = " << hex0x_xlen(rs1 < rs2 ? pc += imm_b : pc += 4);
+    }
+    if (pos == nullptr)
+    {
+        (rs1 < rs2 ? pc += imm_b : pc += 4); // increment pc
+    }
+    if (pc & 2)
+    {
+        branch_misaligned(imm_b, pos); // taken, and bit 1 of imm_b is set
+    }
+}
+/**
+ * Execute bltu instruction
+ * IT executes the bltu RV32I instruction, renders the details of what it has simulated.
+ * it uses render() helper functions
+ * @param uint32_t insn, std::ostream* pos)
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_bltu(uint32_t insn, std::ostream* pos)
+{
+    reg_t rs1 = regs.get(get_rs1(insn)); // get register rs1
+    reg_t rs2 = regs.get(get_rs2(insn)); // get register rs2
+    int32_t imm_b = get_imm_b(insn); // get imm_b
+    if (pos)
+    {
+        std::string s = render_btype(insn, "bltu");
+        s.resize(instruction_width, ' ');
+        *pos << s << "// " << std::dec << "pc += (" << hex0x_xlen(rs1) << " <U " << hex0x_xlen(rs2)
+             << " ? " << hex0x_xlen(imm_b)
+             << " : 4) = " << hex0x_xlen((rs1 < rs2 ? pc += imm_b : pc += 4));
+    }
+    if (pos == nullptr)
+    {
+        (rs1 < rs2 ? pc += imm_b : pc += 4); // increment pc
+    }
+    if (pc & 2)
+    {
+        branch_misaligned(imm_b, pos); // taken, and bit 1 of imm_b is set
+    }
+}
+/**
+ * Execute bne instruction
+ * IT executes the BNE RV32I instruction, renders the details of what it has simulated.
+ * it uses render() helper functions
+ * @param uint32_t insn, std::ostream* pos)
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_bne(uint32_t insn, std::ostream* pos)
+{
+    reg_t rs1 = regs.get(get_rs1(insn)); // get register rs1
+    reg_t rs2 = regs.get(get_rs2(insn)); // get register rs2
+    int32_t imm_b = get_imm_b(insn); // get imm_b
+    if (pos)
+    {
+        std::string s = render_btype(insn, "bne");
+        s.resize(instruction_width, ' ');
+        *pos << s << "// " << std::dec << "pc += (" << hex0x_xlen(rs1) << " != " << hex0x_xlen(rs2)
+             << " ? " << hex0x_xlen(imm_b)
+             << " : 4) = " << hex0x_xlen(rs1 != rs2 ? pc += imm_b : pc += 4);
+    }
+    if (pos == nullptr)
+    {
+        (rs1 != rs2 ? pc += imm_b : pc += 4); // increment pc
+    }
+    if (pc & 2)
+    {
+        branch_misaligned(imm_b, pos); // taken, and bit 1 of imm_b is set
+    }
+}
+/**
+ * Execute lb instruction
+ * IT executes the LB RV32I instruction, renders the details of what it has simulated.
+ * it uses render() helper functions
+ * @param uint32_t insn, std::ostream* pos)
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_lb(uint32_t insn, std::ostream* pos)
+{
+
+    uint32_t rd = get_rd(insn); // rd
+    reg_t rs1 = regs.get(get_rs1(insn)); // register rs1
+    int32_t imm_i = get_imm_i(insn); // imm_i
+    uint8_t byte;
+    if (!read_mem(rs1 + imm_i, byte))
+    {
+        if (pos)
+            render_fault(pos, render_itype_load(insn, "lb"));
+        return;
+    }
+    int32_t address = byte; // memory address
+    // check the MSB if its set to 1 | with 0xFFFFFF00
+    if ((address & 0x00000080) == 0x00000080)
+    {
+        address |= 0xFFFFFF00;
+    }
+    regs.set(rd, address); // set rd to addr
+    pc += 4; // icrement pc by 4
+    if (pos)
+    {
+        std::string s = render_itype_load(insn, "lb");
+        s.resize(instruction_width, ' ');
+        *pos << s << "// "
+             << "x" << rd << " = sx(m8(" << hex0x_xlen(rs1) << " + " << hex0x_xlen(imm_i)
+             << " )) = " << hex0x_xlen(regs.get(rd));
+    }
+}
+/**
+ * Execute lbu instruction
+ * IT executes the LBU RV32I instruction, renders the details of what it has simulated.
+ * it uses render() helper functions
+ * @param uint32_t insn, std::ostream* pos)
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_lbu(uint32_t insn, std::ostream* pos)
+{
+    uint32_t rd = get_rd(insn); // get rd
+    reg_t rs1 = regs.get(get_rs1(insn)); // get register rs1
+    reg_t imm_i = get_imm_i(insn); // get imm_i
+    uint8_t byte;
+    if (!read_mem(rs1 + imm_i, byte)) // read once in case it is a device
+    {
+        if (pos)
+            render_fault(pos, render_itype_load(insn, "lbu"));
+        return;
+    }
+    rd = byte;
+    regs.set(get_rd(insn), rd); // set rd to m8(rs1+imm_i)
+    pc += 4; // increment pc by 4
+    if (pos)
+    {
+        std::string s = render_itype_load(insn, "lbu");
+        s.resize(instruction_width, ' ');
+        *pos << s << "// "
+             << "x" << get_rd(insn) << " = zx(m8(" << hex0x_xlen(rs1) << " + " << hex0x_xlen(imm_i)
+             << " )) = " << hex0x_xlen(rd);
+    }
+}
+/**
+ * Execute lh instruction
+ * IT executes the LH RV32I instruction, renders the details of what it has simulated.
+ * it uses render() helper functions
+ * @param uint32_t insn, std::ostream* pos
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_lh(uint32_t insn, std::ostream* pos)
+{
+    int32_t rd = get_rd(insn); // rd
+    sreg_t rs1 = regs.get(get_rs1(insn)); // register rs1
+    int32_t imm_i = get_imm_i(insn); // imm_i
+    uint16_t half;
+    if (!read_mem(rs1 + imm_i, half))
+    {
+        if (pos)
+            render_fault(pos, render_itype_load(insn, "lh"));
+        return;
+    }
+    int32_t address = half; // memory address
+    // if msb is 1 then | with 0xffff0000
+    if ((address & 0x00008000) == 0x00008000)
+    {
+        address |= 0xffff0000;
+    }
+    regs.set(rd, address); // set rd to address
+    pc += 4; // increment pc by 4
+    if (pos)
+    {
+        std::string s = render_itype_load(insn, "lh");
+        s.resize(instruction_width, ' ');
+        *pos << s << "// "
+             << "x" << rd << " = sx(m16(" << hex0x_xlen(rs1) << " + " << hex0x_xlen(imm_i)
+             << ")) = " << hex0x_xlen(regs.get(rd));
+    }
+}
+/**
+ * Execute lhu instruction
+ * IT executes the LHU RV32I instruction, renders the details of what it has simulated.
+ * it uses render() helper functions
+ * @param uint32_t insn, std::ostream* pos)
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_lhu(uint32_t insn, std::ostream* pos)
+{
+    uint32_t rd = get_rd(insn); // get rd
+    reg_t rs1 = regs.get(get_rs1(insn)); // register rs1
+    reg_t imm_i = get_imm_i(insn); // get imm_i
+    uint16_t val; // read once in case it is a device
+    if (!read_mem(rs1 + imm_i, val))
+    {
+        if (pos)
+            render_fault(pos, render_itype_load(insn, "lhu"));
+        return;
+    }
+    regs.set(rd, val); // set rd to memory address get16(rs1+imm_i)
+    pc += 4; // increment pc with 4
+    if (pos)
+    {
+        std::string s = render_itype_load(insn, "lhu");
+        s.resize(instruction_width, ' ');
+        *pos << s << "// "
+             << "x" << rd << " = zx(m16(" << hex0x_xlen(rs1) << " + " << hex0x_xlen(imm_i)
+             << " )) = " << hex0x_xlen(val);
+    }
+}
+/**
+ * Execute lw instruction
+ * IT executes the LW RV32I instruction, renders the details of what it has simulated.
+ * it uses render() helper functions
+ * @param uint32_t insn, std::ostream* pos)
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_lw(uint32_t insn, std::ostream* pos)
+{
+    uint32_t rd = get_rd(insn); // rd
+    reg_t rs1 = regs.get(get_rs1(insn)); // register rs1
+    reg_t imm_i = get_imm_i(insn); // imm_i
+    uint32_t val;
+    if (!read_mem(rs1 + imm_i, val))
+    {
+        if (pos)
+            render_fault(pos, render_itype_load(insn, "lw"));
+        return;
+    }
+    regs.set(rd, (int32_t)val); // set rd to memory address get32(rs1+imm_i)
+    pc += 4; // increment pc by 4
+    if (pos)
+    {
+        std::string s = render_itype_load(insn, "lw");
+        s.resize(instruction_width, ' ');
+        *pos << s << "// "
+             << "x" << rd << " = sx(m32(" << hex0x_xlen(rs1) << " + " << hex0x_xlen(imm_i)
+             << " )) = " << hex0x_xlen(regs.get(rd));
+    }
+}
+/**
+ * Execute or instruction
+ * IT executes the OR RV32I instruction, renders the details of what it has simulated.
+ * it uses render() helper functions
+ * @param uint32_t insn, std::ostream* pos)
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_or(uint32_t insn, std::ostream* pos)
+{
+    uint32_t rd = get_rd(insn); // get rd
+    reg_t rs1 = regs.get(get_rs1(insn)); // register rs1
+    reg_t rs2 = regs.get(get_rs2(insn)); // register rs2
+    if (pos)
+    {
+        std::string s = render_rtype(insn, "or");
+        s.resize(instruction_width, ' ');
+        *pos << s << "// "
+             << "x" << rd << " = " << hex0x_xlen(rs1) << " | " << hex0x_xlen(rs2) << " = "
+             << hex0x_xlen(rs1 | rs2);
+    }
+    regs.set(rd, (rs1 | rs2)); // set rd to rs1 | rs2
+    pc += 4; // increment pc by 4
+}
+/**
+ * Execute ori instruction
+ * IT executes the ORI RV32I instruction, renders the details of what it has simulated.
+ * it uses render() helper functions
+ * @param uint32_t insn, std::ostream* pos)
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_ori(uint32_t insn, std::ostream* pos)
+{
+    uint32_t rd = get_rd(insn); // get rd
+    reg_t rs1 = regs.get(get_rs1(insn)); // register rs1
+    reg_t imm_i = get_imm_i(insn); // get imm_i
+    if (pos)
+    {
+        std::string s = render_itype_alu(insn, "ori", imm_i);
+        ;
+        s.resize(instruction_width, ' ');
+        *pos << s << "// "
+             << "x" << rd << " = " << hex0x_xlen(rs1) << " | " << hex0x_xlen(imm_i) << " = "
+             << hex0x_xlen(rs1 | imm_i);
+    }
+    regs.set(rd, (rs1 | imm_i)); // set rd to rs1 | imm_i
+    pc += 4; // increment pc by 4
+}
+/**
+ * Execute sb instruction
+ * IT executes the SB RV32I instruction, renders the details of what it has simulated.
+ * it uses render() helper functions
+ * @param uint32_t insn, std::ostream* pos)
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_sb(uint32_t insn, std::ostream* pos)
+{
+    reg_t rs1 = regs.get(get_rs1(insn)); // register rs1
+    reg_t rs2 = regs.get(get_rs2(insn)); // register rs2
+    reg_t imm_s = get_imm_s(insn); // imm_s
+    if (pos)
+    {
+        std::string s = render_stype(insn, "sb");
+        s.resize(instruction_width, ' ');
+        *pos << s << "// "
+             << "m8(" << hex0x_xlen(rs1) << " + " << hex0x_xlen(imm_s)
+             << ") = " << hex0x_xlen(rs2 & 0x000000ff);
+    }
+    if (!write_mem(rs1 + imm_s, (uint8_t)rs2)) // set memory at address rs1+imm_S to rs2&0x000000ff
+    {
+        if (pos)
+            render_fault(pos, "");
+        return;
+    }
+    pc += 4; // increment pc by 4
+}
+/**
+ * Execute sh instruction
+ * IT executes the LUI RV32I instruction, renders the details of what it has simulated.
+ * it uses render() helper functions
+ * @param uint32_t insn, std::ostream* pos)
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_sh(uint32_t insn, std::ostream* pos)
+{
+    uint32_t rs1 = get_rs1(insn);
+    uint32_t rs2 = get_rs2(insn);
+    reg_t imm_s = get_imm_s(insn);
+    uint32_t target = regs.get(rs2) & 0x0000ffff;
+    if (pos)
+    {
+        std::string s = render_stype(insn, "sh");
+        s.resize(instruction_width, ' ');
+        *pos << s << "// "
+             << "m16(" << hex0x_xlen(regs.get(rs1)) << " + " << hex0x_xlen(imm_s)
+             << ") = " << hex0x_xlen(target);
+    }
+    if (!write_mem(regs.get(rs1) + imm_s, (uint16_t)target)) // set addr to target
+    {
+        if (pos)
+            render_fault(pos, "");
+        return;
+    }
+    pc += 4; // incremet pc by 4
+}
+/**
+ * Execute sll instruction
+ * IT executes the SLL RV32I instruction, renders the details of what it has simulated.
+ * it uses render() helper functions
+ * @param uint32_t insn, std::ostream* pos)
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_sll(uint32_t insn, std::ostream* pos)
+{
+    uint32_t rd = get_rd(insn); // get rd
+    reg_t rs1 = regs.get(get_rs1(insn)); // register rs1
+    reg_t rs2 = regs.get(get_rs2(insn)); // register rs2
+    regs.set(rd, rs1 << (rs2 % XLEN)); // set rd to rs1<<(Rs2%xlen)
+    pc += 4; // increment pc by 4
+    if (pos)
+    {
+        std::string s = render_rtype(insn, "sll");
+        s.resize(instruction_width, ' ');
+        *pos << s << "// "
+             << "x" << rd << " = " << hex0x_xlen(rs1) << " << " << rs2 % XLEN << " = "
+             << hex0x_xlen(regs.get(rd));
+    }
+}
+/**
+ * Execute slli instruction
+ * IT executes the SLLI RV32I instruction, renders the details of what it has simulated.
+ * it uses render() helper functions
+ * @param uint32_t insn, std::ostream* pos)
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_slli(uint32_t insn, std::ostream* pos)
+{
+    uint32_t rd = get_rd(insn); // get rd
+    reg_t rs1 = regs.get(get_rs1(insn)); // register rs1
+    uint32_t imm_i = get_imm_i(insn); // get imm_i
+    regs.set(rd, rs1 << (imm_i % XLEN)); // set rd to rs1 << imm_i
+    pc += 4; // increment pc by 4
+    if (pos)
+    {
+        std::string s = render_itype_shamt(insn, "slli");
+        s.resize(instruction_width, ' ');
+        *pos << s << "// "
+             << "x" << rd << " = " << hex0x_xlen(rs1) << " << " << imm_i << " = "
+             << hex0x_xlen(regs.get(rd));
+    }
+}
+/**
+ * Execute slt instruction
+ * IT executes the SLT RV32I instruction, renders the details of what it has simulated.
+ * it uses render() helper functions
+ * @param uint32_t insn, std::ostream* pos)
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_slt(uint32_t insn, std::ostream* pos)
+{
+    uint32_t rd = get_rd(insn); // get rd
+    sreg_t rs1 = regs.get(get_rs1(insn)); // register rs1
+    sreg_t rs2 = regs.get(get_rs2(insn)); // register rs2
+    (rs1 < rs2 ? regs.set(rd, 1) : regs.set(rd, 0)); // set regs 1 or 0 based on condition rs1 < rs2
+    pc += 4;
+    if (pos)
+    {
+        std::string s = render_rtype(insn, "slt");
+        s.resize(instruction_width, ' ');
+        *pos << s << "// "
+             << "x" << rd << " = (" << hex0x_xlen(rs1) << " < " << hex0x_xlen(rs2)
+             << ") ? 1 : 0 = " << hex0x_xlen(regs.get(rd));
+    }
+}
+/**
+ * Execute slti instruction
+ * IT executes the SLTI RV32I instruction, renders the details of what it has simulated.
+ * it uses render() helper functions
+ * @param uint32_t insn, std::ostream* pos)
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_slti(uint32_t insn, std::ostream* pos)
+{
+    uint32_t rd = get_rd(insn); // get rd
+    sreg_t rs1 = regs.get(get_rs1(insn)); // register rs1
+    int32_t imm_i = get_imm_i(insn); // get imm_i
+    if (rs1 < imm_i)
+    {
+        regs.set(rd, 1);
+    }
+    else
+    {
+        regs.set(rd, 0);
+    }
+    (rs1 < imm_i ? regs.set(rd, 1)
+                 : regs.set(rd, 0)); // set rd to 0 or 1 based on condition rs1 <imm_i
+    pc += 4; // increment pc by 4
+    if (pos)
+    {
+        std::string s = render_itype_alu(insn, "slti", imm_i);
+        s.resize(instruction_width, ' ');
+        *pos << s << "// "
+             << "x" << rd << " = (" << hex0x_xlen(rs1) << " < " << imm_i
+             << ") ? 1 : 0 = " << hex0x_xlen(regs.get(rd));
+    }
+}
+/**
+ * Execute sltiu instruction
+ * IT executes the SLTIU RV32I instruction, renders the details of what it has simulated.
+ * it uses render() helper functions
+ * @param uint32_t insn, std::ostream* pos)
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_sltiu(uint32_t insn, std::ostream* pos)
+{
+    uint32_t rd = get_rd(insn); // get rd
+    reg_t rs1 = regs.get(get_rs1(insn)); // register rs1
+    reg_t imm_i = get_imm_i(insn); // get imm_i
+    (rs1 < imm_i ? regs.set(rd, 1)
+                 : regs.set(rd, 0)); // set rd to 0 or 1 based to condition rs1 < imm_i
+    pc += 4; // increment pc by 4
+    if (pos)
+    {
+        std::string s = render_itype_alu(insn, "sltiu", imm_i);
+        s.resize(instruction_width, ' ');
+        *pos << s << "// "
+             << "x" << rd << " = (" << hex0x_xlen(rs1) << " <U " << imm_i
+             << ") ? 1 : 0 =" << hex0x_xlen(regs.get(rd));
+    }
+}
+/**
+ * Execute sltu instruction
+ * IT executes the SLTU RV32I instruction, renders the details of what it has simulated.
+ * it uses render() helper functions
+ * @param uint32_t insn, std::ostream* pos)
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_sltu(uint32_t insn, std::ostream* pos)
+{
+    uint32_t rd = get_rd(insn); // get rd
+    reg_t rs1 = regs.get(get_rs1(insn)); // register rs1
+    reg_t rs2 = regs.get(get_rs2(insn)); // register rs2
+    (rs1 < rs2 ? regs.set(rd, 1) : regs.set(rd, 0)); // set rd to 1 or 0 based on cond rs1 < rs2
+    pc += 4; // increment pc by 4
+    if (pos)
+    {
+        std::string s = render_rtype(insn, "sltu");
+        s.resize(instruction_width, ' ');
+        *pos << s << "// "
+             << "x" << rd << " = (" << hex0x_xlen(rs1) << " <U " << hex0x_xlen(rs2)
+             << ") ? 1 : 0 = " << hex0x_xlen(regs.get(rd));
+    }
+}
+/**
+ * Execute sra instruction
+ * IT executes the SRAI RV32I instruction, renders the details of what it has simulated.
+ * it uses render() helper functions
+ * @param uint32_t insn, std::ostream* pos)
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_sra(uint32_t insn, std::ostream* pos)
+{
+    uint32_t rd = get_rd(insn); // ged rd
+    sreg_t rs1 = regs.get(get_rs1(insn)); // register rs1
+    sreg_t rs2 = regs.get(get_rs2(insn)); // register rs2
+    regs.set(rd, rs1 >> (rs2 & (XLEN - 1))); // set rd to rs1>>rs2
+    pc += 4; // increment pc by 4
+    if (pos)
+    {
+        std::string s = render_rtype(insn, "sra");
+        s.resize(instruction_width, ' ');
+        *pos << s << "// "
+             << "x" << rd << " = " << hex0x_xlen(rs1) << " >> " << (rs2 & (XLEN - 1)) << " = "
+             << hex0x_xlen(regs.get(rd));
+    }
+}
+/**
+ * Execute srai instruction
+ * IT executes the SRAI RV32I instruction, renders the details of what it has simulated.
+ * it uses render() helper functions
+ * @param uint32_t insn, std::ostream* pos)
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_srai(uint32_t insn, std::ostream* pos)
+{
+    uint32_t rd = get_rd(insn); // get rd
+    sreg_t rs1 = regs.get(get_rs1(insn)); // register rs1
+    uint32_t imm_i = get_imm_i(insn); // get imm_i
+    regs.set(rd, rs1 >> (imm_i % XLEN)); // set rd to rs1 >>imm_i
+    pc += 4; // increment pc by 4
+    if (pos)
+    {
+        std::string s = render_itype_shamt(insn, "srai");
+        s.resize(instruction_width, ' ');
+        *pos << s << "// "
+             << "x" << rd << " = " << hex0x_xlen(rs1) << " >> " << (imm_i % XLEN) << " = "
+             << hex0x_xlen(regs.get(rd));
+    }
+}
+/**
+ * Execute srl instruction
+ * IT executes the SRL RV32I instruction, renders the details of what it has simulated.
+ * it uses render() helper functions
+ * @param uint32_t insn, std::ostream* pos)
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_srl(uint32_t insn, std::ostream* pos)
+{
+    uint32_t rd = get_rd(insn); // get rd
+    reg_t rs1 = regs.get(get_rs1(insn)); // register rs1
+    reg_t rs2 = regs.get(get_rs2(insn)); // register rs2
+    regs.set(rd, rs1 >> (rs2 & (XLEN - 1))); // set rd to rs1 >> rs2
+    pc += 4; // increment pc by 4
+    if (pos)
+    {
+        std::string s = render_rtype(insn, "srl");
+        s.resize(instruction_width, ' ');
+        *pos << s << "// "
+             << "x" << rd << " = " << hex0x_xlen(rs1) << " >> " << (rs2 & (XLEN - 1)) << " = "
+             << hex0x_xlen(regs.get(rd));
+    }
+}
+/**
+ * Execute sub instruction
+ * IT executes the SUB RV32I instruction, renders the details of what it has simulated.
+ * it uses render() helper functions
+ * @param uint32_t insn, std::ostream* pos)
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_sub(uint32_t insn, std::ostream* pos)
+{
+    uint32_t rd = get_rd(insn); // get rd
+    reg_t rs1 = regs.get(get_rs1(insn)); // register rs1
+    reg_t rs2 = regs.get(get_rs2(insn)); // register rs2
+    regs.set(rd, rs1 - rs2); // set rd to rs1-rs2
+    pc += 4; // increment pc by 4
+    if (pos)
+    {
+        std::string s = render_rtype(insn, "sub");
+        s.resize(instruction_width, ' ');
+        *pos << s << "// "
+             << "x" << rd << " = " << hex0x_xlen(rs1) << " - " << hex0x_xlen(rs2) << " = "
+             << hex0x_xlen(rs1 - rs2);
+    }
+}
+/**
+ * Execute sw instruction
+ * IT executes the SW RV32I instruction, renders the details of what it has simulated.
+ * it uses render() helper functions
+ * @param uint32_t insn, std::ostream* pos)
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_sw(uint32_t insn, std::ostream* pos)
+{
+    reg_t rs1 = regs.get(get_rs1(insn)); // register rs1
+    reg_t rs2 = regs.get(get_rs2(insn)); // register rs2
+    reg_t imm_s = get_imm_s(insn); // get imm_s
+    if (pos)
+    {
+        std::string s = render_stype(insn, "sw");
+        s.resize(instruction_width, ' ');
+        *pos << s << "// "
+             << "m32(" << hex0x_xlen(rs1) << " + " << hex0x_xlen(imm_s)
+             << ") = " << hex0x_xlen(rs2 & 0xffffffff);
+    }
+    if (!write_mem(rs1 + imm_s, (uint32_t)rs2)) // set memory at rs1+imms to rs2 & 0xffffffff
+    {
+        if (pos)
+            render_fault(pos, "");
+        return;
+    }
+    pc += 4; // increment pc by 4
+}
+/**
+ * Execute xor instruction
+ * IT executes the XOR RV32I instruction, renders the details of what it has simulated.
+ * it uses render() helper functions
+ * @param uint32_t insn, std::ostream* pos)
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_xor(uint32_t insn, std::ostream* pos)
+{
+    uint32_t rd = get_rd(insn); // get rd
+    reg_t rs1 = regs.get(get_rs1(insn)); // register rs1
+    reg_t rs2 = regs.get(get_rs2(insn)); // register rs2
+    if (pos)
+    {
+        std::string s = render_rtype(insn, "xor");
+        s.resize(instruction_width, ' ');
+        *pos << s << "// "
+             << "x" << rd << " = " << hex0x_xlen(rs1) << " ^ " << hex0x_xlen(rs2) << " = "
+             << hex0x_xlen(rs1 ^ rs2);
+    }
+    regs.set(rd, rs1 ^ rs2); // set rd to rs1^rs2
+    pc += 4; // increment pc by 4
+}
+/**
+ * Execute xori instruction
+ * IT executes the xori RV32I instruction, renders the details of what it has simulated.
+ * it uses render() helper functions
+ * @param uint32_t insn, std::ostream* pos)
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_xori(uint32_t insn, std::ostream* pos)
+{
+    uint32_t rd = get_rd(insn); // get rd
+    reg_t rs1 = regs.get(get_rs1(insn)); // register rs1
+    reg_t imm_i = get_imm_i(insn); // get imm_i
+    if (pos)
+    {
+        std::string s = render_itype_alu(insn, "xori", imm_i);
+        ;
+        s.resize(instruction_width, ' ');
+        *pos << s << "// "
+             << "x" << rd << " = " << hex0x_xlen(rs1) << " ^ " << hex0x_xlen(imm_i) << " = "
+             << hex0x_xlen(rs1 ^ imm_i);
+    }
+    regs.set(rd, (rs1 ^ imm_i)); // set rd to rs1 ^ imm_i
+    pc += 4; // incremet pc by 4
+}
+/**
+ * Execute fence instruction
+ * IT executes the fence RV32I instruction, renders the details of what it has simulated.
+ * it uses render() helper functions
+ * @param uint32_t insn, std::ostream* pos)
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_fence(uint32_t insn, std::ostream* pos)
+{
+    if (pos)
+    {
+        std::string s = render_fence(insn);
+        s.resize(instruction_width, ' ');
+        *pos << s << "// fence ";
+    }
+    pc += 4; // incremet pc by 4
+}
+/**
+ * Execute ecall instruction
+ * IT executes the ECALL RV32I instruction, renders the details of what it has simulated.
+ * The syscall number is taken from a7 and the arguments from a0-a5, the host proxy performs
+ * the call and the result is returned in a0. exit and exit_group halt the hart. Below M-mode
+ * ecall raises the environment call exception instead, for the kernel or firmware to handle.
+ * @param uint32_t insn, std::ostream* pos)
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_ecall(uint32_t insn, std::ostream* pos)
+{
+    if (priv != mmu::priv_m)
+    {
+        take_exception(cause_ecall_u + priv, 0); // the host only serves M-mode
+        if (pos)
+            render_fault(pos, render_ecall());
+        return;
+    }
+    if (io == nullptr)
+    {
+        if (pos)
+        {
+            std::string s = render_ecall();
+            s.resize(instruction_width, ' ');
+            *pos << s << "// no host i/o";
+        }
+        pc += 4; // incremet pc by 4
+        return;
+    }
+    uint32_t nr = regs.get(17); // syscall number in a7
+    uint64_t args[6];
+    for (uint32_t i = 0; i < 6; i++)
+    {
+        args[i] = regs.get(10 + i); // arguments in a0-a5
+    }
+    int64_t ret = 0;
+    if (log == nullptr || !log->is_replaying() || nr == hostio::sys_exit || nr == hostio::sys_exit_group)
+    {
+        ret = io->call(nr, args); // a replay takes the result from the log instead
+    }
+    if (log != nullptr)
+    {
+        int32_t logged = ret; // only rv32i harts are recorded
+        log->syscall(insn_counter, logged, mem, &io->get_written());
+        ret = logged;
+        if (log->failed())
+        {
+            halt = true;
+            return;
+        }
+    }
+    if (pos)
+    {
+        std::string s = render_ecall();
+        s.resize(instruction_width, ' ');
+        *pos << s << "// x10 = syscall(" << std::dec << nr << ") = " << hex0x_xlen(ret);
+    }
+    if (io->has_exited())
+    {
+        halt = true; // set halt flag to true
+        io->flush();
+        *out << "Execution terminated by exit(" << std::dec << io->get_exit_code() << ")";
+        return;
+    }
+    regs.set(10, ret); // result in a0
+    pc += 4; // incremet pc by 4
+}
+/**
+ * Execute ebreak instruction
+ * IT executes the EBREAK RV32I instruction, renders the details of what it has simulated.
+ * it uses render() helper functions
+ * @param uint32_t insn, std::ostream* pos)
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_ebreak(uint32_t insn, std::ostream* pos)
+{
+    if (pos)
+    {
+        std::string s = render_ebreak();
+        s.resize(instruction_width, ' ');
+        *pos << s << "// HALT \n";
+    }
+    halt = true; // set halt flag to ture
+    *out << "Execution terminated by EBREAK instruction";
+}
+/**
+ * Execute lr.w instruction
+ * IT executes the LR.W RV32A instruction, renders the details of what it has simulated.
+ * The loaded value is remembered together with the address so that a later sc.w can check
+ * (with a host compare-and-swap) that no other hart has changed the word in between.
+ * @param uint32_t insn, std::ostream* pos
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_lr_w(uint32_t insn, std::ostream* pos)
+{
+    uint32_t rd = get_rd(insn); // get rd
+    reg_t addr = regs.get(get_rs1(insn)); // address in rs1
+    if (addr & 3)
+    {
+        take_exception(cause_load_misaligned, addr); // atomics must be aligned
+        if (pos)
+            render_fault(pos, render_lr(insn, "lr.w"));
+        return;
+    }
+    uint32_t paddr;
+    if (!translate(addr, mmu::access_load, paddr))
+    {
+        if (pos)
+            render_fault(pos, render_lr(insn, "lr.w"));
+        return;
+    }
+    uint32_t word;
+    if (!mem->load_reserved32(paddr, word))
+    {
+        take_exception(cause_access_fault[mmu::access_load], addr);
+        if (pos)
+            render_fault(pos, render_lr(insn, "lr.w"));
+        return;
+    }
+    int32_t val = word;
+    reservation_valid = true;
+    reservation_addr = paddr; // other harts may map the word elsewhere
+    reservation_value = val;
+    if (pos)
+    {
+        std::string s = render_lr(insn, "lr.w");
+        s.resize(instruction_width, ' ');
+        *pos << s << "// "
+             << "x" << rd << " = m32(" << hex0x_xlen(addr) << ") = " << hex0x_xlen(val)
+             << ", reserve " << hex0x_xlen(addr);
+    }
+    regs.set(rd, val); // set rd to the loaded word
+    pc += 4; // increment pc by 4
+}
+/**
+ * Execute sc.w instruction
+ * IT executes the SC.W RV32A instruction, renders the details of what it has simulated.
+ * rd is set to 0 when the store succeeded and to 1 when it failed. The reservation is
+ * always released.
+ * @param uint32_t insn, std::ostream* pos
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_sc_w(uint32_t insn, std::ostream* pos)
+{
+    uint32_t rd = get_rd(insn); // get rd
+    reg_t addr = regs.get(get_rs1(insn)); // address in rs1
+    reg_t rs2 = regs.get(get_rs2(insn)); // value to store
+    if (addr & 3)
+    {
+        take_exception(cause_store_misaligned, addr); // atomics must be aligned
+        if (pos)
+            render_fault(pos, render_amo(insn, "sc.w"));
+        return;
+    }
+    uint32_t paddr;
+    if (!translate(addr, mmu::access_store, paddr))
+    {
+        if (pos)
+            render_fault(pos, render_amo(insn, "sc.w"));
+        return;
+    }
+    bool ok = reservation_valid && reservation_addr == paddr
+        && mem->store_conditional32(paddr, reservation_value, rs2);
+    reservation_valid = false;
+    if (pos)
+    {
+        std::string s = render_amo(insn, "sc.w");
+        s.resize(instruction_width, ' ');
+        *pos << s << "// ";
+        if (ok)
+        {
+            *pos << "m32(" << hex0x_xlen(addr) << ") = " << hex0x_xlen(rs2) << ", x" << rd << " = 0";
+        }
+        else
+        {
+            *pos << "x" << rd << " = 1";
+        }
+    }
+    regs.set(rd, ok ? 0 : 1); // 0 on success, 1 on failure
+    pc += 4; // increment pc by 4
+}
+/**
+ * Common part of the amo*.w instructions
+ * Performs op on the word addressed by rs1 with rs2 as one host atomic operation and writes the
+ * old value of the word into rd, renders the details of what it has simulated.
+ * @param uint32_t insn, std::ostream* pos, memory::amo_op op, const char* mnemonic
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_amo(uint32_t insn, std::ostream* pos, memory::amo_op op, const char* mnemonic)
+{
+    uint32_t rd = get_rd(insn); // get rd
+    reg_t addr = regs.get(get_rs1(insn)); // address in rs1
+    reg_t rs2 = regs.get(get_rs2(insn)); // register rs2
+    if (addr & 3)
+    {
+        take_exception(cause_store_misaligned, addr); // atomics must be aligned
+        if (pos)
+            render_fault(pos, render_amo(insn, mnemonic));
+        return;
+    }
+    uint32_t paddr;
+    if (!translate(addr, mmu::access_store, paddr)) // an amo needs write permission even to read
+    {
+        if (pos)
+            render_fault(pos, render_amo(insn, mnemonic));
+        return;
+    }
+    uint32_t word;
+    if (!mem->amo32(paddr, op, rs2, word))
+    {
+        take_exception(cause_access_fault[mmu::access_store], addr);
+        if (pos)
+            render_fault(pos, render_amo(insn, mnemonic));
+        return;
+    }
+    int32_t old = word;
+    if (pos)
+    {
+        std::string s = render_amo(insn, mnemonic);
+        s.resize(instruction_width, ' ');
+        *pos << s << "// "
+             << "x" << rd << " = m32(" << hex0x_xlen(addr) << ") = " << hex0x_xlen(old) << ", "
+             << mnemonic << " " << hex0x_xlen(rs2);
+    }
+    regs.set(rd, old); // set rd to the old value of the word
+    pc += 4; // increment pc by 4
+}
+/**
+ * Execute amoswap.w instruction
+ * IT executes the AMOSWAP.W RV32A instruction, renders the details of what it has simulated.
+ * @param uint32_t insn, std::ostream* pos
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_amoswap_w(uint32_t insn, std::ostream* pos)
+{
+    exec_amo(insn, pos, memory::amo_swap, "amoswap.w");
+}
+/**
+ * Execute amoadd.w instruction
+ * IT executes the AMOADD.W RV32A instruction, renders the details of what it has simulated.
+ * @param uint32_t insn, std::ostream* pos
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_amoadd_w(uint32_t insn, std::ostream* pos)
+{
+    exec_amo(insn, pos, memory::amo_add, "amoadd.w");
+}
+/**
+ * Execute amoxor.w instruction
+ * IT executes the AMOXOR.W RV32A instruction, renders the details of what it has simulated.
+ * @param uint32_t insn, std::ostream* pos
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_amoxor_w(uint32_t insn, std::ostream* pos)
+{
+    exec_amo(insn, pos, memory::amo_xor, "amoxor.w");
+}
+/**
+ * Execute amoand.w instruction
+ * IT executes the AMOAND.W RV32A instruction, renders the details of what it has simulated.
+ * @param uint32_t insn, std::ostream* pos
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_amoand_w(uint32_t insn, std::ostream* pos)
+{
+    exec_amo(insn, pos, memory::amo_and, "amoand.w");
+}
+/**
+ * Execute amoor.w instruction
+ * IT executes the AMOOR.W RV32A instruction, renders the details of what it has simulated.
+ * @param uint32_t insn, std::ostream* pos
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_amoor_w(uint32_t insn, std::ostream* pos)
+{
+    exec_amo(insn, pos, memory::amo_or, "amoor.w");
+}
+/**
+ * Execute amomin.w instruction
+ * IT executes the AMOMIN.W RV32A instruction, renders the details of what it has simulated.
+ * @param uint32_t insn, std::ostream* pos
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_amomin_w(uint32_t insn, std::ostream* pos)
+{
+    exec_amo(insn, pos, memory::amo_min, "amomin.w");
+}
+/**
+ * Execute amomax.w instruction
+ * IT executes the AMOMAX.W RV32A instruction, renders the details of what it has simulated.
+ * @param uint32_t insn, std::ostream* pos
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_amomax_w(uint32_t insn, std::ostream* pos)
+{
+    exec_amo(insn, pos, memory::amo_max, "amomax.w");
+}
+/**
+ * Execute amominu.w instruction
+ * IT executes the AMOMINU.W RV32A instruction, renders the details of what it has simulated.
+ * @param uint32_t insn, std::ostream* pos
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_amominu_w(uint32_t insn, std::ostream* pos)
+{
+    exec_amo(insn, pos, memory::amo_minu, "amominu.w");
+}
+/**
+ * Execute amomaxu.w instruction
+ * IT executes the AMOMAXU.W RV32A instruction, renders the details of what it has simulated.
+ * @param uint32_t insn, std::ostream* pos
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_amomaxu_w(uint32_t insn, std::ostream* pos)
+{
+    exec_amo(insn, pos, memory::amo_maxu, "amomaxu.w");
+}
+/**
+ * Common part of the csr instructions
+ * reads the old value of the CSR into rd and writes the new one, the variants are told apart by
+ * funct3. csrrw(i) does not read when rd is x0 and csrrs(i)/csrrc(i) do not write when rs1 (or
+ * the immediate) is zero. Accessing a CSR that does not exist, or writing a read-only one, is an
+ * illegal instruction.
+ * @param uint32_t insn, std::ostream* pos, const char* mnemonic
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_csr(uint32_t insn, std::ostream* pos, const char* mnemonic)
+{
+    uint32_t rd = get_rd(insn); // get rd
+    uint32_t funct3 = get_funct3(insn);
+    uint32_t csr = insn >> 20;
+    reg_t src = (funct3 & 4) ? get_rs1(insn) : regs.get(get_rs1(insn)); // zimm or rs1
+    bool do_write = (funct3 & 3) == 1 || get_rs1(insn) != 0;
+    bool do_read = (funct3 & 3) != 1 || rd != 0;
+    reg_t old = 0;
+    if (!csr_accessible(csr, do_write))
+    {
+        exec_illegal_insn(insn, pos);
+        return;
+    }
+    if (do_read && !csr_read(csr, old))
+    {
+        exec_illegal_insn(insn, pos);
+        return;
+    }
+    if (do_read && log != nullptr && (csr == csr_mip || csr == csr_time || csr == csr_timeh))
+    {
+        uint32_t logged = old;
+        log->value(replaylog::rec_csr, logged); // these follow the devices, which a replay leaves out
+        old = logged;
+    }
+    reg_t val = old;
+    switch (funct3 & 3)
+    {
+        case 1:
+            val = src;
+            break;
+        case 2:
+            val = old | src;
+            break;
+        case 3:
+            val = old & ~src;
+            break;
+    }
+    if (do_write && !csr_write(csr, val))
+    {
+        exec_illegal_insn(insn, pos);
+        return;
+    }
+    if (pos)
+    {
+        std::string s = (funct3 & 4) ? render_csrrxi(insn, mnemonic) : render_csrrx(insn, mnemonic);
+        s.resize(instruction_width, ' ');
+        *pos << s << "// "
+             << "x" << std::dec << rd << " = " << hex0x_xlen(old);
+        if (do_write)
+        {
+            *pos << ", csr[" << hex0x32(csr) << "] = " << hex0x_xlen(val);
+        }
+    }
+    regs.set(rd, old); // set rd to the old value of the csr
+    pc += 4; // increment pc by 4
+}
+/**
+ * Execute csrrw instruction
+ * IT executes the CSRRW Zicsr instruction, renders the details of what it has simulated.
+ * @param uint32_t insn, std::ostream* pos
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_csrrw(uint32_t insn, std::ostream* pos)
+{
+    exec_csr(insn, pos, "csrrw");
+}
+/**
+ * Execute csrrs instruction
+ * IT executes the CSRRS Zicsr instruction, renders the details of what it has simulated.
+ * @param uint32_t insn, std::ostream* pos
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_csrrs(uint32_t insn, std::ostream* pos)
+{
+    exec_csr(insn, pos, "csrrs");
+}
+/**
+ * Execute csrrc instruction
+ * IT executes the CSRRC Zicsr instruction, renders the details of what it has simulated.
+ * @param uint32_t insn, std::ostream* pos
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_csrrc(uint32_t insn, std::ostream* pos)
+{
+    exec_csr(insn, pos, "csrrc");
+}
+/**
+ * Execute csrrwi instruction
+ * IT executes the CSRRWI Zicsr instruction, renders the details of what it has simulated.
+ * @param uint32_t insn, std::ostream* pos
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_csrrwi(uint32_t insn, std::ostream* pos)
+{
+    exec_csr(insn, pos, "csrrwi");
+}
+/**
+ * Execute csrrsi instruction
+ * IT executes the CSRRSI Zicsr instruction, renders the details of what it has simulated.
+ * @param uint32_t insn, std::ostream* pos
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_csrrsi(uint32_t insn, std::ostream* pos)
+{
+    exec_csr(insn, pos, "csrrsi");
+}
+/**
+ * Execute csrrci instruction
+ * IT executes the CSRRCI Zicsr instruction, renders the details of what it has simulated.
+ * @param uint32_t insn, std::ostream* pos
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_csrrci(uint32_t insn, std::ostream* pos)
+{
+    exec_csr(insn, pos, "csrrci");
+}
+/**
+ * Execute mret instruction
+ * IT executes the MRET instruction, renders the details of what it has simulated.
+ * pc goes back to mepc, MIE is restored from MPIE and the privilege level from MPP.
+ * @param uint32_t insn, std::ostream* pos
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_mret(uint32_t insn, std::ostream* pos)
+{
+    if (priv != mmu::priv_m)
+    {
+        exec_illegal_insn(insn, pos);
+        return;
+    }
+    if (mstatus & mstatus_mpie)
+        mstatus |= mstatus_mie;
+    else
+        mstatus &= ~mstatus_mie;
+    mstatus |= mstatus_mpie;
+    priv = (mstatus & mstatus_mpp) >> mstatus_mpp_shift;
+    mstatus &= ~mstatus_mpp; // MPP becomes U
+    if (priv != mmu::priv_m)
+        mstatus &= ~mstatus_mprv;
+    update_privilege();
+    if (pos)
+    {
+        std::string s = render_mret();
+        s.resize(instruction_width, ' ');
+        *pos << s << "// pc = mepc = " << hex0x_xlen(mepc);
+    }
+    pc = mepc;
+    next_check = 0; // interrupts may have been enabled again
+}
+/**
+ * Execute sret instruction
+ * the S-mode counterpart of mret: pc goes back to sepc, SIE is restored from SPIE and the
+ * privilege level from SPP. Illegal in U-mode, and in S-mode when mstatus.TSR is set.
+ * @param uint32_t insn, std::ostream* pos
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_sret(uint32_t insn, std::ostream* pos)
+{
+    if (priv == mmu::priv_u || (priv == mmu::priv_s && (mstatus & mstatus_tsr)))
+    {
+        exec_illegal_insn(insn, pos);
+        return;
+    }
+    if (mstatus & mstatus_spie)
+        mstatus |= mstatus_sie;
+    else
+        mstatus &= ~mstatus_sie;
+    mstatus |= mstatus_spie;
+    priv = (mstatus & mstatus_spp) ? mmu::priv_s : mmu::priv_u;
+    mstatus &= ~(mstatus_spp | mstatus_mprv); // SPP becomes U, and the hart is below M-mode
+    update_privilege();
+    if (pos)
+    {
+        std::string s = render_sret();
+        s.resize(instruction_width, ' ');
+        *pos << s << "// pc = sepc = " << hex0x_xlen(sepc);
+    }
+    pc = sepc;
+    next_check = 0; // interrupts may have been enabled again
+}
+/**
+ * Execute wfi instruction
+ * IT executes the WFI instruction, renders the details of what it has simulated.
+ * If no interrupt is pending the hart sleeps until the next event, which means the instruction
+ * counter (and so mtime) jumps ahead to it. If nothing is scheduled the hart would sleep
+ * forever, so it halts instead. Illegal in U-mode, and in S-mode when mstatus.TW is set.
+ * @param uint32_t insn, std::ostream* pos
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_wfi(uint32_t insn, std::ostream* pos)
+{
+    if (priv == mmu::priv_u || (priv == mmu::priv_s && (mstatus & mstatus_tw)))
+    {
+        exec_illegal_insn(insn, pos);
+        return;
+    }
+    uint64_t wake = insn_counter;
+    if ((mip & mie) == 0)
+    {
+        wake = events.next_due();
+    }
+    if (log != nullptr)
+    {
+        log->event(replaylog::rec_wfi, insn_counter, wake);
+        if (log->failed())
+        {
+            halt = true;
+            return;
+        }
+    }
+    if (pos)
+    {
+        std::string s = render_wfi();
+        s.resize(instruction_width, ' ');
+        *pos << s << "// ";
+        if (wake == event_queue::never)
+            *pos << "HALT \n";
+        else
+            *pos << "sleep until instruction " << std::dec << wake;
+    }
+    if (wake == event_queue::never)
+    {
+        halt = true; // set halt flag to true
+        *out << "Execution terminated by WFI with nothing left to wake the hart";
+        return;
+    }
+    if (wake > insn_counter)
+    {
+        insn_counter = wake;
+    }
+    pc += 4; // increment pc by 4
+}
+/**
+ * Execute sfence.vma instruction
+ * The TLB has no ASIDs and is small, so every sfence.vma empties all of it whatever rs1 and rs2
+ * select. Illegal in U-mode, and in S-mode when mstatus.TVM is set.
+ * @param uint32_t insn, std::ostream* pos
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_sfence_vma(uint32_t insn, std::ostream* pos)
+{
+    if (priv == mmu::priv_u || (priv == mmu::priv_s && (mstatus & mstatus_tvm)))
+    {
+        exec_illegal_insn(insn, pos);
+        return;
+    }
+    vm.flush();
+    if (pos)
+    {
+        std::string s = render_sfence_vma(insn);
+        s.resize(instruction_width, ' ');
+        *pos << s << "// flush the TLB";
+    }
+    pc += 4; // increment pc by 4
+}
+/**
+ * Execute ld instruction (RV64I)
+ * @param uint32_t insn, std::ostream* pos
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_ld(uint32_t insn, std::ostream* pos)
+{
+    uint32_t rd = get_rd(insn); // rd
+    reg_t rs1 = regs.get(get_rs1(insn)); // register rs1
+    int32_t imm_i = get_imm_i(insn); // imm_i
+    uint64_t val;
+    if (!read_mem(rs1 + imm_i, val))
+    {
+        if (pos)
+            render_fault(pos, render_itype_load(insn, "ld"));
+        return;
+    }
+    regs.set(rd, val); // set rd to memory address get64(rs1+imm_i)
+    pc += 4; // increment pc by 4
+    if (pos)
+    {
+        std::string s = render_itype_load(insn, "ld");
+        s.resize(instruction_width, ' ');
+        *pos << s << "// "
+             << "x" << rd << " = m64(" << hex0x_xlen(rs1) << " + " << hex0x_xlen(imm_i)
+             << ") = " << hex0x_xlen(regs.get(rd));
+    }
+}
+/**
+ * Execute lwu instruction (RV64I)
+ * @param uint32_t insn, std::ostream* pos
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_lwu(uint32_t insn, std::ostream* pos)
+{
+    uint32_t rd = get_rd(insn); // rd
+    reg_t rs1 = regs.get(get_rs1(insn)); // register rs1
+    int32_t imm_i = get_imm_i(insn); // imm_i
+    uint32_t val; // read once in case it is a device
+    if (!read_mem(rs1 + imm_i, val))
+    {
+        if (pos)
+            render_fault(pos, render_itype_load(insn, "lwu"));
+        return;
+    }
+    regs.set(rd, val); // set rd to the zero extended word
+    pc += 4; // increment pc by 4
+    if (pos)
+    {
+        std::string s = render_itype_load(insn, "lwu");
+        s.resize(instruction_width, ' ');
+        *pos << s << "// "
+             << "x" << rd << " = zx(m32(" << hex0x_xlen(rs1) << " + " << hex0x_xlen(imm_i)
+             << ")) = " << hex0x_xlen(val);
+    }
+}
+/**
+ * Execute sd instruction (RV64I)
+ * @param uint32_t insn, std::ostream* pos
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_sd(uint32_t insn, std::ostream* pos)
+{
+    reg_t rs1 = regs.get(get_rs1(insn)); // register rs1
+    reg_t rs2 = regs.get(get_rs2(insn)); // register rs2
+    int32_t imm_s = get_imm_s(insn); // imm_s
+    if (pos)
+    {
+        std::string s = render_stype(insn, "sd");
+        s.resize(instruction_width, ' ');
+        *pos << s << "// "
+             << "m64(" << hex0x_xlen(rs1) << " + " << hex0x_xlen(imm_s) << ") = " << hex0x_xlen(rs2);
+    }
+    if (!write_mem(rs1 + imm_s, (uint64_t)rs2)) // set memory at rs1+imm_s to rs2
+    {
+        if (pos)
+            render_fault(pos, "");
+        return;
+    }
+    pc += 4; // increment pc by 4
+}
+/**
+ * Execute addiw instruction (RV64I)
+ * adds in 64 bits and sign extends the low 32 bits of the sum into rd
+ * @param uint32_t insn, std::ostream* pos
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_addiw(uint32_t insn, std::ostream* pos)
+{
+    uint32_t rd = get_rd(insn); // rd
+    reg_t rs1 = regs.get(get_rs1(insn)); // register rs1
+    int32_t imm_i = get_imm_i(insn); // imm_i
+    regs.set(rd, (int32_t)(rs1 + imm_i)); // set rd to sx(rs1+imm_i)
+    pc += 4; // increment pc by 4
+    if (pos)
+    {
+        std::string s = render_itype_alu(insn, "addiw", imm_i);
+        s.resize(instruction_width, ' ');
+        *pos << s << "// "
+             << "x" << rd << " = sx(" << hex0x_xlen(rs1) << " + " << hex0x_xlen(imm_i) << ") = "
+             << hex0x_xlen(regs.get(rd));
+    }
+}
+/**
+ * Execute slliw instruction (RV64I)
+ * @param uint32_t insn, std::ostream* pos
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_slliw(uint32_t insn, std::ostream* pos)
+{
+    uint32_t rd = get_rd(insn); // rd
+    uint32_t rs1 = regs.get(get_rs1(insn)); // low word of register rs1
+    uint32_t shamt = get_rs2(insn); // 5-bit shamt
+    regs.set(rd, (int32_t)(rs1 << shamt)); // set rd to sx(rs1 << shamt)
+    pc += 4; // increment pc by 4
+    if (pos)
+    {
+        std::string s = render_itype_shamt(insn, "slliw");
+        s.resize(instruction_width, ' ');
+        *pos << s << "// "
+             << "x" << rd << " = sx(" << hex0x32(rs1) << " << " << shamt << ") = "
+             << hex0x_xlen(regs.get(rd));
+    }
+}
+/**
+ * Execute srliw instruction (RV64I)
+ * @param uint32_t insn, std::ostream* pos
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_srliw(uint32_t insn, std::ostream* pos)
+{
+    uint32_t rd = get_rd(insn); // rd
+    uint32_t rs1 = regs.get(get_rs1(insn)); // low word of register rs1
+    uint32_t shamt = get_rs2(insn); // 5-bit shamt
+    regs.set(rd, (int32_t)(rs1 >> shamt)); // set rd to sx(rs1 >> shamt)
+    pc += 4; // increment pc by 4
+    if (pos)
+    {
+        std::string s = render_itype_shamt(insn, "srliw");
+        s.resize(instruction_width, ' ');
+        *pos << s << "// "
+             << "x" << rd << " = sx(" << hex0x32(rs1) << " >> " << shamt << ") = "
+             << hex0x_xlen(regs.get(rd));
+    }
+}
+/**
+ * Execute sraiw instruction (RV64I)
+ * @param uint32_t insn, std::ostream* pos
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_sraiw(uint32_t insn, std::ostream* pos)
+{
+    uint32_t rd = get_rd(insn); // rd
+    int32_t rs1 = regs.get(get_rs1(insn)); // low word of register rs1
+    uint32_t shamt = get_rs2(insn); // 5-bit shamt
+    regs.set(rd, rs1 >> shamt); // set rd to rs1 >> shamt
+    pc += 4; // increment pc by 4
+    if (pos)
+    {
+        std::string s = render_itype_shamt(insn, "sraiw");
+        s.resize(instruction_width, ' ');
+        *pos << s << "// "
+             << "x" << rd << " = " << hex0x32(rs1) << " >> " << shamt << " = "
+             << hex0x_xlen(regs.get(rd));
+    }
+}
+/**
+ * Execute addw instruction (RV64I)
+ * @param uint32_t insn, std::ostream* pos
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_addw(uint32_t insn, std::ostream* pos)
+{
+    uint32_t rd = get_rd(insn); // rd
+    uint32_t rs1 = regs.get(get_rs1(insn)); // low word of register rs1
+    uint32_t rs2 = regs.get(get_rs2(insn)); // low word of register rs2
+    regs.set(rd, (int32_t)(rs1 + rs2)); // set rd to sx(rs1+rs2)
+    pc += 4; // increment pc by 4
+    if (pos)
+    {
+        std::string s = render_rtype(insn, "addw");
+        s.resize(instruction_width, ' ');
+        *pos << s << "// "
+             << "x" << rd << " = sx(" << hex0x32(rs1) << " + " << hex0x32(rs2) << ") = "
+             << hex0x_xlen(regs.get(rd));
+    }
+}
+/**
+ * Execute subw instruction (RV64I)
+ * @param uint32_t insn, std::ostream* pos
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_subw(uint32_t insn, std::ostream* pos)
+{
+    uint32_t rd = get_rd(insn); // rd
+    uint32_t rs1 = regs.get(get_rs1(insn)); // low word of register rs1
+    uint32_t rs2 = regs.get(get_rs2(insn)); // low word of register rs2
+    regs.set(rd, (int32_t)(rs1 - rs2)); // set rd to sx(rs1-rs2)
+    pc += 4; // increment pc by 4
+    if (pos)
+    {
+        std::string s = render_rtype(insn, "subw");
+        s.resize(instruction_width, ' ');
+        *pos << s << "// "
+             << "x" << rd << " = sx(" << hex0x32(rs1) << " - " << hex0x32(rs2) << ") = "
+             << hex0x_xlen(regs.get(rd));
+    }
+}
+/**
+ * Execute sllw instruction (RV64I)
+ * @param uint32_t insn, std::ostream* pos
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_sllw(uint32_t insn, std::ostream* pos)
+{
+    uint32_t rd = get_rd(insn); // rd
+    uint32_t rs1 = regs.get(get_rs1(insn)); // low word of register rs1
+    uint32_t rs2 = regs.get(get_rs2(insn)) & 31; // shift amount
+    regs.set(rd, (int32_t)(rs1 << rs2)); // set rd to sx(rs1 << rs2)
+    pc += 4; // increment pc by 4
+    if (pos)
+    {
+        std::string s = render_rtype(insn, "sllw");
+        s.resize(instruction_width, ' ');
+        *pos << s << "// "
+             << "x" << rd << " = sx(" << hex0x32(rs1) << " << " << rs2 << ") = "
+             << hex0x_xlen(regs.get(rd));
+    }
+}
+/**
+ * Execute srlw instruction (RV64I)
+ * @param uint32_t insn, std::ostream* pos
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_srlw(uint32_t insn, std::ostream* pos)
+{
+    uint32_t rd = get_rd(insn); // rd
+    uint32_t rs1 = regs.get(get_rs1(insn)); // low word of register rs1
+    uint32_t rs2 = regs.get(get_rs2(insn)) & 31; // shift amount
+    regs.set(rd, (int32_t)(rs1 >> rs2)); // set rd to sx(rs1 >> rs2)
+    pc += 4; // increment pc by 4
+    if (pos)
+    {
+        std::string s = render_rtype(insn, "srlw");
+        s.resize(instruction_width, ' ');
+        *pos << s << "// "
+             << "x" << rd << " = sx(" << hex0x32(rs1) << " >> " << rs2 << ") = "
+             << hex0x_xlen(regs.get(rd));
+    }
+}
+/**
+ * Execute sraw instruction (RV64I)
+ * @param uint32_t insn, std::ostream* pos
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_sraw(uint32_t insn, std::ostream* pos)
+{
+    uint32_t rd = get_rd(insn); // rd
+    int32_t rs1 = regs.get(get_rs1(insn)); // low word of register rs1
+    uint32_t rs2 = regs.get(get_rs2(insn)) & 31; // shift amount
+    regs.set(rd, rs1 >> rs2); // set rd to rs1 >> rs2
+    pc += 4; // increment pc by 4
+    if (pos)
+    {
+        std::string s = render_rtype(insn, "sraw");
+        s.resize(instruction_width, ' ');
+        *pos << s << "// "
+             << "x" << rd << " = " << hex0x32(rs1) << " >> " << rs2 << " = "
+             << hex0x_xlen(regs.get(rd));
+    }
+}
+/**
+ * Host bit operations for the Zbb instructions, the builtins are one instruction on hosts that
+ * have one (lzcnt, tzcnt, popcnt, bswap) and a short sequence elsewhere
+ * @param uint32_t or uint64_t v (and uint32_t n for rotate_left)
+ * @return the result, in the width of v
+ ********************************************************************************/
+static inline uint32_t count_leading_zeros(uint32_t v) { return v == 0 ? 32 : __builtin_clz(v); }
+static inline uint64_t count_leading_zeros(uint64_t v) { return v == 0 ? 64 : __builtin_clzll(v); }
+static inline uint32_t count_trailing_zeros(uint32_t v) { return v == 0 ? 32 : __builtin_ctz(v); }
+static inline uint64_t count_trailing_zeros(uint64_t v) { return v == 0 ? 64 : __builtin_ctzll(v); }
+static inline uint32_t count_ones(uint32_t v) { return __builtin_popcount(v); }
+static inline uint64_t count_ones(uint64_t v) { return __builtin_popcountll(v); }
+static inline uint32_t byte_swap(uint32_t v) { return __builtin_bswap32(v); }
+static inline uint64_t byte_swap(uint64_t v) { return __builtin_bswap64(v); }
+template<typename T>
+static inline T rotate_left(T v, uint32_t n) { return (v << n) | (v >> (-n & (sizeof(T) * 8 - 1))); } // a rol
+template<typename T>
+static inline T or_combine(T v)
+{
+    const T low7 = (T)0x7f7f7f7f7f7f7f7full;
+    T high = ((v & low7) + low7) | v; // bit 7 of every byte that is not 0
+    return ((high & ~low7) >> 7) * 0xff;
+}
+/**
+ * Finish a Zba or Zbb instruction: rd = val, the mnemonic and the operands for the log come
+ * from the decode table
+ * @param uint32_t insn, std::ostream* pos, reg_t val
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_bitmanip(uint32_t insn, std::ostream* pos, reg_t val)
+{
+    uint32_t rd = get_rd(insn); // rd
+    if (pos)
+    {
+        const insn_info<XLEN>& info = insn_infos<XLEN>[lookup<XLEN>(insn)];
+        std::string s;
+        std::ostringstream args;
+        args << hex0x_xlen(regs.get(get_rs1(insn)));
+        switch (info.format)
+        {
+            case format_rtype:
+                s = render_rtype(insn, info.mnemonic);
+                args << ", " << hex0x_xlen(regs.get(get_rs2(insn)));
+                break;
+            case format_shamt:
+                s = render_itype_shamt(insn, info.mnemonic);
+                args << ", " << std::dec << (get_imm_i(insn) & (XLEN - 1));
+                break;
+            default:
+                s = render_unary(insn, info.mnemonic);
+                break;
+        }
+        s.resize(instruction_width, ' ');
+        *pos << s << "// "
+             << "x" << std::dec << rd << " = " << info.mnemonic << "(" << args.str() << ") = " << hex0x_xlen(val);
+    }
+    regs.set(rd, val); // set rd to val
+    pc += 4; // increment pc by 4
+}
 /**
- * Reset the rv32i object and the register file
- * Does the reset by setting pc register to zero, insn_counter to 0 and halt flag to false
- * @param none
+ * Execute sh1add instruction (Zba), rd = (rs1 << 1) + rs2
+ * @param uint32_t insn, std::ostream* pos
  * @return none
  ********************************************************************************/
-void rv32i::reset()
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_sh1add(uint32_t insn, std::ostream* pos)
 {
-    pc = 0;
-    insn_counter = 0;
-    halt = false;
+    reg_t a = regs.get(get_rs1(insn)); // rs1
+    reg_t b = regs.get(get_rs2(insn)); // rs2
+    exec_bitmanip(insn, pos, (a << 1) + b);
 }
 /**
- * Dumps the state of the hart
- * This method which is a member of rv32i class will dump the sate of the hart. Will dump registers
- * and pc register
- * @param none
+ * Execute sh2add instruction (Zba), rd = (rs1 << 2) + rs2
+ * @param uint32_t insn, std::ostream* pos
  * @return none
  ********************************************************************************/
-void rv32i::dump() const
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_sh2add(uint32_t insn, std::ostream* pos)
 {
-    regs.dump();
-    cout << " pc " << hex32(pc) << std::endl;
+    reg_t a = regs.get(get_rs1(insn)); // rs1
+    reg_t b = regs.get(get_rs2(insn)); // rs2
+    exec_bitmanip(insn, pos, (a << 2) + b);
 }
 /**
- * Execute the given RV32I instruction
- * This function executes the given rv32i instruction by making use of the get__xxx() methods to
- *extract
- * needed instruction fields and then call exec_xx() to print the instructions.
+ * Execute sh3add instruction (Zba), rd = (rs1 << 3) + rs2
  * @param uint32_t insn, std::ostream* pos
  * @return none
  ********************************************************************************/
-void rv32i::dcex(uint32_t insn, std::ostream* pos)
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_sh3add(uint32_t insn, std::ostream* pos)
 {
-
-    uint32_t opcode = get_opcode(insn);
-    uint32_t funct3 = get_funct3(insn);
-    uint32_t funct7 = get_funct7(insn);
-    switch (opcode)
-    {
-        default:
-            exec_illegal_insn(insn, pos);
-            return;
-        case opcode_lui:
-            exec_lui(insn, pos);
-            return;
-        case opcode_auipc:
-            exec_auipc(insn, pos);
-            return;
-        case opcode_jal:
-            exec_jal(insn, pos);
-            return;
-        case opcode_jalr:
-            exec_jalr(insn, pos);
-            return;
-        case opcode_rtype:
-            switch (funct3)
-            {
-                default:
-                    exec_illegal_insn(insn, pos);
-                    return;
-                case funct3_add:
-                    switch (funct7)
-                    {
-                        default:
-                            render_illegal_insn();
-                            return;
-                        case funct7_add:
-                            exec_add(insn, pos);
-                            return;
-                        case funct7_sub:
-                            exec_sub(insn, pos);
-                            return;
-                    }
-                    assert(0 && "unhandled funct7");
-                case funct3_sll:
-                    exec_sll(insn, pos);
-                    return;
-                case funct3_slt:
-                    exec_slt(insn, pos);
-                    return;
-                case funct3_sltu:
-                    exec_sltu(insn, pos);
-                    return;
-                case funct3_xor:
-                    exec_xor(insn, pos);
-                    return;
-                case funct3_srl:
-                    switch (funct7)
-                    {
-                        default:
-                            render_illegal_insn();
-                            return;
-                        case funct7_srl:
-                            exec_srl(insn, pos);
-                            return;
-                        case funct7_sra:
-                            exec_sra(insn, pos);
-                            return;
-                    }
-                case funct3_or:
-                    exec_or(insn, pos);
-                    return;
-                case funct3_and:
-                    exec_and(insn, pos);
-                    return;
-            }
-        case opcode_btype:
-            switch (funct3)
-            {
-                default:
-                    exec_illegal_insn(insn, pos);
-                    return;
-                case funct3_beq:
-                    exec_beq(insn, pos);
-                    return;
-                case funct3_bne:
-                    exec_bne(insn, pos);
-                    return;
-                case funct3_blt:
-                    exec_blt(insn, pos);
-                    return;
-                case funct3_bge:
-                    exec_bge(insn, pos);
-                    return;
-                case funct3_bltu:
-                    exec_bltu(insn, pos);
-                    return;
-                case funct3_bgeu:
-                    exec_bgeu(insn, pos);
-                    return;
-                    assert(0 && "unhandled funct3");
-            }
-        case opcode_itype:
-            switch (funct3)
-            {
-                default:
-                    exec_illegal_insn(insn, pos);
-                    return;
-                case funct3_lb:
-                    exec_lb(insn, pos);
-                    return;
-                case funct3_lh:
-                    exec_lh(insn, pos);
-                    return;
-                case funct3_lw:
-                    exec_lw(insn, pos);
-                    return;
-                case funct3_lbu:
-                    exec_lbu(insn, pos);
-                    return;
-                case funct3_lhu:
-                    exec_lhu(insn, pos);
-                    return;
-            }
-        case opcode_itype_imm_shamt:
-            switch (funct3)
-            {
-                default:
-                    exec_illegal_insn(insn, pos);
-                    return;
-                case funct3_addi:
-                    exec_addi(insn, pos);
-                    return;
-                    break;
-                case funct3_slti:
-                    exec_slti(insn, pos);
-                    return;
-                    break;
-                case funct3_xori:
-                    exec_xori(insn, pos);
-                    return;
-                    break;
-                case funct3_sltiu:
-                    exec_sltiu(insn, pos);
-                    return;
-                    break;
-                case funct3_ori:
-                    exec_ori(insn, pos);
-                    return;
-                    break;
-                case funct3_andi:
-                    exec_andi(insn, pos);
-                    return;
-                    break;
-                case funct3_slli:
-                    exec_slli(insn, pos);
-                    return;
-                    break;
-                case funct3_srli:
-                    switch (funct7)
-                    {
-                        default:
-                            exec_illegal_insn(insn, pos);
-                            return;
-                        case funct7_srli:
-                            exec_srli(insn, pos);
-                            return;
-                            break;
-                        case funct7_srai:
-                            exec_srai(insn, pos);
-                            return;
-                            break;
-                    }
-            }
-        case opcode_stype:
-            switch (funct3)
-            {
-                default:
-                    exec_illegal_insn(insn, pos);
-                    return;
-                case funct3_sb:
-                    exec_sb(insn, pos);
-                    return;
-                    break;
-                case funct3_sh:
-                    exec_sh(insn, pos);
-                    return;
-                    break;
-                case funct3_sw:
-                    exec_sw(insn, pos);
-                    return;
-                    break;
-            }
-        case opcode_fence:
-            exec_fence(insn, pos);
-            return;
-            break;
-        case opcode_ecall:
-            switch (funct7 + get_rs2(insn))
-            {
-                default:
-                    exec_illegal_insn(insn, pos);
-                    return;
-                case 0b000000000001:
-                    exec_ebreak(insn, pos);
-                    return;
-                case 0b000000000000:
-                    exec_ecall(insn, pos);
-                    return;
-            }
-    }
-    assert(0 && "unhandled opcode");
+    reg_t a = regs.get(get_rs1(insn)); // rs1
+    reg_t b = regs.get(get_rs2(insn)); // rs2
+    exec_bitmanip(insn, pos, (a << 3) + b);
 }
 /**
- * function to take care of illegal cases
- * sets the halt flag to ture, if ostream* parameter is not nullptr then call render_illegal_insn()
- * to print the message
+ * Execute andn instruction (Zbb), rd = rs1 & ~rs2
  * @param uint32_t insn, std::ostream* pos
  * @return none
  ********************************************************************************/
-void rv32i::exec_illegal_insn(uint32_t insn, std::ostream* pos)
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_andn(uint32_t insn, std::ostream* pos)
 {
-    halt = true; // set the halt flag to true
-    if (pos != nullptr) // if pos is not nulltpr call render_illegal_insn()
-    {
-        render_illegal_insn();
-    }
+    reg_t a = regs.get(get_rs1(insn)); // rs1
+    reg_t b = regs.get(get_rs2(insn)); // rs2
+    exec_bitmanip(insn, pos, a & ~b);
 }
 /**
- * Execute lui instruction
- * IT executes the LUI RV32I instruction, renders the details of what it has simulated.
- * it uses render() helper functions
- * @param uint32_t insn, std::ostream* pos)
+ * Execute orn instruction (Zbb), rd = rs1 | ~rs2
+ * @param uint32_t insn, std::ostream* pos
  * @return none
  ********************************************************************************/
-void rv32i::exec_lui(uint32_t insn, std::ostream* pos)
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_orn(uint32_t insn, std::ostream* pos)
 {
-    uint32_t rd = get_rd(insn); // get rd
-    int32_t imm_u = get_imm_u(insn); // get imm_u
-    if (pos)
-    {
-        std::string s = render_lui(insn); // call render_lui
-        s.resize(instruction_width, ' ');
-        *pos << s << "// "
-             << "x" << std::dec << rd << " = " << hex0x32(imm_u);
-    }
-    regs.set(rd, imm_u); // set rd to imm_u
-    pc += 4; // increment pc by 4
+    reg_t a = regs.get(get_rs1(insn)); // rs1
+    reg_t b = regs.get(get_rs2(insn)); // rs2
+    exec_bitmanip(insn, pos, a | ~b);
 }
 /**
- * Execute auipc instruction
- * IT executes the AUIPC RV32I instruction, renders the details of what it has simulated.
- * it uses render() helper functions
- * @param uint32_t insn, std::ostream* pos)
+ * Execute xnor instruction (Zbb), rd = ~(rs1 ^ rs2)
+ * @param uint32_t insn, std::ostream* pos
  * @return none
  ********************************************************************************/
-void rv32i::exec_auipc(uint32_t insn, std::ostream* pos)
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_xnor(uint32_t insn, std::ostream* pos)
 {
-    uint32_t rd = get_rd(insn); // get rd
-    int32_t imm_u = get_imm_u(insn) + pc; // get imm_u + pc
-    if (pos)
-    {
-        std::string s = render_auipc(insn);
-        s.resize(instruction_width, ' ');
-        *pos << s << "// "
-             << "x" << rd << " = " << hex0x32(pc) << " + " << hex0x32(get_imm_u(insn)) << " = "
-             << hex0x32(imm_u);
-    }
-    regs.set(rd, imm_u); // set rd to imm_u
-    pc += 4; // increment pc by 4
+    reg_t a = regs.get(get_rs1(insn)); // rs1
+    reg_t b = regs.get(get_rs2(insn)); // rs2
+    exec_bitmanip(insn, pos, ~(a ^ b));
 }
 /**
- * Execute jal instruction
- * IT executes the JAL RV32I instruction, renders the details of what it has simulated.
- * it uses render() helper functions
- * @param uint32_t insn, std::ostream* pos)
+ * Execute min instruction (Zbb), the signed minimum
+ * @param uint32_t insn, std::ostream* pos
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_min(uint32_t insn, std::ostream* pos)
+{
+    reg_t a = regs.get(get_rs1(insn)); // rs1
+    reg_t b = regs.get(get_rs2(insn)); // rs2
+    exec_bitmanip(insn, pos, (sreg_t)a < (sreg_t)b ? a : b);
+}
+/**
+ * Execute minu instruction (Zbb), the unsigned minimum
+ * @param uint32_t insn, std::ostream* pos
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_minu(uint32_t insn, std::ostream* pos)
+{
+    reg_t a = regs.get(get_rs1(insn)); // rs1
+    reg_t b = regs.get(get_rs2(insn)); // rs2
+    exec_bitmanip(insn, pos, a < b ? a : b);
+}
+/**
+ * Execute max instruction (Zbb), the signed maximum
+ * @param uint32_t insn, std::ostream* pos
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_max(uint32_t insn, std::ostream* pos)
+{
+    reg_t a = regs.get(get_rs1(insn)); // rs1
+    reg_t b = regs.get(get_rs2(insn)); // rs2
+    exec_bitmanip(insn, pos, (sreg_t)a < (sreg_t)b ? b : a);
+}
+/**
+ * Execute maxu instruction (Zbb), the unsigned maximum
+ * @param uint32_t insn, std::ostream* pos
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_maxu(uint32_t insn, std::ostream* pos)
+{
+    reg_t a = regs.get(get_rs1(insn)); // rs1
+    reg_t b = regs.get(get_rs2(insn)); // rs2
+    exec_bitmanip(insn, pos, a < b ? b : a);
+}
+/**
+ * Execute rol instruction (Zbb), rotate left by rs2
+ * @param uint32_t insn, std::ostream* pos
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_rol(uint32_t insn, std::ostream* pos)
+{
+    reg_t a = regs.get(get_rs1(insn)); // rs1
+    reg_t b = regs.get(get_rs2(insn)); // rs2
+    exec_bitmanip(insn, pos, rotate_left(a, b & (XLEN - 1)));
+}
+/**
+ * Execute ror instruction (Zbb), rotate right by rs2
+ * @param uint32_t insn, std::ostream* pos
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_ror(uint32_t insn, std::ostream* pos)
+{
+    reg_t a = regs.get(get_rs1(insn)); // rs1
+    reg_t b = regs.get(get_rs2(insn)); // rs2
+    exec_bitmanip(insn, pos, rotate_left(a, -b & (XLEN - 1)));
+}
+/**
+ * Execute rori instruction (Zbb), rotate right by shamt
+ * @param uint32_t insn, std::ostream* pos
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_rori(uint32_t insn, std::ostream* pos)
+{
+    reg_t a = regs.get(get_rs1(insn)); // rs1
+    exec_bitmanip(insn, pos, rotate_left(a, -get_imm_i(insn) & (XLEN - 1)));
+}
+/**
+ * Execute clz instruction (Zbb), count leading zeros, XLEN for 0
+ * @param uint32_t insn, std::ostream* pos
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_clz(uint32_t insn, std::ostream* pos)
+{
+    reg_t a = regs.get(get_rs1(insn)); // rs1
+    exec_bitmanip(insn, pos, count_leading_zeros(a));
+}
+/**
+ * Execute ctz instruction (Zbb), count trailing zeros, XLEN for 0
+ * @param uint32_t insn, std::ostream* pos
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_ctz(uint32_t insn, std::ostream* pos)
+{
+    reg_t a = regs.get(get_rs1(insn)); // rs1
+    exec_bitmanip(insn, pos, count_trailing_zeros(a));
+}
+/**
+ * Execute cpop instruction (Zbb), count the bits set
+ * @param uint32_t insn, std::ostream* pos
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_cpop(uint32_t insn, std::ostream* pos)
+{
+    reg_t a = regs.get(get_rs1(insn)); // rs1
+    exec_bitmanip(insn, pos, count_ones(a));
+}
+/**
+ * Execute sext.b instruction (Zbb), sign-extend the low byte
+ * @param uint32_t insn, std::ostream* pos
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_sext_b(uint32_t insn, std::ostream* pos)
+{
+    reg_t a = regs.get(get_rs1(insn)); // rs1
+    exec_bitmanip(insn, pos, (int8_t)a);
+}
+/**
+ * Execute sext.h instruction (Zbb), sign-extend the low halfword
+ * @param uint32_t insn, std::ostream* pos
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_sext_h(uint32_t insn, std::ostream* pos)
+{
+    reg_t a = regs.get(get_rs1(insn)); // rs1
+    exec_bitmanip(insn, pos, (int16_t)a);
+}
+/**
+ * Execute zext.h instruction (Zbb), zero-extend the low halfword
+ * @param uint32_t insn, std::ostream* pos
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_zext_h(uint32_t insn, std::ostream* pos)
+{
+    reg_t a = regs.get(get_rs1(insn)); // rs1
+    exec_bitmanip(insn, pos, (uint16_t)a);
+}
+/**
+ * Execute orc.b instruction (Zbb), every byte becomes 0xff if it is not 0
+ * @param uint32_t insn, std::ostream* pos
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_orc_b(uint32_t insn, std::ostream* pos)
+{
+    reg_t a = regs.get(get_rs1(insn)); // rs1
+    exec_bitmanip(insn, pos, or_combine(a));
+}
+/**
+ * Execute rev8 instruction (Zbb), reverse the byte order
+ * @param uint32_t insn, std::ostream* pos
  * @return none
  ********************************************************************************/
-void rv32i::exec_jal(uint32_t insn, std::ostream* pos)
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_rev8(uint32_t insn, std::ostream* pos)
+{
+    reg_t a = regs.get(get_rs1(insn)); // rs1
+    exec_bitmanip(insn, pos, byte_swap(a));
+}
+// vregfile::alu_op of the OPIVV, OPIVX and OPIVI funct6 values up to vxor
+static constexpr vregfile::alu_op opi_alu[12] = {
+    vregfile::alu_add, vregfile::alu_count, vregfile::alu_sub, vregfile::alu_sub, vregfile::alu_minu,
+    vregfile::alu_min, vregfile::alu_maxu, vregfile::alu_max, vregfile::alu_count, vregfile::alu_and,
+    vregfile::alu_or, vregfile::alu_xor
+};
+// vregfile::alu_op of vredsum .. vredmax, by funct6
+static constexpr vregfile::alu_op red_alu[8] = {
+    vregfile::alu_add, vregfile::alu_and, vregfile::alu_or, vregfile::alu_xor, vregfile::alu_minu,
+    vregfile::alu_min, vregfile::alu_maxu, vregfile::alu_max
+};
+/**
+ * Execute vsetvli, vsetivli and vsetvl (V): set vtype and vl = min(AVL, VLMAX), rd = vl
+ * AVL is rs1 (uimm for vsetivli), VLMAX when rs1 is x0 and rd is not, the old vl when both are x0
+ * @param uint32_t insn, std::ostream* pos
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_vsetvl(uint32_t insn, std::ostream* pos)
 {
     uint32_t rd = get_rd(insn); // rd
-    uint32_t imm_j = get_imm_j(insn); // imm_j
-    uint32_t old_pc = pc;
+    uint32_t rs1 = get_rs1(insn); // rs1
+    bool immediate = (insn >> 30) == 3; // vsetivli
+    bool from_rs2 = !immediate && (insn >> 31) != 0; // vsetvl
+    reg_t vtypei = from_rs2 ? regs.get(get_rs2(insn)) : (insn >> 20) & (immediate ? 0x3ff : 0x7ff);
+    reg_t avl = immediate ? rs1 : rs1 != 0 ? regs.get(rs1) : rd != 0 ? ~(reg_t)0 : vec.get_vl();
+    uint32_t vl = vec.set_vtype(vtypei, avl);
+    regs.set(rd, vl); // set rd to the new vl
+    pc += 4; // increment pc by 4
     if (pos)
     {
-        std::string s = render_jal(insn);
+        std::string s = from_rs2 ? render_rtype(insn, "vsetvl") : render_vector(insn);
         s.resize(instruction_width, ' ');
-        pc += imm_j;
         *pos << s << "// "
-             << "x" << to_string(rd) << " = " << hex0x32(old_pc + 4) << ", "
-             << " pc = " << hex0x32(old_pc) << " + " << hex0x32(imm_j) << " = " << hex0x32(pc);
+             << "x" << std::dec << rd << " = vl = " << vl;
+        if (vec.is_vill())
+            *pos << ", vill";
     }
-    regs.set(rd, old_pc + 4);
-    pc = old_pc + imm_j;
 }
 /**
- * Execute jalr instruction
- * IT executes the JALR RV32I instruction, renders the details of what it has simulated.
- * it uses render() helper functions
- * @param uint32_t insn, std::ostream* pos)
+ * Execute the unit-stride and strided vector loads (V): vd[i] = m[rs1 + i * stride] for the
+ * first vl elements, the stride is rs2 or the element size
+ * @param uint32_t insn, std::ostream* pos
  * @return none
  ********************************************************************************/
-void rv32i::exec_jalr(uint32_t insn, std::ostream* pos)
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_vload(uint32_t insn, std::ostream* pos)
 {
-   uint32_t rd = get_rd(insn); //get rd
-   uint32_t rs1 = get_rs1(insn); //register rs1
-   uint32_t imm_i = get_imm_i(insn); //get imm_i
-   uint32_t old_pc = pc; //old pc value
-   pc = (regs.get(rs1) + imm_i) & 0xfffffffe; // increment pc 
-   if (pos)
-   {
-    std::string s = render_jalr(insn) ;
-     s.resize(instruction_width,' ');
-     *pos << s << "// x" << to_string(rd) <<" = "<<hex0x32(old_pc+4) << ", pc = (" << hex0x32(imm_i)
-     <<" + " << hex0x32(regs.get(rs1)) << ") & 0xfffffffe" << " = " << hex0x32(pc);
-
-   }
-   regs.set(rd,old_pc+4); //set rd to old_pc +4
-} 
+    uint32_t vd = get_rd(insn); // vd
+    uint32_t eew = vmem_eew[get_funct3(insn)]; // element width
+    reg_t addr = regs.get(get_rs1(insn)); // base address
+    int32_t stride = get_funct7(insn) == funct7_vstrided ? (int32_t)regs.get(get_rs2(insn)) : eew / 8;
+    if (!vec.check_group(vd, eew))
+    {
+        exec_illegal_insn(insn, pos);
+        return;
+    }
+    if (!vector_access(vd, addr, stride, eew, mmu::access_load))
+    {
+        if (pos)
+            render_fault(pos, render_vector(insn));
+        return;
+    }
+    pc += 4; // increment pc by 4
+    if (pos)
+    {
+        std::string s = render_vector(insn);
+        s.resize(instruction_width, ' ');
+        *pos << s << "// "
+             << "v" << std::dec << vd << " = m" << eew << "[" << hex0x_xlen(addr) << " + i * " << stride
+             << "], " << vec.get_vl() << " elements";
+    }
+}
 /**
- * Execute add instruction
- * IT executes the add RV32I instruction, renders the details of what it has simulated.
- * it uses render() helper functions
- * @param uint32_t insn, std::ostream* pos)
+ * Execute the unit-stride and strided vector stores (V): m[rs1 + i * stride] = vs3[i] for the
+ * first vl elements, the stride is rs2 or the element size
+ * @param uint32_t insn, std::ostream* pos
  * @return none
  ********************************************************************************/
-void rv32i::exec_add(uint32_t insn, std::ostream* pos)
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_vstore(uint32_t insn, std::ostream* pos)
 {
-    uint32_t rd = get_rd(insn); // rd
-    uint32_t rs1 = regs.get(get_rs1(insn)); // rs1
-    uint32_t rs2 = regs.get(get_rs2(insn)); // rs2
+    uint32_t vs3 = get_rd(insn); // vs3 is where loads have vd
+    uint32_t eew = vmem_eew[get_funct3(insn)]; // element width
+    reg_t addr = regs.get(get_rs1(insn)); // base address
+    int32_t stride = get_funct7(insn) == funct7_vstrided ? (int32_t)regs.get(get_rs2(insn)) : eew / 8;
+    if (!vec.check_group(vs3, eew))
+    {
+        exec_illegal_insn(insn, pos);
+        return;
+    }
+    if (!vector_access(vs3, addr, stride, eew, mmu::access_store))
+    {
+        if (pos)
+            render_fault(pos, render_vector(insn));
+        return;
+    }
+    pc += 4; // increment pc by 4
     if (pos)
     {
-        std::string s = render_rtype(insn, "add");
+        std::string s = render_vector(insn);
         s.resize(instruction_width, ' ');
         *pos << s << "// "
-             << "x" << rd << " = " << hex0x32(rs1) << " + " << hex0x32(rs2) << " = "
-             << hex0x32(rs1 + rs2);
+             << "m" << std::dec << eew << "[" << hex0x_xlen(addr) << " + i * " << stride << "] = v" << vs3
+             << ", " << vec.get_vl() << " elements";
     }
-    regs.set(rd, (rs1 + rs2)); // set rd to (rs1+rs2)
-    pc += 4; // increment pc by 4
 }
 /**
- * Execute addi instruction
- * IT executes the ADDI RV32I instruction, renders the details of what it has simulated.
- * it uses render() helper functions
- * @param uint32_t insn, std::ostream* pos)
+ * Execute the element-wise integer instructions (V): vadd, vsub, vrsub, vminu, vmin, vmaxu, vmax,
+ * vand, vor, vxor and vmul in their vv, vx and vi forms, vd[i] = vs2[i] op vs1[i] / rs1 / simm5
+ * for the first vl elements
+ * @param uint32_t insn, std::ostream* pos
  * @return none
  ********************************************************************************/
-void rv32i::exec_addi(uint32_t insn, std::ostream* pos)
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_varith(uint32_t insn, std::ostream* pos)
 {
-    uint32_t rd = get_rd(insn); // rd
-    uint32_t rs1 = regs.get(get_rs1(insn)); // rs1
-    int32_t imm_i = get_imm_i(insn); // imm_i
-    regs.set(rd, (rs1 + imm_i)); // set rd to rs1+imm_i
-    pc += 4; // increment pc by 4
+    uint32_t vd = get_rd(insn); // vd
+    uint32_t vs2 = get_rs2(insn); // vs2
+    uint32_t rs1 = get_rs1(insn); // vs1, rs1 or simm5
+    uint32_t funct3 = get_funct3(insn);
+    uint32_t funct6 = insn >> 26;
+    uint32_t sew = vec.get_sew();
+    bool opm = funct3 == funct3_opmvv || funct3 == funct3_opmvx;
+    bool vv = funct3 == funct3_opivv || funct3 == funct3_opmvv;
+    vregfile::alu_op op = opm ? vregfile::alu_mul : opi_alu[funct6];
+    if (!vec.check_group(vd, sew) || !vec.check_group(vs2, sew) || (vv && !vec.check_group(rs1, sew)))
+    {
+        exec_illegal_insn(insn, pos);
+        return;
+    }
+    sreg_t x = funct3 == funct3_opivi ? (int32_t)(insn << 12) >> 27 : (sreg_t)regs.get(rs1); // sign-extended to SEW
     if (pos)
     {
-        std::string s = render_itype_alu(insn, "addi", imm_i);
-        ;
+        std::string s = render_vector(insn);
         s.resize(instruction_width, ' ');
         *pos << s << "// "
-             << "x" << rd << " = " << hex0x32(rs1) << " + " << hex0x32(imm_i) << " = "
-             << hex0x32(regs.get(rd));
+             << "v" << std::dec << vd << " = " << insn_infos<XLEN>[lookup<XLEN>(insn)].mnemonic << "(v" << vs2 << ", ";
+        if (vv)
+            *pos << "v" << rs1;
+        else
+            *pos << hex0x_xlen(x);
+        *pos << "), " << vec.get_vl() << " x e" << sew;
     }
+    if (vv)
+        vec.alu_vv(op, vd, vs2, rs1);
+    else
+        vec.alu_vx(op, vd, vs2, (int64_t)x, funct6 == funct6_vrsub);
+    pc += 4; // increment pc by 4
 }
 /**
- * Execute srli instruction
- * IT executes the SRLI RV32I instruction, renders the details of what it has simulated.
- * it uses render() helper functions
- * @param uint32_t insn, std::ostream* pos)
+ * Execute the integer reductions (V): vd[0] = vs1[0] op vs2[0] op ... op vs2[vl - 1] for
+ * vredsum, vredand, vredor, vredxor, vredminu, vredmin, vredmaxu and vredmax
+ * @param uint32_t insn, std::ostream* pos
  * @return none
  ********************************************************************************/
-void rv32i::exec_srli(uint32_t insn, std::ostream* pos)
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_vred(uint32_t insn, std::ostream* pos)
 {
-    uint32_t rd = get_rd(insn); // rd
-    uint32_t rs1 = regs.get(get_rs1(insn)); // rs1
-    uint32_t imm_i = get_imm_i(insn); // imm_i
-    regs.set(rd, rs1 >> imm_i); // set rd to rs1>>imm_i
+    uint32_t vd = get_rd(insn); // vd
+    uint32_t vs2 = get_rs2(insn); // vs2
+    uint32_t vs1 = get_rs1(insn); // vs1
+    if (!vec.check_group(vs2, vec.get_sew()))
+    {
+        exec_illegal_insn(insn, pos);
+        return;
+    }
+    vec.reduce(red_alu[insn >> 26], vd, vs2, vs1);
     pc += 4; // increment pc by 4
     if (pos)
     {
-        std::string s = render_itype_shamt(insn, "srli");
+        std::string s = render_vector(insn);
         s.resize(instruction_width, ' ');
         *pos << s << "// "
-             << "x" << rd << " = " << hex0x32(rs1) << " >> " << imm_i << " = "
-             << hex0x32(regs.get(rd));
+             << "v" << std::dec << vd << "[0] = " << insn_infos<XLEN>[lookup<XLEN>(insn)].mnemonic << "(v" << vs2
+             << "[0.." << vec.get_vl() << "), v" << vs1 << "[0]) = " << hex0x_xlen(vec.get_scalar(vd));
     }
 }
 /**
- * Execute and instruction
- * IT executes the AND RV32I instruction, renders the details of what it has simulated.
- * it uses render() helper functions
- * @param uint32_t insn, std::ostream* pos)
+ * Execute vmv.v.v, vmv.v.x and vmv.v.i (V): vd[i] = vs1[i] / rs1 / simm5 for the first vl elements
+ * @param uint32_t insn, std::ostream* pos
  * @return none
  ********************************************************************************/
-void rv32i::exec_and(uint32_t insn, std::ostream* pos)
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_vmv(uint32_t insn, std::ostream* pos)
 {
-    uint32_t rd = get_rd(insn); // rd
-    uint32_t rs1 = regs.get(get_rs1(insn)); // rs1
-    uint32_t rs2 = regs.get(get_rs2(insn)); // rs2
+    uint32_t vd = get_rd(insn); // vd
+    uint32_t rs1 = get_rs1(insn); // vs1, rs1 or simm5
+    uint32_t funct3 = get_funct3(insn);
+    uint32_t sew = vec.get_sew();
+    if (!vec.check_group(vd, sew) || (funct3 == funct3_opivv && !vec.check_group(rs1, sew)))
+    {
+        exec_illegal_insn(insn, pos);
+        return;
+    }
+    sreg_t x = funct3 == funct3_opivi ? (int32_t)(insn << 12) >> 27 : (sreg_t)regs.get(rs1); // sign-extended to SEW
+    if (funct3 == funct3_opivv)
+        vec.move_vv(vd, rs1);
+    else
+        vec.move_vx(vd, (int64_t)x);
+    pc += 4; // increment pc by 4
     if (pos)
     {
-        std::string s = render_rtype(insn, "and");
+        std::string s = render_vector(insn);
         s.resize(instruction_width, ' ');
         *pos << s << "// "
-             << "x" << rd << " = " << hex0x32(rs1) << " & " << hex0x32(rs2) << " = "
-             << hex0x32(rs1 & rs2);
+             << "v" << std::dec << vd << " = ";
+        if (funct3 == funct3_opivv)
+            *pos << "v" << rs1;
+        else
+            *pos << hex0x_xlen(x);
+        *pos << ", " << vec.get_vl() << " x e" << sew;
     }
-    regs.set(rd, (rs1 & rs2)); // set rd to rs1 & rs2
-    pc += 4; // increment pc by 4
 }
 /**
- * Execute andi instruction
- * IT executes the ANDI RV32I instruction, renders the details of what it has simulated.
- * it uses render() helper functions
- * @param uint32_t insn, std::ostream* pos)
+ * Execute vmv.x.s (V): rd = vs2[0] sign-extended, or its low XLEN bits when SEW > XLEN
+ * @param uint32_t insn, std::ostream* pos
  * @return none
  ********************************************************************************/
-void rv32i::exec_andi(uint32_t insn, std::ostream* pos)
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_vmv_x_s(uint32_t insn, std::ostream* pos)
 {
     uint32_t rd = get_rd(insn); // rd
-    uint32_t imm_i = get_imm_i(insn); // imm_i
-    uint32_t rs1 = regs.get(get_rs1(insn)); // rs1
+    uint32_t vs2 = get_rs2(insn); // vs2
+    if (vec.is_vill())
+    {
+        exec_illegal_insn(insn, pos);
+        return;
+    }
+    regs.set(rd, (sreg_t)vec.get_scalar(vs2)); // set rd to vs2[0]
+    pc += 4; // increment pc by 4
     if (pos)
     {
-        std::string s = render_itype_alu(insn, "andi", imm_i);
+        std::string s = render_vector(insn);
         s.resize(instruction_width, ' ');
         *pos << s << "// "
-             << "x" << rd << " = " << hex0x32(rs1) << " & " << hex0x32(imm_i) << " = "
-             << hex0x32(rs1 & imm_i);
+             << "x" << std::dec << rd << " = v" << vs2 << "[0] = " << hex0x_xlen(regs.get(rd));
     }
-    regs.set(rd, (rs1 & imm_i)); // set rd to rs1&imm_i
-    pc += 4; // increment pc by 4
 }
 /**
- * Execute beq instruction
- * IT executes the BEQ RV32I instruction, renders the details of what it has simulated.
- * it uses render() helper functions
- * @param uint32_t insn, std::ostream* pos)
+ * Execute vmv.s.x (V): vd[0] = rs1 when vl is not 0
+ * @param uint32_t insn, std::ostream* pos
  * @return none
  ********************************************************************************/
-void rv32i::exec_beq(uint32_t insn, std::ostream* pos)
+template<uint32_t XLEN>
+void rvhart<XLEN>::exec_vmv_s_x(uint32_t insn, std::ostream* pos)
 {
-    uint32_t rs1 = regs.get(get_rs1(insn)); // get register rs1
-    uint32_t rs2 = regs.get(get_rs2(insn)); // get register rs2
-    int32_t imm_b = get_imm_b(insn); // get imm_b
+    uint32_t vd = get_rd(insn); // vd
+    sreg_t x = regs.get(get_rs1(insn)); // rs1
+    if (vec.is_vill())
+    {
+        exec_illegal_insn(insn, pos);
+        return;
+    }
+    vec.set_scalar(vd, (int64_t)x);
+    pc += 4; // increment pc by 4
     if (pos)
     {
-        std::string s = render_btype(insn, "beq");
-        ;
+        std::string s = render_vector(insn);
         s.resize(instruction_width, ' ');
         *pos << s << "// "
-             << "pc += (" << hex0x32(regs.get(get_rs1(insn)))
-             << " == " << hex0x32(regs.get(get_rs2(insn))) << " ? " << hex0x32(imm_b)
-             << " : 4) = " << hex0x32(rs1 == rs2 ? pc += imm_b : pc += 4);
+             << "v" << std::dec << vd << "[0] = " << hex0x_xlen(x);
     }
-    if (pos == nullptr)
+}
+/**
+ * Set VLEN, this resets the vector registers
+ * @param uint32_t bits (a power of 2 from vregfile::min_vlen to vregfile::max_vlen)
+ * @return false if bits can't be VLEN
+ ********************************************************************************/
+template<uint32_t XLEN>
+bool rvhart<XLEN>::set_vlen(uint32_t bits)
+{
+    return vec.set_vlen(bits);
+}
+/**
+ * Choose the host instructions the vector element loops use
+ * @param vregfile::simd_level level
+ * @return false if the host does not have them
+ ********************************************************************************/
+template<uint32_t XLEN>
+bool rvhart<XLEN>::set_vector_simd(vregfile::simd_level level)
+{
+    return vec.set_simd(level);
+}
+/**
+ * Check that the hart may access a CSR at its privilege level: the CSR number says the lowest
+ * level and whether it is read-only, mcounteren and scounteren say which counters S-mode and
+ * U-mode may read and mstatus.TVM keeps S-mode away from satp
+ * @param uint32_t csr, bool write
+ * @return false if the access is an illegal instruction
+ ********************************************************************************/
+template<uint32_t XLEN>
+bool rvhart<XLEN>::csr_accessible(uint32_t csr, bool write) const
+{
+    if (((csr >> 8) & 3) > priv || (write && (csr >> 10) == 3))
     {
-        (rs1 == rs2 ? pc += imm_b : pc += 4);
+        return false;
+    }
+    if ((csr & 0xf60) == csr_cycle) // cycle .. hpmcounter31 and their h halves
+    {
+        uint32_t bit = 1u << (csr & 0x1f);
+        return priv == mmu::priv_m || ((mcounteren & bit) && (priv == mmu::priv_s || (scounteren & bit)));
     }
+    return csr != csr_satp || priv == mmu::priv_m || !(mstatus & mstatus_tvm);
 }
 /**
- * Execute bge instruction
- * IT executes the BGE RV32I instruction, renders the details of what it has simulated.
- * it uses render() helper functions
- * @param uint32_t insn, std::ostream* pos)
- * @return none
+ * Read a CSR
+ * @param uint32_t csr, reg_t& val
+ * @return false if the CSR does not exist
  ********************************************************************************/
-void rv32i::exec_bge(uint32_t insn, std::ostream* pos)
+template<uint32_t XLEN>
+bool rvhart<XLEN>::csr_read(uint32_t csr, reg_t& val) const
 {
-    int32_t rs1 = regs.get(get_rs1(insn)); // get register rs1
-    int32_t rs2 = regs.get(get_rs2(insn)); // get register rs2
-    int32_t imm_b = get_imm_b(insn); // get imm_b
-    if (pos)
+    switch (csr)
     {
-        std::string s = render_btype(insn, "bge");
-        s.resize(instruction_width, ' ');
-        *pos << s << "// " << std::dec << "pc += (" << hex0x32(rs1) << " >= " << hex0x32(rs2)
-             << " ? " << hex0x32(imm_b)
-             << " : 4) = " << hex0x32(rs1 >= rs2 ? pc += imm_b : pc += 4);
+        default:
+            return false;
+        case csr_sstatus:
+            val = mstatus & sstatus_fields;
+            break;
+        case csr_sie:
+            val = mie & mideleg;
+            break;
+        case csr_stvec:
+            val = stvec;
+            break;
+        case csr_scounteren:
+            val = scounteren;
+            break;
+        case csr_sscratch:
+            val = sscratch;
+            break;
+        case csr_sepc:
+            val = sepc;
+            break;
+        case csr_scause:
+            val = scause;
+            break;
+        case csr_stval:
+            val = stval;
+            break;
+        case csr_sip:
+            val = mip & mideleg;
+            break;
+        case csr_medeleg:
+            val = medeleg;
+            break;
+        case csr_mideleg:
+            val = mideleg;
+            break;
+        case csr_mcounteren:
+            val = mcounteren;
+            break;
+        case csr_mstatus:
+            val = mstatus;
+            break;
+        case csr_misa:
+            val = (reg_t)(XLEN / 32) << (XLEN - 2) | misa_extensions; // MXL is 1 or 2
+            break;
+        case csr_mie:
+            val = mie;
+            break;
+        case csr_mtvec:
+            val = mtvec;
+            break;
+        case csr_mscratch:
+            val = mscratch;
+            break;
+        case csr_mepc:
+            val = mepc;
+            break;
+        case csr_mcause:
+            val = mcause;
+            break;
+        case csr_mtval:
+            val = mtval;
+            break;
+        case csr_mip:
+            val = mip;
+            break;
+        case csr_mcycle:
+        case csr_minstret:
+        case csr_cycle:
+        case csr_instret:
+            val = insn_counter;
+            break;
+        case csr_mcycleh:
+        case csr_minstreth:
+        case csr_cycleh:
+        case csr_instreth:
+            if (XLEN == 64)
+                return false; // RV64 has the whole counter in the low CSR
+            val = insn_counter >> 32;
+            break;
+        case csr_time:
+            val = get_mtime();
+            break;
+        case csr_timeh:
+            if (XLEN == 64)
+                return false;
+            val = get_mtime() >> 32;
+            break;
+        case csr_mhartid:
+            val = hartid;
+            break;
+        case csr_vstart:
+            val = 0; // no vector instruction stops halfway
+            break;
+        case csr_vl:
+            val = vec.get_vl();
+            break;
+        case csr_vtype:
+            val = vec.is_vill() ? (reg_t)1 << (XLEN - 1) : vec.get_vtype();
+            break;
+        case csr_vlenb:
+            val = vec.get_vlenb();
+            break;
+        case csr_satp:
+            val = vm.get_satp();
+            break;
     }
-    if (pos == nullptr)
+    return true;
+}
+/**
+ * Write a CSR
+ * only the writable fields of mstatus and mie are changed, the M-mode pending bits in mip are set
+ * by the devices and misa ignores writes. Counters and mhartid are read-only. satp ignores the
+ * ASID. sstatus, sie and sip change the fields of mstatus, mie and mip S-mode can see.
+ * @param uint32_t csr, reg_t val
+ * @return false if the CSR does not exist or is read-only
+ ********************************************************************************/
+template<uint32_t XLEN>
+bool rvhart<XLEN>::csr_write(uint32_t csr, reg_t val)
+{
+    switch (csr)
     {
-        (rs1 >= rs2 ? pc += imm_b : pc += 4); // increment pc
+        default:
+            return false;
+        case csr_sstatus:
+            mstatus = (mstatus & ~sstatus_fields) | (val & sstatus_fields);
+            update_privilege();
+            break;
+        case csr_sie:
+            mie = (mie & ~mideleg) | (val & mideleg);
+            break;
+        case csr_stvec:
+            stvec = val & ~(reg_t)2;
+            break;
+        case csr_scounteren:
+            scounteren = val & counteren_writable;
+            break;
+        case csr_sscratch:
+            sscratch = val;
+            break;
+        case csr_sepc:
+            sepc = val & ~(reg_t)3;
+            break;
+        case csr_scause:
+            scause = val;
+            break;
+        case csr_stval:
+            stval = val;
+            break;
+        case csr_sip:
+            mip = (mip & ~(mideleg & mip_ssip)) | (val & mideleg & mip_ssip); // the others follow M-mode
+            break;
+        case csr_medeleg:
+            medeleg = val & medeleg_writable;
+            break;
+        case csr_mideleg:
+            mideleg = val & mideleg_writable;
+            break;
+        case csr_mcounteren:
+            mcounteren = val & counteren_writable;
+            break;
+        case csr_mstatus:
+            if ((val & mstatus_mpp) == 2u << mstatus_mpp_shift)
+                val = (val & ~mstatus_mpp) | (mstatus & mstatus_mpp); // there is no H-mode
+            mstatus = val & mstatus_writable;
+            update_privilege();
+            break;
+        case csr_misa:
+        case csr_vstart:
+            break;
+        case csr_mip:
+            mip = (mip & ~mideleg_writable) | (val & mideleg_writable); // the M-mode bits follow the devices
+            break;
+        case csr_mie:
+            mie = val & (mip_msip | mip_mtip | mip_meip | mideleg_writable);
+            break;
+        case csr_mtvec:
+            mtvec = val & ~(reg_t)2; // modes 0 (direct) and 1 (vectored)
+            break;
+        case csr_mscratch:
+            mscratch = val;
+            break;
+        case csr_mepc:
+            mepc = val & ~(reg_t)3;
+            break;
+        case csr_mcause:
+            mcause = val;
+            break;
+        case csr_mtval:
+            mtval = val;
+            break;
+        case csr_satp:
+            if (XLEN == 32)
+                vm.set_satp(val); // rv64i has no Sv39, so satp stays Bare
+            break;
     }
+    next_check = 0; // the write may have unmasked an interrupt
+    return true;
 }
 /**
- * Execute bgeu instruction
- * IT executes the LUI RV32I instruction, renders the details of what it has simulated.
- * it uses render() helper functions
- * @param uint32_t insn, std::ostream* pos)
+ * Take a trap
+ * saves pc in mepc, records the cause, disables interrupts (remembering the old MIE in MPIE),
+ * goes to M-mode (remembering the old privilege level in MPP) and continues at mtvec. Interrupts
+ * go to mtvec + 4 * cause when mtvec is in vectored mode. A trap below M-mode that medeleg or
+ * mideleg delegates does the same with the S-mode CSRs, SIE, SPIE and SPP instead.
+ * @param reg_t cause, reg_t tval
  * @return none
  ********************************************************************************/
-void rv32i::exec_bgeu(uint32_t insn, std::ostream* pos)
+template<uint32_t XLEN>
+void rvhart<XLEN>::take_trap(reg_t cause, reg_t tval)
 {
-    uint32_t rs1 = regs.get(get_rs1(insn)); // get register rs1
-    uint32_t rs2 = regs.get(get_rs2(insn)); // get register rs2
-    int32_t imm_b = get_imm_b(insn); // get imm_b
-    if (pos)
+    uint32_t code = cause & ~mcause_interrupt;
+    if (priv != mmu::priv_m && ((cause & mcause_interrupt ? mideleg : medeleg) >> code & 1))
     {
-        std::string s = render_btype(insn, "bgeu");
-        s.resize(instruction_width, ' ');
-        *pos << s << "// " << std::dec << "pc += (" << hex0x32(rs1) << " >=U " << hex0x32(rs2)
-             << " ? " << hex0x32(imm_b)
-             << " : 4) = " << hex0x32(rs1 >= rs2 ? pc += imm_b : pc += 4);
+        sepc = pc;
+        scause = cause;
+        stval = tval;
+        if (mstatus & mstatus_sie)
+            mstatus |= mstatus_spie;
+        else
+            mstatus &= ~mstatus_spie;
+        mstatus &= ~(mstatus_sie | mstatus_spp);
+        mstatus |= priv == mmu::priv_s ? mstatus_spp : 0;
+        priv = mmu::priv_s;
+        update_privilege();
+        pc = stvec & ~(reg_t)3;
+        if ((stvec & 1) && (cause & mcause_interrupt))
+        {
+            pc += 4 * code;
+        }
+        return;
     }
-    if (pos == nullptr)
+    mepc = pc;
+    mcause = cause;
+    mtval = tval;
+    if (mstatus & mstatus_mie)
+        mstatus |= mstatus_mpie;
+    else
+        mstatus &= ~mstatus_mpie;
+    mstatus &= ~mstatus_mie;
+    mstatus = (mstatus & ~mstatus_mpp) | priv << mstatus_mpp_shift;
+    priv = mmu::priv_m;
+    update_privilege();
+    pc = mtvec & ~(reg_t)3;
+    if ((mtvec & 1) && (cause & mcause_interrupt))
     {
-        (rs1 >= rs2 ? pc += imm_b : pc += 4); // increment pc
+        pc += 4 * code;
     }
 }
 /**
- * Execute blt instruction
- * IT executes the BLT RV32I instruction, renders the details of what it has simulated.
- * it uses render() helper functions
- * @param uint32_t insn, std::ostream* pos)
+ * Raise an exception for the instruction at pc, which must not have changed anything yet
+ * the slow path of every instruction that traps, nothing on the fast path tests for traps. If the
+ * trap vector it would go to is 0, where every program starts, there is no handler and the hart
+ * halts as it did before it had traps, with the exception in mepc, mcause and mtval.
+ * @param uint32_t cause, reg_t tval
  * @return none
  ********************************************************************************/
-void rv32i::exec_blt(uint32_t insn, std::ostream* pos)
+template<uint32_t XLEN>
+void rvhart<XLEN>::take_exception(uint32_t cause, reg_t tval)
 {
-    int32_t rs1 = regs.get(get_rs1(insn)); // get register rs1
-    int32_t rs2 = regs.get(get_rs2(insn)); // get register rs1
-    uint32_t imm_b = get_imm_b(insn); // get imm_b
-    if (pos)
+    bool to_s = priv != mmu::priv_m && (medeleg >> cause & 1);
+    if (((to_s ? stvec : mtvec) & ~(reg_t)3) == 0)
     {
-        std::string s = render_btype(insn, "blt");
-        s.resize(instruction_width, ' ');
-        *pos << s << "// " << std::dec << "pc += (" << hex0x32(rs1) << " < " << hex0x32(rs2)
-             << " ? " << hex0x32(imm_b) << " : 4) = " << hex0x32(rs1 < rs2 ? pc += imm_b : pc += 4);
+        mepc = pc;
+        mcause = cause;
+        mtval = tval;
+        halt = true;
+        unhandled = true;
+        return;
     }
-    if (pos == nullptr)
+    take_trap(cause, tval);
+}
+/**
+ * Raise the instruction address misaligned exception for a taken branch to a pc that is not a
+ * multiple of 4, after the branch has already moved pc (and shown it)
+ * @param int32_t imm_b, std::ostream* pos
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::branch_misaligned(int32_t imm_b, std::ostream* pos)
+{
+    reg_t target = pc;
+    pc -= imm_b; // back to the branch
+    take_exception(cause_insn_misaligned, target);
+    if (pos)
     {
-        (rs1 < rs2 ? pc += imm_b : pc += 4); // increment pc
+        render_fault(pos, "");
     }
 }
 /**
- * Execute bltu instruction
- * IT executes the bltu RV32I instruction, renders the details of what it has simulated.
- * it uses render() helper functions
- * @param uint32_t insn, std::ostream* pos)
+ * Tell the mmu which privilege level fetches and data accesses are checked for, after the
+ * privilege level or mstatus changed
+ * @param none
  * @return none
  ********************************************************************************/
-void rv32i::exec_bltu(uint32_t insn, std::ostream* pos)
+template<uint32_t XLEN>
+void rvhart<XLEN>::update_privilege()
 {
-    uint32_t rs1 = regs.get(get_rs1(insn)); // get register rs1
-    uint32_t rs2 = regs.get(get_rs2(insn)); // get register rs2
-    int32_t imm_b = get_imm_b(insn); // get imm_b
-    if (pos)
+    uint32_t data_priv = mstatus & mstatus_mprv ? (mstatus & mstatus_mpp) >> mstatus_mpp_shift : priv;
+    vm.set_privilege(priv, data_priv, mstatus & mstatus_sum, mstatus & mstatus_mxr);
+}
+/**
+ * Whether an untranslated address is beyond the 32-bit physical address space, the memory only
+ * takes 32-bit addresses so on rv64i these must fault instead of wrapping around into the RAM
+ * @param reg_t addr
+ * @return true if the address has bits set above bit 31
+ ********************************************************************************/
+template<uint32_t XLEN>
+inline bool rvhart<XLEN>::beyond_4g(reg_t addr)
+{
+    return XLEN == 64 && (uint64_t)addr >> 32 != 0;
+}
+/**
+ * Translate a virtual address, taking the page fault or access fault if there is one
+ * must be called before the instruction changes anything, so that mepc is its pc and a fault
+ * leaves nothing half done
+ * @param reg_t addr, mmu::access_type access, uint32_t& paddr (set to the physical address)
+ * @return false if the hart trapped
+ ********************************************************************************/
+template<uint32_t XLEN>
+bool rvhart<XLEN>::translate(reg_t addr, mmu::access_type access, uint32_t& paddr)
+{
+    if (!(access == mmu::access_fetch ? vm.fetch_translated() : vm.data_translated()))
     {
-        std::string s = render_btype(insn, "bltu");
-        s.resize(instruction_width, ' ');
-        *pos << s << "// " << std::dec << "pc += (" << hex0x32(rs1) << " <U " << hex0x32(rs2)
-             << " ? " << hex0x32(imm_b)
-             << " : 4) = " << hex0x32((rs1 < rs2 ? pc += imm_b : pc += 4));
+        if (beyond_4g(addr))
+        {
+            take_exception(cause_access_fault[access], addr);
+            return false;
+        }
+        paddr = addr;
+        return true;
     }
-    if (pos == nullptr)
+    uint32_t cause = vm.translate(addr, access, paddr);
+    if (cause != 0)
     {
-        (rs1 < rs2 ? pc += imm_b : pc += 4); // increment pc
+        take_exception(cause, addr);
+        return false;
     }
+    return true;
 }
 /**
- * Execute bne instruction
- * IT executes the BNE RV32I instruction, renders the details of what it has simulated.
- * it uses render() helper functions
- * @param uint32_t insn, std::ostream* pos)
- * @return none
+ * Fetch the instruction at pc
+ * a TLB hit reads it through the host pointer, everything else goes to fetch_slow()
+ * @param uint32_t& insn
+ * @return false if the fetch trapped
  ********************************************************************************/
-void rv32i::exec_bne(uint32_t insn, std::ostream* pos)
+template<uint32_t XLEN>
+inline bool rvhart<XLEN>::fetch(uint32_t& insn)
 {
-    uint32_t rs1 = regs.get(get_rs1(insn)); // get register rs1
-    uint32_t rs2 = regs.get(get_rs2(insn)); // get register rs2
-    int32_t imm_b = get_imm_b(insn); // get imm_b
-    if (pos)
+    if (!vm.fetch_translated())
     {
-        std::string s = render_btype(insn, "bne");
-        s.resize(instruction_width, ' ');
-        *pos << s << "// " << std::dec << "pc += (" << hex0x32(rs1) << " != " << hex0x32(rs2)
-             << " ? " << hex0x32(imm_b)
-             << " : 4) = " << hex0x32(rs1 != rs2 ? pc += imm_b : pc += 4);
+        if (!beyond_4g(pc) && mem->fetch(pc, insn))
+        {
+            return true;
+        }
+        take_exception(cause_access_fault[mmu::access_fetch], pc);
+        return false;
     }
-    if (pos == nullptr)
+    const uint8_t* p = vm.find_fetch(pc);
+    if (p != nullptr)
     {
-        (rs1 != rs2 ? pc += imm_b : pc += 4); // increment pc
+        memcpy(&insn, p, 4); // little-endian host
+        return true;
     }
+    return fetch_slow(insn);
 }
 /**
- * Execute lb instruction
- * IT executes the LB RV32I instruction, renders the details of what it has simulated.
- * it uses render() helper functions
- * @param uint32_t insn, std::ostream* pos)
- * @return none
+ * Fetch the instruction at pc through translate(), both pages of an instruction that crosses into
+ * the next page are translated
+ * @param uint32_t& insn
+ * @return false if the fetch trapped
  ********************************************************************************/
-void rv32i::exec_lb(uint32_t insn, std::ostream* pos)
+template<uint32_t XLEN>
+bool rvhart<XLEN>::fetch_slow(uint32_t& insn)
 {
-
-    uint32_t rd = get_rd(insn); // rd
-    uint32_t rs1 = regs.get(get_rs1(insn)); // register rs1
-    int32_t imm_i = get_imm_i(insn); // imm_i
-    int32_t address = mem->get8(rs1 + imm_i); // memory address
-    // check the MSB if its set to 1 | with 0xFFFFFF00
-    if ((address & 0x00000080) == 0x00000080)
+    uint32_t paddr;
+    if (!translate(pc, mmu::access_fetch, paddr))
     {
-        address = mem->get8(rs1 + imm_i) | 0xFFFFFF00;
+        return false;
     }
-    regs.set(rd, address); // set rd to addr
-    pc += 4; // icrement pc by 4
-    if (pos)
+    uint32_t shift = 8 * (pc & 3);
+    if ((pc & mmu::offset_mask) <= mmu::page_size - 4)
     {
-        std::string s = render_itype_load(insn, "lb");
-        s.resize(instruction_width, ' ');
-        *pos << s << "// "
-             << "x" << rd << " = sx(m8(" << hex0x32(rs1) << " + " << hex0x32(imm_i)
-             << " )) = " << hex0x32(regs.get(rd));
+        if (mem->fetch(paddr, insn))
+        {
+            return true;
+        }
+        take_exception(cause_access_fault[mmu::access_fetch], pc);
+        return false;
+    }
+    uint32_t next;
+    if (!translate((pc | mmu::offset_mask) + 1, mmu::access_fetch, next))
+    {
+        return false;
+    }
+    uint32_t lo, hi;
+    if (!mem->fetch(paddr & ~3, lo) || !mem->fetch(next, hi))
+    {
+        take_exception(cause_access_fault[mmu::access_fetch], pc);
+        return false;
     }
+    insn = lo >> shift | hi << (32 - shift);
+    return true;
 }
 /**
- * Execute lbu instruction
- * IT executes the LBU RV32I instruction, renders the details of what it has simulated.
- * it uses render() helper functions
- * @param uint32_t insn, std::ostream* pos)
- * @return none
+ * The instruction at pc for the loops that look at it before tick() executes it, without
+ * trapping. Only the RAM is looked at, so that a device is not read twice and a bad pc is not
+ * reported as a fault twice.
+ * @param none
+ * @return the instruction, 0 if fetching it faults or it is not in the RAM
  ********************************************************************************/
-void rv32i::exec_lbu(uint32_t insn, std::ostream* pos)
+template<uint32_t XLEN>
+uint32_t rvhart<XLEN>::peek_insn()
 {
-    uint32_t rd = get_rd(insn); // get rd
-    uint32_t rs1 = regs.get(get_rs1(insn)); // get register rs1
-    uint32_t imm_i = get_imm_i(insn); // get imm_i
-    regs.set(rd, mem->get8((rs1 + imm_i))); // set rd to mem->get8(rs1+imm_i)
-    rd = mem->get8((rs1 + imm_i)); // get8(rs1 + imm_i)
-    pc += 4; // increment pc by 4
-    if (pos)
+    uint32_t paddr = pc;
+    if (beyond_4g(pc) || (vm.fetch_translated() && vm.translate(pc, mmu::access_fetch, paddr) != 0))
     {
-        std::string s = render_itype_load(insn, "lbu");
-        s.resize(instruction_width, ' ');
-        *pos << s << "// "
-             << "x" << get_rd(insn) << " = zx(m8(" << hex0x32(rs1) << " + " << hex0x32(imm_i)
-             << " )) = " << hex0x32(rd);
+        return 0;
+    }
+    if (paddr > mem->get_size() - 4)
+    {
+        return 0;
     }
+    return mem->fetch32(paddr);
 }
 /**
- * Execute lh instruction
- * IT executes the LH RV32I instruction, renders the details of what it has simulated.
- * it uses render() helper functions
- * @param uint32_t insn, std::ostream* pos
- * @return none
+ * Load sizeof(T) bytes from addr
+ * untranslated this is the memory accessor, translated a TLB hit is a compare and a copy from
+ * the host page, anything else (devices, watched pages, misaligned or missing translations)
+ * goes to read_slow(). A load outside the memory and every device raises the access fault.
+ * @param reg_t addr, T& val
+ * @return false if the load trapped
  ********************************************************************************/
-void rv32i::exec_lh(uint32_t insn, std::ostream* pos)
+template<uint32_t XLEN>
+template<typename T>
+inline bool rvhart<XLEN>::read_mem(reg_t addr, T& val)
 {
-    int32_t rd = get_rd(insn); // rd
-    int32_t rs1 = regs.get(get_rs1(insn)); // register rs1
-    int32_t imm_i = get_imm_i(insn); // imm_i
-    int32_t address = (mem->get16(rs1 + imm_i)); // memory address
-    // if msb is 1 then | with 0xffff0000
-    if ((address & 0x00008000) == 0x00008000)
+    if (!vm.data_translated())
     {
-        address = (mem->get16(rs1 + imm_i) | 0xffff0000);
+        uint64_t v;
+        if (!beyond_4g(addr) && mem->read(addr, sizeof(T), v))
+        {
+            val = v;
+            return true;
+        }
+        take_exception(cause_access_fault[mmu::access_load], addr);
+        return false;
     }
-    regs.set(rd, address); // set rd to address
-    pc += 4; // increment pc by 4
-    if (pos)
+    const uint8_t* p = vm.find_data(addr, sizeof(T), mmu::access_load);
+    if (p != nullptr)
     {
-        std::string s = render_itype_load(insn, "lh");
-        s.resize(instruction_width, ' ');
-        *pos << s << "// "
-             << "x" << rd << " = sx(m16(" << hex0x32(rs1) << " + " << hex0x32(imm_i)
-             << ")) = " << hex0x32(regs.get(rd));
+        memcpy(&val, p, sizeof(T)); // little-endian host
+        return true;
     }
+    uint64_t v;
+    if (!read_slow(addr, sizeof(T), v))
+    {
+        return false;
+    }
+    val = v;
+    return true;
 }
 /**
- * Execute lhu instruction
- * IT executes the LHU RV32I instruction, renders the details of what it has simulated.
- * it uses render() helper functions
- * @param uint32_t insn, std::ostream* pos)
- * @return none
+ * Store sizeof(T) bytes to addr, the counterpart of read_mem()
+ * @param reg_t addr, T val
+ * @return false if the store trapped
  ********************************************************************************/
-void rv32i::exec_lhu(uint32_t insn, std::ostream* pos)
+template<uint32_t XLEN>
+template<typename T>
+inline bool rvhart<XLEN>::write_mem(reg_t addr, T val)
 {
-    uint32_t rd = get_rd(insn); // get rd
-    uint32_t rs1 = regs.get(get_rs1(insn)); // register rs1
-    uint32_t imm_i = get_imm_i(insn); // get imm_i
-    regs.set(rd, mem->get16((rs1 + imm_i))); // set rd to memory address get16(rs1+imm_i)
-    pc += 4; // increment pc with 4
-    if (pos)
+    if (!vm.data_translated())
     {
-        std::string s = render_itype_load(insn, "lhu");
-        s.resize(instruction_width, ' ');
-        *pos << s << "// "
-             << "x" << rd << " = zx(m16(" << hex0x32(rs1) << " + " << hex0x32(imm_i)
-             << " )) = " << hex0x32(mem->get16(rs1 + imm_i));
+        if (!beyond_4g(addr) && mem->write(addr, sizeof(T), val))
+        {
+            return true;
+        }
+        take_exception(cause_access_fault[mmu::access_store], addr);
+        return false;
     }
+    uint8_t* p = vm.find_data(addr, sizeof(T), mmu::access_store);
+    if (p != nullptr)
+    {
+        memcpy(p, &val, sizeof(T)); // the page was marked written when it went into the TLB
+        return true;
+    }
+    return write_slow(addr, sizeof(T), val);
 }
 /**
- * Execute lw instruction
- * IT executes the LW RV32I instruction, renders the details of what it has simulated.
- * it uses render() helper functions
- * @param uint32_t insn, std::ostream* pos)
- * @return none
+ * Translated load that missed the TLB, a misaligned load that crosses into the next page is
+ * done byte by byte after both pages are translated
+ * @param uint32_t addr, uint32_t size, uint64_t& val
+ * @return false if the load trapped
  ********************************************************************************/
-void rv32i::exec_lw(uint32_t insn, std::ostream* pos)
+template<uint32_t XLEN>
+bool rvhart<XLEN>::read_slow(uint32_t addr, uint32_t size, uint64_t& val)
 {
-    uint32_t rd = get_rd(insn); // rd
-    uint32_t rs1 = regs.get(get_rs1(insn)); // register rs1
-    uint32_t imm_i = get_imm_i(insn); // imm_i
-    regs.set(rd, mem->get32(rs1 + imm_i)); // set rd to memory address get32(rs1+imm_i)
-    pc += 4; // increment pc by 4
-    if (pos)
+    uint32_t paddr;
+    if (!translate(addr, mmu::access_load, paddr))
     {
-        std::string s = render_itype_load(insn, "lw");
-        s.resize(instruction_width, ' ');
-        *pos << s << "// "
-             << "x" << rd << " = sx(m32(" << hex0x32(rs1) << " + " << hex0x32(imm_i)
-             << " )) = " << hex0x32(regs.get(rd));
+        return false;
+    }
+    uint32_t split = mmu::page_size - (addr & mmu::offset_mask); // bytes left in the page
+    if (size <= split)
+    {
+        if (mem->read(paddr, size, val))
+        {
+            return true;
+        }
+        take_exception(cause_access_fault[mmu::access_load], addr);
+        return false;
+    }
+    uint32_t next;
+    if (!translate(addr + split, mmu::access_load, next))
+    {
+        return false;
+    }
+    val = 0;
+    for (uint32_t i = 0; i < size; i++)
+    {
+        uint64_t byte;
+        if (!mem->read(i < split ? paddr + i : next + i - split, 1, byte))
+        {
+            take_exception(cause_access_fault[mmu::access_load], addr + i);
+            return false;
+        }
+        val |= byte << 8 * i;
     }
+    return true;
 }
 /**
- * Execute or instruction
- * IT executes the OR RV32I instruction, renders the details of what it has simulated.
- * it uses render() helper functions
- * @param uint32_t insn, std::ostream* pos)
- * @return none
+ * Translated store that missed the TLB, both pages of a store that crosses into the next page
+ * are translated before anything is written
+ * @param uint32_t addr, uint32_t size, uint64_t val
+ * @return false if the store trapped
  ********************************************************************************/
-void rv32i::exec_or(uint32_t insn, std::ostream* pos)
+template<uint32_t XLEN>
+bool rvhart<XLEN>::write_slow(uint32_t addr, uint32_t size, uint64_t val)
 {
-    uint32_t rd = get_rd(insn); // get rd
-    uint32_t rs1 = regs.get(get_rs1(insn)); // register rs1
-    uint32_t rs2 = regs.get(get_rs2(insn)); // register rs2
-    if (pos)
+    uint32_t paddr;
+    if (!translate(addr, mmu::access_store, paddr))
     {
-        std::string s = render_rtype(insn, "or");
-        s.resize(instruction_width, ' ');
-        *pos << s << "// "
-             << "x" << rd << " = " << hex0x32(rs1) << " | " << hex0x32(rs2) << " = "
-             << hex0x32(rs1 | rs2);
+        return false;
     }
-    regs.set(rd, (rs1 | rs2)); // set rd to rs1 | rs2
-    pc += 4; // increment pc by 4
+    uint32_t split = mmu::page_size - (addr & mmu::offset_mask);
+    if (size <= split)
+    {
+        if (mem->write(paddr, size, val))
+        {
+            return true;
+        }
+        take_exception(cause_access_fault[mmu::access_store], addr);
+        return false;
+    }
+    uint32_t next;
+    if (!translate(addr + split, mmu::access_store, next))
+    {
+        return false;
+    }
+    for (uint32_t i = 0; i < size; i++)
+    {
+        if (!mem->write(i < split ? paddr + i : next + i - split, 1, val >> 8 * i))
+        {
+            take_exception(cause_access_fault[mmu::access_store], addr + i);
+            return false;
+        }
+    }
+    return true;
 }
 /**
- * Execute ori instruction
- * IT executes the ORI RV32I instruction, renders the details of what it has simulated.
- * it uses render() helper functions
- * @param uint32_t insn, std::ostream* pos)
- * @return none
+ * Load or store the first vl elements of register group v, element i at addr + i * stride
+ * translated, every element is translated before any is accessed so that a fault leaves the
+ * registers and the memory as they were. Elements that are contiguous in physical memory go to
+ * vregfile in one run, so a unit-stride access costs one call per page. A misaligned element
+ * raises the misaligned exception instead of being split between pages.
+ * @param uint32_t v, reg_t addr, int32_t stride, uint32_t eew, mmu::access_type access (load or
+ * store)
+ * @return false if the access trapped
  ********************************************************************************/
-void rv32i::exec_ori(uint32_t insn, std::ostream* pos)
+template<uint32_t XLEN>
+bool rvhart<XLEN>::vector_access(uint32_t v, reg_t addr, int32_t stride, uint32_t eew, mmu::access_type access)
 {
-    uint32_t rd = get_rd(insn); // get rd
-    uint32_t rs1 = regs.get(get_rs1(insn)); // register rs1
-    uint32_t imm_i = get_imm_i(insn); // get imm_i
-    if (pos)
+    uint32_t vl = vec.get_vl();
+    uint32_t done;
+    if (!vm.data_translated())
     {
-        std::string s = render_itype_alu(insn, "ori", imm_i);
-        ;
-        s.resize(instruction_width, ' ');
-        *pos << s << "// "
-             << "x" << rd << " = " << hex0x32(rs1) << " | " << hex0x32(imm_i) << " = "
-             << hex0x32(rs1 | imm_i);
+        if (access == mmu::access_load)
+            done = vec.load(mem, v, addr, stride, eew, 0, vl);
+        else
+            done = vec.store(mem, v, addr, stride, eew, 0, vl);
+        if (done != vl)
+        {
+            take_exception(cause_access_fault[access], addr + done * stride);
+            return false;
+        }
+        return true;
     }
-    regs.set(rd, (rs1 | imm_i)); // set rd to rs1 | imm_i
-    pc += 4; // increment pc by 4
+    struct run
+    {
+        uint32_t first; // element
+        uint32_t count;
+        uint32_t paddr; // of element first
+    };
+    std::vector<run> runs;
+    uint32_t size = eew / 8;
+    uint32_t prev = 0; // virtual and physical address of the last element translated
+    uint32_t prev_paddr = 0;
+    for (uint32_t i = 0; i < vl; i++)
+    {
+        uint32_t a = addr + i * stride;
+        if (a & (size - 1))
+        {
+            take_exception(access == mmu::access_load ? cause_load_misaligned : cause_store_misaligned, a);
+            return false;
+        }
+        uint32_t paddr = prev_paddr + (a - prev);
+        if (i == 0 || ((a ^ prev) & ~mmu::offset_mask) != 0)
+        {
+            if (!translate(a, access, paddr))
+            {
+                return false;
+            }
+        }
+        if (i != 0 && stride == (int32_t)size && paddr == prev_paddr + size)
+        {
+            runs.back().count++;
+        }
+        else
+        {
+            runs.push_back({ i, 1, paddr });
+        }
+        prev = a;
+        prev_paddr = paddr;
+    }
+    for (const run& r : runs)
+    {
+        if (access == mmu::access_load)
+            done = vec.load(mem, v, r.paddr, stride, eew, r.first, r.count);
+        else
+            done = vec.store(mem, v, r.paddr, stride, eew, r.first, r.count);
+        if (done != r.count)
+        {
+            take_exception(cause_access_fault[access], addr + (r.first + done) * stride);
+            return false;
+        }
+    }
+    return true;
 }
 /**
- * Execute sb instruction
- * IT executes the SB RV32I instruction, renders the details of what it has simulated.
- * it uses render() helper functions
- * @param uint32_t insn, std::ostream* pos)
+ * Renders an instruction that trapped on its memory access
+ * @param std::ostream* pos, const std::string& s (the rendered instruction, empty if a store
+ * has shown it already)
  * @return none
  ********************************************************************************/
-void rv32i::exec_sb(uint32_t insn, std::ostream* pos)
+template<uint32_t XLEN>
+void rvhart<XLEN>::render_fault(std::ostream* pos, const std::string& s) const
 {
-    uint32_t rs1 = regs.get(get_rs1(insn)); // register rs1
-    uint32_t rs2 = regs.get(get_rs2(insn)); // register rs2
-    uint32_t imm_s = get_imm_s(insn); // imm_s
-    if (pos)
+    if (s.empty())
     {
-        std::string s = render_stype(insn, "sb");
-        s.resize(instruction_width, ' ');
-        *pos << s << "// "
-             << "m8(" << hex0x32(rs1) << " + " << hex0x32(imm_s)
-             << ") = " << hex0x32(rs2 & 0x000000ff);
+        *pos << ", ";
     }
-    mem->set8(rs1 + imm_s, rs2 & 0x000000ff); // set memory at address rs1+imm_S to rs2&0x000000ff
-    pc += 4; // increment pc by 4
+    else
+    {
+        std::string t = s;
+        t.resize(instruction_width, ' ');
+        *pos << t << "// ";
+    }
+    *pos << render_trap();
 }
 /**
- * Execute sh instruction
- * IT executes the LUI RV32I instruction, renders the details of what it has simulated.
- * it uses render() helper functions
- * @param uint32_t insn, std::ostream* pos)
- * @return none
+ * Renders the exception just taken: its name, the address it is about if it has one and where
+ * the hart continues
+ * @param none
+ * @return std::string
  ********************************************************************************/
-void rv32i::exec_sh(uint32_t insn, std::ostream* pos)
+template<uint32_t XLEN>
+std::string rvhart<XLEN>::render_trap() const
 {
-    uint32_t rs1 = get_rs1(insn);
-    uint32_t rs2 = get_rs2(insn);
-    uint32_t imm_s = get_imm_s(insn);
-    // unsigned short mask = (1 << (16-0))-1;
-    uint32_t addr = regs.get(rs1) + imm_s;
-    uint32_t target = regs.get(rs2) & 0x0000ffff;
-    if (pos)
+    bool in_s = !halt && priv == mmu::priv_s; // S-mode is only reached through a delegated trap
+    reg_t cause = in_s ? scause : mcause;
+    std::ostringstream os;
+    os << exception_names[cause & 15];
+    if (cause_tval_address >> (cause & 15) & 1)
     {
-        std::string s = render_stype(insn, "sh");
-        s.resize(instruction_width, ' ');
-        *pos << s << "// "
-             << "m16(" << hex0x32(regs.get(rs1)) << " + " << hex0x32(imm_s)
-             << ") = " << hex0x32(target);
+        os << " at " << hex0x_xlen(in_s ? stval : mtval);
     }
-    mem->set16(addr, target); // set addr to target
-    pc += 4; // incremet pc by 4
+    if (halt)
+    {
+        os << ", no handler";
+    }
+    else
+    {
+        os << ", pc = " << hex0x_xlen(pc);
+    }
+    return os.str();
 }
 /**
- * Execute sll instruction
- * IT executes the SLL RV32I instruction, renders the details of what it has simulated.
- * it uses render() helper functions
- * @param uint32_t insn, std::ostream* pos)
+ * Service due events and pending interrupts
+ * called by tick() only when insn_counter reaches next_check, so the per-instruction cost is a
+ * single compare. Fires the events that are due and takes the highest priority interrupt
+ * (external, then software, then timer, M-mode before S-mode) that is pending and enabled at
+ * the privilege level of the hart.
+ * @param none
  * @return none
  ********************************************************************************/
-void rv32i::exec_sll(uint32_t insn, std::ostream* pos)
+template<uint32_t XLEN>
+void rvhart<XLEN>::check_interrupts()
 {
-    uint32_t rd = get_rd(insn); // get rd
-    uint32_t rs1 = regs.get(get_rs1(insn)); // register rs1
-    uint32_t rs2 = regs.get(get_rs2(insn)); // register rs2
-    regs.set(rd, rs1 << (rs2 % XLEN)); // set rd to rs1<<(Rs2%xlen)
-    pc += 4; // increment pc by 4
-    if (pos)
+    events.run_due(insn_counter);
+    next_check = events.next_due();
+    if (log != nullptr && log->is_replaying())
     {
-        std::string s = render_rtype(insn, "sll");
-        s.resize(instruction_width, ' ');
-        *pos << s << "// "
-             << "x" << rd << " = " << hex0x32(rs1) << " << " << rs2 % XLEN << " = "
-             << hex0x32(regs.get(rd));
+        replay_interrupt();
+        return;
+    }
+    uint32_t pending = mip & mie;
+    if (pending == 0)
+    {
+        return;
+    }
+    // M-mode interrupts are always on below M-mode, the delegated ones are always on in U-mode
+    uint32_t to_m = priv != mmu::priv_m || (mstatus & mstatus_mie) ? pending & ~mideleg : 0;
+    uint32_t to_s = priv == mmu::priv_u || (priv == mmu::priv_s && (mstatus & mstatus_sie)) ? pending & mideleg : 0;
+    pending = to_m != 0 ? to_m : to_s;
+    if (pending == 0)
+    {
+        return;
+    }
+    static constexpr uint32_t priority[] = { 11, 3, 7, 9, 1, 5 }; // MEI, MSI, MTI, SEI, SSI, STI
+    uint32_t cause = 0;
+    for (uint32_t c : priority)
+    {
+        if (pending >> c & 1)
+        {
+            cause = c;
+            break;
+        }
+    }
+    reg_t old_pc = pc;
+    if (log != nullptr)
+    {
+        uint64_t c = cause;
+        log->event(replaylog::rec_interrupt, insn_counter, c);
+    }
+    take_trap(mcause_interrupt | cause, 0);
+    if (show_instructions)
+    {
+        *out << hex_xlen(old_pc) << ": interrupt " << std::dec << cause << ", pc = " << hex0x_xlen(pc)
+                  << std::endl;
     }
 }
 /**
- * Execute slli instruction
- * IT executes the SLLI RV32I instruction, renders the details of what it has simulated.
- * it uses render() helper functions
- * @param uint32_t insn, std::ostream* pos)
+ * Deliver the interrupts of a replayed run at the instructions recorded in the log instead of
+ * looking at mip, and make tick() come back when the next one is due
+ * @param none
  * @return none
  ********************************************************************************/
-void rv32i::exec_slli(uint32_t insn, std::ostream* pos)
+template<uint32_t XLEN>
+void rvhart<XLEN>::replay_interrupt()
 {
-    uint32_t rd = get_rd(insn); // get rd
-    uint32_t rs1 = regs.get(get_rs1(insn)); // register rs1
-    uint32_t imm_i = get_imm_i(insn); // get imm_i
-    regs.set(rd, rs1 << imm_i); // set rd to rs1 << imm_i
-    pc += 4; // increment pc by 4
-    if (pos)
+    uint64_t when = log->next_interrupt();
+    if (when == insn_counter)
     {
-        std::string s = render_itype_shamt(insn, "slli");
-        s.resize(instruction_width, ' ');
-        *pos << s << "// "
-             << "x" << rd << " = " << hex0x32(rs1) << " << " << imm_i << " = "
-             << hex0x32(regs.get(rd));
+        uint64_t cause = 0;
+        log->event(replaylog::rec_interrupt, insn_counter, cause);
+        if (log->failed())
+        {
+            halt = true;
+            return;
+        }
+        reg_t old_pc = pc;
+        take_trap(mcause_interrupt | cause, 0);
+        if (show_instructions)
+        {
+            *out << hex_xlen(old_pc) << ": interrupt " << std::dec << cause << ", pc = " << hex0x_xlen(pc)
+                      << std::endl;
+        }
+        when = log->next_interrupt();
+    }
+    if (when < next_check)
+    {
+        next_check = when;
+    }
+    if (when == event_queue::never && log->is_following())
+    {
+        next_check = 0; // the leader may record an interrupt for the very next instruction
     }
 }
 /**
- * Execute slt instruction
- * IT executes the SLT RV32I instruction, renders the details of what it has simulated.
- * it uses render() helper functions
- * @param uint32_t insn, std::ostream* pos)
+ * Function tick executes 1 instruction
+ * if the halt flag is true than returns without doing anything, else it services due events
+ * and pending interrupts if insn_counter has reached next_check, then it increments
+ * insn_counter. If show_register is true it dumps the sate of hart otherwise does nothing
+ * it fetches an instruction from the memory at address of pc regiser. If show instruction
+ * is true then print the value of pc regiser and fetched instruction, call dcex(insn, out)
+ * to execute instruction and render the instruction and simulation details else call
+ * dcex(insn,nullptr) to execute the instruction without rendering anything
+ * @param none
  * @return none
  ********************************************************************************/
-void rv32i::exec_slt(uint32_t insn, std::ostream* pos)
+template<uint32_t XLEN>
+void rvhart<XLEN>::tick()
 {
-    uint32_t rd = get_rd(insn); // get rd
-    int32_t rs1 = regs.get(get_rs1(insn)); // register rs1
-    int32_t rs2 = regs.get(get_rs2(insn)); // register rs2
-    (rs1 < rs2 ? regs.set(rd, 1) : regs.set(rd, 0)); // set regs 1 or 0 based on condition rs1 < rs2
-    pc += 4;
-    if (pos)
+    if (is_halted())
     {
-        std::string s = render_rtype(insn, "slt");
-        s.resize(instruction_width, ' ');
-        *pos << s << "// "
-             << "x" << rd << " = (" << hex0x32(rs1) << " < " << hex0x32(rs2)
-             << ") ? 1 : 0 = " << hex0x32(regs.get(rd));
+        return; // if halt ==true return
+    }
+    else
+    {
+        if (insn_counter >= next_check)
+        {
+            check_interrupts(); // an event is due or the interrupt state changed
+            if (debug_active)
+            {
+                check_debug();
+            }
+            if (is_halted() || stopped != stop_none)
+            {
+                return;
+            }
+        }
+        uint32_t insn;
+        if (!fetch(insn)) // fetch an instruction, a fault goes to mtvec without counting
+        {
+            if (show_instructions)
+            {
+                *out << hex_xlen(!halt && priv == mmu::priv_s ? sepc : mepc) << ": " << render_trap() << endl;
+            }
+            return;
+        }
+        ++insn_counter; // increment insn_counter
+        if (show_registers == true)
+        {
+            dump(); // if show_register true dump()
+        }
+        if (show_instructions)
+        {
+            *out << hex_xlen(pc) << ": "; // print pc
+            *out << hex32(insn) << "  "; // print instructon
+            dcex(insn, out); // call dcex
+            *out << endl;
+        }
+        else
+        {
+            dcex(insn, nullptr); // if show_instruciton ==false  execute instruction without
+                                 // rendering anything
+        }
     }
 }
 /**
- * Execute slti instruction
- * IT executes the SLTI RV32I instruction, renders the details of what it has simulated.
- * it uses render() helper functions
- * @param uint32_t insn, std::ostream* pos)
+ * run-loop
+ * call start() to reset the hart, then call resume() to tick until the halt flag is set or
+ * limit number of instructions have been executed. When loop is completed finish() prints out
+ * how many instruction where executed
+ * @param uint64_t limit
  * @return none
  ********************************************************************************/
-void rv32i::exec_slti(uint32_t insn, std::ostream* pos)
+template<uint32_t XLEN>
+void rvhart<XLEN>::run(uint64_t limit)
 {
-    uint32_t rd = get_rd(insn); // get rd
-    int32_t rs1 = regs.get(get_rs1(insn)); // register rs1
-    int32_t imm_i = get_imm_i(insn); // get imm_i
-    if (rs1 < imm_i)
+    start();
+    resume(limit);
+    finish();
+}
+/**
+ * run-loop with a warmup boundary
+ * the first fast_forward instructions run in the plain functional engine without tracing, the
+ * next warmup instructions go through the timing model only to warm up its caches and predictor,
+ * then its statistics are cleared and the rest of the run is measured. Switching engines only
+ * switches loops, the hart state stays where it is.
+ * @param uint64_t limit (0 = no limit), uint64_t fast_forward, uint64_t warmup, timing* model
+ * @return none
+ ********************************************************************************/
+template<uint32_t XLEN>
+void rvhart<XLEN>::run(uint64_t limit, uint64_t fast_forward, uint64_t warmup, timing* model)
+{
+    start();
+    uint64_t warm_start = fast_forward;
+    uint64_t measure_start = fast_forward + warmup;
+    if (limit != 0)
     {
-        regs.set(rd, 1);
+        warm_start = std::min(warm_start, limit);
+        measure_start = std::min(measure_start, limit);
     }
-    else
+    if (warm_start > insn_counter)
     {
-        regs.set(rd, 0);
+        // fast-forwarding skips the part of the run nobody wants to look at, -i and -r start
+        // tracing at the boundary
+        bool trace_insns = show_instructions;
+        bool trace_regs = show_registers;
+        show_instructions = false;
+        show_registers = false;
+        resume(warm_start);
+        show_instructions = trace_insns;
+        show_registers = trace_regs;
     }
-    (rs1 < imm_i ? regs.set(rd, 1)
-                 : regs.set(rd, 0)); // set rd to 0 or 1 based on condition rs1 <imm_i
-    pc += 4; // increment pc by 4
-    if (pos)
+    if (measure_start > insn_counter && !is_halted() && stopped == stop_none)
     {
-        std::string s = render_itype_alu(insn, "slti", imm_i);
-        s.resize(instruction_width, ' ');
-        *pos << s << "// "
-             << "x" << rd << " = (" << hex0x32(rs1) << " < " << imm_i
-             << ") ? 1 : 0 = " << hex0x32(regs.get(rd));
+        resume_detailed(measure_start, model);
     }
+    model->reset_stats();
+    if ((limit == 0 || insn_counter < limit) && !is_halted() && stopped == stop_none)
+    {
+        resume_detailed(limit, model);
+    }
+    finish();
 }
 /**
- * Execute sltiu instruction
- * IT executes the SLTIU RV32I instruction, renders the details of what it has simulated.
- * it uses render() helper functions
- * @param uint32_t insn, std::ostream* pos)
+ * Get ready to run the program from the start
+ * call reset to reset pc insn_counter, halt flag and the registers then set register 2 (sp) to the
+ * memory size
+ * @param none
  * @return none
  ********************************************************************************/
-void rv32i::exec_sltiu(uint32_t insn, std::ostream* pos)
+template<uint32_t XLEN>
+void rvhart<XLEN>::start()
 {
-    uint32_t rd = get_rd(insn); // get rd
-    uint32_t rs1 = regs.get(get_rs1(insn)); // register rs1
-    uint32_t imm_i = get_imm_i(insn); // get imm_i
-    (rs1 < imm_i ? regs.set(rd, 1)
-                 : regs.set(rd, 0)); // set rd to 0 or 1 based to condition rs1 < imm_i
-    pc += 4; // increment pc by 4
-    if (pos)
-    {
-        std::string s = render_itype_alu(insn, "sltiu", imm_i);
-        s.resize(instruction_width, ' ');
-        *pos << s << "// "
-             << "x" << rd << " = (" << hex0x32(rs1) << " <U " << imm_i
-             << ") ? 1 : 0 =" << hex0x32(regs.get(rd));
-    }
+    reset(); // rest pc,insnscounter and halt
+    regs.set(2, mem->get_size()); // stack starts at the top of memory
 }
 /**
- * Execute sltu instruction
- * IT executes the SLTU RV32I instruction, renders the details of what it has simulated.
- * it uses render() helper functions
- * @param uint32_t insn, std::ostream* pos)
+ * Enter a loop that will call tick() until the halt flag is set, insn_counter reaches limit or
+ * a breakpoint or watchpoint stops the hart. An instruction sitting on a breakpoint is executed
+ * when resume() starts on it, otherwise the hart could never get past it.
+ * @param uint64_t limit (0 = no limit)
  * @return none
  ********************************************************************************/
-void rv32i::exec_sltu(uint32_t insn, std::ostream* pos)
+template<uint32_t XLEN>
+void rvhart<XLEN>::resume(uint64_t limit)
 {
-    uint32_t rd = get_rd(insn); // get rd
-    uint32_t rs1 = regs.get(get_rs1(insn)); // register rs1
-    uint32_t rs2 = regs.get(get_rs2(insn)); // register rs2
-    (rs1 < rs2 ? regs.set(rd, 1) : regs.set(rd, 0)); // set rd to 1 or 0 based on cond rs1 < rs2
-    pc += 4; // increment pc by 4
-    if (pos)
+    stopped = stop_none;
+    resume_counter = insn_counter;
+    while ((limit == 0 || insn_counter < limit) && !is_halted() && stopped == stop_none)
     {
-        std::string s = render_rtype(insn, "sltu");
-        s.resize(instruction_width, ' ');
-        *pos << s << "// "
-             << "x" << rd << " = (" << hex0x32(rs1) << " <U " << hex0x32(rs2)
-             << ") ? 1 : 0 = " << hex0x32(regs.get(rd));
+        tick(); // cal tick
     }
 }
 /**
- * Execute sra instruction
- * IT executes the SRAI RV32I instruction, renders the details of what it has simulated.
- * it uses render() helper functions
- * @param uint32_t insn, std::ostream* pos)
+ * Like resume() but hands every instruction to the observers, before() ahead of it and after()
+ * once it retired. catch_up() is called first so that the instruction looked at here is the one
+ * that tick() then executes.
+ * @param uint64_t limit (0 = no limit), const std::vector<insn_observer*>& observers
  * @return none
  ********************************************************************************/
-void rv32i::exec_sra(uint32_t insn, std::ostream* pos)
+template<uint32_t XLEN>
+void rvhart<XLEN>::resume_observed(uint64_t limit, const std::vector<insn_observer*>& observers)
 {
-    uint32_t rd = get_rd(insn); // ged rd
-    int32_t rs1 = regs.get(get_rs1(insn)); // register rs1
-    int32_t rs2 = regs.get(get_rs2(insn)); // register rs2
-    regs.set(rd, rs1 >> rs2); // set rd to rs1>>rs2
-    pc += 4; // increment pc by 4
-    if (pos)
+    stopped = stop_none;
+    resume_counter = insn_counter;
+    insn_observer::step_info s;
+    while ((limit == 0 || insn_counter < limit) && !is_halted() && stopped == stop_none)
     {
-        std::string s = render_rtype(insn, "sra");
-        s.resize(instruction_width, ' ');
-        *pos << s << "// "
-             << "x" << rd << " = " << hex0x32(rs1) << " >> " << (rs2 % XLEN) << " = "
-             << hex0x32(regs.get(rd));
+        if (!catch_up())
+        {
+            break;
+        }
+        s.pc = pc;
+        s.insn = peek_insn();
+        s.data_addr = regs.get(get_rs1(s.insn));
+        if (get_opcode(s.insn) == opcode_itype)
+        {
+            s.data_addr += get_imm_i(s.insn);
+        }
+        else if (get_opcode(s.insn) == opcode_stype)
+        {
+            s.data_addr += get_imm_s(s.insn);
+        }
+        bool stop = false;
+        for (insn_observer* o : observers)
+        {
+            if (o->before(this, s))
+            {
+                stop = true; // the observers after it don't see an instruction that won't run
+                break;
+            }
+        }
+        if (stop)
+        {
+            break;
+        }
+        uint64_t old_counter = insn_counter;
+        tick();
+        if (insn_counter != old_counter)
+        {
+            s.next_pc = pc;
+            for (insn_observer* o : observers)
+            {
+                o->after(this, s);
+            }
+        }
     }
 }
 /**
- * Execute srai instruction
- * IT executes the SRAI RV32I instruction, renders the details of what it has simulated.
- * it uses render() helper functions
- * @param uint32_t insn, std::ostream* pos)
+ * Like resume() but every instruction also goes through the timing model
+ * @param uint64_t limit (0 = no limit), timing* model
  * @return none
  ********************************************************************************/
-void rv32i::exec_srai(uint32_t insn, std::ostream* pos)
+template<uint32_t XLEN>
+void rvhart<XLEN>::resume_detailed(uint64_t limit, timing* model)
 {
-    uint32_t rd = get_rd(insn); // get rd
-    int32_t rs1 = regs.get(get_rs1(insn)); // register rs1
-    uint32_t imm_i = get_imm_i(insn); // get imm_i
-    regs.set(rd, rs1 >> imm_i); // set rd to rs1 >>imm_i
-    pc += 4; // increment pc by 4
-    if (pos)
+    stopped = stop_none;
+    resume_counter = insn_counter;
+    while ((limit == 0 || insn_counter < limit) && !is_halted() && stopped == stop_none)
     {
-        std::string s = render_itype_shamt(insn, "srai");
-        s.resize(instruction_width, ' ');
-        *pos << s << "// "
-             << "x" << rd << " = " << hex0x32(rs1) << " >> " << (imm_i & 0X0000001f) << " = "
-             << hex0x32(regs.get(rd));
+        tick_detailed(model);
     }
 }
 /**
- * Execute srl instruction
- * IT executes the SRL RV32I instruction, renders the details of what it has simulated.
- * it uses render() helper functions
- * @param uint32_t insn, std::ostream* pos)
- * @return none
+ * Do the slow part of tick() now if it is due, for the loops that have to look at the next
+ * instruction before tick() executes it (an interrupt may move the pc first)
+ * @param none
+ * @return false if the hart halted or stopped and must not execute anything
  ********************************************************************************/
-void rv32i::exec_srl(uint32_t insn, std::ostream* pos)
+template<uint32_t XLEN>
+bool rvhart<XLEN>::catch_up()
 {
-    uint32_t rd = get_rd(insn); // get rd
-    uint32_t rs1 = regs.get(get_rs1(insn)); // register rs1
-    uint32_t rs2 = regs.get(get_rs2(insn)); // register rs2
-    regs.set(rd, rs1 >> rs2); // set rd to rs1 >> rs2
-    pc += 4; // increment pc by 4
-    if (pos)
+    if (insn_counter >= next_check)
     {
-        std::string s = render_rtype(insn, "srl");
-        s.resize(instruction_width, ' ');
-        *pos << s << "// "
-             << "x" << rd << " = " << hex0x32(rs1) << " >> " << (rs2 % XLEN) << " = "
-             << hex0x32(regs.get(rd));
+        check_interrupts();
+        if (debug_active)
+        {
+            check_debug();
+        }
     }
+    return !is_halted() && stopped == stop_none;
 }
 /**
- * Execute sub instruction
- * IT executes the SUB RV32I instruction, renders the details of what it has simulated.
- * it uses render() helper functions
- * @param uint32_t insn, std::ostream* pos)
+ * Execute one instruction and feed it to the timing model
+ * catch_up() is called first so that the instruction looked at here is the one that tick() then
+ * executes
+ * @param timing* model
  * @return none
  ********************************************************************************/
-void rv32i::exec_sub(uint32_t insn, std::ostream* pos)
+template<uint32_t XLEN>
+void rvhart<XLEN>::tick_detailed(timing* model)
 {
-    uint32_t rd = get_rd(insn); // get rd
-    uint32_t rs1 = regs.get(get_rs1(insn)); // register rs1
-    uint32_t rs2 = regs.get(get_rs2(insn)); // register rs2
-    regs.set(rd, rs1 - rs2); // set rd to rs1-rs2
-    pc += 4; // increment pc by 4
-    if (pos)
+    if (is_halted())
     {
-        std::string s = render_rtype(insn, "sub");
-        s.resize(instruction_width, ' ');
-        *pos << s << "// "
-             << "x" << rd << " = " << hex0x32(rs1) << " - " << hex0x32(rs2) << " = "
-             << hex0x32(rs1 - rs2);
+        return;
+    }
+    if (!catch_up())
+    {
+        return;
+    }
+    reg_t old_pc = pc;
+    uint32_t insn = peek_insn();
+    uint32_t data_addr = regs.get(get_rs1(insn)); // loads, stores and AMOs add their offset below
+    if (get_opcode(insn) == opcode_itype)
+    {
+        data_addr += get_imm_i(insn);
+    }
+    else if (get_opcode(insn) == opcode_stype)
+    {
+        data_addr += get_imm_s(insn);
+    }
+    uint64_t old_counter = insn_counter;
+    tick();
+    if (insn_counter != old_counter)
+    {
+        model->step(old_pc, insn, pc, data_addr);
     }
 }
 /**
- * Execute sw instruction
- * IT executes the SW RV32I instruction, renders the details of what it has simulated.
- * it uses render() helper functions
- * @param uint32_t insn, std::ostream* pos)
+ * Print why the simulation ended and how many instructions were executed
+ * @param none
  * @return none
  ********************************************************************************/
-void rv32i::exec_sw(uint32_t insn, std::ostream* pos)
+template<uint32_t XLEN>
+void rvhart<XLEN>::finish()
 {
-    uint32_t rs1 = regs.get(get_rs1(insn)); // register rs1
-    uint32_t rs2 = regs.get(get_rs2(insn)); // register rs2
-    uint32_t imm_s = get_imm_s(insn); // get imm_s
-    if (pos)
+    if (io != nullptr)
     {
-        std::string s = render_stype(insn, "sw");
-        s.resize(instruction_width, ' ');
-        *pos << s << "// "
-             << "m32(" << hex0x32(rs1) << " + " << hex0x32(imm_s)
-             << ") = " << hex0x32(rs2 & 0xffffffff);
+        io->flush(); // guest output goes before the summary
     }
-    mem->set32((rs1 + imm_s), rs2 & 0xffffffff); // set memory at rs1+imms to rs2 & 0xffffffff
-    pc += 4; // increment pc by 4
+    if (stopped == stop_breakpoint)
+    {
+        *out << "Stopped at breakpoint " << hex0x32(stop_addr) << std::endl;
+    }
+    else if (stopped == stop_watchpoint)
+    {
+        *out << "Stopped by watchpoint on " << (stop_kind == memory::watch_read ? "read" : "write")
+                  << " of " << hex0x32(stop_addr) << ", pc = " << hex0x_xlen(pc) << std::endl;
+    }
+    else if (unhandled)
+    {
+        *out << "Stopped by " << exception_names[mcause] << " with no trap handler, pc = " << hex0x_xlen(mepc)
+                  << std::endl;
+    }
+    if (show_instructions == false)
+    {
+        *out << endl;
+    }
+    *out << insn_counter << " instructions executed" << std::endl;
 }
 /**
- * Execute xor instruction
- * IT executes the XOR RV32I instruction, renders the details of what it has simulated.
- * it uses render() helper functions
- * @param uint32_t insn, std::ostream* pos)
+ * Stop before executing the instruction at addr
+ * @param uint32_t addr
  * @return none
  ********************************************************************************/
-void rv32i::exec_xor(uint32_t insn, std::ostream* pos)
+template<uint32_t XLEN>
+void rvhart<XLEN>::add_breakpoint(uint32_t addr)
 {
-    uint32_t rd = get_rd(insn); // get rd
-    uint32_t rs1 = regs.get(get_rs1(insn)); // register rs1
-    uint32_t rs2 = regs.get(get_rs2(insn)); // register rs2
-    if (pos)
+    if (breakpoint_pages.empty())
     {
-        std::string s = render_rtype(insn, "xor");
-        s.resize(instruction_width, ' ');
-        *pos << s << "// "
-             << "x" << rd << " = " << hex0x32(rs1) << " ^ " << hex0x32(rs2) << " = "
-             << hex0x32(rs1 ^ rs2);
+        breakpoint_pages.resize((1u << 20) / 64);
     }
-    regs.set(rd, rs1 ^ rs2); // set rd to rs1^rs2
-    pc += 4; // increment pc by 4
+    breakpoints.push_back(addr);
+    breakpoint_pages[(addr >> 12) / 64] |= 1ull << ((addr >> 12) % 64);
+    update_debug();
 }
 /**
- * Execute xori instruction
- * IT executes the xori RV32I instruction, renders the details of what it has simulated.
- * it uses render() helper functions
- * @param uint32_t insn, std::ostream* pos)
- * @return none
+ * Remove a breakpoint set by add_breakpoint()
+ * @param uint32_t addr
+ * @return false if there was no breakpoint at addr
  ********************************************************************************/
-void rv32i::exec_xori(uint32_t insn, std::ostream* pos)
+template<uint32_t XLEN>
+bool rvhart<XLEN>::remove_breakpoint(uint32_t addr)
 {
-    uint32_t rd = get_rd(insn); // get rd
-    uint32_t rs1 = regs.get(get_rs1(insn)); // register rs1
-    uint32_t imm_i = get_imm_i(insn); // get imm_i
-    if (pos)
+    auto it = std::find(breakpoints.begin(), breakpoints.end(), addr);
+    if (it == breakpoints.end())
     {
-        std::string s = render_itype_alu(insn, "xori", imm_i);
-        ;
-        s.resize(instruction_width, ' ');
-        *pos << s << "// "
-             << "x" << rd << " = " << hex0x32(rs1) << " ^ " << hex0x32(imm_i) << " = "
-             << hex0x32(rs1 ^ imm_i);
+        return false;
     }
-    regs.set(rd, (rs1 ^ imm_i)); // set rd to rs1 ^ imm_i
-    pc += 4; // incremet pc by 4
+    breakpoints.erase(it);
+    std::fill(breakpoint_pages.begin(), breakpoint_pages.end(), 0);
+    for (uint32_t a : breakpoints)
+    {
+        breakpoint_pages[(a >> 12) / 64] |= 1ull << ((a >> 12) % 64);
+    }
+    update_debug();
+    return true;
 }
 /**
- * Execute fence instruction
- * IT executes the fence RV32I instruction, renders the details of what it has simulated.
- * it uses render() helper functions
- * @param uint32_t insn, std::ostream* pos)
- * @return none
+ * Stop after an instruction that reads or writes (depending on kind) any of the len bytes at addr
+ * @param uint32_t addr, uint32_t len, uint32_t kind (memory::watch_read and/or memory::watch_write)
+ * @return false if the watchpoint can't be set
  ********************************************************************************/
-void rv32i::exec_fence(uint32_t insn, std::ostream* pos)
+template<uint32_t XLEN>
+bool rvhart<XLEN>::add_watchpoint(uint32_t addr, uint32_t len, uint32_t kind)
 {
-    if (pos)
-    {
-        std::string s = render_fence(insn);
-        s.resize(instruction_width, ' ');
-        *pos << s << "// fence ";
-    }
-    pc += 4; // incremet pc by 4
+    bool ok = mem->add_watch(addr, len, kind);
+    update_debug();
+    return ok;
 }
 /**
- * Execute fence instruction
- * IT executes the fence RV32I instruction, renders the details of what it has simulated.
- * it uses render() helper functions
- * @param uint32_t insn, std::ostream* pos)
- * @return none
+ * Remove a watchpoint set by add_watchpoint()
+ * @param uint32_t addr, uint32_t len, uint32_t kind
+ * @return false if there was no such watchpoint
  ********************************************************************************/
-void rv32i::exec_ecall(uint32_t insn, std::ostream* pos)
+template<uint32_t XLEN>
+bool rvhart<XLEN>::remove_watchpoint(uint32_t addr, uint32_t len, uint32_t kind)
 {
-    if (pos)
-    {
-        std::string s = render_ecall();
-    }
-    pc += 4; // incremet pc by 4
+    bool ok = mem->remove_watch(addr, len, kind);
+    update_debug();
+    return ok;
 }
 /**
- * Execute ebreak instruction
- * IT executes the EBREAK RV32I instruction, renders the details of what it has simulated.
- * it uses render() helper functions
- * @param uint32_t insn, std::ostream* pos)
+ * Make resume() return before the next instruction
+ * meant to be called from an event_target::fire() on the hart's own thread, which is how a
+ * debugger polling its connection interrupts a running hart
+ * @param none
  * @return none
  ********************************************************************************/
-void rv32i::exec_ebreak(uint32_t insn, std::ostream* pos)
+template<uint32_t XLEN>
+void rvhart<XLEN>::request_stop()
 {
-    if (pos)
-    {
-        std::string s = render_ebreak();
-        s.resize(instruction_width, ' ');
-        *pos << s << "// HALT \n";
-    }
-    halt = true; // set halt flag to ture
-    std::cout << "Execution terminated by EBREAK instruction";
+    stopped = stop_request;
 }
 /**
- * Function tick executes 1 instruction
- * if the halt flag is true than returns without doing anything, else it increments
- * insn_counter. If show_register is true it dumps the sate of hart otherwise does nothing
- * it fetches an instruction from the memory at address of pc regiser. If show instruction
- * is true then print the value of pc regiser and fetched instruction, call dcex(insn,&std::cout)
- * to execute instruction and render the instruction and simulation details else call
- * dcex(insn,nullptr) to execute the instruction without rendering anything
+ * getter get_stop_reason
+ * @param none
+ * @return why the last resume() stopped (stop_none if it ran into the limit or a halt)
+ ********************************************************************************/
+template<uint32_t XLEN>
+typename rvhart<XLEN>::stop_reason rvhart<XLEN>::get_stop_reason() const
+{
+    return stopped;
+}
+/**
+ * getter get_stop_addr
+ * @param none
+ * @return the breakpoint or the watched data address of the last stop
+ ********************************************************************************/
+template<uint32_t XLEN>
+uint32_t rvhart<XLEN>::get_stop_addr() const
+{
+    return stop_addr;
+}
+/**
+ * getter get_stop_kind
+ * @param none
+ * @return memory::watch_read or memory::watch_write for a watchpoint stop
+ ********************************************************************************/
+template<uint32_t XLEN>
+uint32_t rvhart<XLEN>::get_stop_kind() const
+{
+    return stop_kind;
+}
+/**
+ * Recompute debug_active after breakpoints or watchpoints changed
+ * while it is set tick() goes through its slow part before every instruction, with no
+ * breakpoints and watchpoints the debugger costs nothing. The TLB is emptied too.
  * @param none
  * @return none
  ********************************************************************************/
-void rv32i::tick()
+template<uint32_t XLEN>
+void rvhart<XLEN>::update_debug()
 {
-    if (is_halted())
-    {
-        return; // if halt ==true return
-    }
-    else
-    {
-        ++insn_counter; // increment insn_counter
-        if (show_registers == true)
-        {
-            dump(); // if show_register true dump()
-        }
-        uint32_t insn = mem->get32(pc); // fetch an instruction
-        if (show_instructions)
-        {
-            std::cout << hex32(pc) << ": "; // print pc
-            std::cout << hex32(insn) << "  "; // print instructon
-            dcex(insn, &std::cout); // call dcex
-            std::cout << endl;
-        }
-        else
-        {
-            dcex(insn, nullptr); // if show_instruciton ==false  execute instruction without
-                                 // rendering anything
-        }
-    }
+    debug_active = !breakpoints.empty() || mem->watching();
+    next_check = 0;
+    vm.flush(); // watched pages must not be reached through the host pointers of the TLB
 }
 /**
- * run-loop
- * call reset to reset pc insn_counter and halt flag then set register 2 to 0x00000100
- * Enter a loop that will cal tick() until the halt flag is set or limit number of
- * instructions have been executed. When loop is completed print out how many
- * instruction where executed
- * @param uint64_t limit
+ * Check for a watched access by the last instruction and for a breakpoint on the next one
+ * the page bitmap rules out almost every pc with one test before the breakpoint list is searched
+ * @param none
  * @return none
  ********************************************************************************/
-void rv32i::run(uint64_t limit)
+template<uint32_t XLEN>
+void rvhart<XLEN>::check_debug()
 {
-    reset(); // rest pc,insnscounter and halt
-    regs.set(2, mem->get_size()); // set reg 2 to 0x00000100
-    while ((limit == 0 || (limit != 0 && insn_counter < limit)) && !is_halted())
+    next_check = 0; // look again before the next instruction
+    uint32_t addr, kind;
+    if (mem->take_watch_hit(addr, kind) && insn_counter != resume_counter)
     {
-        tick(); // cal tick
+        stopped = stop_watchpoint;
+        stop_addr = addr;
+        stop_kind = kind;
+        return;
     }
-    if (show_instructions == false)
+    uint32_t page = pc >> 12;
+    if (insn_counter != resume_counter && !breakpoints.empty()
+        && (breakpoint_pages[page / 64] >> (page % 64) & 1)
+        && std::find(breakpoints.begin(), breakpoints.end(), pc) != breakpoints.end())
     {
-        std::cout << endl;
+        stopped = stop_breakpoint;
+        stop_addr = pc;
     }
-    std::cout << insn_counter << " instructions executed" << std::endl;
 }
+
+// rv32i has everything, rv64i what main() runs it with (the traces, gdb, cosim and the
+// interrupt controllers take an rv32i)
+template class rvhart<32>;
+template rvhart<64>::rvhart(memory* m);
+template void rvhart<64>::disasm(void);
+template void rvhart<64>::reset();
+template void rvhart<64>::dump() const;
+template void rvhart<64>::set_show_instructions(bool b);
+template void rvhart<64>::set_show_registers(bool b);
+template void rvhart<64>::set_register(uint32_t r, sreg_t val);
+template rvhart<64>::sreg_t rvhart<64>::get_register(uint32_t r) const;
+template rvhart<64>::reg_t rvhart<64>::get_pc() const;
+template void rvhart<64>::set_pc(reg_t addr);
+template void rvhart<64>::set_hostio(hostio* h);
+template void rvhart<64>::set_output(std::ostream* os);
+template void rvhart<64>::set_insns_per_tick(uint32_t n);
+template bool rvhart<64>::set_vlen(uint32_t bits);
+template bool rvhart<64>::set_vector_simd(vregfile::simd_level level);
+template uint64_t rvhart<64>::get_insn_counter() const;
+template bool rvhart<64>::is_halted() const;
+template void rvhart<64>::tick();
+template void rvhart<64>::run(uint64_t limit);
+template void rvhart<64>::start();
+template void rvhart<64>::resume(uint64_t limit);
+template void rvhart<64>::finish();
@@ -2,14 +2,35 @@
 #ifndef RV32I_H
 #define RV32I_H
 #include "registerfile.h"
+#include "vregfile.h"
+#include "mmu.h"
 #include "hex.h"
 #include "memory.h"
-class rv32i
+#include "hostio.h"
+#include "eventqueue.h"
+#include "replaylog.h"
+#include "timing.h"
+#include "insnobserver.h"
+
+#include <vector>
+#include <type_traits>
+/**
+ * A hart with XLEN-bit registers, rv32i (RV32IA) or rv64i (RV64IA), both with Zba, Zbb and a
+ * subset of V. The width is fixed at compile time so the interpreter has no width checks, both
+ * are built from rv32i.cpp. Both have M, S and U-mode, rv32i translates addresses with Sv32 below
+ * M-mode, rv64i only has Bare mode. Exceptions are precise traps, an exception with no handler
+ * (the trap vector is still 0, where every program starts) halts the hart.
+ ********************************************************************************/
+template<uint32_t XLEN>
+class rvhart
 {
 public:
+    // the value of a register, unsigned and signed
+    typedef typename std::conditional<XLEN == 64, uint64_t, uint32_t>::type reg_t;
+    typedef typename basic_registerfile<XLEN>::sreg_t sreg_t;
     bool show_instructions = false; 
     bool show_registers= false;
-    rv32i(memory* m);
+    rvhart(memory* m);
     void disasm(void);
     std::string decode(uint32_t insn) const; // function decode prototype
     static uint32_t get_opcode(uint32_t insn); 
@@ -37,7 +58,16 @@ public:
     std::string render_fence(uint32_t insn) const; 
     std::string render_ecall() const; 
     std::string render_ebreak() const; 
-    static constexpr uint32_t XLEN = 32; 
+    std::string render_lr(uint32_t insn, const char* mnemonic) const; 
+    std::string render_amo(uint32_t insn, const char* mnemonic) const; 
+    std::string render_csrrx(uint32_t insn, const char* mnemonic) const; 
+    std::string render_csrrxi(uint32_t insn, const char* mnemonic) const; 
+    std::string render_mret() const; 
+    std::string render_sret() const; 
+    std::string render_wfi() const; 
+    std::string render_unary(uint32_t insn, const char* mnemonic) const; 
+    std::string render_vector(uint32_t insn) const; 
+    std::string render_sfence_vma(uint32_t insn) const; 
     void exec_illegal_insn(uint32_t insn, std::ostream* pos); 
     void exec_lui(uint32_t insn, std::ostream* pos) ; 
     void exec_auipc(uint32_t insn, std::ostream* pos) ; 
@@ -79,20 +109,200 @@ public:
     void exec_fence(uint32_t insn,std::ostream* pos); 
     void exec_ecall(uint32_t insn,std::ostream* pos); 
     void exec_ebreak(uint32_t insn,std::ostream* pos); 
+    void exec_lr_w(uint32_t insn, std::ostream* pos); 
+    void exec_sc_w(uint32_t insn, std::ostream* pos); 
+    void exec_amoswap_w(uint32_t insn, std::ostream* pos); 
+    void exec_amoadd_w(uint32_t insn, std::ostream* pos); 
+    void exec_amoxor_w(uint32_t insn, std::ostream* pos); 
+    void exec_amoand_w(uint32_t insn, std::ostream* pos); 
+    void exec_amoor_w(uint32_t insn, std::ostream* pos); 
+    void exec_amomin_w(uint32_t insn, std::ostream* pos); 
+    void exec_amomax_w(uint32_t insn, std::ostream* pos); 
+    void exec_amominu_w(uint32_t insn, std::ostream* pos); 
+    void exec_amomaxu_w(uint32_t insn, std::ostream* pos); 
+    void exec_csrrw(uint32_t insn, std::ostream* pos); 
+    void exec_csrrs(uint32_t insn, std::ostream* pos); 
+    void exec_csrrc(uint32_t insn, std::ostream* pos); 
+    void exec_csrrwi(uint32_t insn, std::ostream* pos); 
+    void exec_csrrsi(uint32_t insn, std::ostream* pos); 
+    void exec_csrrci(uint32_t insn, std::ostream* pos); 
+    void exec_mret(uint32_t insn, std::ostream* pos); 
+    void exec_sret(uint32_t insn, std::ostream* pos); 
+    void exec_wfi(uint32_t insn, std::ostream* pos); 
+    void exec_sfence_vma(uint32_t insn, std::ostream* pos); 
+    // RV64I only
+    void exec_ld(uint32_t insn, std::ostream* pos); 
+    void exec_lwu(uint32_t insn, std::ostream* pos); 
+    void exec_sd(uint32_t insn, std::ostream* pos); 
+    void exec_addiw(uint32_t insn, std::ostream* pos); 
+    void exec_slliw(uint32_t insn, std::ostream* pos); 
+    void exec_srliw(uint32_t insn, std::ostream* pos); 
+    void exec_sraiw(uint32_t insn, std::ostream* pos); 
+    void exec_addw(uint32_t insn, std::ostream* pos); 
+    void exec_subw(uint32_t insn, std::ostream* pos); 
+    void exec_sllw(uint32_t insn, std::ostream* pos); 
+    void exec_srlw(uint32_t insn, std::ostream* pos); 
+    void exec_sraw(uint32_t insn, std::ostream* pos); 
+    // Zba and Zbb
+    void exec_sh1add(uint32_t insn, std::ostream* pos); 
+    void exec_sh2add(uint32_t insn, std::ostream* pos); 
+    void exec_sh3add(uint32_t insn, std::ostream* pos); 
+    void exec_andn(uint32_t insn, std::ostream* pos); 
+    void exec_orn(uint32_t insn, std::ostream* pos); 
+    void exec_xnor(uint32_t insn, std::ostream* pos); 
+    void exec_min(uint32_t insn, std::ostream* pos); 
+    void exec_minu(uint32_t insn, std::ostream* pos); 
+    void exec_max(uint32_t insn, std::ostream* pos); 
+    void exec_maxu(uint32_t insn, std::ostream* pos); 
+    void exec_rol(uint32_t insn, std::ostream* pos); 
+    void exec_ror(uint32_t insn, std::ostream* pos); 
+    void exec_rori(uint32_t insn, std::ostream* pos); 
+    void exec_clz(uint32_t insn, std::ostream* pos); 
+    void exec_ctz(uint32_t insn, std::ostream* pos); 
+    void exec_cpop(uint32_t insn, std::ostream* pos); 
+    void exec_sext_b(uint32_t insn, std::ostream* pos); 
+    void exec_sext_h(uint32_t insn, std::ostream* pos); 
+    void exec_zext_h(uint32_t insn, std::ostream* pos); 
+    void exec_orc_b(uint32_t insn, std::ostream* pos); 
+    void exec_rev8(uint32_t insn, std::ostream* pos); 
+    void exec_bitmanip(uint32_t insn, std::ostream* pos, reg_t val); 
+    // V subset
+    void exec_vsetvl(uint32_t insn, std::ostream* pos); 
+    void exec_vload(uint32_t insn, std::ostream* pos); 
+    void exec_vstore(uint32_t insn, std::ostream* pos); 
+    void exec_varith(uint32_t insn, std::ostream* pos); 
+    void exec_vred(uint32_t insn, std::ostream* pos); 
+    void exec_vmv(uint32_t insn, std::ostream* pos); 
+    void exec_vmv_x_s(uint32_t insn, std::ostream* pos); 
+    void exec_vmv_s_x(uint32_t insn, std::ostream* pos); 
+    // interrupt pending bits in mip
+    static constexpr uint32_t mip_msip = 1 << 3; 
+    static constexpr uint32_t mip_mtip = 1 << 7; 
+    static constexpr uint32_t mip_meip = 1 << 11; 
+    static constexpr uint32_t mip_ssip = 1 << 1; // the S-mode bits are written by M-mode software
+    static constexpr uint32_t mip_stip = 1 << 5; 
+    static constexpr uint32_t mip_seip = 1 << 9; 
     void reset(); // reset prototype
     void dump() const; // dump prototype    
     void set_show_instructions(bool b); 
     void set_show_registers(bool b); 
+    void set_register(uint32_t r, sreg_t val); 
+    sreg_t get_register(uint32_t r) const; 
+    reg_t get_pc() const; 
+    void set_pc(reg_t addr); 
+    void set_hostio(hostio* h); 
+    void set_output(std::ostream* os); 
+    void set_log(replaylog* l); 
+    void set_hartid(uint32_t id); 
+    void set_insns_per_tick(uint32_t n); 
+    bool set_vlen(uint32_t bits); 
+    bool set_vector_simd(vregfile::simd_level level); 
+    uint64_t get_insn_counter() const; 
+    uint64_t get_mtime() const; 
+    void set_mtime(uint64_t t); 
+    uint64_t mtime_to_insn(uint64_t t) const; 
+    void schedule_event(uint64_t when, event_target* target); 
+    void set_interrupt_pending(uint32_t bit, bool level); 
     bool is_halted() const; 
     void dcex(uint32_t insn, std::ostream*); //dcex prototype
     void tick(); 
     void run(uint64_t limit); //run prototype
+    void run(uint64_t limit, uint64_t fast_forward, uint64_t warmup, timing* model); 
+    void start(); 
+    void resume(uint64_t limit); 
+    void resume_detailed(uint64_t limit, timing* model); 
+    void resume_observed(uint64_t limit, const std::vector<insn_observer*>& observers); 
+    void tick_detailed(timing* model); 
+    void finish(); 
+    // why resume() returned before the limit or a halt
+    enum stop_reason { stop_none, stop_breakpoint, stop_watchpoint, stop_request };
+    void add_breakpoint(uint32_t addr); 
+    bool remove_breakpoint(uint32_t addr); 
+    bool add_watchpoint(uint32_t addr, uint32_t len, uint32_t kind); 
+    bool remove_watchpoint(uint32_t addr, uint32_t len, uint32_t kind); 
+    void request_stop(); 
+    stop_reason get_stop_reason() const; 
+    uint32_t get_stop_addr() const; 
+    uint32_t get_stop_kind() const; 
 private:
     memory* mem; // pointer pointing to memory object
-    uint32_t pc = 0; // contains the address of instruction being decoded
-    registerfile regs; 
+    reg_t pc = 0; // contains the address of instruction being decoded
+    basic_registerfile<XLEN> regs; 
+    vregfile vec; // vector registers, vl and vtype
+    mmu vm; // satp, the page-table walk and the TLB
+    uint32_t priv = mmu::priv_m; // privilege level
     bool halt = false; 
     uint64_t insn_counter; // insn_counter to keep track of how many instructins are executed 
+    std::ostream* out = &std::cout; // where the hart prints
+    hostio* io = nullptr; // services ecall, when nullptr ecall does nothing
+    replaylog* log = nullptr; // records nondeterministic inputs, or replays them instead of asking io
+    bool reservation_valid = false; // set by lr.w, cleared by sc.w
+    uint32_t reservation_addr = 0; // address reserved by the last lr.w
+    uint32_t reservation_value = 0; // value observed by the last lr.w
+    void exec_amo(uint32_t insn, std::ostream* pos, memory::amo_op op, const char* mnemonic); 
+    // machine-mode CSRs
+    uint32_t mstatus = 0; 
+    uint32_t mie = 0; 
+    uint32_t mip = 0; 
+    reg_t mtvec = 0; 
+    reg_t mscratch = 0; 
+    reg_t mepc = 0; 
+    reg_t mcause = 0; 
+    reg_t mtval = 0; 
+    static constexpr reg_t mcause_interrupt = (reg_t)1 << (XLEN - 1); 
+    uint32_t medeleg = 0; // exceptions below M-mode that go to S-mode
+    uint32_t mideleg = 0; // the same for interrupts
+    uint32_t mcounteren = 0; // counters S-mode may read
+    // supervisor CSRs, sstatus, sie and sip are views of mstatus, mie and mip
+    reg_t stvec = 0; 
+    reg_t sscratch = 0; 
+    reg_t sepc = 0; 
+    reg_t scause = 0; 
+    reg_t stval = 0; 
+    uint32_t scounteren = 0; // counters U-mode may read
+    bool unhandled = false; // halted on an exception with no handler, mcause says which
+    uint32_t hartid = 0; // value of mhartid
+    uint32_t insns_per_tick = 1; // instructions per mtime tick
+    int64_t mtime_offset = 0; // set by writes to mtime
+    event_queue events; // timer and device events keyed on insn_counter
+    uint64_t next_check = 0; // tick() looks at events and interrupts when insn_counter gets here
+    void check_interrupts(); 
+    void replay_interrupt(); 
+    // debugging, all of it is looked at from the slow part of tick() only
+    bool debug_active = false; // breakpoints or watchpoints are set, check before every insn
+    std::vector<uint32_t> breakpoints; 
+    std::vector<uint64_t> breakpoint_pages; // one bit per 4 KiB page with a breakpoint on it
+    stop_reason stopped = stop_none; 
+    uint32_t stop_addr = 0; // breakpoint or watched data address
+    uint32_t stop_kind = 0; // memory::watch_read or memory::watch_write
+    uint64_t resume_counter = 0; // insn_counter when resume() was called
+    void check_debug(); 
+    bool catch_up(); 
+    void update_debug(); 
+    void take_trap(reg_t cause, reg_t tval); 
+    void take_exception(uint32_t cause, reg_t tval); 
+    void branch_misaligned(int32_t imm_b, std::ostream* pos); 
+    void update_privilege(); 
+    bool translate(reg_t addr, mmu::access_type access, uint32_t& paddr); 
+    static bool beyond_4g(reg_t addr); 
+    bool fetch(uint32_t& insn); 
+    bool fetch_slow(uint32_t& insn); 
+    uint32_t peek_insn(); 
+    template<typename T> bool read_mem(reg_t addr, T& val); 
+    template<typename T> bool write_mem(reg_t addr, T val); 
+    bool read_slow(uint32_t addr, uint32_t size, uint64_t& val); 
+    bool write_slow(uint32_t addr, uint32_t size, uint64_t val); 
+    bool vector_access(uint32_t v, reg_t addr, int32_t stride, uint32_t eew, mmu::access_type access); 
+    void render_fault(std::ostream* pos, const std::string& s) const; 
+    std::string render_trap() const; 
+    bool csr_accessible(uint32_t csr, bool write) const; 
+    bool csr_read(uint32_t csr, reg_t& val) const; 
+    bool csr_write(uint32_t csr, reg_t val); 
+    void exec_csr(uint32_t insn, std::ostream* pos, const char* mnemonic); 
+    static std::string hex_xlen(reg_t v); 
+    static std::string hex0x_xlen(reg_t v); 
 };
+typedef rvhart<32> rv32i;
+typedef rvhart<64> rv64i;
 
 #endif
\ No newline at end of file
@@ -0,0 +1,321 @@
+
+#include "rv32iapi.h"
+#include "memory.h"
+#include "rv32i.h"
+#include "hostio.h"
+#include <memory>
+#include <string.h>
+#include <vector>
+
+/**
+ * Stream buffer that hands everything written to it to a rv32i_sink, nothing is passed on when
+ * the sink is NULL
+ ********************************************************************************/
+class sink_buffer : public std::streambuf
+{
+public:
+    rv32i_sink sink = nullptr; 
+    void* ctx = nullptr; 
+protected:
+    int overflow(int c) override
+    {
+        if (c != traits_type::eof() && sink != nullptr)
+        {
+            char ch = c;
+            sink(ctx, &ch, 1);
+        }
+        return c;
+    }
+    std::streamsize xsputn(const char* s, std::streamsize n) override
+    {
+        if (sink != nullptr)
+            sink(ctx, s, n);
+        return n;
+    }
+};
+
+/**
+ * Hands every instruction rv32i_run_for() is about to execute to the rv32i_insn_hook, a nonzero
+ * return of the hook stops the run before that instruction
+ ********************************************************************************/
+class hook_observer : public insn_observer
+{
+public:
+    rv32i_insn_hook hook; 
+    void* ctx; 
+    hook_observer(rv32i_insn_hook h, void* c) : hook(h), ctx(c) {}
+    bool before(rv32i*, const step_info& s) override
+    {
+        return hook(ctx, s.pc, s.insn) != 0;
+    }
+};
+
+struct rv32i_sim
+{
+    memory mem; 
+    rv32i hart; 
+    std::unique_ptr<hostio> io; // made again by every reset, it keeps the program break and exit state
+    sink_buffer sim_buf; 
+    sink_buffer guest_buf; 
+    std::ostream sim_out; 
+    std::ostream guest_out; 
+    bool own_guest_output = false; // guest_out is used instead of the host's stdout and stderr
+    rv32i_insn_hook hook = nullptr; 
+    void* hook_ctx = nullptr; 
+    rv32i_sim(uint32_t size) : mem(size), hart(&mem), sim_out(&sim_buf), guest_out(&guest_buf) {}
+};
+
+/**
+ * Create a simulator with mem_size bytes of memory, its output goes to std::cout until
+ * rv32i_set_output() is called
+ * @param uint32_t mem_size
+ * @return the simulator, free it with rv32i_destroy()
+ ********************************************************************************/
+rv32i_sim* rv32i_create(uint32_t mem_size)
+{
+    rv32i_sim* sim = new rv32i_sim(mem_size);
+    rv32i_reset(sim);
+    return sim;
+}
+
+/**
+ * Free a simulator made by rv32i_create()
+ * @param rv32i_sim* sim
+ * @return none
+ ********************************************************************************/
+void rv32i_destroy(rv32i_sim* sim)
+{
+    sim->io->flush();
+    delete sim;
+}
+
+/**
+ * Load a binary file at address 0 and reset the hart
+ * @param rv32i_sim* sim, const char* fname
+ * @return 0 on success, -1 if the file can't be read or does not fit
+ ********************************************************************************/
+int rv32i_load_file(rv32i_sim* sim, const char* fname)
+{
+    if (!sim->mem.load_file(fname))
+        return -1;
+    rv32i_reset(sim);
+    return 0;
+}
+
+/**
+ * Copy a program image to address 0 and reset the hart
+ * @param rv32i_sim* sim, const void* image, uint32_t len
+ * @return 0 on success, -1 if it does not fit
+ ********************************************************************************/
+int rv32i_load(rv32i_sim* sim, const void* image, uint32_t len)
+{
+    if (!sim->mem.load_image(static_cast<const uint8_t*>(image), len))
+        return -1;
+    rv32i_reset(sim);
+    return 0;
+}
+
+/**
+ * Get ready to run the loaded program from address 0 as rv32i::start() does: the registers and
+ * devices get their reset values and the syscall state is fresh (the program break starts after
+ * the image again, files the program left open are closed). The memory is left alone.
+ * @param rv32i_sim* sim
+ * @return none
+ ********************************************************************************/
+void rv32i_reset(rv32i_sim* sim)
+{
+    if (sim->io)
+        sim->io->flush();
+    sim->io.reset(new hostio(&sim->mem, (sim->mem.get_image_size() + 15) & 0xfffffff0));
+    if (sim->own_guest_output)
+        sim->io->set_output(&sim->guest_out, &sim->guest_out);
+    sim->hart.set_hostio(sim->io.get());
+    sim->mem.reset_devices();
+    sim->hart.start();
+}
+
+/**
+ * Remember the memory as it is now (normally right after loading) for rv32i_restore()
+ * @param rv32i_sim* sim
+ * @return none
+ ********************************************************************************/
+void rv32i_snapshot(rv32i_sim* sim)
+{
+    sim->mem.snapshot();
+}
+
+/**
+ * Put the memory back to the last rv32i_snapshot() and reset the hart, only the pages written
+ * since then are copied so this is cheap for short runs
+ * @param rv32i_sim* sim
+ * @return the number of pages copied back
+ ********************************************************************************/
+uint32_t rv32i_restore(rv32i_sim* sim)
+{
+    uint32_t pages = sim->mem.restore();
+    rv32i_reset(sim);
+    return pages;
+}
+
+/**
+ * Run at most n instructions, fewer if the hart halts or the instruction hook says stop
+ * @param rv32i_sim* sim, uint64_t n
+ * @return the number of instructions executed
+ ********************************************************************************/
+uint64_t rv32i_run_for(rv32i_sim* sim, uint64_t n)
+{
+    uint64_t first = sim->hart.get_insn_counter();
+    uint64_t limit = first + n;
+    if (n == 0)
+    {
+        return 0; // resume(0) would run without a limit
+    }
+    if (sim->hook == nullptr)
+    {
+        sim->hart.resume(limit);
+    }
+    else
+    {
+        hook_observer observer(sim->hook, sim->hook_ctx);
+        std::vector<insn_observer*> observers { &observer };
+        sim->hart.resume_observed(limit, observers);
+    }
+    sim->io->flush();
+    return sim->hart.get_insn_counter() - first;
+}
+
+/**
+ * getter rv32i_halted
+ * @param const rv32i_sim* sim
+ * @return nonzero once the hart has halted (ebreak, exit, illegal instruction...)
+ ********************************************************************************/
+int rv32i_halted(const rv32i_sim* sim)
+{
+    return sim->hart.is_halted();
+}
+
+/**
+ * getter rv32i_exit_code
+ * @param const rv32i_sim* sim
+ * @return the status the guest passed to exit(), 0 if it did not call it
+ ********************************************************************************/
+int rv32i_exit_code(const rv32i_sim* sim)
+{
+    return sim->io->has_exited() ? sim->io->get_exit_code() : 0;
+}
+
+/**
+ * getter rv32i_insn_count
+ * @param const rv32i_sim* sim
+ * @return instructions executed since the last reset
+ ********************************************************************************/
+uint64_t rv32i_insn_count(const rv32i_sim* sim)
+{
+    return sim->hart.get_insn_counter();
+}
+
+/**
+ * getter rv32i_get_reg
+ * @param const rv32i_sim* sim, uint32_t r
+ * @return the value of register r
+ ********************************************************************************/
+uint32_t rv32i_get_reg(const rv32i_sim* sim, uint32_t r)
+{
+    return sim->hart.get_register(r);
+}
+
+/**
+ * setter rv32i_set_reg, writes to x0 are ignored
+ * @param rv32i_sim* sim, uint32_t r, uint32_t val
+ * @return none
+ ********************************************************************************/
+void rv32i_set_reg(rv32i_sim* sim, uint32_t r, uint32_t val)
+{
+    sim->hart.set_register(r, val);
+}
+
+/**
+ * getter rv32i_get_pc
+ * @param const rv32i_sim* sim
+ * @return the pc
+ ********************************************************************************/
+uint32_t rv32i_get_pc(const rv32i_sim* sim)
+{
+    return sim->hart.get_pc();
+}
+
+/**
+ * setter rv32i_set_pc
+ * @param rv32i_sim* sim, uint32_t pc
+ * @return none
+ ********************************************************************************/
+void rv32i_set_pc(rv32i_sim* sim, uint32_t pc)
+{
+    sim->hart.set_pc(pc);
+}
+
+/**
+ * Copy len bytes of simulated memory at addr to buf
+ * @param rv32i_sim* sim, uint32_t addr, void* buf, uint32_t len
+ * @return 0 on success, -1 if the range is not all memory
+ ********************************************************************************/
+int rv32i_read_mem(rv32i_sim* sim, uint32_t addr, void* buf, uint32_t len)
+{
+    const uint8_t* p = sim->mem.get_ptr(addr, len);
+    if (p == nullptr)
+        return -1;
+    memcpy(buf, p, len);
+    return 0;
+}
+
+/**
+ * Copy len bytes from buf to the simulated memory at addr
+ * @param rv32i_sim* sim, uint32_t addr, const void* buf, uint32_t len
+ * @return 0 on success, -1 if the range is not all memory
+ ********************************************************************************/
+int rv32i_write_mem(rv32i_sim* sim, uint32_t addr, const void* buf, uint32_t len)
+{
+    uint8_t* p = sim->mem.get_ptr(addr, len);
+    if (p == nullptr)
+        return -1;
+    memcpy(p, buf, len);
+    return 0;
+}
+
+/**
+ * Send what the simulator prints (halt messages, traces, warnings) to sink
+ * @param rv32i_sim* sim, rv32i_sink sink (NULL to throw it away), void* ctx (passed to sink)
+ * @return none
+ ********************************************************************************/
+void rv32i_set_output(rv32i_sim* sim, rv32i_sink sink, void* ctx)
+{
+    sim->sim_buf.sink = sink;
+    sim->sim_buf.ctx = ctx;
+    sim->hart.set_output(&sim->sim_out);
+    sim->mem.set_output(&sim->sim_out);
+}
+
+/**
+ * Send what the guest writes to its stdout and stderr to sink
+ * @param rv32i_sim* sim, rv32i_sink sink (NULL to throw it away), void* ctx (passed to sink)
+ * @return none
+ ********************************************************************************/
+void rv32i_set_guest_output(rv32i_sim* sim, rv32i_sink sink, void* ctx)
+{
+    sim->guest_buf.sink = sink;
+    sim->guest_buf.ctx = ctx;
+    sim->own_guest_output = true;
+    sim->io->set_output(&sim->guest_out, &sim->guest_out);
+}
+
+/**
+ * Have hook called before every instruction rv32i_run_for() executes, this takes the hart off
+ * its fast loop so leave it unset when it is not needed
+ * @param rv32i_sim* sim, rv32i_insn_hook hook (NULL to remove it), void* ctx (passed to hook)
+ * @return none
+ ********************************************************************************/
+void rv32i_set_insn_hook(rv32i_sim* sim, rv32i_insn_hook hook, void* ctx)
+{
+    sim->hook = hook;
+    sim->hook_ctx = ctx;
+}
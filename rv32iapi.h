@@ -0,0 +1,48 @@
+
+#ifndef RV32IAPI_H
+#define RV32IAPI_H
+/*
+ * C interface to the simulator for programs that embed it (librv32i.a / librv32i.so).
+ * A simulator is created once and can be loaded and reset any number of times, nothing is
+ * printed to the process's stdout unless no sink is set.
+ */
+#include <stddef.h>
+#include <stdint.h>
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct rv32i_sim rv32i_sim;
+
+/* receives text printed by the simulator or by the guest */
+typedef void (*rv32i_sink)(void* ctx, const char* data, size_t len);
+/* called before every instruction, a nonzero return stops rv32i_run_for() before it. Pending
+   interrupts are taken first, so pc is the instruction that really runs next, insn is 0 when it
+   can't be fetched from the RAM (it then traps when it runs). */
+typedef int (*rv32i_insn_hook)(void* ctx, uint32_t pc, uint32_t insn);
+
+rv32i_sim* rv32i_create(uint32_t mem_size);
+void rv32i_destroy(rv32i_sim* sim);
+int rv32i_load_file(rv32i_sim* sim, const char* fname);
+int rv32i_load(rv32i_sim* sim, const void* image, uint32_t len);
+void rv32i_reset(rv32i_sim* sim);
+void rv32i_snapshot(rv32i_sim* sim);
+uint32_t rv32i_restore(rv32i_sim* sim);
+uint64_t rv32i_run_for(rv32i_sim* sim, uint64_t n);
+int rv32i_halted(const rv32i_sim* sim);
+int rv32i_exit_code(const rv32i_sim* sim);
+uint64_t rv32i_insn_count(const rv32i_sim* sim);
+uint32_t rv32i_get_reg(const rv32i_sim* sim, uint32_t r);
+void rv32i_set_reg(rv32i_sim* sim, uint32_t r, uint32_t val);
+uint32_t rv32i_get_pc(const rv32i_sim* sim);
+void rv32i_set_pc(rv32i_sim* sim, uint32_t pc);
+int rv32i_read_mem(rv32i_sim* sim, uint32_t addr, void* buf, uint32_t len);
+int rv32i_write_mem(rv32i_sim* sim, uint32_t addr, const void* buf, uint32_t len);
+void rv32i_set_output(rv32i_sim* sim, rv32i_sink sink, void* ctx);
+void rv32i_set_guest_output(rv32i_sim* sim, rv32i_sink sink, void* ctx);
+void rv32i_set_insn_hook(rv32i_sim* sim, rv32i_insn_hook hook, void* ctx);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
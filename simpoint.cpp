@@ -0,0 +1,392 @@
+
+#include "simpoint.h"
+#include "rv32i.h"
+#include "replaylog.h"
+#include "timing.h"
+#include <algorithm>
+#include <iomanip>
+#include <string.h>
+#include <unistd.h>
+
+static constexpr uint32_t dims = 15; // basic block vectors are projected down to this many dimensions
+static constexpr uint32_t kmeans_rounds = 20;
+
+/**
+ * One component of the random projection, +1 or -1 depending on a hash of the block id and the
+ * dimension so that it is the same for every interval
+ * @param uint32_t id, uint32_t d
+ * @return +1.0 or -1.0
+ ********************************************************************************/
+static double projection(uint32_t id, uint32_t d)
+{
+    uint32_t h = id * 0x9e3779b1u ^ (d + 1) * 0x85ebca6bu;
+    h ^= h >> 15;
+    h *= 0x2c1b3c6du;
+    h ^= h >> 12;
+    return (h & 1) ? 1.0 : -1.0;
+}
+
+/**
+ * Squared euclidean distance between two projected vectors
+ * @param const std::vector<double>& a, const std::vector<double>& b
+ * @return the distance squared
+ ********************************************************************************/
+static double distance(const std::vector<double>& a, const std::vector<double>& b)
+{
+    double sum = 0;
+    for (uint32_t d = 0; d < dims; d++)
+    {
+        sum += (a[d] - b[d]) * (a[d] - b[d]);
+    }
+    return sum;
+}
+
+/**
+ * simpoint constructor
+ * @param uint64_t interval_size (instructions per interval), uint32_t k (most clusters to pick)
+ * @return nothing
+ ********************************************************************************/
+simpoint::simpoint(uint64_t size, uint32_t clusters)
+{
+    interval_size = size;
+    k = clusters;
+    keys.assign(1024, 0);
+    ids.assign(1024, 0);
+}
+
+/**
+ * Enter the first block where the hart is
+ * @param rv32i* hart
+ * @return none
+ ********************************************************************************/
+void simpoint::begin(rv32i* hart)
+{
+    boundary = hart->get_insn_counter() + interval_size;
+    next_pc = hart->get_pc();
+    enter_block(next_pc, hart->get_insn_counter());
+}
+
+/**
+ * Enter a new block whenever an instruction does not follow the previous one (after a jump, a
+ * taken branch, a trap or an interrupt) and close an interval every interval_size instructions
+ * @param const rv32i* hart, const step_info& s
+ * @return none
+ ********************************************************************************/
+void simpoint::after(const rv32i* hart, const step_info& s)
+{
+    uint64_t now = hart->get_insn_counter();
+    if (s.pc != next_pc)
+    {
+        enter_block(s.pc, now - 1);
+    }
+    next_pc = s.pc + 4;
+    if (now >= boundary)
+    {
+        end_interval(now);
+        boundary = now + interval_size;
+    }
+}
+
+/**
+ * Close the interval in progress
+ * @param rv32i* hart
+ * @return none
+ ********************************************************************************/
+void simpoint::end(rv32i* hart)
+{
+    end_interval(hart->get_insn_counter());
+}
+
+/**
+ * Called whenever control moves somewhere other than the next instruction, the instructions
+ * since the previous call are credited to the block being left
+ * @param uint32_t pc (entry of the new block), uint64_t now (instruction count)
+ * @return none
+ ********************************************************************************/
+void simpoint::enter_block(uint32_t pc, uint64_t now)
+{
+    if (now > block_start)
+    {
+        if (counts[current] == 0)
+            touched.push_back(current);
+        counts[current] += now - block_start;
+    }
+    current = lookup(pc);
+    block_start = now;
+}
+
+/**
+ * Close the current interval and keep its basic block vector
+ * @param uint64_t now (instruction count)
+ * @return none
+ ********************************************************************************/
+void simpoint::end_interval(uint64_t now)
+{
+    enter_block(current_pc, now); // credit the block in progress, it goes on in the next interval
+    if (touched.empty())
+    {
+        return;
+    }
+    std::vector<std::pair<uint32_t, uint64_t>> bbv;
+    for (uint32_t id : touched)
+    {
+        bbv.push_back(std::make_pair(id, counts[id]));
+        counts[id] = 0;
+    }
+    touched.clear();
+    std::sort(bbv.begin(), bbv.end());
+    intervals.push_back(bbv);
+    starts.push_back(interval_start);
+    interval_start = now;
+}
+
+/**
+ * getter get_interval_size
+ * @param none
+ * @return instructions per interval
+ ********************************************************************************/
+uint64_t simpoint::get_interval_size() const
+{
+    return interval_size;
+}
+
+/**
+ * Write the basic block vectors in the SimPoint .bb format, one line per interval with
+ * :block:instructions pairs (block ids start at 1)
+ * @param std::ostream& os
+ * @return none
+ ********************************************************************************/
+void simpoint::write_bbv(std::ostream& os) const
+{
+    for (const auto& bbv : intervals)
+    {
+        os << "T";
+        for (const auto& b : bbv)
+        {
+            os << ":" << std::dec << b.first + 1 << ":" << b.second << " ";
+        }
+        os << std::endl;
+    }
+}
+
+/**
+ * Pick the representative intervals
+ * every vector is normalized, randomly projected to a few dimensions and clustered with k-means
+ * (farthest-point seeding). The interval nearest to each cluster center represents the cluster.
+ * @param none
+ * @return the representative intervals and their weights, in execution order
+ ********************************************************************************/
+std::vector<simpoint::pick> simpoint::choose() const
+{
+    std::vector<pick> picks;
+    uint32_t n = intervals.size();
+    if (n == 0)
+    {
+        return picks;
+    }
+    std::vector<std::vector<double>> points(n, std::vector<double>(dims, 0.0));
+    for (uint32_t i = 0; i < n; i++)
+    {
+        double total = 0;
+        for (const auto& b : intervals[i])
+            total += b.second;
+        for (const auto& b : intervals[i])
+        {
+            for (uint32_t d = 0; d < dims; d++)
+                points[i][d] += projection(b.first, d) * b.second / total;
+        }
+    }
+    uint32_t clusters = std::min(k, n);
+    std::vector<std::vector<double>> centers(1, points[0]);
+    std::vector<double> nearest(n);
+    for (uint32_t i = 0; i < n; i++)
+        nearest[i] = distance(points[i], centers[0]);
+    while (centers.size() < clusters)
+    {
+        uint32_t far = std::max_element(nearest.begin(), nearest.end()) - nearest.begin();
+        if (nearest[far] == 0)
+            break; // fewer distinct phases than clusters
+        centers.push_back(points[far]);
+        for (uint32_t i = 0; i < n; i++)
+            nearest[i] = std::min(nearest[i], distance(points[i], centers.back()));
+    }
+    std::vector<uint32_t> member(n, 0);
+    for (uint32_t round = 0; round < kmeans_rounds; round++)
+    {
+        for (uint32_t i = 0; i < n; i++)
+        {
+            member[i] = 0;
+            for (uint32_t c = 1; c < centers.size(); c++)
+            {
+                if (distance(points[i], centers[c]) < distance(points[i], centers[member[i]]))
+                    member[i] = c;
+            }
+        }
+        for (uint32_t c = 0; c < centers.size(); c++)
+        {
+            std::vector<double> sum(dims, 0.0);
+            uint32_t size = 0;
+            for (uint32_t i = 0; i < n; i++)
+            {
+                if (member[i] != c)
+                    continue;
+                size++;
+                for (uint32_t d = 0; d < dims; d++)
+                    sum[d] += points[i][d];
+            }
+            for (uint32_t d = 0; size != 0 && d < dims; d++)
+                centers[c][d] = sum[d] / size;
+        }
+    }
+    for (uint32_t c = 0; c < centers.size(); c++)
+    {
+        uint32_t size = 0;
+        uint32_t best = n;
+        for (uint32_t i = 0; i < n; i++)
+        {
+            if (member[i] != c)
+                continue;
+            size++;
+            if (best == n || distance(points[i], centers[c]) < distance(points[best], centers[c]))
+                best = i;
+        }
+        if (size != 0)
+            picks.push_back(pick { best, (double)size / n });
+    }
+    std::sort(picks.begin(), picks.end(), [](const pick& a, const pick& b) { return a.interval < b.interval; });
+    return picks;
+}
+
+/**
+ * Do a complete sampled simulation of the loaded program
+ * The profiling run records its nondeterministic inputs so that the detailed run can replay
+ * them, then the memory goes back to the loaded image and the detailed run fast-forwards with
+ * the functional engine to the start of each representative interval (which serves as its
+ * checkpoint), warms a fresh timing model up for up to warmup instructions and measures the
+ * interval.
+ * @param rv32i* hart, memory* mem, uint64_t limit (0 = no limit), uint64_t warmup,
+ * std::ostream* bbv_out (where to write the basic block vectors, may be nullptr)
+ * @return false if the temporary log can't be created
+ ********************************************************************************/
+bool simpoint::run(rv32i* hart, memory* mem, uint64_t limit, uint64_t warmup, std::ostream* bbv_out)
+{
+    std::vector<uint8_t> image(mem->get_ptr(0, mem->get_size()), mem->get_ptr(0, mem->get_size()) + mem->get_size());
+    char path[] = "/tmp/rv32i-simpoint-XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0)
+    {
+        std::cerr << "Can't create a temporary file for the profiling log." << std::endl;
+        return false;
+    }
+    close(fd);
+    {
+        replaylog rec;
+        rec.record(path);
+        hart->set_log(&rec);
+        mem->set_log(&rec);
+        hart->start();
+        std::vector<insn_observer*> profile { this };
+        begin(hart);
+        hart->resume_observed(limit, profile);
+        end(hart);
+        std::cout << std::endl << std::dec << hart->get_insn_counter() << " instructions profiled in "
+                  << intervals.size() << " intervals" << std::endl;
+    }
+    if (bbv_out != nullptr)
+    {
+        write_bbv(*bbv_out);
+    }
+    std::vector<pick> picks = choose();
+    memcpy(mem->get_ptr(0, mem->get_size()), image.data(), image.size());
+    replaylog rep;
+    rep.replay(path);
+    hart->set_log(&rep);
+    mem->set_log(&rep);
+    hart->start(); // the same registers, vector registers and devices the profiling run began with
+    mem->reset_devices();
+    double cpi = 0;
+    for (const pick& p : picks)
+    {
+        uint64_t start = starts[p.interval];
+        uint64_t warm_start = start > warmup ? start - warmup : 0;
+        if (warm_start > hart->get_insn_counter())
+        {
+            hart->resume(warm_start); // fast-forward
+        }
+        timing model;
+        if (start > hart->get_insn_counter())
+        {
+            hart->resume_detailed(start, &model); // warm up
+        }
+        model.reset_stats();
+        hart->resume_detailed(start + interval_size, &model);
+        std::cout << "interval " << std::dec << p.interval << " at instruction " << starts[p.interval]
+                  << ", weight " << std::fixed << std::setprecision(3) << p.weight << ": ";
+        model.report(std::cout);
+        if (model.get_insns() != 0)
+        {
+            cpi += p.weight * model.get_cycles() / model.get_insns();
+        }
+    }
+    std::cout << "estimated CPI " << std::fixed << std::setprecision(3) << cpi << std::endl;
+    std::cout.unsetf(std::ios::floatfield);
+    hart->set_log(nullptr);
+    mem->set_log(nullptr);
+    unlink(path);
+    return true;
+}
+
+/**
+ * Find the id of the block starting at pc, giving it the next id if it is new
+ * @param uint32_t pc
+ * @return the block id
+ ********************************************************************************/
+uint32_t simpoint::lookup(uint32_t pc)
+{
+    current_pc = pc;
+    uint32_t mask = keys.size() - 1;
+    for (uint32_t i = (pc >> 2) * 0x9e3779b1u & mask;; i = (i + 1) & mask)
+    {
+        if (keys[i] == pc + 1)
+        {
+            return ids[i];
+        }
+        if (keys[i] == 0)
+        {
+            keys[i] = pc + 1;
+            ids[i] = counts.size();
+            counts.push_back(0);
+            if (counts.size() * 2 > keys.size())
+            {
+                uint32_t id = ids[i];
+                grow();
+                return id;
+            }
+            return ids[i];
+        }
+    }
+}
+
+/**
+ * Double the size of the hash table
+ * @param none
+ * @return none
+ ********************************************************************************/
+void simpoint::grow()
+{
+    std::vector<uint32_t> old_keys(keys.size() * 2, 0);
+    std::vector<uint32_t> old_ids(ids.size() * 2, 0);
+    old_keys.swap(keys);
+    old_ids.swap(ids);
+    uint32_t mask = keys.size() - 1;
+    for (uint32_t j = 0; j < old_keys.size(); j++)
+    {
+        if (old_keys[j] == 0)
+            continue;
+        uint32_t i = ((old_keys[j] - 1) >> 2) * 0x9e3779b1u & mask;
+        while (keys[i] != 0)
+            i = (i + 1) & mask;
+        keys[i] = old_keys[j];
+        ids[i] = old_ids[j];
+    }
+}
@@ -0,0 +1,55 @@
+
+#ifndef SIMPOINT_H
+#define SIMPOINT_H
+#include <iostream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "memory.h"
+#include "insnobserver.h"
+
+/**
+ * SimPoint-style sampled simulation. A fast profiling run collects a basic block vector (how many
+ * instructions were executed in each block, keyed on the block entry pc) for every interval of
+ * a fixed number of instructions. The intervals are clustered and the one closest to the middle
+ * of each cluster is run again with the detailed timing model, weighted by the cluster size.
+ ********************************************************************************/
+class simpoint : public insn_observer
+{
+public:
+    struct pick
+    {
+        uint32_t interval; // index of the representative interval
+        double weight; // fraction of all intervals in its cluster
+    };
+    simpoint(uint64_t interval_size, uint32_t k); // constructor prototype
+    void begin(rv32i* hart) override; 
+    void after(const rv32i* hart, const step_info& s) override; 
+    void end(rv32i* hart) override; 
+    void enter_block(uint32_t pc, uint64_t now); 
+    void end_interval(uint64_t now); 
+    uint64_t get_interval_size() const; 
+    void write_bbv(std::ostream& os) const; 
+    std::vector<pick> choose() const; 
+    bool run(rv32i* hart, memory* mem, uint64_t limit, uint64_t warmup, std::ostream* bbv_out); 
+private:
+    uint64_t interval_size; // instructions per interval
+    uint32_t k; // maximum number of clusters
+    // open-addressing hash table from block entry pc to block id
+    std::vector<uint32_t> keys; // pc + 1, 0 = empty slot
+    std::vector<uint32_t> ids; 
+    std::vector<uint64_t> counts; // per block id, instructions in the current interval
+    std::vector<uint32_t> touched; // block ids with a non-zero count in the current interval
+    uint32_t current = 0; // id of the block being executed
+    uint32_t current_pc = 0; // its entry pc
+    uint64_t block_start = 0; // insn count when it was entered
+    // one sparse vector (block id, instructions) per finished interval
+    std::vector<std::vector<std::pair<uint32_t, uint64_t>>> intervals; 
+    std::vector<uint64_t> starts; // instruction count at the start of each interval
+    uint64_t interval_start = 0; 
+    uint64_t boundary = 0; // instruction count that closes the current interval
+    uint32_t next_pc = 0; // the instruction after the last one, a block goes on there
+    uint32_t lookup(uint32_t pc); 
+    void grow(); 
+};
+#endif
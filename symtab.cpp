@@ -0,0 +1,110 @@
+
+#include "symtab.h"
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+/**
+ * Load the symbols from a file written by nm
+ * lines that don't look like "address type name" are skipped
+ * @param const std::string& fname
+ * @return false if the file can't be opened
+ ********************************************************************************/
+bool symtab::load_file(const std::string& fname)
+{
+    std::ifstream infile(fname);
+    if (!infile)
+    {
+        std::cerr << "Can't open symbol file " << fname << " for reading." << std::endl;
+        return false;
+    }
+    std::string line;
+    while (std::getline(infile, line))
+    {
+        std::istringstream is(line);
+        std::string addr, type, name;
+        if (!(is >> addr >> type >> name) || type.size() != 1)
+        {
+            continue;
+        }
+        uint32_t a = std::stoul(addr, nullptr, 16);
+        by_name[name] = a;
+        if (type == "t" || type == "T")
+        {
+            by_addr[a] = name;
+        }
+    }
+    return true;
+}
+
+/**
+ * Look up the address of a symbol
+ * @param const std::string& name, uint32_t& addr
+ * @return false if there is no such symbol
+ ********************************************************************************/
+bool symtab::lookup(const std::string& name, uint32_t& addr) const
+{
+    auto it = by_name.find(name);
+    if (it == by_name.end())
+    {
+        return false;
+    }
+    addr = it->second;
+    return true;
+}
+
+/**
+ * Turn a command-line address into a number
+ * accepts a symbol name or a hex number (with or without 0x)
+ * @param const std::string& s, uint32_t& addr
+ * @return false if s is neither
+ ********************************************************************************/
+bool symtab::parse_address(const std::string& s, uint32_t& addr) const
+{
+    if (lookup(s, addr))
+    {
+        return true;
+    }
+    size_t used = 0;
+    try
+    {
+        addr = std::stoul(s, &used, 16);
+    }
+    catch (const std::exception&)
+    {
+        return false;
+    }
+    return used == s.size();
+}
+
+/**
+ * Find the function containing addr
+ * a function is taken to end where the next text symbol starts
+ * @param uint32_t addr, uint32_t* start, uint32_t* end (optional, filled in when found)
+ * @return the function name or an empty string
+ ********************************************************************************/
+std::string symtab::find(uint32_t addr, uint32_t* start, uint32_t* end) const
+{
+    auto it = by_addr.upper_bound(addr);
+    if (it == by_addr.begin())
+    {
+        return "";
+    }
+    auto next = it;
+    --it;
+    if (start)
+        *start = it->first;
+    if (end)
+        *end = (next == by_addr.end()) ? 0xffffffff : next->first;
+    return it->second;
+}
+
+/**
+ * getter functions
+ * @param none
+ * @return the text symbols ordered by address
+ ********************************************************************************/
+const std::map<uint32_t, std::string>& symtab::functions() const
+{
+    return by_addr;
+}
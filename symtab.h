@@ -0,0 +1,23 @@
+
+#ifndef SYMTAB_H
+#define SYMTAB_H
+#include <map>
+#include <string>
+#include <stdint.h>
+/**
+ * Symbol table read from the output of nm (address, type and name on each line), since the
+ * simulator loads flat binaries that carry no symbols of their own.
+ ********************************************************************************/
+class symtab
+{
+public:
+    bool load_file(const std::string& fname); 
+    bool lookup(const std::string& name, uint32_t& addr) const; 
+    bool parse_address(const std::string& s, uint32_t& addr) const; 
+    std::string find(uint32_t addr, uint32_t* start = nullptr, uint32_t* end = nullptr) const; 
+    const std::map<uint32_t, std::string>& functions() const; 
+private:
+    std::map<std::string, uint32_t> by_name; // every symbol
+    std::map<uint32_t, std::string> by_addr; // text symbols only (types t and T)
+};
+#endif
@@ -0,0 +1,161 @@
+
+#include "timing.h"
+#include <iomanip>
+
+static constexpr uint32_t history_bits = 12; // size of the branch predictor is 1 << history_bits
+static constexpr uint32_t opcode_load = 0b0000011; 
+static constexpr uint32_t opcode_store = 0b0100011; 
+static constexpr uint32_t opcode_amo = 0b0101111; 
+static constexpr uint32_t opcode_branch = 0b1100011; 
+static constexpr uint32_t opcode_jalr = 0b1100111; 
+
+/**
+ * cache constructor
+ * @param uint32_t sets, uint32_t ways, uint32_t line_size (sets and line_size powers of two)
+ * @return nothing
+ ********************************************************************************/
+cache::cache(uint32_t s, uint32_t w, uint32_t line_size)
+{
+    sets = s;
+    ways = w;
+    line_shift = 0;
+    while ((1u << line_shift) < line_size)
+        line_shift++;
+    tags.assign(sets * ways, 0);
+    stamps.assign(sets * ways, 0);
+}
+
+/**
+ * Look up the line holding addr and bring it in if it is not there
+ * @param uint32_t addr
+ * @return true on a hit
+ ********************************************************************************/
+bool cache::access(uint32_t addr)
+{
+    uint32_t line = addr >> line_shift;
+    uint32_t* t = &tags[(line & (sets - 1)) * ways];
+    uint32_t* s = &stamps[(line & (sets - 1)) * ways];
+    uint32_t victim = 0;
+    ++clock;
+    for (uint32_t i = 0; i < ways; i++)
+    {
+        if (t[i] == line + 1)
+        {
+            s[i] = clock;
+            return true;
+        }
+        if (s[i] < s[victim])
+            victim = i;
+    }
+    t[victim] = line + 1;
+    s[victim] = clock;
+    return false;
+}
+
+/**
+ * timing constructor
+ * 16 KiB 4-way instruction and data caches with 32-byte lines
+ * @param none
+ * @return nothing
+ ********************************************************************************/
+timing::timing()
+    : icache(128, 4, 32)
+    , dcache(128, 4, 32)
+{
+    counters.assign(1u << history_bits, 1); // weakly not taken
+}
+
+/**
+ * Account for one executed instruction
+ * @param uint32_t pc, uint32_t insn, uint32_t next_pc (pc of the next instruction),
+ * uint32_t data_addr (effective address, only used by loads, stores and AMOs)
+ * @return none
+ ********************************************************************************/
+void timing::step(uint32_t pc, uint32_t insn, uint32_t next_pc, uint32_t data_addr)
+{
+    insns++;
+    cycles++;
+    if (!icache.access(pc))
+    {
+        icache_misses++;
+        cycles += miss_penalty;
+    }
+    uint32_t opcode = insn & 0x7f;
+    if (opcode == opcode_load || opcode == opcode_store || opcode == opcode_amo)
+    {
+        dcache_accesses++;
+        if (!dcache.access(data_addr))
+        {
+            dcache_misses++;
+            cycles += miss_penalty;
+        }
+    }
+    else if (opcode == opcode_branch)
+    {
+        branches++;
+        bool taken = next_pc != pc + 4;
+        uint8_t& c = counters[((pc >> 2) ^ history) & ((1u << history_bits) - 1)];
+        if ((c >= 2) != taken)
+        {
+            mispredicts++;
+            cycles += mispredict_penalty;
+        }
+        if (taken && c < 3)
+            c++;
+        else if (!taken && c > 0)
+            c--;
+        history = (history << 1) | taken;
+    }
+    else if (opcode == opcode_jalr)
+    {
+        branches++;
+        mispredicts++; // no target predictor
+        cycles += mispredict_penalty;
+    }
+}
+
+/**
+ * Start counting from zero, the caches and the predictor keep their contents
+ * @param none
+ * @return none
+ ********************************************************************************/
+void timing::reset_stats()
+{
+    insns = cycles = 0;
+    icache_misses = dcache_accesses = dcache_misses = 0;
+    branches = mispredicts = 0;
+}
+
+/**
+ * getter get_insns
+ * @param none
+ * @return instructions counted since the last reset_stats()
+ ********************************************************************************/
+uint64_t timing::get_insns() const
+{
+    return insns;
+}
+
+/**
+ * getter get_cycles
+ * @param none
+ * @return cycles counted since the last reset_stats()
+ ********************************************************************************/
+uint64_t timing::get_cycles() const
+{
+    return cycles;
+}
+
+/**
+ * Print the counters
+ * @param std::ostream& os
+ * @return none
+ ********************************************************************************/
+void timing::report(std::ostream& os) const
+{
+    os << std::dec << insns << " instructions, " << cycles << " cycles, CPI " << std::fixed
+       << std::setprecision(3) << (insns ? (double)cycles / insns : 0.0) << std::endl;
+    os << "  icache misses " << icache_misses << ", dcache misses " << dcache_misses << " of "
+       << dcache_accesses << ", branch mispredicts " << mispredicts << " of " << branches << std::endl;
+    os.unsetf(std::ios::floatfield);
+}
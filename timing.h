@@ -0,0 +1,54 @@
+
+#ifndef TIMING_H
+#define TIMING_H
+#include <iostream>
+#include <vector>
+#include <stdint.h>
+/**
+ * Set-associative cache with LRU replacement, only the tags are kept.
+ ********************************************************************************/
+class cache
+{
+public:
+    cache(uint32_t sets, uint32_t ways, uint32_t line_size); // constructor prototype
+    bool access(uint32_t addr); 
+private:
+    uint32_t sets; 
+    uint32_t ways; 
+    uint32_t line_shift; // log2 of the line size
+    std::vector<uint32_t> tags; // sets*ways entries, line number + 1 (0 = invalid)
+    std::vector<uint32_t> stamps; // time of the last use of each entry
+    uint32_t clock = 0; 
+};
+
+/**
+ * Detailed timing model of an in-order pipeline: instruction and data caches and a gshare branch
+ * predictor. It is driven by rv32i::tick_detailed() with every executed instruction and turns
+ * them into a cycle count. reset_stats() clears the counters but keeps the caches and the
+ * predictor warm.
+ ********************************************************************************/
+class timing
+{
+public:
+    static constexpr uint32_t miss_penalty = 20; // cycles added by a cache miss
+    static constexpr uint32_t mispredict_penalty = 3; // cycles added by a mispredicted branch or jalr
+    timing(); // constructor prototype
+    void step(uint32_t pc, uint32_t insn, uint32_t next_pc, uint32_t data_addr); 
+    void reset_stats(); 
+    uint64_t get_insns() const; 
+    uint64_t get_cycles() const; 
+    void report(std::ostream& os) const; 
+private:
+    cache icache; 
+    cache dcache; 
+    std::vector<uint8_t> counters; // 2-bit saturating counters indexed by pc ^ history
+    uint32_t history = 0; // global branch history
+    uint64_t insns = 0; 
+    uint64_t cycles = 0; 
+    uint64_t icache_misses = 0; 
+    uint64_t dcache_accesses = 0; 
+    uint64_t dcache_misses = 0; 
+    uint64_t branches = 0; 
+    uint64_t mispredicts = 0; 
+};
+#endif
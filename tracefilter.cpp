@@ -0,0 +1,144 @@
+
+#include "tracefilter.h"
+#include "rv32i.h"
+#include <iostream>
+
+/**
+ * tracefilter constructor
+ * with nothing parsed every instruction is selected
+ * @param uint32_t mem_size (pc ranges are clipped to addresses 0 to mem_size - 1)
+ * @return nothing
+ ********************************************************************************/
+tracefilter::tracefilter(uint32_t mem_size)
+{
+    slots = ((uint64_t)mem_size + (1u << slot_shift) - 1) >> slot_shift;
+    pcs.assign((slots + 63) / 64, 0);
+}
+
+/**
+ * Add the terms of one -I argument, separated by commas:
+ * pc=lo-hi (hex or symbols, hi not included), pc=function (a symbol, its whole function),
+ * pc=addr (one instruction), mem, control, from=n, to=n, every=n
+ * pc ranges and kinds add up, the others replace what an earlier term said
+ * @param const std::string& spec, const symtab& symbols
+ * @return false (after saying why) if a term is bad
+ ********************************************************************************/
+bool tracefilter::parse(const std::string& spec, const symtab& symbols)
+{
+    size_t start = 0;
+    while (start <= spec.size())
+    {
+        size_t comma = spec.find(',', start);
+        if (comma == std::string::npos)
+            comma = spec.size();
+        std::string term = spec.substr(start, comma - start);
+        start = comma + 1;
+        size_t eq = term.find('=');
+        std::string key = term.substr(0, eq);
+        std::string val = eq == std::string::npos ? "" : term.substr(eq + 1);
+        bool ok = true;
+        try
+        {
+            if (key == "mem" && eq == std::string::npos)
+                kinds |= kind_memory;
+            else if (key == "control" && eq == std::string::npos)
+                kinds |= kind_control;
+            else if (key == "pc" && add_range(val, symbols))
+                ranged = true;
+            else if (key == "from" && !val.empty())
+                from = std::stoull(val, nullptr, 10);
+            else if (key == "to" && !val.empty())
+                to = std::stoull(val, nullptr, 10);
+            else if (key == "every" && !val.empty())
+                ok = (every = std::stoull(val, nullptr, 10)) != 0;
+            else
+                ok = false;
+        }
+        catch (const std::exception&)
+        {
+            ok = false;
+        }
+        if (!ok)
+        {
+            std::cerr << "Bad trace filter " << term << "." << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * getter get_from
+ * @param none
+ * @return the first instruction count traced
+ ********************************************************************************/
+uint64_t tracefilter::get_from() const
+{
+    return from;
+}
+
+/**
+ * getter get_to
+ * @param none
+ * @return the first instruction count no longer traced, 0 if there is no end
+ ********************************************************************************/
+uint64_t tracefilter::get_to() const
+{
+    return to;
+}
+
+/**
+ * Show the instruction about to run only if it is in the window and selected
+ * @param rv32i* hart, const step_info& s
+ * @return false, the filter never stops the run
+ ********************************************************************************/
+bool tracefilter::before(rv32i* hart, const step_info& s)
+{
+    uint64_t n = hart->get_insn_counter();
+    hart->set_show_instructions(n >= from && (to == 0 || n < to) && selects(s.pc, s.insn));
+    return false;
+}
+
+/**
+ * Leave the display off once the run is over
+ * @param rv32i* hart
+ * @return none
+ ********************************************************************************/
+void tracefilter::end(rv32i* hart)
+{
+    hart->set_show_instructions(false);
+}
+
+/**
+ * Set the slots of a pc range
+ * @param const std::string& range (lo-hi, a function or one address), const symtab& symbols
+ * @return false if it is neither
+ ********************************************************************************/
+bool tracefilter::add_range(const std::string& range, const symtab& symbols)
+{
+    size_t dash = range.find('-');
+    uint32_t lo, hi;
+    if (dash != std::string::npos)
+    {
+        if (!symbols.parse_address(range.substr(0, dash), lo) || !symbols.parse_address(range.substr(dash + 1), hi))
+            return false;
+    }
+    else if (symbols.lookup(range, lo))
+    {
+        if (symbols.find(lo, &lo, &hi).empty())
+            return false;
+    }
+    else if (symbols.parse_address(range, lo))
+    {
+        hi = lo + (1u << slot_shift);
+    }
+    else
+    {
+        return false;
+    }
+    for (uint64_t s = lo >> slot_shift; s < slots && s < ((uint64_t)hi + (1u << slot_shift) - 1) >> slot_shift; s++)
+    {
+        pcs[s / 64] |= 1ull << (s % 64);
+    }
+    return true;
+}
@@ -0,0 +1,82 @@
+
+#ifndef TRACEFILTER_H
+#define TRACEFILTER_H
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "symtab.h"
+#include "insnobserver.h"
+/**
+ * Selects which instructions -I traces: those at pcs in some ranges (one bit per 4-byte slot,
+ * set up front), of some kinds (loads and stores, control flow), between two instruction counts
+ * and then only every nth of them. As an observer it turns the hart's instruction display on
+ * for the selected ones, inside the window selects() costs a bit test and a look at the opcode.
+ ********************************************************************************/
+class tracefilter : public insn_observer
+{
+public:
+    static constexpr uint32_t slot_shift = 2; // bytes per slot = 1 << slot_shift
+    // kinds of instructions, or-ed together
+    static constexpr uint32_t kind_memory = 1; // loads, stores and AMOs
+    static constexpr uint32_t kind_control = 2; // branches, jumps, ecall, ebreak and mret
+    tracefilter(uint32_t mem_size); // constructor prototype
+    bool parse(const std::string& spec, const symtab& symbols); 
+    uint64_t get_from() const; 
+    uint64_t get_to() const; 
+    bool selects(uint32_t pc, uint32_t insn); 
+    bool before(rv32i* hart, const step_info& s) override; 
+    void end(rv32i* hart) override; 
+private:
+    uint32_t slots; 
+    std::vector<uint64_t> pcs; // slots in the pc ranges
+    bool ranged = false; // a pc range was given, otherwise every pc is in
+    uint32_t kinds = 0; // 0 = every kind
+    uint64_t from = 0; // first instruction count traced
+    uint64_t to = 0; // first instruction count not traced, 0 = no end
+    uint64_t every = 1; 
+    uint64_t skipped = 0; // matching instructions since the last one traced
+    bool add_range(const std::string& range, const symtab& symbols); 
+};
+
+/**
+ * Decide whether the instruction insn at pc is traced, called once per instruction inside the
+ * window
+ * @param uint32_t pc, uint32_t insn
+ * @return true to trace it
+ ********************************************************************************/
+inline bool tracefilter::selects(uint32_t pc, uint32_t insn)
+{
+    if (ranged)
+    {
+        uint32_t s = pc >> slot_shift;
+        if (s >= slots || !(pcs[s / 64] >> (s % 64) & 1))
+            return false;
+    }
+    if (kinds != 0)
+    {
+        uint32_t kind = 0;
+        switch (insn & 0x7f)
+        {
+            case 0b0000011: // load
+            case 0b0100011: // store
+            case 0b0101111: // amo
+                kind = kind_memory;
+                break;
+            case 0b1100011: // branch
+            case 0b1101111: // jal
+            case 0b1100111: // jalr
+                kind = kind_control;
+                break;
+            case 0b1110011: // ecall, ebreak, mret and wfi, but not the CSR instructions
+                kind = (insn & 0x7000) == 0 ? kind_control : 0;
+                break;
+        }
+        if (!(kinds & kind))
+            return false;
+    }
+    if (++skipped < every)
+        return false;
+    skipped = 0;
+    return true;
+}
+#endif
@@ -0,0 +1,55 @@
+
+#include "insntrace.h"
+#include "rv32i.h"
+#include "memory.h"
+#include "hex.h"
+#include <sstream>
+
+/**
+ * Print a trace written with rv32i -X, one instruction per line: its number, pc, instruction,
+ * disassembly, the registers it changed and the address a load, store or AMO accessed
+ * usage: rv32i-untrace insn-trace
+ * @param int argc, char** argv
+ * @return 0 on success, 1 on bad arguments or a bad trace
+ ********************************************************************************/
+int main(int argc, char** argv)
+{
+    if (argc != 2)
+    {
+        std::cerr << "Usage: rv32i-untrace insn-trace" << std::endl;
+        return 1;
+    }
+    insntrace trace;
+    if (!trace.open_read(argv[1]))
+    {
+        return 1;
+    }
+    memory mem(0);
+    rv32i hart(&mem); // only used to disassemble
+    std::ostringstream line;
+    hart.set_output(&line);
+    insntrace::entry e;
+    std::ios::sync_with_stdio(false);
+    while (trace.next(e))
+    {
+        line.str("");
+        line << std::dec << e.index << " " << hex32(e.pc) << ": ";
+        hart.set_pc(e.pc); // branch targets are rendered relative to the pc
+        line << hart.decode(e.insn);
+        for (uint32_t r = 1; r < 32; r++)
+        {
+            if (e.changed >> r & 1)
+                line << "  x" << std::dec << r << " = " << hex0x32(e.regs[r]);
+        }
+        if (e.access)
+            line << "  [" << hex0x32(e.addr) << "]";
+        line << '\n';
+        std::cout << line.str();
+    }
+    if (trace.failed())
+    {
+        std::cerr << argv[1] << " is corrupt or cut short." << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,632 @@
+
+#include "vregfile.h"
+#include <string.h>
+#include <algorithm>
+#include <type_traits>
+#ifdef __x86_64__
+#include <immintrin.h>
+#endif
+
+/*
+ * Element operations. Each one has an element-at-a-time form for every element type and, when
+ * the host instruction set has it, an SSE2 and an AVX2 form per element width, told apart by a
+ * pointer to the element type. set_row() picks the widest form that exists.
+ */
+struct add_op
+{
+    template<typename T> static T scalar(T a, T b) { return a + b; }
+#ifdef __x86_64__
+    static __m128i sse2(__m128i a, __m128i b, const uint8_t*) { return _mm_add_epi8(a, b); }
+    static __m128i sse2(__m128i a, __m128i b, const uint16_t*) { return _mm_add_epi16(a, b); }
+    static __m128i sse2(__m128i a, __m128i b, const uint32_t*) { return _mm_add_epi32(a, b); }
+    static __m128i sse2(__m128i a, __m128i b, const uint64_t*) { return _mm_add_epi64(a, b); }
+    __attribute__((target("avx2"))) static __m256i avx2(__m256i a, __m256i b, const uint8_t*) { return _mm256_add_epi8(a, b); }
+    __attribute__((target("avx2"))) static __m256i avx2(__m256i a, __m256i b, const uint16_t*) { return _mm256_add_epi16(a, b); }
+    __attribute__((target("avx2"))) static __m256i avx2(__m256i a, __m256i b, const uint32_t*) { return _mm256_add_epi32(a, b); }
+    __attribute__((target("avx2"))) static __m256i avx2(__m256i a, __m256i b, const uint64_t*) { return _mm256_add_epi64(a, b); }
+#endif
+};
+struct sub_op
+{
+    template<typename T> static T scalar(T a, T b) { return a - b; }
+#ifdef __x86_64__
+    static __m128i sse2(__m128i a, __m128i b, const uint8_t*) { return _mm_sub_epi8(a, b); }
+    static __m128i sse2(__m128i a, __m128i b, const uint16_t*) { return _mm_sub_epi16(a, b); }
+    static __m128i sse2(__m128i a, __m128i b, const uint32_t*) { return _mm_sub_epi32(a, b); }
+    static __m128i sse2(__m128i a, __m128i b, const uint64_t*) { return _mm_sub_epi64(a, b); }
+    __attribute__((target("avx2"))) static __m256i avx2(__m256i a, __m256i b, const uint8_t*) { return _mm256_sub_epi8(a, b); }
+    __attribute__((target("avx2"))) static __m256i avx2(__m256i a, __m256i b, const uint16_t*) { return _mm256_sub_epi16(a, b); }
+    __attribute__((target("avx2"))) static __m256i avx2(__m256i a, __m256i b, const uint32_t*) { return _mm256_sub_epi32(a, b); }
+    __attribute__((target("avx2"))) static __m256i avx2(__m256i a, __m256i b, const uint64_t*) { return _mm256_sub_epi64(a, b); }
+#endif
+};
+struct and_op
+{
+    template<typename T> static T scalar(T a, T b) { return a & b; }
+#ifdef __x86_64__
+    template<typename T> static __m128i sse2(__m128i a, __m128i b, const T*) { return _mm_and_si128(a, b); }
+    template<typename T> __attribute__((target("avx2"))) static __m256i avx2(__m256i a, __m256i b, const T*) { return _mm256_and_si256(a, b); }
+#endif
+};
+struct or_op
+{
+    template<typename T> static T scalar(T a, T b) { return a | b; }
+#ifdef __x86_64__
+    template<typename T> static __m128i sse2(__m128i a, __m128i b, const T*) { return _mm_or_si128(a, b); }
+    template<typename T> __attribute__((target("avx2"))) static __m256i avx2(__m256i a, __m256i b, const T*) { return _mm256_or_si256(a, b); }
+#endif
+};
+struct xor_op
+{
+    template<typename T> static T scalar(T a, T b) { return a ^ b; }
+#ifdef __x86_64__
+    template<typename T> static __m128i sse2(__m128i a, __m128i b, const T*) { return _mm_xor_si128(a, b); }
+    template<typename T> __attribute__((target("avx2"))) static __m256i avx2(__m256i a, __m256i b, const T*) { return _mm256_xor_si256(a, b); }
+#endif
+};
+struct minu_op
+{
+    template<typename T> static T scalar(T a, T b) { return a < b ? a : b; }
+#ifdef __x86_64__
+    static __m128i sse2(__m128i a, __m128i b, const uint8_t*) { return _mm_min_epu8(a, b); }
+    __attribute__((target("avx2"))) static __m256i avx2(__m256i a, __m256i b, const uint8_t*) { return _mm256_min_epu8(a, b); }
+    __attribute__((target("avx2"))) static __m256i avx2(__m256i a, __m256i b, const uint16_t*) { return _mm256_min_epu16(a, b); }
+    __attribute__((target("avx2"))) static __m256i avx2(__m256i a, __m256i b, const uint32_t*) { return _mm256_min_epu32(a, b); }
+#endif
+};
+struct min_op
+{
+    template<typename T> static T scalar(T a, T b)
+    {
+        return (typename std::make_signed<T>::type)a < (typename std::make_signed<T>::type)b ? a : b;
+    }
+#ifdef __x86_64__
+    static __m128i sse2(__m128i a, __m128i b, const uint16_t*) { return _mm_min_epi16(a, b); }
+    __attribute__((target("avx2"))) static __m256i avx2(__m256i a, __m256i b, const uint8_t*) { return _mm256_min_epi8(a, b); }
+    __attribute__((target("avx2"))) static __m256i avx2(__m256i a, __m256i b, const uint16_t*) { return _mm256_min_epi16(a, b); }
+    __attribute__((target("avx2"))) static __m256i avx2(__m256i a, __m256i b, const uint32_t*) { return _mm256_min_epi32(a, b); }
+#endif
+};
+struct maxu_op
+{
+    template<typename T> static T scalar(T a, T b) { return a < b ? b : a; }
+#ifdef __x86_64__
+    static __m128i sse2(__m128i a, __m128i b, const uint8_t*) { return _mm_max_epu8(a, b); }
+    __attribute__((target("avx2"))) static __m256i avx2(__m256i a, __m256i b, const uint8_t*) { return _mm256_max_epu8(a, b); }
+    __attribute__((target("avx2"))) static __m256i avx2(__m256i a, __m256i b, const uint16_t*) { return _mm256_max_epu16(a, b); }
+    __attribute__((target("avx2"))) static __m256i avx2(__m256i a, __m256i b, const uint32_t*) { return _mm256_max_epu32(a, b); }
+#endif
+};
+struct max_op
+{
+    template<typename T> static T scalar(T a, T b)
+    {
+        return (typename std::make_signed<T>::type)a < (typename std::make_signed<T>::type)b ? b : a;
+    }
+#ifdef __x86_64__
+    static __m128i sse2(__m128i a, __m128i b, const uint16_t*) { return _mm_max_epi16(a, b); }
+    __attribute__((target("avx2"))) static __m256i avx2(__m256i a, __m256i b, const uint8_t*) { return _mm256_max_epi8(a, b); }
+    __attribute__((target("avx2"))) static __m256i avx2(__m256i a, __m256i b, const uint16_t*) { return _mm256_max_epi16(a, b); }
+    __attribute__((target("avx2"))) static __m256i avx2(__m256i a, __m256i b, const uint32_t*) { return _mm256_max_epi32(a, b); }
+#endif
+};
+struct mul_op
+{
+    template<typename T> static T scalar(T a, T b) { return 1u * a * b; } // unsigned, a uint16_t would promote to int
+#ifdef __x86_64__
+    static __m128i sse2(__m128i a, __m128i b, const uint16_t*) { return _mm_mullo_epi16(a, b); }
+    __attribute__((target("avx2"))) static __m256i avx2(__m256i a, __m256i b, const uint16_t*) { return _mm256_mullo_epi16(a, b); }
+    __attribute__((target("avx2"))) static __m256i avx2(__m256i a, __m256i b, const uint32_t*) { return _mm256_mullo_epi32(a, b); }
+#endif
+};
+
+/**
+ * Element-at-a-time kernel, also does the bytes the SIMD kernels leave over
+ * @param uint8_t* d, const uint8_t* a, const uint8_t* b, uint32_t bytes
+ * @return none
+ ********************************************************************************/
+template<typename OP, typename T>
+static void scalar_kernel(uint8_t* d, const uint8_t* a, const uint8_t* b, uint32_t bytes)
+{
+    for (uint32_t i = 0; i < bytes; i += sizeof(T))
+    {
+        T x, y;
+        memcpy(&x, a + i, sizeof(T));
+        memcpy(&y, b + i, sizeof(T));
+        x = OP::scalar(x, y);
+        memcpy(d + i, &x, sizeof(T));
+    }
+}
+
+#ifdef __x86_64__
+/**
+ * SSE2 kernel, 16 bytes at a time
+ * @param uint8_t* d, const uint8_t* a, const uint8_t* b, uint32_t bytes
+ * @return none
+ ********************************************************************************/
+template<typename OP, typename T>
+static void sse2_kernel(uint8_t* d, const uint8_t* a, const uint8_t* b, uint32_t bytes)
+{
+    uint32_t i = 0;
+    for (; i + 16 <= bytes; i += 16)
+    {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+        __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(d + i), OP::sse2(x, y, (const T*)nullptr));
+    }
+    scalar_kernel<OP, T>(d + i, a + i, b + i, bytes - i);
+}
+
+/**
+ * AVX2 kernel, 32 bytes at a time, only called when host_simd() found AVX2
+ * @param uint8_t* d, const uint8_t* a, const uint8_t* b, uint32_t bytes
+ * @return none
+ ********************************************************************************/
+template<typename OP, typename T>
+__attribute__((target("avx2"))) static void avx2_kernel(uint8_t* d, const uint8_t* a, const uint8_t* b, uint32_t bytes)
+{
+    uint32_t i = 0;
+    for (; i + 32 <= bytes; i += 32)
+    {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(d + i), OP::avx2(x, y, (const T*)nullptr));
+    }
+    scalar_kernel<OP, T>(d + i, a + i, b + i, bytes - i);
+}
+
+/**
+ * Pick the kernel of OP for elements of type T, called with 0
+ * the overloads taking int only exist when OP has that form, so they win when they exist and the
+ * ones taking long fall back to the next narrower form
+ * @param int
+ * @return the kernel
+ ********************************************************************************/
+template<typename OP, typename T>
+static auto pick_sse2(int) -> decltype(OP::sse2(__m128i(), __m128i(), (const T*)nullptr), vregfile::kernel_fn())
+{
+    return sse2_kernel<OP, T>;
+}
+template<typename OP, typename T>
+static auto pick_avx2(int) -> decltype(OP::avx2(__m256i(), __m256i(), (const T*)nullptr), vregfile::kernel_fn())
+{
+    return avx2_kernel<OP, T>;
+}
+#endif
+template<typename OP, typename T>
+static vregfile::kernel_fn pick_sse2(long)
+{
+    return scalar_kernel<OP, T>;
+}
+template<typename OP, typename T>
+static vregfile::kernel_fn pick_avx2(long)
+{
+    return pick_sse2<OP, T>(0);
+}
+
+/**
+ * Fill the kernels of OP for the four element widths
+ * @param vregfile::kernel_fn* row, vregfile::simd_level level
+ * @return none
+ ********************************************************************************/
+template<typename OP>
+static void set_row(vregfile::kernel_fn* row, vregfile::simd_level level)
+{
+    switch (level)
+    {
+        case vregfile::simd_scalar:
+            row[0] = scalar_kernel<OP, uint8_t>;
+            row[1] = scalar_kernel<OP, uint16_t>;
+            row[2] = scalar_kernel<OP, uint32_t>;
+            row[3] = scalar_kernel<OP, uint64_t>;
+            break;
+        case vregfile::simd_sse2:
+            row[0] = pick_sse2<OP, uint8_t>(0);
+            row[1] = pick_sse2<OP, uint16_t>(0);
+            row[2] = pick_sse2<OP, uint32_t>(0);
+            row[3] = pick_sse2<OP, uint64_t>(0);
+            break;
+        case vregfile::simd_avx2:
+            row[0] = pick_avx2<OP, uint8_t>(0);
+            row[1] = pick_avx2<OP, uint16_t>(0);
+            row[2] = pick_avx2<OP, uint32_t>(0);
+            row[3] = pick_avx2<OP, uint64_t>(0);
+            break;
+    }
+}
+
+/**
+ * vregfile constructor
+ * VLEN is 128 and the kernels use the best the host has
+ * @param none
+ * @return nothing
+ ********************************************************************************/
+vregfile::vregfile()
+{
+    set_vlen(128);
+    set_simd(host_simd());
+}
+
+/**
+ * Set VLEN, this clears the registers and makes vtype illegal
+ * @param uint32_t bits (a power of 2 from min_vlen to max_vlen)
+ * @return false if bits can't be VLEN
+ ********************************************************************************/
+bool vregfile::set_vlen(uint32_t bits)
+{
+    if (bits < min_vlen || bits > max_vlen || (bits & (bits - 1)) != 0)
+    {
+        return false;
+    }
+    vlenb = bits / 8;
+    regs.assign(32 * vlenb, 0);
+    scratch.assign(8 * vlenb, 0);
+    reset();
+    return true;
+}
+
+/**
+ * getter get_vlenb, the value of the vlenb CSR
+ * @param none
+ * @return VLEN / 8
+ ********************************************************************************/
+uint32_t vregfile::get_vlenb() const
+{
+    return vlenb;
+}
+
+/**
+ * Find the widest kernels the host can run
+ * @param none
+ * @return simd_avx2, simd_sse2 (every x86-64 host) or simd_scalar
+ ********************************************************************************/
+vregfile::simd_level vregfile::host_simd()
+{
+#ifdef __x86_64__
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") ? simd_avx2 : simd_sse2;
+#else
+    return simd_scalar;
+#endif
+}
+
+/**
+ * Turn a kernel name from the command line into a simd_level
+ * @param const std::string& name (scalar, sse2 or avx2), simd_level& level
+ * @return false if there is no such name
+ ********************************************************************************/
+bool vregfile::parse_simd(const std::string& name, simd_level& level)
+{
+    if (name == "scalar")
+        level = simd_scalar;
+    else if (name == "sse2")
+        level = simd_sse2;
+    else if (name == "avx2")
+        level = simd_avx2;
+    else
+        return false;
+    return true;
+}
+
+/**
+ * Choose the kernels, a lower level than the host's is there to compare them
+ * @param simd_level level
+ * @return false if the host can't run that level
+ ********************************************************************************/
+bool vregfile::set_simd(simd_level level)
+{
+    if (level > host_simd())
+    {
+        return false;
+    }
+    simd = level;
+    set_row<add_op>(kernels[alu_add], level);
+    set_row<sub_op>(kernels[alu_sub], level);
+    set_row<and_op>(kernels[alu_and], level);
+    set_row<or_op>(kernels[alu_or], level);
+    set_row<xor_op>(kernels[alu_xor], level);
+    set_row<minu_op>(kernels[alu_minu], level);
+    set_row<min_op>(kernels[alu_min], level);
+    set_row<maxu_op>(kernels[alu_maxu], level);
+    set_row<max_op>(kernels[alu_max], level);
+    set_row<mul_op>(kernels[alu_mul], level);
+    return true;
+}
+
+/**
+ * Reset state: registers 0, vl 0 and vtype illegal
+ * @param none
+ * @return none
+ ********************************************************************************/
+void vregfile::reset()
+{
+    std::fill(regs.begin(), regs.end(), 0);
+    vl = 0;
+    vtype = 0;
+    vill = true;
+    sew_shift = 0;
+    lmul_shift = 0;
+}
+
+/**
+ * What vsetvli, vsetivli and vsetvl do: take the new vtype and set vl from the application
+ * vector length. A vtype this implementation does not support sets vill and vl = 0.
+ * @param uint64_t vtypei, uint64_t avl (all ones for VLMAX)
+ * @return the new vl
+ ********************************************************************************/
+uint32_t vregfile::set_vtype(uint64_t vtypei, uint64_t avl)
+{
+    uint32_t vlmul = vtypei & 7;
+    uint32_t vsew = (vtypei >> 3) & 7;
+    int32_t lmul = vlmul < 4 ? (int32_t)vlmul : (int32_t)vlmul - 8;
+    // reserved bits, LMUL 4 (reserved), SEW above 64 or SEW > LMUL * ELEN with ELEN = 64
+    if ((vtypei >> 8) != 0 || vlmul == 4 || vsew > 3 || (int32_t)vsew > 3 + lmul)
+    {
+        vill = true;
+        vtype = 0;
+        vl = 0;
+        return 0;
+    }
+    uint32_t vlmax = lmul >= 0 ? (vlenb >> vsew) << lmul : (vlenb >> vsew) >> -lmul;
+    vill = vlmax == 0; // SEW / LMUL wider than VLEN
+    vtype = vill ? 0 : vtypei;
+    sew_shift = vsew;
+    lmul_shift = lmul;
+    vl = vill ? 0 : avl < vlmax ? avl : vlmax;
+    return vl;
+}
+
+/**
+ * getter is_vill
+ * @param none
+ * @return true when vtype is illegal, then only vset* may use the vector unit
+ ********************************************************************************/
+bool vregfile::is_vill() const
+{
+    return vill;
+}
+
+/**
+ * getter get_vtype, the vtype CSR without the vill bit (which is XLEN-1)
+ * @param none
+ * @return vlmul, vsew, vta and vma
+ ********************************************************************************/
+uint32_t vregfile::get_vtype() const
+{
+    return vtype;
+}
+
+/**
+ * getter get_vl
+ * @param none
+ * @return the number of elements the next instruction works on
+ ********************************************************************************/
+uint32_t vregfile::get_vl() const
+{
+    return vl;
+}
+
+/**
+ * getter get_sew
+ * @param none
+ * @return SEW in bits
+ ********************************************************************************/
+uint32_t vregfile::get_sew() const
+{
+    return 8 << sew_shift;
+}
+
+/**
+ * Check that v can hold vl elements of eew bits: vtype is legal, EMUL = EEW / SEW * LMUL is in
+ * 1/8 .. 8 and v is a multiple of EMUL
+ * @param uint32_t v, uint32_t eew (8, 16, 32 or 64)
+ * @return false if using v is an illegal instruction
+ ********************************************************************************/
+bool vregfile::check_group(uint32_t v, uint32_t eew) const
+{
+    int32_t emul = lmul_shift + __builtin_ctz(eew / 8) - (int32_t)sew_shift;
+    return !vill && emul >= -3 && emul <= 3 && (emul <= 0 || v % (1u << emul) == 0);
+}
+
+/**
+ * Load count elements of eew bits into vd from element first on, element first + i comes from
+ * addr + i * stride. A unit-stride load of RAM without watchpoints is one copy. A translated
+ * access is done a page at a time, otherwise first is 0 and count is vl. Stops at the first
+ * element that is outside the memory, the elements before it are loaded.
+ * @param memory* mem, uint32_t vd, uint32_t addr, int32_t stride, uint32_t eew, uint32_t first,
+ * uint32_t count
+ * @return the number of elements loaded, less than count if one faulted
+ ********************************************************************************/
+uint32_t vregfile::load(memory* mem, uint32_t vd, uint32_t addr, int32_t stride, uint32_t eew, uint32_t first,
+                        uint32_t count)
+{
+    uint32_t size = eew / 8;
+    uint8_t* d = reg(vd) + first * size;
+    const uint8_t* p;
+    if (stride == (int32_t)size && !mem->watching() && (p = mem->get_ptr(addr, count * size)) != nullptr)
+    {
+        memcpy(d, p, count * size);
+        return count;
+    }
+    for (uint32_t i = 0; i < count; i++, addr += stride)
+    {
+        uint64_t val;
+        if (!mem->read(addr, size, val))
+        {
+            return i;
+        }
+        memcpy(d + i * size, &val, size); // the low bytes on a little-endian host
+    }
+    return count;
+}
+
+/**
+ * Store count elements of eew bits from vs3 from element first on, element first + i goes to
+ * addr + i * stride. Stops at the first element that is outside the memory, the elements before
+ * it are stored.
+ * @param memory* mem, uint32_t vs3, uint32_t addr, int32_t stride, uint32_t eew, uint32_t first,
+ * uint32_t count
+ * @return the number of elements stored, less than count if one faulted
+ ********************************************************************************/
+uint32_t vregfile::store(memory* mem, uint32_t vs3, uint32_t addr, int32_t stride, uint32_t eew, uint32_t first,
+                         uint32_t count)
+{
+    uint32_t size = eew / 8;
+    const uint8_t* s = reg(vs3) + first * size;
+    uint8_t* p;
+    if (stride == (int32_t)size && !mem->watching() && (p = mem->get_ptr(addr, count * size)) != nullptr)
+    {
+        memcpy(p, s, count * size);
+        return count;
+    }
+    for (uint32_t i = 0; i < count; i++, addr += stride)
+    {
+        uint64_t val = 0;
+        memcpy(&val, s + i * size, size);
+        if (!mem->write(addr, size, val))
+        {
+            return i;
+        }
+    }
+    return count;
+}
+
+/**
+ * vd[i] = vs2[i] op vs1[i] for the first vl elements
+ * @param alu_op op, uint32_t vd, uint32_t vs2, uint32_t vs1
+ * @return none
+ ********************************************************************************/
+void vregfile::alu_vv(alu_op op, uint32_t vd, uint32_t vs2, uint32_t vs1)
+{
+    kernels[op][sew_shift](reg(vd), reg(vs2), reg(vs1), vl << sew_shift);
+}
+
+/**
+ * vd[i] = vs2[i] op x, or x op vs2[i] when reverse (vrsub), for the first vl elements
+ * @param alu_op op, uint32_t vd, uint32_t vs2, uint64_t x (truncated to SEW), bool reverse
+ * @return none
+ ********************************************************************************/
+void vregfile::alu_vx(alu_op op, uint32_t vd, uint32_t vs2, uint64_t x, bool reverse)
+{
+    splat(x, vl);
+    if (reverse)
+        kernels[op][sew_shift](reg(vd), scratch.data(), reg(vs2), vl << sew_shift);
+    else
+        kernels[op][sew_shift](reg(vd), reg(vs2), scratch.data(), vl << sew_shift);
+}
+
+/**
+ * vd[0] = vs1[0] op vs2[0] op ... op vs2[vl-1], nothing is written when vl is 0. The elements are
+ * folded in halves so that every step is one kernel call.
+ * @param alu_op op (alu_add for vredsum), uint32_t vd, uint32_t vs2, uint32_t vs1
+ * @return none
+ ********************************************************************************/
+void vregfile::reduce(alu_op op, uint32_t vd, uint32_t vs2, uint32_t vs1)
+{
+    if (vl == 0)
+    {
+        return;
+    }
+    kernel_fn k = kernels[op][sew_shift];
+    uint32_t size = 1 << sew_shift;
+    uint8_t* s = scratch.data();
+    memcpy(s, reg(vs2), vl * size);
+    for (uint32_t n = vl; n > 1; n /= 2)
+    {
+        if (n & 1)
+        {
+            k(s, s, s + (n - 1) * size, size); // fold the odd one out into element 0
+        }
+        k(s, s, s + n / 2 * size, n / 2 * size);
+    }
+    k(s, s, reg(vs1), size);
+    memcpy(reg(vd), s, size);
+}
+
+/**
+ * vd[i] = vs1[i] for the first vl elements (vmv.v.v)
+ * @param uint32_t vd, uint32_t vs1
+ * @return none
+ ********************************************************************************/
+void vregfile::move_vv(uint32_t vd, uint32_t vs1)
+{
+    memmove(reg(vd), reg(vs1), vl << sew_shift);
+}
+
+/**
+ * vd[i] = x for the first vl elements (vmv.v.x and vmv.v.i)
+ * @param uint32_t vd, uint64_t x (truncated to SEW)
+ * @return none
+ ********************************************************************************/
+void vregfile::move_vx(uint32_t vd, uint64_t x)
+{
+    splat(x, vl);
+    memcpy(reg(vd), scratch.data(), vl << sew_shift);
+}
+
+/**
+ * Element 0 of vs2 for vmv.x.s, whatever vl is
+ * @param uint32_t vs2
+ * @return the element sign-extended from SEW
+ ********************************************************************************/
+int64_t vregfile::get_scalar(uint32_t vs2) const
+{
+    const uint8_t* p = &regs[vs2 * vlenb];
+    switch (sew_shift)
+    {
+        case 0:
+            return (int8_t)p[0];
+        case 1:
+        {
+            int16_t v;
+            memcpy(&v, p, 2);
+            return v;
+        }
+        case 2:
+        {
+            int32_t v;
+            memcpy(&v, p, 4);
+            return v;
+        }
+    }
+    int64_t v;
+    memcpy(&v, p, 8);
+    return v;
+}
+
+/**
+ * Element 0 of vd = x for vmv.s.x, nothing happens when vl is 0
+ * @param uint32_t vd, uint64_t x (truncated to SEW)
+ * @return none
+ ********************************************************************************/
+void vregfile::set_scalar(uint32_t vd, uint64_t x)
+{
+    if (vl != 0)
+    {
+        memcpy(reg(vd), &x, 1 << sew_shift);
+    }
+}
+
+/**
+ * The bytes of register v, the ones of v + 1 follow
+ * @param uint32_t v
+ * @return host pointer to them
+ ********************************************************************************/
+uint8_t* vregfile::reg(uint32_t v)
+{
+    return &regs[v * vlenb];
+}
+
+/**
+ * Fill the first count elements of scratch with x
+ * @param uint64_t x (truncated to SEW), uint32_t count
+ * @return none
+ ********************************************************************************/
+void vregfile::splat(uint64_t x, uint32_t count)
+{
+    uint32_t size = 1 << sew_shift;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        memcpy(&scratch[i * size], &x, size);
+    }
+}
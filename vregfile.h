@@ -0,0 +1,64 @@
+
+#ifndef VREGFILE_H
+#define VREGFILE_H
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "memory.h"
+/**
+ * Vector registers and vector configuration (vl, vtype) of the subset of the V extension the harts
+ * implement: vset{i}vl{i}, unit-stride and strided loads and stores, integer add, sub, min, max,
+ * mul and logic, and the integer reductions, all unmasked. The 32 registers are stored back to
+ * back, so a register group (LMUL > 1) is one array and every instruction is one call of an
+ * element kernel over vl elements. On x86-64 hosts the kernels work on 16 (SSE2) or 32 (AVX2)
+ * bytes at a time, AVX2 is used when the host has it. Elements past vl are left alone (tail
+ * undisturbed, which is also what ta allows).
+ ********************************************************************************/
+class vregfile
+{
+public:
+    // what the element kernels compute, d = a op b
+    enum alu_op { alu_add, alu_sub, alu_and, alu_or, alu_xor, alu_minu, alu_min, alu_maxu, alu_max, alu_mul, alu_count };
+    // host instruction sets the kernels may use
+    enum simd_level { simd_scalar, simd_sse2, simd_avx2 };
+    // one kernel: bytes bytes of elements of one width, d may be a or b
+    typedef void (*kernel_fn)(uint8_t* d, const uint8_t* a, const uint8_t* b, uint32_t bytes);
+    static constexpr uint32_t min_vlen = 64; // VLEN in bits, set_vlen() takes powers of 2 in between
+    static constexpr uint32_t max_vlen = 65536;
+    vregfile(); // constructor prototype
+    bool set_vlen(uint32_t bits);
+    uint32_t get_vlenb() const;
+    static simd_level host_simd();
+    static bool parse_simd(const std::string& name, simd_level& level);
+    bool set_simd(simd_level level);
+    void reset();
+    uint32_t set_vtype(uint64_t vtypei, uint64_t avl);
+    bool is_vill() const;
+    uint32_t get_vtype() const;
+    uint32_t get_vl() const;
+    uint32_t get_sew() const;
+    bool check_group(uint32_t v, uint32_t eew) const;
+    uint32_t load(memory* mem, uint32_t vd, uint32_t addr, int32_t stride, uint32_t eew, uint32_t first, uint32_t count);
+    uint32_t store(memory* mem, uint32_t vs3, uint32_t addr, int32_t stride, uint32_t eew, uint32_t first, uint32_t count);
+    void alu_vv(alu_op op, uint32_t vd, uint32_t vs2, uint32_t vs1);
+    void alu_vx(alu_op op, uint32_t vd, uint32_t vs2, uint64_t x, bool reverse);
+    void reduce(alu_op op, uint32_t vd, uint32_t vs2, uint32_t vs1);
+    void move_vv(uint32_t vd, uint32_t vs1);
+    void move_vx(uint32_t vd, uint64_t x);
+    int64_t get_scalar(uint32_t vs2) const;
+    void set_scalar(uint32_t vd, uint64_t x);
+private:
+    uint32_t vlenb = 16; // bytes per register, VLEN = 128
+    std::vector<uint8_t> regs; // v0 .. v31, vlenb bytes each
+    std::vector<uint8_t> scratch; // a splatted scalar or the partial sums of a reduction
+    uint32_t vl = 0;
+    uint32_t vtype = 0; // without vill
+    bool vill = true;
+    uint32_t sew_shift = 0; // log2 of the element size in bytes
+    int32_t lmul_shift = 0; // log2 of LMUL, negative for the fractional ones
+    simd_level simd = simd_scalar;
+    kernel_fn kernels[alu_count][4]; // by alu_op and sew_shift
+    uint8_t* reg(uint32_t v);
+    void splat(uint64_t x, uint32_t count);
+};
+#endif